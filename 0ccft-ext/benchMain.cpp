@@ -0,0 +1,494 @@
+#include "APU/APU.h"
+#include "APU/Types.h"
+#include "APU/RegisterTrace.h"
+#include "SoundChipSet.h"
+#include "ft0cc/doc/dpcm_sample.hpp"
+#include "FamiTrackerModule.h"
+#include "FamiTrackerEnv.h"
+#include "SoundChipService.h"
+#include "ChannelMap.h"
+#include "ChannelOrder.h"
+#include "SongData.h"
+#include "PatternNote.h"
+#include "TextExporter.h"
+#include "MappedFile.h"
+#include "json/json.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr unsigned SAMPLE_RATE = 44100;
+constexpr unsigned FRAME_CYCLES = MASTER_CLOCK_NTSC / FRAME_RATE_NTSC;
+constexpr unsigned WRITE_CYCLES = 100;
+constexpr unsigned DEFAULT_FRAMES = 3600;
+constexpr unsigned RUNS = 3;
+constexpr unsigned TEXT_FRAMES = 128;
+constexpr unsigned TEXT_ROWS = 256;
+
+// Builds a register trace one frame at a time, spacing writes like the sound driver does.
+class CScript {
+public:
+	explicit CScript(CSoundChipSet Chips) : trace_(machine_t::NTSC, Chips) {
+		trace_.RecordReset();
+	}
+
+	void Write(std::uint16_t Address, std::uint8_t Value) {
+		cycle_ = std::min(cycle_ + WRITE_CYCLES, FRAME_CYCLES);
+		trace_.RecordWrite(cycle_, Address, Value);
+	}
+
+	void Sample(std::shared_ptr<const ft0cc::doc::dpcm_sample> pSample) {
+		trace_.RecordSample(cycle_, pSample);
+	}
+
+	void EndFrame() {
+		trace_.RecordEndFrame(FRAME_CYCLES);
+		cycle_ = 0;
+	}
+
+	const CRegisterTrace &GetTrace() const {
+		return trace_;
+	}
+
+private:
+	CRegisterTrace trace_;
+	unsigned cycle_ = 0;
+};
+
+// Fixed synthetic register scripts. Every chip plays a new note on each channel every few frames
+// and changes volume or timbre on the other frames, so that all of its channels stay busy.
+void Script2A03(CScript &s, std::mt19937 &rng, unsigned f) {
+	static const auto SAMPLE = [] {
+		std::mt19937 r {0x2A03};
+		std::vector<ft0cc::doc::dpcm_sample::sample_t> data(0x401);
+		for (auto &x : data)
+			x = static_cast<ft0cc::doc::dpcm_sample::sample_t>(r());
+		return std::make_shared<ft0cc::doc::dpcm_sample>(std::move(data), "bench");
+	}();
+
+	if (f == 0)
+		s.Write(0x4015, 0x0F);
+	for (unsigned i = 0; i < 2; ++i) {
+		s.Write(0x4000 + i * 4, 0x30 | (rng() & 0xCF));
+		s.Write(0x4002 + i * 4, rng() & 0xFF);
+		if (f % 8 == i * 4)
+			s.Write(0x4003 + i * 4, rng() & 0x07);
+	}
+	s.Write(0x4008, 0xFF);
+	s.Write(0x400A, rng() & 0xFF);
+	if (f % 8 == 0)
+		s.Write(0x400B, rng() & 0x07);
+	s.Write(0x400C, 0x30 | (rng() & 0x0F));
+	s.Write(0x400E, rng() & 0x8F);
+	s.Write(0x400F, 0x00);
+	if (f % 32 == 0) {
+		s.Sample(SAMPLE);
+		s.Write(0x4010, rng() & 0x4F);
+		s.Write(0x4012, 0x00);
+		s.Write(0x4013, 0x40);
+		s.Write(0x4015, 0x1F);
+	}
+}
+
+void ScriptVRC6(CScript &s, std::mt19937 &rng, unsigned f) {
+	for (unsigned i = 0; i < 3; ++i) {
+		std::uint16_t Base = 0x9000 + i * 0x1000;
+		s.Write(Base, i == 2 ? rng() & 0x3F : rng() & 0x7F);
+		s.Write(Base + 1, rng() & 0xFF);
+		if (f % 8 == i * 2)
+			s.Write(Base + 2, 0x80 | (rng() & 0x0F));
+	}
+}
+
+void ScriptMMC5(CScript &s, std::mt19937 &rng, unsigned f) {
+	if (f == 0)
+		s.Write(0x5015, 0x03);
+	for (unsigned i = 0; i < 2; ++i) {
+		s.Write(0x5000 + i * 4, 0x30 | (rng() & 0xCF));
+		s.Write(0x5002 + i * 4, rng() & 0xFF);
+		if (f % 8 == i * 4)
+			s.Write(0x5003 + i * 4, rng() & 0x07);
+	}
+}
+
+void ScriptFDS(CScript &s, std::mt19937 &rng, unsigned f) {
+	if (f == 0) {
+		s.Write(0x4023, 0x83);
+		s.Write(0x4089, 0x80);
+		for (unsigned i = 0; i < 0x40; ++i)
+			s.Write(0x4040 + i, static_cast<std::uint8_t>(32 + 31 * std::sin(i * 3.14159265358979 / 32)));
+		s.Write(0x4089, 0x00);
+	}
+	s.Write(0x4080, 0x80 | (rng() & 0x3F));
+	s.Write(0x4082, rng() & 0xFF);
+	s.Write(0x4083, rng() & 0x0F);
+	if (f % 16 == 0) {
+		s.Write(0x4087, 0x80);
+		for (unsigned i = 0; i < 0x20; ++i)
+			s.Write(0x4088, rng() & 0x07);
+		s.Write(0x4084, 0x80 | (rng() & 0x3F));
+		s.Write(0x4086, rng() & 0xFF);
+		s.Write(0x4087, rng() & 0x0F);
+	}
+}
+
+void ScriptVRC7(CScript &s, std::mt19937 &rng, unsigned f) {
+	const auto Reg = [&] (std::uint8_t Address, std::uint8_t Value) {
+		s.Write(0x9010, Address);
+		s.Write(0x9030, Value);
+	};
+	for (std::uint8_t i = 0; i < 6; ++i) {
+		Reg(0x30 + i, rng() & 0xFF);
+		Reg(0x10 + i, rng() & 0xFF);
+		if (f % 8 == i)
+			Reg(0x20 + i, 0x00);
+		Reg(0x20 + i, 0x10 | (rng() & 0x0F));
+	}
+}
+
+void ScriptN163(CScript &s, std::mt19937 &rng, unsigned f, unsigned Channels) {
+	const auto Reg = [&] (std::uint8_t Address, std::uint8_t Value) {
+		s.Write(0xF800, Address);
+		s.Write(0x4800, Value);
+	};
+	if (f == 0) {
+		s.Write(0xF800, 0x80);
+		for (unsigned i = 0; i < 0x40; ++i)
+			s.Write(0x4800, rng() & 0xFF);
+	}
+	for (unsigned i = 0; i < Channels; ++i) {
+		std::uint8_t Base = 0x78 - i * 8;
+		Reg(Base, rng() & 0xFF);
+		Reg(Base + 2, rng() & 0xFF);
+		Reg(Base + 4, 0xE0 | (rng() & 0x03));
+		Reg(Base + 6, (i * 0x10) & 0x7F);
+		Reg(Base + 7, ((Channels - 1) << 4) | (rng() & 0x0F));
+	}
+}
+
+void ScriptS5B(CScript &s, std::mt19937 &rng, unsigned f) {
+	const auto Reg = [&] (std::uint8_t Address, std::uint8_t Value) {
+		s.Write(0xC000, Address);
+		s.Write(0xE000, Value);
+	};
+	for (std::uint8_t i = 0; i < 3; ++i) {
+		Reg(i * 2, rng() & 0xFF);
+		Reg(i * 2 + 1, rng() & 0x0F);
+		Reg(8 + i, (f % 16 == 0 && i == 2) ? 0x10 : rng() & 0x0F);
+	}
+	Reg(0x06, rng() & 0x1F);
+	Reg(0x07, rng() & 0x3F);
+	if (f % 16 == 0) {
+		Reg(0x0B, rng() & 0xFF);
+		Reg(0x0C, rng() & 0x0F);
+		Reg(0x0D, 0x0E);
+	}
+}
+
+struct bench_case_t {
+	std::string Name;
+	CSoundChipSet Chips;
+	unsigned N163Channels = 0;
+};
+
+std::vector<bench_case_t> MakeBenchCases() {
+	std::vector<bench_case_t> cases;
+	cases.push_back({"2A03", sound_chip_t::APU});
+	cases.push_back({"VRC6", sound_chip_t::VRC6});
+	cases.push_back({"VRC7", sound_chip_t::VRC7});
+	cases.push_back({"FDS", sound_chip_t::FDS});
+	cases.push_back({"MMC5", sound_chip_t::MMC5});
+	for (unsigned i = 1; i <= 8; ++i)
+		cases.push_back({"N163-" + std::to_string(i), sound_chip_t::N163, i});
+	cases.push_back({"5B", sound_chip_t::S5B});
+	cases.push_back({"All", CSoundChipSet {sound_chip_t::APU}.WithChip(sound_chip_t::VRC6).WithChip(sound_chip_t::VRC7)
+		.WithChip(sound_chip_t::FDS).WithChip(sound_chip_t::MMC5).WithChip(sound_chip_t::N163).WithChip(sound_chip_t::S5B), 8});
+	return cases;
+}
+
+CRegisterTrace MakeScript(const bench_case_t &c, unsigned Frames) {
+	CScript s {c.Chips};
+	std::mt19937 rng {0x0CC};
+	for (unsigned f = 0; f < Frames; ++f) {
+		if (c.Chips.ContainsChip(sound_chip_t::APU))
+			Script2A03(s, rng, f);
+		if (c.Chips.ContainsChip(sound_chip_t::VRC6))
+			ScriptVRC6(s, rng, f);
+		if (c.Chips.ContainsChip(sound_chip_t::VRC7))
+			ScriptVRC7(s, rng, f);
+		if (c.Chips.ContainsChip(sound_chip_t::FDS))
+			ScriptFDS(s, rng, f);
+		if (c.Chips.ContainsChip(sound_chip_t::MMC5))
+			ScriptMMC5(s, rng, f);
+		if (c.Chips.ContainsChip(sound_chip_t::N163))
+			ScriptN163(s, rng, f, c.N163Channels);
+		if (c.Chips.ContainsChip(sound_chip_t::S5B))
+			ScriptS5B(s, rng, f);
+		s.EndFrame();
+	}
+	return s.GetTrace();
+}
+
+// Counts and hashes the rendered audio, so that emulation changes show up in the results.
+class CBenchCallback : public IAudioCallback {
+public:
+	void FlushBuffer(array_view<int16_t> Buffer) override {
+		samples_ += Buffer.size();
+		for (int16_t x : Buffer) {
+			hash_ ^= static_cast<std::uint16_t>(x);
+			hash_ *= 0x100000001B3ull;
+		}
+	}
+	bool PlayBuffer() override {
+		return true;
+	}
+
+	std::uint64_t GetSampleCount() const {
+		return samples_;
+	}
+	std::uint64_t GetHash() const {
+		return hash_;
+	}
+
+private:
+	std::uint64_t samples_ = 0;
+	std::uint64_t hash_ = 0xCBF29CE484222325ull;
+};
+
+nlohmann::json RunBenchCase(const bench_case_t &c, unsigned Frames) {
+	const CRegisterTrace trace = MakeScript(c, Frames);
+
+	double Best = 0.;
+	std::uint64_t Samples = 0;
+	std::uint64_t Hash = 0;
+	for (unsigned i = 0; i < RUNS; ++i) {
+		CBenchCallback cb;
+		CAPU apu {&cb};
+		apu.SetupSound(SAMPLE_RATE, 1, trace.GetMachine());
+		apu.SetupMixer(16, 12000, 24, 100);
+		apu.SetExternalSound(trace.GetChips());
+
+		CRegisterTracePlayer player {trace, apu};
+		auto t0 = std::chrono::steady_clock::now();
+		while (player.PlayFrame())
+			;
+		double Elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+		if (i == 0 || Elapsed < Best)
+			Best = Elapsed;
+		Samples = cb.GetSampleCount();
+		Hash = cb.GetHash();
+	}
+
+	char HashStr[17] = { };
+	std::snprintf(HashStr, std::size(HashStr), "%016llx", static_cast<unsigned long long>(Hash));
+	double Rate = Best > 0. ? Samples / Best : 0.;
+	return {
+		{"name", c.Name},
+		{"samples", Samples},
+		{"seconds", Best},
+		{"samples_per_second", Rate},
+		{"realtime", Rate / SAMPLE_RATE},
+		{"checksum", HashStr},
+	};
+}
+
+// Compares the results against a baseline written by an earlier run. Checksum mismatches always
+// fail; throughput only fails if it dropped by more than the given fraction.
+bool CompareBaseline(nlohmann::json &results, const nlohmann::json &baseline, double Tolerance) {
+	bool Pass = true;
+	const bool SameScript = baseline.value("frames", 0u) == results["frames"].get<unsigned>();
+
+	for (auto &r : results["results"])
+		for (const auto &b : baseline["results"])
+			if (b["name"] == r["name"]) {
+				double Ratio = r["samples_per_second"].get<double>() / b["samples_per_second"].get<double>();
+				r["baseline_ratio"] = Ratio;
+				if (Ratio < 1. - Tolerance) {
+					std::cerr << r["name"].get<std::string>() << ": " << Ratio << "x of baseline throughput\n";
+					Pass = false;
+				}
+				if (SameScript && b["checksum"] != r["checksum"]) {
+					std::cerr << r["name"].get<std::string>() << ": output differs from baseline\n";
+					Pass = false;
+				}
+			}
+
+	return Pass;
+}
+
+// Builds a module using every expansion chip, whose patterns are all distinct and filled with
+// random notes and effects in every effect column, so that its text export is a large dump.
+std::unique_ptr<CFamiTrackerModule> MakeTextModule() {
+	const effect_t EFFECTS[] = {
+		effect_t::ARPEGGIO, effect_t::VIBRATO, effect_t::TREMOLO, effect_t::PITCH, effect_t::DELAY,
+		effect_t::VOLUME_SLIDE, effect_t::NOTE_CUT, effect_t::RETRIGGER, effect_t::PORTA_UP, effect_t::PORTA_DOWN,
+	};
+
+	auto pModule = std::make_unique<CFamiTrackerModule>();
+	const CSoundChipSet Chips = CSoundChipSet {sound_chip_t::APU}.WithChip(sound_chip_t::VRC6).WithChip(sound_chip_t::VRC7)
+		.WithChip(sound_chip_t::FDS).WithChip(sound_chip_t::MMC5).WithChip(sound_chip_t::N163).WithChip(sound_chip_t::S5B);
+	pModule->SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(Chips, 8));
+
+	std::mt19937 rng {0x7E47};
+	auto &song = *pModule->GetSong(0);
+	song.SetFrameCount(TEXT_FRAMES);
+	song.SetPatternLength(TEXT_ROWS);
+	pModule->GetChannelOrder().ForeachChannel([&] (stChannelID ch) {
+		song.SetEffectColumnCount(ch, MAX_EFFECT_COLUMNS);
+		for (unsigned f = 0; f < TEXT_FRAMES; ++f) {
+			song.SetFramePattern(f, ch, f);
+			for (unsigned r = 0; r < TEXT_ROWS; ++r) {
+				stChanNote note;
+				if (rng() % 2) {
+					note.Note = static_cast<note_t>(1 + rng() % 12);
+					note.Octave = rng() % 8;
+					note.Instrument = rng() % 16;
+				}
+				if (rng() % 2)
+					note.Vol = rng() % 16;
+				for (auto &fx : note.Effects)
+					if (rng() % 2)
+						fx = {EFFECTS[rng() % std::size(EFFECTS)], static_cast<std::uint8_t>(rng())};
+				song.GetPattern(ch, f).SetNoteOn(r, note);
+			}
+		}
+	});
+
+	return pModule;
+}
+
+template <typename F>
+double BestTime(F f) {
+	double Best = 0.;
+	for (unsigned i = 0; i < RUNS; ++i) {
+		auto t0 = std::chrono::steady_clock::now();
+		f();
+		double Elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+		if (i == 0 || Elapsed < Best)
+			Best = Elapsed;
+	}
+	return Best;
+}
+
+nlohmann::json TextResult(const std::string &Name, std::size_t Bytes, double Seconds) {
+	return {
+		{"name", Name},
+		{"bytes", Bytes},
+		{"seconds", Seconds},
+		{"megabytes_per_second", Seconds > 0. ? Bytes / Seconds / 1e6 : 0.},
+	};
+}
+
+// Measures the text exporter and importer on a large module. The importer reads the dump back
+// from a file; exporting the imported module must reproduce the same text.
+bool RunTextBench(nlohmann::json &results) {
+	auto pModule = MakeTextModule();
+
+	std::string Text;
+	double ExportTime = BestTime([&] { Text = CTextExport::ExportText(*pModule); });
+	std::string Rows;
+	double RowsTime = BestTime([&] { Rows = CTextExport::ExportRowsText(*pModule); });
+
+	const auto Path = std::filesystem::temp_directory_path() / "ft0cc-bench.txt";
+	std::ofstream {Path, std::ios::binary}.write(Text.data(), Text.size());
+
+	std::unique_ptr<CFamiTrackerModule> pImported;
+	double ImportTime = BestTime([&] {
+		pImported = std::make_unique<CFamiTrackerModule>();
+		pImported->SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(sound_chip_t::APU, 0));
+		CMappedFile File {Path};
+		CTextExport::ImportText(File.GetText(), *pImported);
+	});
+	std::filesystem::remove(Path);
+
+	results["text_results"] = {
+		TextResult("export", Text.size(), ExportTime),
+		TextResult("export_rows", Rows.size(), RowsTime),
+		TextResult("import", Text.size(), ImportTime),
+	};
+	for (const auto &r : results["text_results"])
+		std::cerr << r["name"].get<std::string>() << ": " << r["megabytes_per_second"].get<double>() << " MB/s\n";
+
+	if (CTextExport::ExportText(*pImported) != Text) {
+		std::cerr << "text export differs after importing it\n";
+		return false;
+	}
+	return true;
+}
+
+} // namespace
+
+// usage: ft0cc-bench [--frames N] [--baseline FILE] [--tolerance FRACTION] [--filter NAME] [--text]
+// The results are written to stdout as JSON, in the same format as the baseline file.
+int main(int argc, char *argv[]) try {
+	unsigned Frames = DEFAULT_FRAMES;
+	std::string BaselinePath;
+	std::string Filter;
+	double Tolerance = .5;
+	bool Text = false;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (i + 1 < argc && arg == "--frames")
+			Frames = std::stoul(argv[++i]);
+		else if (i + 1 < argc && arg == "--baseline")
+			BaselinePath = argv[++i];
+		else if (i + 1 < argc && arg == "--tolerance")
+			Tolerance = std::stod(argv[++i]);
+		else if (i + 1 < argc && arg == "--filter")
+			Filter = argv[++i];
+		else if (arg == "--text")
+			Text = true;
+		else {
+			std::cerr << "Unknown argument: " << arg << '\n';
+			return 2;
+		}
+	}
+
+	nlohmann::json results = {
+		{"version", 1},
+		{"sample_rate", SAMPLE_RATE},
+		{"frames", Frames},
+		{"results", nlohmann::json::array()},
+	};
+	for (const auto &c : MakeBenchCases())
+		if (!Text && (Filter.empty() || c.Name == Filter)) {
+			results["results"].push_back(RunBenchCase(c, Frames));
+			std::cerr << c.Name << ": " << results["results"].back()["realtime"].get<double>() << "x realtime\n";
+		}
+
+	bool Pass = true;
+	if (Text)
+		Pass = RunTextBench(results);
+	if (!BaselinePath.empty()) {
+		std::ifstream baselineFile {BaselinePath};
+		if (!baselineFile) {
+			std::cerr << "Cannot open baseline file " << BaselinePath << '\n';
+			return 2;
+		}
+		Pass = CompareBaseline(results, nlohmann::json::parse(baselineFile), Tolerance) && Pass;
+	}
+
+	std::cout << results.dump(1, '\t') << '\n';
+	return Pass ? 0 : 1;
+}
+catch (std::exception &e) {
+	std::cerr << "C++ exception: " << e.what() << '\n';
+	return 1;
+}
+catch (...) {
+	std::cerr << "Unknown exception\n";
+	return 1;
+}
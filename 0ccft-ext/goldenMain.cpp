@@ -0,0 +1,543 @@
+#include "FamiTrackerModule.h"
+#include "FamiTrackerEnv.h"
+#include "SoundChipService.h"
+#include "SoundChipSet.h"
+#include "ChannelMap.h"
+#include "ChannelOrder.h"
+#include "Kraid.h"
+#include "HeadlessPlayer.h"
+#include "ParallelRenderer.h"
+#include "SoundDriver.h"
+#include "APU/APU.h"
+#include "SongData.h"
+#include "PatternNote.h"
+#include "InstrumentManager.h"
+#include "Instrument2A03.h"
+#include "InstrumentVRC7.h"
+#include "InstrumentFDS.h"
+#include "Sequence.h"
+#include "DSampleManager.h"
+#include "ft0cc/doc/dpcm_sample.hpp"
+#include "FamiTrackerDocIO.h"
+#include "DocumentFile.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr unsigned DEFAULT_FRAMES = 300;
+#ifdef GOLDEN_DIR
+constexpr char DEFAULT_DIR[] = GOLDEN_DIR;
+#else
+constexpr char DEFAULT_DIR[] = "golden";
+#endif
+
+// Every effect that does not change the song position; speed changes are added separately.
+constexpr effect_t CHANNEL_EFFECTS[] = {
+	effect_t::VOLUME, effect_t::PORTAMENTO, effect_t::SWEEPUP, effect_t::SWEEPDOWN, effect_t::ARPEGGIO,
+	effect_t::VIBRATO, effect_t::TREMOLO, effect_t::PITCH, effect_t::DELAY, effect_t::DAC,
+	effect_t::PORTA_UP, effect_t::PORTA_DOWN, effect_t::DUTY_CYCLE, effect_t::SAMPLE_OFFSET, effect_t::SLIDE_UP,
+	effect_t::SLIDE_DOWN, effect_t::VOLUME_SLIDE, effect_t::NOTE_CUT, effect_t::RETRIGGER, effect_t::DELAYED_VOLUME,
+	effect_t::FDS_MOD_DEPTH, effect_t::FDS_MOD_SPEED_HI, effect_t::FDS_MOD_SPEED_LO, effect_t::DPCM_PITCH,
+	effect_t::SUNSOFT_ENV_TYPE, effect_t::SUNSOFT_ENV_HI, effect_t::SUNSOFT_ENV_LO, effect_t::SUNSOFT_NOISE,
+	effect_t::VRC7_PORT, effect_t::VRC7_WRITE, effect_t::NOTE_RELEASE, effect_t::TRANSPOSE,
+	effect_t::N163_WAVE_BUFFER, effect_t::FDS_VOLUME, effect_t::FDS_MOD_BIAS, effect_t::VRC7_PERCUSSION,
+};
+
+inst_type_t InstTypeOf(sound_chip_t Chip) {
+	switch (Chip) {
+	case sound_chip_t::VRC6: return INST_VRC6;
+	case sound_chip_t::VRC7: return INST_VRC7;
+	case sound_chip_t::FDS:  return INST_FDS;
+	case sound_chip_t::N163: return INST_N163;
+	case sound_chip_t::S5B:  return INST_S5B;
+	default:                 return INST_2A03;
+	}
+}
+
+// Builds a module that plays random notes with random effects on every channel, using two
+// instruments per instrument type: one with sequences on every slot and one without any.
+class CCorpusBuilder {
+public:
+	CCorpusBuilder(CFamiTrackerModule &modfile, unsigned Seed) : modfile_(modfile), rng_(Seed) {
+	}
+
+	void operator()() {
+		const inst_type_t TYPES[] = {INST_2A03, INST_VRC6, INST_VRC7, INST_FDS, INST_N163, INST_S5B};
+		for (unsigned i = 0; i < std::size(TYPES); ++i) {
+			MakeInstrument(i * 2, TYPES[i], true);
+			MakeInstrument(i * 2 + 1, TYPES[i], false);
+		}
+		MakeSample();
+
+		auto &song = *modfile_.GetSong(0);
+		song.SetFrameCount(FRAMES);
+		song.SetPatternLength(ROWS);
+		song.SetSongSpeed(3);
+		modfile_.GetChannelOrder().ForeachChannel([&] (stChannelID ch) {
+			song.SetEffectColumnCount(ch, 2);
+			for (unsigned f = 0; f < FRAMES; ++f) {
+				song.SetFramePattern(f, ch, f);
+				for (unsigned r = 0; r < ROWS; ++r)
+					song.GetPattern(ch, f).SetNoteOn(r, MakeNote(ch));
+			}
+		});
+	}
+
+private:
+	static constexpr unsigned FRAMES = 4;
+	static constexpr unsigned ROWS = 32;
+
+	unsigned Rand(unsigned n) {
+		return rng_() % n;
+	}
+
+	void MakeInstrument(unsigned Index, inst_type_t Type, bool Sequences) {
+		auto *pManager = modfile_.GetInstrumentManager();
+		pManager->InsertInstrument(Index, pManager->CreateNew(Type));
+		auto pInst = pManager->GetInstrument(Index);
+
+		if (auto pVRC7 = std::dynamic_pointer_cast<CInstrumentVRC7>(pInst)) {
+			pVRC7->SetPatch(Sequences ? 0 : 1 + Rand(15));
+			for (int i = 0; i < 8; ++i)
+				pVRC7->SetCustomReg(i, Rand(0x100));
+			return;
+		}
+		if (auto pFDS = std::dynamic_pointer_cast<CInstrumentFDS>(pInst)) {
+			for (int i = 0; i < CInstrumentFDS::WAVE_SIZE; ++i)
+				pFDS->SetSample(i, static_cast<int>(std::lround(31.5 + 31.5 * std::sin(i * 6.283185307179586 / CInstrumentFDS::WAVE_SIZE))));
+			for (int i = 0; i < CInstrumentFDS::MOD_SIZE; ++i)
+				pFDS->SetModulation(i, Rand(8));
+			pFDS->SetModulationEnable(Sequences);
+			pFDS->SetModulationSpeed(Rand(0x1000));
+			pFDS->SetModulationDepth(Rand(0x40));
+		}
+		if (auto p2A03 = std::dynamic_pointer_cast<CInstrument2A03>(pInst))
+			for (int n = 0; n < 96; ++n) {
+				p2A03->SetSampleIndex(n, 0);
+				p2A03->SetSamplePitch(n, n % 16);
+				p2A03->SetSampleLoop(n, Sequences);
+			}
+
+		if (!Sequences)
+			return;
+		auto pSeqInst = std::dynamic_pointer_cast<CSeqInstrument>(pInst);
+		auto MakeSeq = [&] (sequence_t Type, std::vector<int> Items, int Loop, int Release) {
+			if (!std::dynamic_pointer_cast<CInstrumentFDS>(pInst)) {		// FDS instruments own their sequences
+				pSeqInst->SetSeqEnable(Type, true);
+				pSeqInst->SetSeqIndex(Type, Index);
+			}
+			auto pSeq = pSeqInst->GetSequence(Type);
+			if (!pSeq)
+				return;
+			pSeq->SetItemCount(Items.size());
+			for (std::size_t i = 0; i < Items.size(); ++i)
+				pSeq->SetItem(i, static_cast<int8_t>(Items[i]));
+			pSeq->SetLoopPoint(Loop);
+			pSeq->SetReleasePoint(Release);
+		};
+		MakeSeq(sequence_t::Volume, {15, 13, 12, 11, 10, 10, 9, 9, 8, 6, 4, 2, 0}, 8, 7);
+		MakeSeq(sequence_t::Arpeggio, {0, 0, 4, 4, 7, 7, 12, 12}, 0, -1);
+		MakeSeq(sequence_t::Pitch, {0, 1, 2, 1, 0, -1, -2, -1}, 0, -1);
+		MakeSeq(sequence_t::DutyCycle, {0, 1, 2, 3}, 0, -1);
+	}
+
+	void MakeSample() {
+		std::vector<ft0cc::doc::dpcm_sample::sample_t> data(0x101);
+		for (auto &x : data)
+			x = static_cast<ft0cc::doc::dpcm_sample::sample_t>(rng_());
+		modfile_.GetDSampleManager()->SetDSample(0, std::make_shared<ft0cc::doc::dpcm_sample>(std::move(data), "golden"));
+	}
+
+	stChanNote MakeNote(stChannelID ch) {
+		stChanNote note;
+		switch (Rand(12)) {
+		case 0: case 1: case 2: case 3:
+			note.Note = static_cast<note_t>(1 + Rand(12));
+			note.Octave = 1 + Rand(6);
+			note.Instrument = InstTypeOf(ch.Chip) * 2 - 2 + Rand(2);
+			break;
+		case 4: note.Note = note_t::halt; break;
+		case 5: note.Note = note_t::release; break;
+		case 6: note.Note = note_t::echo; note.Octave = Rand(4); break;
+		}
+		if (Rand(4) == 0)
+			note.Vol = Rand(16);
+		for (unsigned c = 0; c < 2; ++c)
+			if (Rand(4) == 0) {
+				note.Effects[c].fx = CHANNEL_EFFECTS[Rand(std::size(CHANNEL_EFFECTS))];
+				note.Effects[c].param = Rand(0x100);
+			}
+			else if (Rand(64) == 0)
+				note.Effects[c] = {effect_t::SPEED, 1 + Rand(8)};
+		return note;
+	}
+
+	CFamiTrackerModule &modfile_;
+	std::mt19937 rng_;
+};
+
+struct golden_case_t {
+	std::string Name;
+	std::unique_ptr<CFamiTrackerModule> Module;
+	unsigned Frames = DEFAULT_FRAMES;		// unless overridden by --frames
+};
+
+std::unique_ptr<CFamiTrackerModule> MakeCorpusModule(CSoundChipSet Chips, unsigned N163Channels, unsigned Seed) {
+	auto pModule = std::make_unique<CFamiTrackerModule>();
+	pModule->SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(Chips, N163Channels));
+	CCorpusBuilder {*pModule, Seed}();
+	return pModule;
+}
+
+// Plays only in the first and the last frame. Parallel renders must not accept a seam inside
+// the silent gap only because the audio matches, since the triangle phase and the noise shift
+// register keep running and decide how the last frame sounds.
+std::unique_ptr<CFamiTrackerModule> MakeSilentGapModule() {
+	constexpr unsigned FRAMES = 9;
+	constexpr unsigned ROWS = 64;
+
+	auto pModule = std::make_unique<CFamiTrackerModule>();
+	pModule->SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(sound_chip_t::APU, 0));
+	auto *pManager = pModule->GetInstrumentManager();
+	pManager->InsertInstrument(0, pManager->CreateNew(INST_2A03));
+
+	auto &song = *pModule->GetSong(0);
+	song.SetFrameCount(FRAMES);
+	song.SetPatternLength(ROWS);
+	song.SetSongSpeed(6);
+	auto MakeNote = [] (note_t Note, int Octave) {
+		stChanNote note;
+		note.Note = Note;
+		note.Octave = Octave;
+		note.Instrument = 0;
+		return note;
+	};
+
+	for (unsigned r = 0; r < ROWS; r += 8) {
+		song.GetPattern(apu_subindex_t::pulse1, 0).SetNoteOn(r, MakeNote(note_t::C, 3 + r / 32));
+		song.GetPattern(apu_subindex_t::pulse2, 0).SetNoteOn(r + 4, MakeNote(note_t::G, 3));
+	}
+	song.GetPattern(apu_subindex_t::pulse1, 0).SetNoteOn(ROWS - 2, MakeNote(note_t::halt, 0));
+	song.GetPattern(apu_subindex_t::pulse2, 0).SetNoteOn(ROWS - 1, MakeNote(note_t::halt, 0));
+	song.GetPattern(apu_subindex_t::triangle, 0).SetNoteOn(0, MakeNote(note_t::E, 3));
+	song.GetPattern(apu_subindex_t::triangle, 0).SetNoteOn(37, MakeNote(note_t::halt, 0));
+	song.GetPattern(apu_subindex_t::noise, 0).SetNoteOn(0, MakeNote(note_t::D, 0));
+	song.GetPattern(apu_subindex_t::noise, 0).SetNoteOn(21, MakeNote(note_t::halt, 0));
+	for (unsigned f = 0; f < FRAMES; ++f) {
+		const unsigned Gap = f && f < FRAMES - 1;
+		for (auto ch : {apu_subindex_t::pulse1, apu_subindex_t::pulse2, apu_subindex_t::triangle, apu_subindex_t::noise})
+			song.SetFramePattern(f, ch, Gap);
+	}
+
+	return pModule;
+}
+
+std::vector<golden_case_t> MakeCorpus() {
+	std::vector<golden_case_t> corpus;
+
+	auto kraid = std::make_unique<CFamiTrackerModule>();
+	kraid->SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(sound_chip_t::APU, 0));
+	Kraid { }(*kraid);
+	corpus.push_back({"kraid", std::move(kraid)});
+
+	const CSoundChipSet APU = sound_chip_t::APU;
+	corpus.push_back({"2a03", MakeCorpusModule(APU, 0, 0x2A03)});
+	corpus.push_back({"vrc6", MakeCorpusModule(APU.WithChip(sound_chip_t::VRC6), 0, 0x7C6)});
+	corpus.push_back({"vrc7", MakeCorpusModule(APU.WithChip(sound_chip_t::VRC7), 0, 0x7C7)});
+	corpus.push_back({"fds", MakeCorpusModule(APU.WithChip(sound_chip_t::FDS), 0, 0xFD5)});
+	corpus.push_back({"mmc5", MakeCorpusModule(APU.WithChip(sound_chip_t::MMC5), 0, 0x3C5)});
+	corpus.push_back({"n163", MakeCorpusModule(APU.WithChip(sound_chip_t::N163), 8, 0x163)});
+	corpus.push_back({"5b", MakeCorpusModule(APU.WithChip(sound_chip_t::S5B), 0, 0x5B)});
+	corpus.push_back({"all", MakeCorpusModule(APU.WithChip(sound_chip_t::VRC6).WithChip(sound_chip_t::VRC7)
+		.WithChip(sound_chip_t::FDS).WithChip(sound_chip_t::MMC5).WithChip(sound_chip_t::N163).WithChip(sound_chip_t::S5B), 4, 0xA11)});
+	corpus.push_back({"silentgap", MakeSilentGapModule(), 3200});
+
+	return corpus;
+}
+
+std::unique_ptr<CFamiTrackerModule> LoadModule(const fs::path &Path) {
+	CDocumentFile file;
+	file.Open(Path, std::ios::in | std::ios::binary);
+	file.ValidateFile();
+	auto pModule = std::make_unique<CFamiTrackerModule>();
+	if (file.GetFileVersion() < 0x0200U || !CFamiTrackerDocIO {file, module_error_level_t::MODULE_ERROR_DEFAULT}.Load(*pModule))
+		throw std::runtime_error {"Cannot load module: " + Path.string()};
+	return pModule;
+}
+
+// FNV-1a over 32-bit words
+class CHash {
+public:
+	void Add(std::uint32_t x) {
+		for (int i = 0; i < 4; ++i) {
+			h_ ^= (x >> (i * 8)) & 0xFFu;
+			h_ *= 0x01000193u;
+		}
+	}
+	std::uint32_t Get() const {
+		return h_;
+	}
+
+private:
+	std::uint32_t h_ = 0x811C9DC5u;
+};
+
+// Hash of the rendered audio followed by one hash per channel, in channel order
+using frame_hashes_t = std::vector<std::uint32_t>;
+
+struct golden_result_t {
+	std::vector<stChannelID> Channels;
+	std::vector<frame_hashes_t> Frames;
+	double DriverTime = 0.;		// average microseconds per frame
+	double EmulationTime = 0.;
+	bool AudioOnly = false;		// frames only contain the audio hash
+	unsigned Seams = 0;
+	unsigned RejectedSeams = 0;
+	double Seconds = 0.;
+};
+
+struct render_options_t {
+	unsigned Threads = 0;		// render with CParallelRenderer if nonzero
+	unsigned Warmup = CParallelRenderer::DEFAULT_WARMUP_TICKS;
+	unsigned Overlap = CParallelRenderer::DEFAULT_OVERLAP_TICKS;
+};
+
+std::uint32_t HashAudio(const int16_t *Begin, const int16_t *End) {
+	CHash audio;
+	for (auto it = Begin; it != End; ++it)
+		audio.Add(static_cast<std::uint16_t>(*it));
+	return audio.Get();
+}
+
+// Renders the first frames of a song on several threads, hashing the audio only
+golden_result_t RenderParallel(const CFamiTrackerModule &modfile, unsigned Frames, const render_options_t &Options) {
+	golden_result_t result;
+	result.AudioOnly = true;
+
+	auto t0 = std::chrono::steady_clock::now();
+	CParallelRenderer renderer {modfile, 0};
+	renderer.SetWarmup(Options.Warmup, Options.Overlap);
+	auto audio = renderer.Render(Frames, Options.Threads);
+	result.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	result.Seams = renderer.GetSeamCount();
+	result.RejectedSeams = renderer.GetRejectedSeamCount();
+
+	std::size_t Begin = 0;
+	for (std::size_t End : audio.FrameEnds) {
+		result.Frames.push_back({HashAudio(audio.Samples.data() + Begin, audio.Samples.data() + End)});
+		Begin = End;
+	}
+	return result;
+}
+
+// Renders frames [Seek, Frames), fast-forwarding over the frames before Seek
+golden_result_t Render(const CFamiTrackerModule &modfile, unsigned Frames, unsigned Seek) {
+	golden_result_t result;
+	modfile.GetChannelOrder().ForeachChannel([&] (stChannelID ch) {
+		result.Channels.push_back(ch);
+	});
+
+	CHeadlessPlayer player {modfile};
+	player.StartPlayer(0);
+	if (!player.SeekTick(Seek))
+		return result;
+	for (unsigned f = Seek; f < Frames; ++f) {
+		bool playing = player.RenderFrame();
+
+		frame_hashes_t hashes;
+		const auto &audio = player.GetFrameAudio();
+		hashes.push_back(HashAudio(audio.data(), audio.data() + audio.size()));
+		for (stChannelID ch : result.Channels) {
+			CHash h;
+			h.Add(player.GetAPU().GetVol(ch));
+			h.Add(player.GetSoundDriver().GetChannelNote(ch));
+			h.Add(player.GetSoundDriver().GetChannelVolume(ch));
+			hashes.push_back(h.Get());
+		}
+		result.Frames.push_back(std::move(hashes));
+
+		if (!playing)
+			break;
+	}
+
+	result.DriverTime = player.GetTickTimer().GetAverage(tick_part_t::driver);
+	result.EmulationTime = player.GetTickTimer().GetAverage(tick_part_t::emulation);
+	return result;
+}
+
+// One line per frame: the audio hash, then one hash per channel, all as 8 hex digits
+void WriteReference(const fs::path &Path, const golden_result_t &result) {
+	std::ofstream out(Path, std::ios::out | std::ios::binary);
+	if (!out)
+		throw std::runtime_error {"Cannot write " + Path.string()};
+	char buf[16];
+	for (const auto &hashes : result.Frames) {
+		for (std::size_t i = 0; i < hashes.size(); ++i) {
+			std::snprintf(buf, std::size(buf), "%s%08x", i ? " " : "", hashes[i]);
+			out << buf;
+		}
+		out << '\n';
+	}
+}
+
+std::vector<frame_hashes_t> ReadReference(const fs::path &Path) {
+	std::ifstream in(Path, std::ios::in | std::ios::binary);
+	if (!in)
+		throw std::runtime_error {"Cannot read " + Path.string() + ", run with --update to create it"};
+	std::vector<frame_hashes_t> frames;
+	std::string line;
+	while (std::getline(in, line)) {
+		std::istringstream ss {line};
+		frame_hashes_t hashes;
+		std::string word;
+		while (ss >> word)
+			hashes.push_back(static_cast<std::uint32_t>(std::stoul(word, nullptr, 16)));
+		frames.push_back(std::move(hashes));
+	}
+	return frames;
+}
+
+// Returns an empty string if the rendered output matches the reference from frame Seek onwards
+std::string Compare(const golden_result_t &result, const std::vector<frame_hashes_t> &Reference, unsigned Seek) {
+	std::ostringstream ss;
+	const std::size_t Expected = Reference.size() > Seek ? Reference.size() - Seek : 0;
+	for (std::size_t f = 0; f < result.Frames.size() || f < Expected; ++f) {
+		if (f >= Expected || f >= result.Frames.size()) {
+			ss << "length mismatch, " << result.Frames.size() << " frames rendered, " << Expected << " expected";
+			break;
+		}
+		const auto &x = result.Frames[f];
+		const auto &y = Reference[Seek + f];
+		if (result.AudioOnly) {
+			if (x.front() == y.front())
+				continue;
+			ss << "first divergent frame " << Seek + f << ", audio only";
+			break;
+		}
+		if (x.size() != y.size()) {
+			ss << "channel count mismatch, " << x.size() - 1 << " channels rendered, " << y.size() - 1 << " expected";
+			break;
+		}
+		if (x == y)
+			continue;
+
+		ss << "first divergent frame " << Seek + f;
+		std::size_t i = 1;
+		while (i < x.size() && x[i] == y[i])
+			++i;
+		if (i < x.size())
+			ss << ", channel " << FTEnv.GetSoundChipService()->GetChannelFullName(result.Channels[i - 1]);
+		else
+			ss << ", audio only";
+		break;
+	}
+	return ss.str();
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) try {
+	std::optional<unsigned> Frames;
+	unsigned Seek = 0;
+	fs::path Dir = DEFAULT_DIR;
+	bool Update = false;
+	bool Timing = false;
+	render_options_t Options;
+	std::string Filter;
+	std::vector<fs::path> Files;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--frames" && i + 1 < argc)
+			Frames = std::stoul(argv[++i]);
+		else if (arg == "--seek" && i + 1 < argc)
+			Seek = std::stoul(argv[++i]);
+		else if (arg == "--threads" && i + 1 < argc)
+			Options.Threads = std::stoul(argv[++i]);
+		else if (arg == "--warmup" && i + 1 < argc)
+			Options.Warmup = std::stoul(argv[++i]);
+		else if (arg == "--overlap" && i + 1 < argc)
+			Options.Overlap = std::stoul(argv[++i]);
+		else if (arg == "--dir" && i + 1 < argc)
+			Dir = argv[++i];
+		else if (arg == "--filter" && i + 1 < argc)
+			Filter = argv[++i];
+		else if (arg == "--update")
+			Update = true;
+		else if (arg == "--timing")
+			Timing = true;
+		else if (!arg.empty() && arg[0] != '-')
+			Files.push_back(arg);
+		else {
+			std::cerr << "Usage: " << argv[0] << " [--update] [--timing] [--dir DIR] [--frames N] [--seek N] [--threads N [--warmup N] [--overlap N]] [--filter NAME] [module.0cc ...]\n";
+			return 2;
+		}
+	}
+	if (Update && Seek) {
+		std::cerr << "--update cannot be used with --seek\n";
+		return 2;
+	}
+	if (Options.Threads && (Update || Seek)) {
+		std::cerr << "--threads cannot be used with --update or --seek\n";
+		return 2;
+	}
+
+	auto corpus = MakeCorpus();
+	for (const auto &path : Files)
+		corpus.push_back({path.stem().string(), LoadModule(path)});
+
+	int Failures = 0;
+	for (const auto &c : corpus) {
+		if (!Filter.empty() && c.Name.find(Filter) == std::string::npos)
+			continue;
+		auto result = Options.Threads ? RenderParallel(*c.Module, Frames.value_or(c.Frames), Options) : Render(*c.Module, Frames.value_or(c.Frames), Seek);
+		if (Timing && Options.Threads) {
+			char buf[96];
+			std::snprintf(buf, std::size(buf), "%s: %.3f s, %u of %u seams rejected\n",
+				c.Name.c_str(), result.Seconds, result.RejectedSeams, result.Seams);
+			std::cout << buf;
+		}
+		else if (Timing) {
+			char buf[96];
+			std::snprintf(buf, std::size(buf), "%s: driver %.2f us/frame, emulation %.2f us/frame\n",
+				c.Name.c_str(), result.DriverTime, result.EmulationTime);
+			std::cout << buf;
+		}
+		fs::path RefPath = Dir / (c.Name + ".txt");
+		if (Update) {
+			WriteReference(RefPath, result);
+			std::cout << c.Name << ": wrote " << result.Frames.size() << " frames\n";
+			continue;
+		}
+		if (std::string err = Compare(result, ReadReference(RefPath), Seek); !err.empty()) {
+			std::cout << c.Name << ": FAILED, " << err << '\n';
+			++Failures;
+		}
+		else
+			std::cout << c.Name << ": OK\n";
+	}
+
+	return Failures ? 1 : 0;
+}
+catch (std::exception &e) {
+	std::cerr << "C++ exception: " << e.what() << '\n';
+	return 1;
+}
+catch (...) {
+	std::cerr << "Unknown exception\n";
+	return 1;
+}
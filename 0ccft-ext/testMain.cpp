@@ -9,8 +9,28 @@
 
 #include "FamiTrackerDocIO.h"
 #include "DocumentFile.h"
+#include "AtomicFile.h"
+#include "ModuleJournal.h"
+#include "ModuleMerger.h"
+#include "SongData.h"
+#include "PatternNote.h"
+#include "InstrumentManager.h"
+#include "DSampleManager.h"
+#include "Instrument2A03.h"
+#include "ft0cc/doc/dpcm_sample.hpp"
+#include "ft0cc/doc/groove.hpp"
+#include "Sequence.h"
+#include "HeadlessPlayer.h"
+#include "APU/APU.h"
+#include "APU/RegisterTrace.h"
+#include "SoundChipSet.h"
 
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
 
 class CStdoutLog : public CCompilerLog {
 public:
@@ -20,6 +40,396 @@ public:
 	void Clear() override { }
 };
 
+namespace {
+
+std::vector<unsigned char> ReadFile(const fs::path &Path) {
+	std::ifstream file {Path, std::ios::in | std::ios::binary};
+	return {std::istreambuf_iterator<char> {file}, std::istreambuf_iterator<char> { }};
+}
+
+std::vector<unsigned char> SaveImage(const CFamiTrackerModule &modfile) {
+	CDocumentFile file;
+	file.OpenBuffer();
+	if (!CFamiTrackerDocIO {file, module_error_level_t::MODULE_ERROR_DEFAULT}.Save(modfile))
+		throw std::runtime_error {"Cannot save module"};
+	return file.ReleaseBuffer();
+}
+
+// only changes to the sample table make the instrument chunks dirty, not reading a sample
+void TestDSampleDirty() {
+	CFamiTrackerModule modfile;
+	auto &manager = *modfile.GetInstrumentManager();
+	const auto Check = [&] (bool Dirty, const char *what) {
+		if (manager.IsDirty() != Dirty)
+			throw std::runtime_error {std::string {"Instrument manager dirty flag is wrong after "} + what};
+		manager.ClearDirty();
+	};
+	manager.ClearDirty();
+
+	auto pSample = std::make_shared<ft0cc::doc::dpcm_sample>(std::vector<ft0cc::doc::dpcm_sample::sample_t>(16, 0xAA), "snare");
+	manager.SetDSample(0, pSample);
+	Check(true, "SetDSample");
+	(void)manager.GetDSample(0);
+	(void)manager.GetDSample(1);
+	Check(false, "GetDSample");
+	manager.SetDSample(0, pSample);
+	Check(false, "setting the same sample");
+	manager.GetDSampleManager()->RemoveDSample(1);
+	Check(false, "removing an empty slot");
+	manager.GetDSampleManager()->RemoveDSample(0);
+	Check(true, "RemoveDSample");
+}
+
+// replays the journal and checks that it merges into the module as saved now
+void CheckReplay(const fs::path &journal, const CFamiTrackerModule &modfile, const std::string &what) {
+	if (CModuleJournal::Replay(journal) != SaveImage(modfile))
+		throw std::runtime_error {"Journal replay differs from the saved module: " + what};
+}
+
+void TestJournal() {
+	CFamiTrackerModule modfile;
+	modfile.SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(sound_chip_t::APU, 0));
+	Kraid { }(modfile);
+	// keeps the small edits below the size limit
+	modfile.SetComment(std::string(0x10000, '.'), false);
+
+	const fs::path Path = "journal.bin";
+	CModuleJournal journal;
+	std::size_t SnapshotSize = 0;
+	std::size_t JournalSize = 0;
+	unsigned Deltas = 0;
+
+	// commits, writes and replays the changes, checking when the journal starts over
+	const auto Commit = [&] (bool ExpectSnapshot, const std::string &what) {
+		auto commit = journal.Commit(modfile, module_error_level_t::MODULE_ERROR_DEFAULT);
+		if (!commit)
+			throw std::runtime_error {"Journal has no changes: " + what};
+		if (commit->Snapshot != ExpectSnapshot)
+			throw std::runtime_error {"Journal " + std::string {ExpectSnapshot ? "did not start" : "started"} + " over: " + what};
+		CModuleJournal::Write(Path, *commit);
+		if (commit->Snapshot) {
+			SnapshotSize = JournalSize = commit->Data.size();
+			Deltas = 0;
+		}
+		else {
+			JournalSize += commit->Data.size();
+			++Deltas;
+		}
+		if (fs::file_size(Path) != JournalSize)
+			throw std::runtime_error {"Journal file has the wrong size: " + what};
+		CheckReplay(Path, modfile, what);
+	};
+
+	auto &song = *modfile.GetSong(0);
+	const unsigned Rows = song.GetPatternLength();
+
+	Commit(true, "initial commit");
+	if (journal.Commit(modfile, module_error_level_t::MODULE_ERROR_DEFAULT))
+		throw std::runtime_error {"Journal commits an unchanged module"};
+
+	// small edits roll over after 256 commits
+	for (unsigned i = 0; i <= 256; ++i) {
+		stChanNote note;
+		note.Note = note_t::C;
+		note.Octave = i % 8;
+		note.Vol = i % MAX_VOLUME;
+		song.SetPatternData(apu_subindex_t::pulse1, i / Rows % 4, i % Rows, note);
+		if (i == 100)
+			modfile.SetModuleName("journal");
+		Commit(i == 256, "small edit " + std::to_string(i));
+	}
+	if (Deltas != 0)
+		throw std::runtime_error {"Journal did not start over after 256 commits"};
+
+	// large edits roll over once the journal is 4 times as large as its snapshot
+	for (unsigned i = 0; ; ++i) {
+		if (i == 256)
+			throw std::runtime_error {"Journal never outgrew its snapshot"};
+		const bool Outgrown = JournalSize > SnapshotSize * 4;
+		modfile.SetComment(std::string(0x10000, static_cast<char>('a' + i % 26)), false);
+		Commit(Outgrown, "large edit " + std::to_string(i));
+		if (Outgrown)
+			break;
+	}
+
+	std::error_code ec;
+	fs::remove(Path, ec);
+}
+
+// Writes modules the way autosave does: serialized in memory, then written with WriteFileAtomic
+// over a previous version of the file. Saving to memory must give the same bytes as a regular
+// save, and the written module must load back into one that saves to the same bytes.
+void TestAtomicSave(const CFamiTrackerModule &modfile, const fs::path &Expected) {
+	if (SaveImage(modfile) != ReadFile(Expected))
+		throw std::runtime_error {"Saving to memory differs from saving to a file"};
+
+	CFamiTrackerModule vrc7;
+	vrc7.SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(sound_chip_t::VRC7, 0));
+	vrc7.SetModuleName("autosave");
+	stChanNote note;
+	note.Note = note_t::C;
+	note.Octave = 4;
+	note.Instrument = 0;
+	note.Effects[0] = {effect_t::VRC7_PORT, 0x12};
+	vrc7.GetSong(0)->SetPatternData(vrc7_subindex_t::ch3, 0, 5, note);
+	const auto Image = SaveImage(vrc7);
+
+	const fs::path Path = "autosave.0cc";
+	WriteFileAtomic(Path, std::vector<unsigned char>(Image.size() * 2, 0xFF));
+	WriteFileAtomic(Path, Image);
+	if (ReadFile(Path) != Image)
+		throw std::runtime_error {"WriteFileAtomic did not replace the file"};
+	if (fs::exists(fs::path {Path} += ".tmp"))
+		throw std::runtime_error {"WriteFileAtomic left its temporary file behind"};
+
+	CDocumentFile file;
+	file.Open(Path, std::ios::in | std::ios::binary);
+	file.ValidateFile();
+	CFamiTrackerModule loaded;
+	if (!CFamiTrackerDocIO {file, module_error_level_t::MODULE_ERROR_DEFAULT}.Load(loaded))
+		throw std::runtime_error {"Cannot load the autosaved module"};
+	file.Close();
+	if (SaveImage(loaded) != Image)
+		throw std::runtime_error {"Autosaved module does not load back to the same module"};
+	fs::remove(Path);
+}
+
+std::string WriteJsonText(const CFamiTrackerModule &modfile) {
+	std::ostringstream ss;
+	WriteModuleJson(ss, modfile);
+	return ss.str();
+}
+
+void TestJsonRoundTrip() {
+	CFamiTrackerModule modfile;
+	modfile.SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(sound_chip_t::APU, 0));
+	Kraid { }(modfile);
+
+	auto *pManager = modfile.GetInstrumentManager();
+	pManager->SetDSample(3, std::make_shared<ft0cc::doc::dpcm_sample>(std::vector<ft0cc::doc::dpcm_sample::sample_t>(64, 0x55), "kick"));
+	auto pInst = std::dynamic_pointer_cast<CInstrument2A03>(pManager->GetInstrument(0));
+	if (!pInst)
+		throw std::runtime_error {"Kraid has no 2A03 instrument 0"};
+	pInst->SetSampleIndex(36, 3);
+	pInst->SetSamplePitch(36, 0xC);
+	pInst->SetSampleLoop(36, true);
+	pInst->SetSampleDeltaValue(36, 0x40);
+
+	const std::pair<json_format_t, const char *> FORMATS[] = {
+		{json_format_t::text, "text"},
+		{json_format_t::cbor, "CBOR"},
+		{json_format_t::msgpack, "msgpack"},
+	};
+	for (auto [fmt, name] : FORMATS) {
+		const std::string Expected = WriteJsonText(modfile);
+		std::stringstream ss;
+		WriteModuleJson(ss, modfile, fmt);
+		CFamiTrackerModule loaded;
+		ReadModuleJson(ss, loaded, fmt);
+
+		const auto *pLoaded = loaded.GetInstrumentManager();
+		if (pLoaded->GetInstrumentCount() != pManager->GetInstrumentCount())
+			throw std::runtime_error {std::string {"Instruments lost in "} + name + " round trip"};
+		for (int i = 0; i < CInstrumentManager::MAX_INSTRUMENTS; ++i)
+			if (auto pOld = pManager->GetInstrument(i)) {
+				auto pNew = pLoaded->GetInstrument(i);
+				if (!pNew || pNew->GetType() != pOld->GetType() || pNew->GetName() != pOld->GetName())
+					throw std::runtime_error {std::string {"Instrument "} + std::to_string(i) + " differs after " + name + " round trip"};
+			}
+		if (WriteJsonText(loaded) != Expected)
+			throw std::runtime_error {std::string {"Module differs after "} + name + " round trip"};
+		if (SaveImage(loaded) != SaveImage(modfile))
+			throw std::runtime_error {std::string {"Saved module differs after "} + name + " round trip"};
+	}
+}
+
+std::unique_ptr<CFamiTrackerModule> MakeMergeModule() {
+	auto pModule = std::make_unique<CFamiTrackerModule>();
+	pModule->SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(sound_chip_t::APU, 0));
+	Kraid { }(*pModule);
+	pModule->SetGroove(0, std::make_shared<ft0cc::doc::groove>(ft0cc::doc::groove {6, 6}));
+	return pModule;
+}
+
+void TestMerge() {
+	// two copies of Kraid, and one whose instrument 0 uses a changed sequence and O05 on a new groove
+	auto pTarget = MakeMergeModule();
+	auto pCopy = MakeMergeModule();
+	auto pVariant = MakeMergeModule();
+	pVariant->GetInstrumentManager()->GetSequence(INST_2A03, sequence_t::Volume, 0)->SetItem(0, 9);
+	pVariant->SetGroove(5, std::make_shared<ft0cc::doc::groove>(ft0cc::doc::groove {5, 7}));
+	stChanNote note;
+	note.Note = note_t::C;
+	note.Octave = 3;
+	note.Instrument = 0;
+	note.Effects[0] = {effect_t::GROOVE, 5};
+	pVariant->GetSong(0)->SetPatternData(apu_subindex_t::pulse1, 0, 0, note);
+
+	CModuleMerger merger {*pTarget};
+	merger.AddModule(*pCopy);
+	merger.AddModule(*pVariant);
+	const stMergeReport &report = merger.Plan();
+	if (report.Songs != 3 || report.Instruments != 4 || report.Sequences != 4 || report.Samples != 0 || report.Grooves != 2)
+		throw std::runtime_error {"Merge report counts the wrong number of resources"};
+	if (report.SharedInstruments != 5 || report.SharedSequences != 5 || report.SharedSamples != 0 || report.SharedGrooves != 2)
+		throw std::runtime_error {"Merge report counts the wrong number of shared resources"};
+	if (!merger.Merge())
+		throw std::runtime_error {"Merge failed"};
+	if (pTarget->GetSongCount() != 3 || pTarget->GetInstrumentManager()->GetInstrumentCount() != 4 || pTarget->GetGrooveCount() != 2)
+		throw std::runtime_error {"Merged module has the wrong number of resources"};
+	const auto merged = pTarget->GetSong(2)->GetPatternData(apu_subindex_t::pulse1, 0, 0);
+	if (merged.Instrument != 3 || merged.Effects[0].fx != effect_t::GROOVE || merged.Effects[0].param != 1)
+		throw std::runtime_error {"Merged pattern data is not remapped"};
+	if (pTarget->GetSong(1)->GetPatternData(apu_subindex_t::pulse1, 0, 0).Instrument != pTarget->GetSong(0)->GetPatternData(apu_subindex_t::pulse1, 0, 0).Instrument)
+		throw std::runtime_error {"Shared instruments are not reused"};
+
+	// too many songs, nothing may change
+	auto pSmall = MakeMergeModule();
+	auto pLarge = MakeMergeModule();
+	for (unsigned i = 1; i < MAX_TRACKS; ++i)
+		pLarge->InsertSong(i, pLarge->MakeNewSong());
+	const auto SmallImage = SaveImage(*pSmall);
+	const auto LargeImage = SaveImage(*pLarge);
+	CModuleMerger overflow {*pSmall};
+	overflow.AddModule(*pLarge);
+	if (overflow.Plan().Fits() || overflow.Merge())
+		throw std::runtime_error {"Merge accepted too many songs"};
+	if (SaveImage(*pSmall) != SmallImage || SaveImage(*pLarge) != LargeImage)
+		throw std::runtime_error {"Failed merge changed a module"};
+}
+
+// effect names are shared between chips, so the reader must translate them with each track's chip
+void TestJsonExpansionEffects() {
+	const CSoundChipSet chips = CSoundChipSet {sound_chip_t::APU}.WithChip(sound_chip_t::FDS)
+		.WithChip(sound_chip_t::VRC7).WithChip(sound_chip_t::N163).WithChip(sound_chip_t::S5B);
+	CFamiTrackerModule modfile;
+	modfile.SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(chips, 4));
+
+	const std::pair<stChannelID, stEffectCommand> EFFECTS[] = {
+		{fds_subindex_t::wave, {effect_t::FDS_MOD_DEPTH, 0x21}},
+		{fds_subindex_t::wave, {effect_t::FDS_MOD_BIAS, 0x90}},
+		{vrc7_subindex_t::ch1, {effect_t::VRC7_PORT, 0x03}},
+		{vrc7_subindex_t::ch2, {effect_t::VRC7_WRITE, 0x15}},
+		{n163_subindex_t::ch1, {effect_t::N163_WAVE_BUFFER, 0x7F}},
+		{s5b_subindex_t::square1, {effect_t::SUNSOFT_ENV_TYPE, 0x0E}},
+		{s5b_subindex_t::square2, {effect_t::SUNSOFT_NOISE, 0x1F}},
+	};
+	CSongData &song = *modfile.GetSong(0);
+	unsigned row = 0;
+	for (const auto &[ch, fx] : EFFECTS) {
+		stChanNote note;
+		note.Effects[0] = fx;
+		song.SetPatternData(ch, 0, row++, note);
+	}
+
+	const std::pair<json_format_t, const char *> FORMATS[] = {
+		{json_format_t::text, "text"},
+		{json_format_t::cbor, "CBOR"},
+		{json_format_t::msgpack, "msgpack"},
+	};
+	for (auto [fmt, name] : FORMATS) {
+		std::stringstream ss;
+		WriteModuleJson(ss, modfile, fmt);
+		CFamiTrackerModule loaded;
+		ReadModuleJson(ss, loaded, fmt);
+
+		const CSongData &loadedSong = *loaded.GetSong(0);
+		row = 0;
+		for (const auto &[ch, fx] : EFFECTS)
+			if (loadedSong.GetPatternData(ch, 0, row++).Effects[0] != fx)
+				throw std::runtime_error {std::string {"Expansion chip effect differs after "} + name + " round trip"};
+	}
+}
+
+// collects the audio of a register trace playback
+class CTraceAudio : public IAudioCallback {
+public:
+	void FlushBuffer(array_view<int16_t> Buffer) override {
+		audio_.insert(audio_.end(), Buffer.begin(), Buffer.end());
+	}
+	bool PlayBuffer() override {
+		return true;
+	}
+
+	std::vector<int16_t> audio_;
+};
+
+std::vector<int16_t> ReplayTrace(const CRegisterTrace &trace, unsigned Rate) {
+	CTraceAudio cb;
+	CAPU apu {&cb};
+	apu.SetupSound(CHeadlessPlayer::DEFAULT_SAMPLE_RATE, 1, trace.GetMachine());
+	apu.SetupMixer(30, 12000, 24, 100);		// the filter settings of CHeadlessPlayer
+	apu.SetExternalSound(trace.GetChips());
+	apu.ChangeMachineRate(trace.GetMachine(), Rate);
+	CRegisterTracePlayer player {trace, apu};
+	while (player.PlayFrame())
+		;
+	return cb.audio_;
+}
+
+// records a render of Kraid with DPCM notes, then plays the trace back on a separate APU, both
+// directly and after a save and load, which must reproduce the audio sample for sample
+void TestRegisterTrace() {
+	CFamiTrackerModule modfile;
+	modfile.SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(sound_chip_t::APU, 0));
+	Kraid { }(modfile);
+
+	auto *pManager = modfile.GetInstrumentManager();
+	std::vector<ft0cc::doc::dpcm_sample::sample_t> data(0x101);
+	for (std::size_t i = 0; i < data.size(); ++i)
+		data[i] = static_cast<ft0cc::doc::dpcm_sample::sample_t>(i * 0x35 ^ 0x5A);
+	pManager->SetDSample(0, std::make_shared<ft0cc::doc::dpcm_sample>(std::move(data), "trace"));
+	auto pInst = std::dynamic_pointer_cast<CInstrument2A03>(pManager->GetInstrument(0));
+	if (!pInst)
+		throw std::runtime_error {"Kraid has no 2A03 instrument 0"};
+	stChanNote note;
+	note.Note = note_t::C;
+	note.Octave = 3;
+	note.Instrument = 0;
+	pInst->SetSampleIndex(note.ToMidiNote(), 0);
+	pInst->SetSamplePitch(note.ToMidiNote(), 0xF);
+	for (unsigned row = 0; row < 16; row += 4)
+		modfile.GetSong(0)->SetPatternData(apu_subindex_t::dpcm, 0, row, note);
+
+	constexpr unsigned FRAMES = 300;
+	CRegisterTrace trace {modfile.GetMachine(), modfile.GetSoundChipSet()};
+	CHeadlessPlayer player {modfile};
+	player.GetAPU().SetRegisterTrace(&trace);
+	player.StartPlayer(0);
+	std::vector<int16_t> Expected;
+	for (unsigned f = 0; f < FRAMES && player.RenderFrame(); ++f) {
+		const auto &audio = player.GetFrameAudio();
+		Expected.insert(Expected.end(), audio.begin(), audio.end());
+	}
+	player.GetAPU().SetRegisterTrace(nullptr);
+
+	bool HasSample = false;
+	CRegisterTrace::event_t Event;
+	for (std::size_t Pos = 0; trace.ReadEvent(Pos, Event); )
+		if (Event.Type == CRegisterTrace::event_type_t::sample)
+			HasSample = true;
+	if (trace.GetFrameCount() != FRAMES || !HasSample)
+		throw std::runtime_error {"Register trace is missing frames or DPCM sample events"};
+
+	const unsigned Rate = modfile.GetFrameRate();
+	if (ReplayTrace(trace, Rate) != Expected)
+		throw std::runtime_error {"Register trace playback differs from the recorded render"};
+
+	const fs::path Path = "kraid.trace";
+	trace.Save(Path);
+	CRegisterTrace loaded;
+	loaded.Load(Path);
+	if (loaded.GetFrameCount() != FRAMES || loaded.GetMachine() != trace.GetMachine() || loaded.GetChips() != trace.GetChips())
+		throw std::runtime_error {"Loaded register trace has the wrong header"};
+	if (ReplayTrace(loaded, Rate) != Expected)
+		throw std::runtime_error {"Loaded register trace playback differs from the recorded render"};
+
+	std::error_code ec;
+	fs::remove(Path, ec);
+}
+
+} // namespace
+
 int main() try {
 	CFamiTrackerModule modfile;
 	modfile.SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(sound_chip_t::APU, 0));
@@ -31,15 +441,31 @@ int main() try {
 	compiler.ExportNSF(nsffile, 0);
 	nsffile.Close();
 
-	auto j = nlohmann::json(modfile);
-//	std::cout << j.dump(2) << '\n';
-	std::ofstream("kraid.json", std::ios::out) << j.dump() << '\n';
+	{
+		std::ofstream jsonfile("kraid.json", std::ios::out);
+		WriteModuleJson(jsonfile, modfile);
+		jsonfile << '\n';
+	}
+	{
+		std::ofstream cborfile("kraid.cbor", std::ios::out | std::ios::binary);
+		WriteModuleJson(cborfile, modfile, json_format_t::cbor);
+		std::ofstream msgpackfile("kraid.msgpack", std::ios::out | std::ios::binary);
+		WriteModuleJson(msgpackfile, modfile, json_format_t::msgpack);
+	}
 
 	CDocumentFile outfile;
 	outfile.Open("kraid.0cc", std::ios::out | std::ios::binary);
 	CFamiTrackerDocIO io {outfile, module_error_level_t::MODULE_ERROR_DEFAULT};
 	io.Save(modfile);
 	outfile.Close();
+
+	TestAtomicSave(modfile, "kraid.0cc");
+	TestDSampleDirty();
+	TestJournal();
+	TestJsonRoundTrip();
+	TestJsonExpansionEffects();
+	TestRegisterTrace();
+	TestMerge();
 }
 catch (std::exception &e) {
 	std::cerr << "C++ exception: " << e.what() << '\n';
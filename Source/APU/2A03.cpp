@@ -137,6 +137,26 @@ double C2A03::GetFreq(int Channel) const		// // //
 	return 0.0;
 }
 
+void C2A03::SaveState(apu_state_t &State) const		// // //
+{
+	m_Square1.SaveState(State);
+	m_Square2.SaveState(State);
+	m_Triangle.SaveState(State);
+	m_Noise.SaveState(State);
+	m_DPCM.SaveState(State);
+	AppendState(State, m_iFrameSequence, m_iFrameMode);
+}
+
+void C2A03::LoadState(const apu_state_t &State, std::size_t &Pos)		// // //
+{
+	m_Square1.LoadState(State, Pos);
+	m_Square2.LoadState(State, Pos);
+	m_Triangle.LoadState(State, Pos);
+	m_Noise.LoadState(State, Pos);
+	m_DPCM.LoadState(State, Pos);
+	ReadState(State, Pos, m_iFrameSequence, m_iFrameMode);
+}
+
 void C2A03::ClockSequence()
 {
 	if (m_iFrameMode == 0) {
@@ -231,16 +251,22 @@ inline void C2A03::RunAPU2(uint32_t Time)
 	}
 }
 
-void C2A03::WriteSample(std::shared_ptr<const ft0cc::doc::dpcm_sample> pSample) {		// // //
+void C2A03::WriteSample(std::shared_ptr<const ft0cc::doc::dpcm_sample> pSample,
+	std::shared_ptr<const std::atomic<std::size_t>> pProgress) {		// // //
 	// Sample may not be removed when used by the sample memory class!
 	preview_sample_ = std::move(pSample);
-	m_DPCM.GetSampleMemory().SetMem(*preview_sample_);
+	preview_progress_ = std::move(pProgress);
+	m_DPCM.GetSampleMemory().SetMem(*preview_sample_, preview_progress_.get());
 }
 
 void C2A03::ClearSample() {		// // //
 	m_DPCM.GetSampleMemory().Clear();
 }
 
+const std::shared_ptr<const ft0cc::doc::dpcm_sample> &C2A03::GetSample() const {		// // //
+	return preview_sample_;
+}
+
 uint8_t C2A03::GetSamplePos() const
 {
 	return m_DPCM.GetSamplePos();
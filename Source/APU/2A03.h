@@ -29,6 +29,8 @@ class dpcm_sample;
 } // namespace ft0cc::doc
 
 #include <memory>		// // //
+#include <atomic>		// // //
+#include <cstddef>		// // //
 #include "APU/SoundChip.h"
 #include "APU/Channel.h"
 
@@ -52,14 +54,20 @@ public:
 	uint8_t Read(uint16_t Address, bool &Mapped) override;
 
 	double GetFreq(int Channel) const override;		// // //
+	void SaveState(apu_state_t &State) const override;		// // //
+	void LoadState(const apu_state_t &State, std::size_t &Pos) override;		// // //
 
 public:
 	void	ClockSequence();		// // //
 
 	void	ChangeMachine(machine_t Machine);
 
-	void	WriteSample(std::shared_ptr<const ft0cc::doc::dpcm_sample> pSample);		// // //
+	// // // pProgress, if given, counts the bytes of a sample still being written, and the sample
+	// memory stops reading there; the chip keeps both pointers while the sample is in use
+	void	WriteSample(std::shared_ptr<const ft0cc::doc::dpcm_sample> pSample,
+		std::shared_ptr<const std::atomic<std::size_t>> pProgress = nullptr);
 	void	ClearSample();		// // //
+	const std::shared_ptr<const ft0cc::doc::dpcm_sample> &GetSample() const;		// // //
 	uint8_t	GetSamplePos() const;
 	uint8_t	GetDeltaCounter() const;
 	bool	DPCMPlaying() const;
@@ -83,4 +91,5 @@ private:
 	uint8_t		m_iFrameMode = 0;			// 4 or 5-steps frame sequence
 
 	std::shared_ptr<const ft0cc::doc::dpcm_sample> preview_sample_;		// // //
+	std::shared_ptr<const std::atomic<std::size_t>> preview_progress_;		// // //
 };
@@ -26,3 +26,13 @@
 uint16_t C2A03Chan::GetPeriod() const {
 	return m_iPeriod;
 }
+
+void C2A03Chan::SaveState(apu_state_t &State) const {		// // //
+	CChannel::SaveState(State);
+	AppendState(State, m_iControlReg, m_iEnabled, m_iPeriod, m_iLengthCounter, m_iCounter);
+}
+
+void C2A03Chan::LoadState(const apu_state_t &State, std::size_t &Pos) {		// // //
+	CChannel::LoadState(State, Pos);
+	ReadState(State, Pos, m_iControlReg, m_iEnabled, m_iPeriod, m_iLengthCounter, m_iCounter);
+}
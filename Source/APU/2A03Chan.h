@@ -30,6 +30,8 @@ public:
 	using CChannel::CChannel;		// // //
 
 	uint16_t GetPeriod() const;
+	void SaveState(apu_state_t &State) const;		// // //
+	void LoadState(const apu_state_t &State, std::size_t &Pos);		// // //
 
 	static constexpr unsigned SEQUENCER_FREQUENCY = 240;
 
@@ -42,9 +44,9 @@ public:
 
 protected:
 	// Variables used by channels
-	uint8_t		m_iControlReg;
-	uint8_t		m_iEnabled;
-	uint16_t	m_iPeriod;
-	uint16_t	m_iLengthCounter;
-	uint32_t	m_iCounter;
+	uint8_t		m_iControlReg = 0;		// // //
+	uint8_t		m_iEnabled = 0;
+	uint16_t	m_iPeriod = 0;
+	uint16_t	m_iLengthCounter = 0;
+	uint32_t	m_iCounter = 0;
 };
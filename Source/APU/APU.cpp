@@ -31,11 +31,13 @@
 #include "FamiTrackerEnv.h"		// // //
 #include "SoundChipService.h"		// // //
 #include "RegisterState.h"		// // //
+#include "APU/RegisterTrace.h"		// // //
 #include "Assertion.h"		// // //
 
 CAPU::CAPU(IAudioCallback *pCallback) :		// // //
 	m_pMixer(std::make_unique<CMixer>()),		// // //
 	m_pParent(pCallback),
+	m_pRegisterHistory(std::make_unique<CRegisterHistory>()),		// // //
 	m_iSampleRate(44100),		// // //
 	m_iCyclesToRun(0),
 	m_iFrameCycles(0),
@@ -66,6 +68,15 @@ CAPU::~CAPU()
 // The amount of cycles that will be emulated is added by CAPU::AddCycles
 //
 void CAPU::Process()
+{
+	// // // writes are traced on their own; other stops are traced since the 2A03 mixes its channels
+	// in steps that begin here
+	if (m_pRegisterTrace && m_iCyclesToRun > 0)
+		m_pRegisterTrace->RecordProcess(m_iFrameCycles + m_iCyclesToRun);
+	RunCycles();
+}
+
+void CAPU::RunCycles()		// // //
 {
 	while (m_iCyclesToRun > 0) {
 
@@ -85,9 +96,7 @@ void CAPU::Process()
 
 void CAPU::StepSequence()		// // //
 {
-	if (++m_iSequencerCount == C2A03Chan::SEQUENCER_FREQUENCY)
-		m_iSequencerClock = m_iSequencerCount = 0;
-	m_iSequencerNext = (uint64_t)MASTER_CLOCK_NTSC * (m_iSequencerCount + 1) / C2A03Chan::SEQUENCER_FREQUENCY;
+	AdvanceSequence();
 
 	for (auto &c : m_pSoundChips)		// // //
 		if (auto *p2A03 = dynamic_cast<C2A03 *>(c.get()))
@@ -96,6 +105,52 @@ void CAPU::StepSequence()		// // //
 			pMMC5->ClockSequence();
 }
 
+void CAPU::AdvanceSequence()		// // //
+{
+	if (++m_iSequencerCount == C2A03Chan::SEQUENCER_FREQUENCY)
+		m_iSequencerClock = m_iSequencerCount = 0;
+	m_iSequencerNext = (uint64_t)MASTER_CLOCK_NTSC * (m_iSequencerCount + 1) / C2A03Chan::SEQUENCER_FREQUENCY;
+}
+
+// // // Ends a frame like EndFrame, but discards its audio without reading it from the mixer
+int CAPU::SkipFrame()
+{
+	for (auto *Chip : m_pActiveChips)
+		Chip->SkipFrame();
+
+	if (m_pRegisterTrace)
+		m_pRegisterTrace->RecordEndFrame(m_iFrameCycles);
+
+	int Samples = m_pMixer->SkipFrame(m_iFrameCycles);
+	m_iFrameCycles = 0;
+	return Samples;
+}
+
+void CAPU::SaveState(apu_state_t &State) const		// // //
+{
+	AppendState(State, m_iCyclesToRun, m_iFrameCycles, m_iSequencerClock, m_iSequencerNext, m_iSequencerCount);
+	for (auto *Chip : m_pActiveChips) {
+		AppendState(State, Chip->GetID());
+		Chip->SaveState(State);
+	}
+	m_pMixer->SaveState(State);
+}
+
+bool CAPU::LoadState(const apu_state_t &State)		// // //
+{
+	std::size_t Pos = 0;
+	ReadState(State, Pos, m_iCyclesToRun, m_iFrameCycles, m_iSequencerClock, m_iSequencerNext, m_iSequencerCount);
+	for (auto *Chip : m_pActiveChips) {
+		sound_chip_t ID;
+		ReadState(State, Pos, ID);
+		if (ID != Chip->GetID())
+			return false;
+		Chip->LoadState(State, Pos);
+	}
+	m_pMixer->LoadState(State, Pos);
+	return Pos == State.size();
+}
+
 // End of audio frame, flush the buffer if enough samples has been produced, and start a new frame
 void CAPU::EndFrame()
 {
@@ -104,6 +159,9 @@ void CAPU::EndFrame()
 	for (auto *Chip : m_pActiveChips)		// // //
 		Chip->EndFrame();
 
+	if (m_pRegisterTrace)		// // //
+		m_pRegisterTrace->RecordEndFrame(m_iFrameCycles);
+
 	int SamplesAvail = m_pMixer->FinishBuffer(m_iFrameCycles);
 	int ReadSamples	= m_pMixer->ReadBuffer(SamplesAvail, m_pSoundBuffer.get(), m_bStereoEnabled);
 	if (m_pParent)		// // //
@@ -113,6 +171,7 @@ void CAPU::EndFrame()
 
 	for (auto *r : m_pActiveChips)		// // //
 		r->GetRegisterLogger().Step();
+	PushRegisterSnapshot();		// // //
 
 #ifdef LOGGING
 	++m_iFrame;
@@ -131,6 +190,9 @@ void CAPU::Reset()
 	m_iCyclesToRun		= 0;
 	m_iFrameCycles		= 0;
 
+	if (m_pRegisterTrace)		// // //
+		m_pRegisterTrace->RecordReset();
+
 	for (auto &c : m_pSoundChips)		// // //
 		if (auto *p2A03 = dynamic_cast<C2A03 *>(c.get()))
 			p2A03->ClearSample();
@@ -140,6 +202,9 @@ void CAPU::Reset()
 		Chip->Reset();
 	}
 
+	m_pRegisterHistory->Clear();		// // //
+	PushRegisterSnapshot();
+
 	m_pMixer->ClearBuffer();
 
 #ifdef LOGGING
@@ -161,6 +226,10 @@ void CAPU::SetCallback(IAudioCallback &pCallback) {
 	m_pParent = &pCallback;
 }
 
+void CAPU::SetRegisterTrace(CRegisterTrace *pTrace) {
+	m_pRegisterTrace = pTrace;
+}
+
 void CAPU::SetExternalSound(CSoundChipSet Chip) {
 	// Set expansion chip
 	m_iExternalSoundChip = Chip;
@@ -230,7 +299,10 @@ void CAPU::Write(uint16_t Address, uint8_t Value)
 {
 	// Data was written to an external sound chip
 
-	Process();
+	RunCycles();		// // //
+
+	if (m_pRegisterTrace)		// // //
+		TraceWrite(Address, Value);
 
 	for (auto *Chip : m_pActiveChips)		// // //
 		Chip->Write(Address, Value);
@@ -353,6 +425,16 @@ void CAPU::LogWrite(uint16_t Address, uint8_t Value)
 		r->Log(Address, Value);
 }
 
+void CAPU::TraceWrite(uint16_t Address, uint8_t Value)		// // //
+{
+	// DPCM sample memory is set outside the register interface; check for a new sample whenever
+	// the DPCM channel may be (re)started
+	if (Address >= 0x4010 && Address <= 0x4015)
+		if (auto *p2A03 = dynamic_cast<C2A03 *>(GetSoundChip(sound_chip_t::APU)))
+			m_pRegisterTrace->RecordSample(m_iFrameCycles, p2A03->GetSample());
+	m_pRegisterTrace->RecordWrite(m_iFrameCycles, Address, Value);
+}
+
 uint8_t CAPU::GetReg(sound_chip_t Chip, int Reg) const
 {
 	if (auto *r = GetRegState(Chip, Reg))		// // //
@@ -371,3 +453,16 @@ CRegisterState *CAPU::GetRegState(sound_chip_t Chip, int Reg) const		// // //
 	const CSoundChip *pChip = GetSoundChip(Chip);
 	return pChip ? pChip->GetRegisterLogger().GetRegister(Reg) : nullptr;
 }
+
+std::shared_ptr<const CRegisterSnapshot> CAPU::GetRegisterSnapshot(unsigned FramesBack) const		// // //
+{
+	return m_pRegisterHistory->Get(FramesBack);
+}
+
+void CAPU::PushRegisterSnapshot()		// // //
+{
+	auto pSnapshot = std::make_shared<CRegisterSnapshot>();
+	for (auto *r : m_pActiveChips)
+		pSnapshot->AddChip(r->GetID(), r->GetRegisterLogger());
+	m_pRegisterHistory->Push(std::move(pSnapshot));
+}
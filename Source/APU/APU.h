@@ -30,6 +30,7 @@
 #include <vector>		// // //
 #include "SoundChipSet.h"		// // //
 #include "APUInterface.h"		// // //
+#include "APUState.h"		// // //
 
 namespace ft0cc::doc {
 class dpcm_sample;
@@ -37,6 +38,9 @@ class dpcm_sample;
 class CMixer;		// // //
 class CSoundChip;		// // //
 class CRegisterState;		// // //
+class CRegisterSnapshot;		// // //
+class CRegisterHistory;		// // //
+class CRegisterTrace;		// // //
 enum chip_level_t : unsigned char;		// // //
 
 #ifdef LOGGING
@@ -52,6 +56,7 @@ public:
 	void	Process();
 	void	AddTime(int32_t Cycles);
 	void	EndFrame();		// // // public
+	int		SkipFrame();		// // //
 
 	void	SetExternalSound(CSoundChipSet Chips);
 	void	Write(uint16_t Address, uint8_t Value) override;		// // //
@@ -61,11 +66,13 @@ public:
 	bool	SetupSound(int SampleRate, int NrChannels, machine_t Speed);		// // //
 	void	SetupMixer(int LowCut, int HighCut, int HighDamp, int Volume) const;
 	void	SetCallback(IAudioCallback &pCallback);		// // //
+	void	SetRegisterTrace(CRegisterTrace *pTrace);		// // // nullptr stops recording
 
 	int32_t	GetVol(stChannelID Chan) const;		// // //
 	uint8_t	GetReg(sound_chip_t Chip, int Reg) const;
 	double	GetFreq(sound_chip_t Chip, int Chan) const;		// // //
 	CRegisterState *GetRegState(sound_chip_t Chip, int Reg) const;		// // //
+	std::shared_ptr<const CRegisterSnapshot> GetRegisterSnapshot(unsigned FramesBack = 0) const;		// // //
 
 	void	SetChipLevel(chip_level_t Chip, float Level);
 
@@ -76,22 +83,35 @@ public:
 
 	CSoundChip *GetSoundChip(sound_chip_t Chip) const override;		// // //
 
+	// // // Appends the emulation state of the frame sequencer, the active chips and the mixer
+	void	SaveState(apu_state_t &State) const;
+	// // // Restores a state saved by an APU with the same chips and setup, between frames. The
+	// DPCM sample memory is restored by address, so the 2A03 must already use the same sample.
+	// Returns false if the state was saved with other chips
+	bool	LoadState(const apu_state_t &State);
+
 #ifdef LOGGING
 	void	Log();
 #endif
 
 private:
+	void RunCycles();		// // //
 	void StepSequence();		// // //
+	void AdvanceSequence();		// // //
+	void PushRegisterSnapshot();		// // //
 
 	void LogWrite(uint16_t Address, uint8_t Value);
+	void TraceWrite(uint16_t Address, uint8_t Value);		// // //
 
 private:
 	std::unique_ptr<CMixer> m_pMixer;		// // //
 	IAudioCallback *m_pParent;
+	CRegisterTrace *m_pRegisterTrace = nullptr;		// // //
 
 	// Expansion chips
 	std::vector<std::unique_ptr<CSoundChip>> m_pSoundChips;		// // //
 	std::vector<CSoundChip *> m_pActiveChips;		// // //
+	std::unique_ptr<CRegisterHistory> m_pRegisterHistory;		// // // register states at recent frame boundaries
 
 	CSoundChipSet m_iExternalSoundChip;				// // // External sound chip, if used
 
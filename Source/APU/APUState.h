@@ -0,0 +1,62 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// // // Emulation state of the sound chips and the mixer. Two APU instances whose states are
+// equal produce the same audio as long as they receive the same register writes. A state can
+// be loaded into another APU of the same process with the same chips and setup.
+using apu_state_t = std::vector<std::uint8_t>;
+
+// Appends the object representation of each value; values must not contain padding bytes.
+// Pointers only compare equal within the same process.
+template <typename... T>
+void AppendState(apu_state_t &State, const T &... Values) {
+	static_assert(((std::has_unique_object_representations_v<T> || std::is_floating_point_v<T>) && ...));
+	(State.insert(State.end(), reinterpret_cast<const std::uint8_t *>(&Values), reinterpret_cast<const std::uint8_t *>(&Values) + sizeof(T)), ...);
+}
+
+template <typename T>
+void AppendStateRange(apu_state_t &State, const T *Values, std::size_t Count) {
+	static_assert(std::has_unique_object_representations_v<T>);
+	State.insert(State.end(), reinterpret_cast<const std::uint8_t *>(Values), reinterpret_cast<const std::uint8_t *>(Values + Count));
+}
+
+// Reads back values in the order they were appended, starting from Pos which is advanced
+template <typename... T>
+void ReadState(const apu_state_t &State, std::size_t &Pos, T &... Values) {
+	static_assert(((std::has_unique_object_representations_v<T> || std::is_floating_point_v<T>) && ...));
+	((std::memcpy(&Values, State.data() + Pos, sizeof(T)), Pos += sizeof(T)), ...);
+}
+
+template <typename T>
+void ReadStateRange(const apu_state_t &State, std::size_t &Pos, T *Values, std::size_t Count) {
+	static_assert(std::has_unique_object_representations_v<T>);
+	std::memcpy(Values, State.data() + Pos, sizeof(T) * Count);
+	Pos += sizeof(T) * Count;
+}
@@ -32,6 +32,14 @@ void CChannel::EndFrame() {
 	m_iTime = 0;
 }
 
+void CChannel::SaveState(apu_state_t &State) const {		// // //
+	AppendState(State, m_iTime, m_iLastValue);
+}
+
+void CChannel::LoadState(const apu_state_t &State, std::size_t &Pos) {		// // //
+	ReadState(State, Pos, m_iTime, m_iLastValue);
+}
+
 stChannelID CChannel::GetChannelType() const {		// // //
 	return m_iChanId;
 }
@@ -25,6 +25,7 @@
 
 #include <cstdint>		// // //
 #include "APU/Types.h"		// // //
+#include "APU/APUState.h"		// // //
 
 class CMixer;
 
@@ -43,6 +44,9 @@ public:
 
 	virtual double GetFrequency() const = 0;		// // //
 
+	void SaveState(apu_state_t &State) const;		// // //
+	void LoadState(const apu_state_t &State, std::size_t &Pos);		// // //
+
 protected:
 	void Mix(int32_t Value);		// // //
 
@@ -181,6 +181,24 @@ void CDPCM::Process(uint32_t Time)
 	m_iTime += Time;
 }
 
+void CDPCM::SaveState(apu_state_t &State) const		// // //
+{
+	C2A03Chan::SaveState(State);
+	AppendState(State, m_iBitDivider, m_iShiftReg, m_iPlayMode, m_iDeltaCounter, m_iSampleBuffer,
+		m_iDMA_LoadReg, m_iDMA_LengthReg, m_iDMA_Address, m_iDMA_BytesRemaining,
+		m_bTriggeredIRQ, m_bSampleFilled, m_bSilenceFlag);
+	m_SampleMem.SaveState(State);
+}
+
+void CDPCM::LoadState(const apu_state_t &State, std::size_t &Pos)		// // //
+{
+	C2A03Chan::LoadState(State, Pos);
+	ReadState(State, Pos, m_iBitDivider, m_iShiftReg, m_iPlayMode, m_iDeltaCounter, m_iSampleBuffer,
+		m_iDMA_LoadReg, m_iDMA_LengthReg, m_iDMA_Address, m_iDMA_BytesRemaining,
+		m_bTriggeredIRQ, m_bSampleFilled, m_bSilenceFlag);
+	m_SampleMem.LoadState(State, Pos);
+}
+
 double CDPCM::GetFrequency() const		// // //
 {
 	if (!m_bSampleFilled && !m_iDMA_BytesRemaining)
@@ -37,6 +37,8 @@ public:
 	uint8_t	ReadControl() const;
 	void	Process(uint32_t Time);
 	double	GetFrequency() const;		// // //
+	void	SaveState(apu_state_t &State) const;		// // //
+	void	LoadState(const apu_state_t &State, std::size_t &Pos);		// // //
 
 	uint8_t	DidIRQ() const;
 	void	Reload();
@@ -55,9 +57,9 @@ public:
 private:
 	uint8_t	m_iBitDivider = 0;
 	uint8_t	m_iShiftReg = 0;
-	uint8_t	m_iPlayMode;
+	uint8_t	m_iPlayMode = 0;		// // //
 	uint8_t	m_iDeltaCounter = 0;
-	uint8_t	m_iSampleBuffer;
+	uint8_t	m_iSampleBuffer = 0;		// // //
 
 	uint16_t	m_iDMA_LoadReg = 0;
 	uint16_t	m_iDMA_LengthReg = 0;
@@ -66,7 +68,7 @@ private:
 
 	bool	m_bTriggeredIRQ = false;
 	bool	m_bSampleFilled = false;
-	bool	m_bSilenceFlag;
+	bool	m_bSilenceFlag = true;		// // //
 
 	// Needed by FamiTracker
 	CSampleMem	m_SampleMem;		// // //
@@ -81,6 +81,18 @@ void CFDS::Process(uint32_t Time)
 	}
 }
 
+void CFDS::SaveState(apu_state_t &State) const		// // //
+{
+	CChannel::SaveState(State);
+	emu_->SaveState(State);
+}
+
+void CFDS::LoadState(const apu_state_t &State, std::size_t &Pos)		// // //
+{
+	CChannel::LoadState(State, Pos);
+	emu_->LoadState(State, Pos);
+}
+
 double CFDS::GetFreq(int Channel) const		// // //
 {
 	if (Channel) return 0.;
@@ -46,6 +46,8 @@ public:
 
 	double	GetFreq(int Channel) const override;		// // //
 	double	GetFrequency() const { return GetFreq(0); }		// // //
+	void	SaveState(apu_state_t &State) const override;		// // //
+	void	LoadState(const apu_state_t &State, std::size_t &Pos) override;		// // //
 
 private:
 	std::unique_ptr<xgm::NES_FDS> emu_;		// // //
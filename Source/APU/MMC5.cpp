@@ -134,6 +134,20 @@ double CMMC5::GetFreq(int Channel) const		// // //
 	return 0.;
 }
 
+void CMMC5::SaveState(apu_state_t &State) const		// // //
+{
+	m_Square1.SaveState(State);
+	m_Square2.SaveState(State);
+	AppendState(State, m_iEXRAM, m_iMulLow, m_iMulHigh);
+}
+
+void CMMC5::LoadState(const apu_state_t &State, std::size_t &Pos)		// // //
+{
+	m_Square1.LoadState(State, Pos);
+	m_Square2.LoadState(State, Pos);
+	ReadState(State, Pos, m_iEXRAM, m_iMulLow, m_iMulHigh);
+}
+
 void CMMC5::LengthCounterUpdate()
 {
 	m_Square1.LengthCounterUpdate();
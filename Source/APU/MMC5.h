@@ -40,6 +40,8 @@ public:
 	uint8_t Read(uint16_t Address, bool &Mapped) override;
 
 	double GetFreq(int Channel) const override;		// // //
+	void SaveState(apu_state_t &State) const override;		// // //
+	void LoadState(const apu_state_t &State, std::size_t &Pos) override;		// // //
 
 	void LengthCounterUpdate();
 	void EnvelopeUpdate();
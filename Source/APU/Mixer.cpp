@@ -56,7 +56,6 @@
 #include <algorithm>		// // //
 #include <memory>
 #include <cmath>
-#include "APU/ext/emu2413.h"		// // //
 
 namespace {
 
@@ -257,6 +256,35 @@ void CMixer::ClearBuffer()
 	});
 }
 
+void CMixer::SaveState(apu_state_t &State) const		// // //
+{
+	levels2A03SS_.SaveState(State);
+	levels2A03TND_.SaveState(State);
+	levelsVRC6_.SaveState(State);
+	levelsFDS_.SaveState(State);
+	levelsMMC5_.SaveState(State);
+	levelsN163_.SaveState(State);
+	levelsS5B_.SaveState(State);
+	AppendState(State, BlipBuffer.offset_, BlipBuffer.reader_state());
+	AppendStateRange(State, BlipBuffer.buffer_, BlipBuffer.buffered_count());
+}
+
+void CMixer::LoadState(const apu_state_t &State, std::size_t &Pos)		// // //
+{
+	levels2A03SS_.LoadState(State, Pos);
+	levels2A03TND_.LoadState(State, Pos);
+	levelsVRC6_.LoadState(State, Pos);
+	levelsFDS_.LoadState(State, Pos);
+	levelsMMC5_.LoadState(State, Pos);
+	levelsN163_.LoadState(State, Pos);
+	levelsS5B_.LoadState(State, Pos);
+	decltype(BlipBuffer.offset_) Offset;
+	long Reader;
+	ReadState(State, Pos, Offset, Reader);
+	BlipBuffer.restore(Offset, Reader, State.data() + Pos);
+	Pos += BlipBuffer.buffered_count() * sizeof(Blip_Buffer::buf_t_);
+}
+
 int CMixer::SamplesAvail() const
 {
 	return (int)BlipBuffer.samples_avail();
@@ -266,16 +294,20 @@ int CMixer::FinishBuffer(int t)
 {
 	BlipBuffer.end_frame(t);
 
-	// Get channel levels for VRC7
-	for (std::size_t i = 0; i < MAX_CHANNELS_VRC7; ++i)
-		StoreChannelLevel(stChannelID {sound_chip_t::VRC7, static_cast<std::uint8_t>(i)}, OPLL_getchanvol(i));
-		
 	UpdateMeters();		// // //
 
 	// Return number of samples available
 	return BlipBuffer.samples_avail();
 }
 
+int CMixer::SkipFrame(int t)		// // //
+{
+	BlipBuffer.end_frame(t);
+	int Count = BlipBuffer.samples_avail();
+	BlipBuffer.remove_samples(Count);
+	return Count;
+}
+
 //
 // Mixing
 //
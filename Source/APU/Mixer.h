@@ -55,6 +55,9 @@ public:
 	void	SetClockRate(uint32_t Rate);
 	void	ClearBuffer();
 	int		FinishBuffer(int t);
+	int		SkipFrame(int t);		// // //
+	void	SaveState(apu_state_t &State) const;		// // //
+	void	LoadState(const apu_state_t &State, std::size_t &Pos);		// // //
 	int		SamplesAvail() const;
 	void	MixSamples(blip_sample_t *pBuffer, uint32_t Count);
 	uint32_t	GetMixSampleCount(int t) const;
@@ -71,9 +74,10 @@ public:
 	decay_rate_t GetMeterDecayRate() const;		// // // 050B
 	void	SetMeterDecayRate(decay_rate_t Rate);		// // // 050B
 
+	void	StoreChannelLevel(stChannelID Channel, int Level);		// // //
+
 private:
 	void UpdateMeters();		// // //
-	void StoreChannelLevel(stChannelID Channel, int Level);		// // //
 
 	float GetAttenuation() const;
 
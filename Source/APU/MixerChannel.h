@@ -24,6 +24,7 @@
 #pragma once
 
 #include "APU/Types.h"
+#include "APU/APUState.h"		// // //
 #include "Blip_Buffer/Blip_Buffer.h"
 
 class CMixerChannelBase {
@@ -60,6 +61,14 @@ public:
 		levels_ = LevelsT { };
 	}
 
+	void SaveState(apu_state_t &State) const {		// // //
+		AppendState(State, lastSum_, levels_);
+	}
+
+	void LoadState(const apu_state_t &State, std::size_t &Pos) {		// // //
+		ReadState(State, Pos, lastSum_, levels_);
+	}
+
 private:
 	LevelsT levels_;
 };
@@ -195,6 +195,22 @@ double CN163::GetFreq(int Channel) const		// // //
 	return m_Channels[7 - Channel].GetFrequency() / (m_iChansInUse + 1);
 }
 
+void CN163::SaveState(apu_state_t &State) const		// // //
+{
+	for (const auto &x : m_Channels)
+		x.SaveState(State);
+	AppendState(State, m_iWaveData, m_iExpandAddr, m_iChansInUse, m_iLastValue, m_iGlobalTime,
+		m_iChannelCntr, m_iActiveChan, m_iLastChan, m_iCycle, m_bOldMixing);
+}
+
+void CN163::LoadState(const apu_state_t &State, std::size_t &Pos)		// // //
+{
+	for (auto &x : m_Channels)
+		x.LoadState(State, Pos);
+	ReadState(State, Pos, m_iWaveData, m_iExpandAddr, m_iChansInUse, m_iLastValue, m_iGlobalTime,
+		m_iChannelCntr, m_iActiveChan, m_iLastChan, m_iCycle, m_bOldMixing);
+}
+
 uint8_t CN163::Read(uint16_t Address, bool &Mapped)
 {
 	uint16_t ReadAddr;
@@ -377,6 +393,20 @@ void CN163Chan::ResetCounter()
 	m_iCounter = 0;
 }
 
+void CN163Chan::SaveState(apu_state_t &State) const		// // //
+{
+	CChannel::SaveState(State);
+	AppendState(State, m_iCounter, m_iFrequency, m_iPhase, m_iWaveLength, m_iVolume,
+		m_iWaveOffset, m_iLastSample);
+}
+
+void CN163Chan::LoadState(const apu_state_t &State, std::size_t &Pos)		// // //
+{
+	CChannel::LoadState(State, Pos);
+	ReadState(State, Pos, m_iCounter, m_iFrequency, m_iPhase, m_iWaveLength, m_iVolume,
+		m_iWaveOffset, m_iLastSample);
+}
+
 double CN163Chan::GetFrequency() const		// // //
 {
 	return MASTER_CLOCK_NTSC / 983040. * m_iFrequency / (m_iWaveLength >> 16);
@@ -44,6 +44,8 @@ public:
 	uint8_t ReadMem(uint8_t Reg);
 	void ResetCounter();
 	double GetFrequency() const;		// // //
+	void SaveState(apu_state_t &State) const;		// // //
+	void LoadState(const apu_state_t &State, std::size_t &Pos);		// // //
 
 private:
 	uint32_t	m_iCounter, m_iFrequency;
@@ -76,6 +78,8 @@ public:
 	void Log(uint16_t Address, uint8_t Value) override;		// // //
 
 	double GetFreq(int Channel) const override;		// // //
+	void SaveState(apu_state_t &State) const override;		// // //
+	void LoadState(const apu_state_t &State, std::size_t &Pos) override;		// // //
 
 	void Mix(int32_t Value, uint32_t Time, stChannelID ChanID);		// // //
 	void SetMixingMethod(bool bLinear);		// // //
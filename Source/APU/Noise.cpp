@@ -127,6 +127,20 @@ double CNoise::GetFrequency() const		// // //
 	return Rate / m_iPeriod;
 }
 
+void CNoise::SaveState(apu_state_t &State) const		// // //
+{
+	C2A03Chan::SaveState(State);
+	AppendState(State, m_iLooping, m_iEnvelopeFix, m_iEnvelopeSpeed, m_iEnvelopeVolume,
+		m_iFixedVolume, m_iEnvelopeCounter, m_iSampleRate, m_iShiftReg);
+}
+
+void CNoise::LoadState(const apu_state_t &State, std::size_t &Pos)		// // //
+{
+	C2A03Chan::LoadState(State, Pos);
+	ReadState(State, Pos, m_iLooping, m_iEnvelopeFix, m_iEnvelopeSpeed, m_iEnvelopeVolume,
+		m_iFixedVolume, m_iEnvelopeCounter, m_iSampleRate, m_iShiftReg);
+}
+
 void CNoise::LengthCounterUpdate()
 {
 	if ((m_iLooping == 0) && (m_iLengthCounter > 0))
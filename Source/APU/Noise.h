@@ -41,6 +41,8 @@ public:
 	uint8_t	ReadControl();
 	void	Process(uint32_t Time);
 	double	GetFrequency() const;		// // //
+	void	SaveState(apu_state_t &State) const;		// // //
+	void	LoadState(const apu_state_t &State, std::size_t &Pos);		// // //
 
 	void	LengthCounterUpdate();
 	void	EnvelopeUpdate();
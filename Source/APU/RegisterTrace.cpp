@@ -0,0 +1,292 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+#include "APU/RegisterTrace.h"
+#include "APU/APU.h"
+#include "APU/2A03.h"
+#include "SimpleFile.h"
+#include "ft0cc/doc/dpcm_sample.hpp"
+#include <stdexcept>
+
+namespace {
+
+const char TRACE_HEADER_ID[] = "0CCTRACE";
+
+} // namespace
+
+CRegisterTrace::CRegisterTrace(machine_t Machine, CSoundChipSet Chips) :
+	m_iMachine(Machine), m_iChips(Chips)
+{
+}
+
+CRegisterTrace::~CRegisterTrace() = default;
+
+machine_t CRegisterTrace::GetMachine() const {
+	return m_iMachine;
+}
+
+CSoundChipSet CRegisterTrace::GetChips() const {
+	return m_iChips;
+}
+
+unsigned CRegisterTrace::GetFrameCount() const {
+	return m_iFrameCount;
+}
+
+std::size_t CRegisterTrace::GetSize() const {
+	return m_Events.size();
+}
+
+void CRegisterTrace::Clear() {
+	m_iFrameCount = 0u;
+	m_iLastCycle = 0u;
+	m_Events.clear();
+	m_pSamples.clear();
+}
+
+void CRegisterTrace::RecordWrite(std::uint32_t Cycle, std::uint16_t Address, std::uint8_t Value) {
+	PutEvent(event_type_t::write, Cycle);
+	m_Events.push_back(static_cast<std::uint8_t>(Address));
+	m_Events.push_back(static_cast<std::uint8_t>(Address >> 8));
+	m_Events.push_back(Value);
+}
+
+void CRegisterTrace::RecordEndFrame(std::uint32_t Cycle) {
+	PutEvent(event_type_t::end_frame, Cycle);
+	m_iLastCycle = 0u;
+	++m_iFrameCount;
+}
+
+void CRegisterTrace::RecordReset() {
+	PutEvent(event_type_t::reset, m_iLastCycle);
+	m_iLastCycle = 0u;
+}
+
+void CRegisterTrace::RecordProcess(std::uint32_t Cycle) {
+	PutEvent(event_type_t::process, Cycle);
+}
+
+void CRegisterTrace::RecordSample(std::uint32_t Cycle, const std::shared_ptr<const ft0cc::doc::dpcm_sample> &pSample) {
+	if (!pSample || (!m_pSamples.empty() && m_pSamples.back() == pSample))
+		return;
+	PutEvent(event_type_t::sample, Cycle);
+	PutVarInt(static_cast<std::uint32_t>(m_pSamples.size()));
+	m_pSamples.push_back(pSample);
+}
+
+void CRegisterTrace::PutEvent(event_type_t Type, std::uint32_t Cycle) {
+	// cycle stamps only go backward if the APU was reset without being traced
+	std::uint32_t Delta = Cycle >= m_iLastCycle ? Cycle - m_iLastCycle : 0u;
+	m_iLastCycle = Cycle;
+	PutHeader(Type, Delta);
+}
+
+void CRegisterTrace::PutHeader(event_type_t Type, std::uint32_t Delta) {
+	PutVarInt((Delta << TYPE_BITS) | static_cast<std::uint32_t>(Type));
+}
+
+void CRegisterTrace::PutVarInt(std::uint32_t Value) {
+	while (Value >= 0x80u) {
+		m_Events.push_back(static_cast<std::uint8_t>(Value | 0x80u));
+		Value >>= 7;
+	}
+	m_Events.push_back(static_cast<std::uint8_t>(Value));
+}
+
+bool CRegisterTrace::ReadEvent(std::size_t &Pos, event_t &Event) const {
+	return ReadEvent(m_Events, Pos, Event, TYPE_BITS);
+}
+
+bool CRegisterTrace::ReadEvent(const std::vector<std::uint8_t> &Events, std::size_t &Pos, event_t &Event, unsigned TypeBits) {
+	std::size_t p = Pos;
+	const auto GetVarInt = [&] (std::uint32_t &Value) {
+		Value = 0u;
+		for (unsigned Shift = 0u; p < Events.size() && Shift < 32u; Shift += 7u) {
+			std::uint8_t x = Events[p++];
+			Value |= static_cast<std::uint32_t>(x & 0x7Fu) << Shift;
+			if (!(x & 0x80u))
+				return true;
+		}
+		return false;
+	};
+
+	std::uint32_t Header = 0u;
+	if (!GetVarInt(Header))
+		return false;
+	Event.Type = static_cast<event_type_t>(Header & ((1u << TypeBits) - 1u));
+	Event.Delta = Header >> TypeBits;
+
+	switch (Event.Type) {
+	case event_type_t::write:
+		if (Events.size() - p < 3u)
+			return false;
+		Event.Address = static_cast<std::uint16_t>(Events[p] | (Events[p + 1] << 8));
+		Event.Value = Events[p + 2];
+		p += 3u;
+		break;
+	case event_type_t::sample: {
+		std::uint32_t Index = 0u;
+		if (!GetVarInt(Index))
+			return false;
+		Event.Sample = Index;
+	}	break;
+	case event_type_t::end_frame: case event_type_t::reset: case event_type_t::process:
+		break;
+	default:
+		return false;
+	}
+
+	Pos = p;
+	return true;
+}
+
+std::shared_ptr<const ft0cc::doc::dpcm_sample> CRegisterTrace::GetSample(std::size_t Index) const {
+	return Index < m_pSamples.size() ? m_pSamples[Index] : nullptr;
+}
+
+void CRegisterTrace::Save(const fs::path &fname) const {
+	CSimpleFile file(fname, std::ios::out | std::ios::binary);
+	if (!file)
+		throw std::runtime_error {"Cannot open register trace: " + file.GetErrorMessage()};
+
+	file.WriteBytes(std::string_view {TRACE_HEADER_ID});
+	file.WriteInt32(FILE_VERSION);
+	file.WriteInt8(value_cast(m_iMachine));
+	file.WriteInt32(m_iChips.GetFlag());
+	file.WriteInt32(m_iFrameCount);
+	file.WriteInt32(static_cast<int32_t>(m_pSamples.size()));
+	for (const auto &pSample : m_pSamples) {
+		file.WriteInt32(static_cast<int32_t>(pSample->size()));
+		file.WriteBytes(array_view<unsigned char> {pSample->data(), pSample->size()});
+	}
+	file.WriteInt32(static_cast<int32_t>(m_Events.size()));
+	file.WriteBytes(array_view<unsigned char> {m_Events.data(), m_Events.size()});
+
+	if (!file)
+		throw std::runtime_error {"Cannot write register trace: " + file.GetErrorMessage()};
+}
+
+void CRegisterTrace::Load(const fs::path &fname) {
+	CSimpleFile file(fname, std::ios::in | std::ios::binary);
+	if (!file)
+		throw std::runtime_error {"Cannot open register trace: " + file.GetErrorMessage()};
+
+	const auto ReadVector = [&] (std::size_t Size) {
+		std::vector<std::uint8_t> Data(Size);
+		if (file.ReadBytes(Data.data(), Size) != Size)
+			throw std::runtime_error {"Register trace is truncated"};
+		return Data;
+	};
+
+	if (file.ReadStringN(std::size(TRACE_HEADER_ID) - 1) != TRACE_HEADER_ID)
+		throw std::runtime_error {"File is not a register trace"};
+	std::uint32_t Version = file.ReadUint32();
+	if (Version < 1u || Version > FILE_VERSION)
+		throw std::runtime_error {"Unsupported register trace version"};
+	auto Machine = enum_cast<machine_t>(file.ReadUint8());
+	if (Machine == machine_t::none)
+		throw std::runtime_error {"Register trace has an invalid machine type"};
+	auto Chips = CSoundChipSet::FromFlag(file.ReadUint32());
+	unsigned FrameCount = file.ReadUint32();
+
+	std::vector<std::shared_ptr<const ft0cc::doc::dpcm_sample>> Samples(file.ReadUint32());
+	for (auto &pSample : Samples)
+		pSample = std::make_shared<ft0cc::doc::dpcm_sample>(ReadVector(file.ReadUint32()), "");
+	std::vector<std::uint8_t> Events = ReadVector(file.ReadUint32());
+
+	m_iMachine = Machine;
+	m_iChips = Chips;
+	m_iFrameCount = FrameCount;
+	m_iLastCycle = 0u;
+	m_pSamples = std::move(Samples);
+	if (Version >= 2u) {
+		m_Events = std::move(Events);
+		return;
+	}
+
+	// version 1 traces have no process events and 2 bits for the event type
+	m_Events.clear();
+	event_t Event;
+	for (std::size_t Pos = 0u; ReadEvent(Events, Pos, Event, 2u); ) {
+		PutHeader(Event.Type, Event.Delta);
+		if (Event.Type == event_type_t::write) {
+			m_Events.push_back(static_cast<std::uint8_t>(Event.Address));
+			m_Events.push_back(static_cast<std::uint8_t>(Event.Address >> 8));
+			m_Events.push_back(Event.Value);
+		}
+		else if (Event.Type == event_type_t::sample)
+			PutVarInt(static_cast<std::uint32_t>(Event.Sample));
+	}
+}
+
+
+
+CRegisterTracePlayer::CRegisterTracePlayer(const CRegisterTrace &Trace, CAPU &APU) :
+	m_Trace(Trace), m_APU(APU)
+{
+}
+
+bool CRegisterTracePlayer::PlayFrame() {
+	CRegisterTrace::event_t Event;
+	bool Played = false;
+
+	while (m_Trace.ReadEvent(m_iPos, Event)) {
+		Played = true;
+		switch (Event.Type) {
+		case CRegisterTrace::event_type_t::write:
+			m_APU.AddTime(Event.Delta);
+			m_APU.Write(Event.Address, Event.Value);
+			break;
+		case CRegisterTrace::event_type_t::sample:
+			m_APU.AddTime(Event.Delta);
+			m_APU.Process();
+			if (auto pSample = m_Trace.GetSample(Event.Sample))
+				if (auto *p2A03 = dynamic_cast<C2A03 *>(m_APU.GetSoundChip(sound_chip_t::APU)))
+					p2A03->WriteSample(std::move(pSample));
+			break;
+		case CRegisterTrace::event_type_t::process:
+			m_APU.AddTime(Event.Delta);
+			m_APU.Process();
+			break;
+		case CRegisterTrace::event_type_t::reset:
+			m_APU.Reset();
+			break;
+		case CRegisterTrace::event_type_t::end_frame:
+			m_APU.AddTime(Event.Delta);
+			m_APU.Process();
+			m_APU.EndFrame();
+			++m_iFrame;
+			return true;
+		}
+	}
+
+	return Played;
+}
+
+void CRegisterTracePlayer::Rewind() {
+	m_iPos = 0u;
+	m_iFrame = 0u;
+}
+
+unsigned CRegisterTracePlayer::GetFrame() const {
+	return m_iFrame;
+}
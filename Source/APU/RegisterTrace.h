@@ -0,0 +1,157 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "APU/Types.h"
+#include "SoundChipSet.h"
+#include "ft0cc/fs.h"
+
+namespace ft0cc::doc {
+class dpcm_sample;
+} // namespace ft0cc::doc
+
+class CAPU;
+
+/*!
+	\brief A compact binary log of all register writes sent to the APU, stamped with the CPU cycle
+	within the frame at which each write occurred.
+	\details Events are stored as a byte stream. Each event begins with a variable-length integer
+	holding the number of cycles since the previous event of the same frame, shifted left by 3 and
+	combined with the event type. Write events are followed by a 16-bit little-endian address and the
+	8-bit value; DPCM sample events are followed by a variable-length index into the sample table.
+	Samples are only referenced while recording, so that the sound thread never copies them.
+	Process events mark where the APU was run without a write, because the 2A03 mixes its channels
+	in steps that begin at these points; playback is only sample-exact if it runs the same steps.
+*/
+class CRegisterTrace
+{
+public:
+	enum class event_type_t : std::uint8_t {
+		write, end_frame, reset, sample, process,
+	};
+
+	struct event_t {
+		event_type_t Type = event_type_t::write;
+		std::uint32_t Delta = 0;
+		std::uint16_t Address = 0;
+		std::uint8_t Value = 0;
+		std::size_t Sample = 0;
+	};
+
+	/*!	\brief Constructor of an empty register trace.
+		\param Machine The machine type the trace is recorded for.
+		\param Chips The sound chips enabled during recording. */
+	explicit CRegisterTrace(machine_t Machine = DEFAULT_MACHINE_TYPE, CSoundChipSet Chips = sound_chip_t::APU);
+	~CRegisterTrace();
+
+	machine_t GetMachine() const;
+	CSoundChipSet GetChips() const;
+	unsigned GetFrameCount() const;
+	std::size_t GetSize() const;
+
+	/*!	\brief Removes all events and samples from the trace. */
+	void Clear();
+
+	/*!	\brief Appends a register write.
+		\param Cycle The cycle count since the beginning of the current frame.
+		\param Address The register address.
+		\param Value The written value. */
+	void RecordWrite(std::uint32_t Cycle, std::uint16_t Address, std::uint8_t Value);
+	/*!	\brief Appends the end of the current frame.
+		\param Cycle The total number of cycles emulated in the frame. */
+	void RecordEndFrame(std::uint32_t Cycle);
+	/*!	\brief Appends an APU reset. */
+	void RecordReset();
+	/*!	\brief Appends a point up to which the APU was emulated without writing to it.
+		\param Cycle The cycle count since the beginning of the current frame. */
+	void RecordProcess(std::uint32_t Cycle);
+	/*!	\brief Appends a DPCM sample load, unless the sample is the most recently recorded one.
+		\param Cycle The cycle count since the beginning of the current frame.
+		\param pSample The sample now used by the DPCM channel. */
+	void RecordSample(std::uint32_t Cycle, const std::shared_ptr<const ft0cc::doc::dpcm_sample> &pSample);
+
+	/*!	\brief Decodes an event.
+		\param Pos The byte offset of the event, advanced past it on success.
+		\param Event Receives the decoded event.
+		\return Whether an event was read before the end of the trace. */
+	bool ReadEvent(std::size_t &Pos, event_t &Event) const;
+
+	/*!	\brief Obtains a DPCM sample referenced by the trace.
+		\param Index The sample index of a sample event.
+		\return The sample, or nullptr if the index is invalid. */
+	std::shared_ptr<const ft0cc::doc::dpcm_sample> GetSample(std::size_t Index) const;
+
+	/*!	\brief Writes the trace to a file. Throws std::runtime_error on failure. */
+	void Save(const fs::path &fname) const;
+	/*!	\brief Replaces the trace with the contents of a file. Throws std::runtime_error on failure. */
+	void Load(const fs::path &fname);
+
+private:
+	void PutEvent(event_type_t Type, std::uint32_t Cycle);
+	void PutHeader(event_type_t Type, std::uint32_t Delta);
+	void PutVarInt(std::uint32_t Value);
+	static bool ReadEvent(const std::vector<std::uint8_t> &Events, std::size_t &Pos, event_t &Event, unsigned TypeBits);
+
+private:
+	static const std::uint32_t FILE_VERSION = 2u;
+	static const unsigned TYPE_BITS = 3u;		// 2 before version 2, which added process events
+
+	machine_t m_iMachine;
+	CSoundChipSet m_iChips;
+	unsigned m_iFrameCount = 0u;
+	std::uint32_t m_iLastCycle = 0u;
+	std::vector<std::uint8_t> m_Events;
+	std::vector<std::shared_ptr<const ft0cc::doc::dpcm_sample>> m_pSamples;
+};
+
+/*!
+	\brief A class which drives an APU from a register trace, without the tracker's sound driver.
+	\details The APU should be set up with the machine type and sound chips of the trace before
+	playback. Audio is delivered through the APU's callback object as usual, if it has one.
+*/
+class CRegisterTracePlayer
+{
+public:
+	CRegisterTracePlayer(const CRegisterTrace &Trace, CAPU &APU);
+
+	/*!	\brief Emulates all events up to and including the end of the next frame.
+		\return False if the trace has no more events. */
+	bool PlayFrame();
+
+	/*!	\brief Restarts playback from the beginning of the trace. */
+	void Rewind();
+
+	/*!	\brief Obtains the number of frames played so far. */
+	unsigned GetFrame() const;
+
+private:
+	const CRegisterTrace &m_Trace;
+	CAPU &m_APU;
+	std::size_t m_iPos = 0u;
+	unsigned m_iFrame = 0u;
+};
@@ -88,6 +88,18 @@ void CS5BChannel::Output(uint32_t Noise, uint32_t Envelope)
 	Mix(Output);
 }
 
+void CS5BChannel::SaveState(apu_state_t &State) const		// // //
+{
+	CChannel::SaveState(State);
+	AppendState(State, m_iVolume, m_iPeriod, m_iPeriodClock, m_bSquareHigh, m_bSquareDisable, m_bNoiseDisable);
+}
+
+void CS5BChannel::LoadState(const apu_state_t &State, std::size_t &Pos)		// // //
+{
+	CChannel::LoadState(State, Pos);
+	ReadState(State, Pos, m_iVolume, m_iPeriod, m_iPeriodClock, m_bSquareHigh, m_bSquareDisable, m_bNoiseDisable);
+}
+
 double CS5BChannel::GetFrequency() const		// // //
 {
 	if (m_bSquareDisable || !m_iPeriod)
@@ -198,6 +210,22 @@ double CS5B::GetFreq(int Channel) const		// // //
 	return 0.;
 }
 
+void CS5B::SaveState(apu_state_t &State) const		// // //
+{
+	for (const auto &x : m_Channel)
+		x.SaveState(State);
+	AppendState(State, m_cPort, m_iCounter, m_iNoisePeriod, m_iNoiseClock, m_iNoiseState,
+		m_iEnvelopePeriod, m_iEnvelopeClock, m_iEnvelopeLevel, m_iEnvelopeShape, m_bEnvelopeHold);
+}
+
+void CS5B::LoadState(const apu_state_t &State, std::size_t &Pos)		// // //
+{
+	for (auto &x : m_Channel)
+		x.LoadState(State, Pos);
+	ReadState(State, Pos, m_cPort, m_iCounter, m_iNoisePeriod, m_iNoiseClock, m_iNoiseState,
+		m_iEnvelopePeriod, m_iEnvelopeClock, m_iEnvelopeLevel, m_iEnvelopeShape, m_bEnvelopeHold);
+}
+
 void CS5B::WriteReg(uint8_t Port, uint8_t Value)
 {
 	switch (Port) {
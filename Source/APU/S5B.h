@@ -42,6 +42,8 @@ public:
 	void Output(uint32_t Noise, uint32_t Envelope);
 
 	double GetFrequency() const;
+	void SaveState(apu_state_t &State) const;		// // //
+	void LoadState(const apu_state_t &State, std::size_t &Pos);		// // //
 
 private:
 	uint8_t m_iVolume;
@@ -70,6 +72,8 @@ public:
 	void	Log(uint16_t Address, uint8_t Value) override;		// // //
 
 	double	GetFreq(int Channel) const override;		// // //
+	void	SaveState(apu_state_t &State) const override;		// // //
+	void	LoadState(const apu_state_t &State, std::size_t &Pos) override;		// // //
 
 private:
 	void	WriteReg(uint8_t Port, uint8_t Value);
@@ -26,13 +26,28 @@ uint8_t CSampleMem::ReadMem(uint16_t Address) const {
 	uint16_t Addr = (Address - 0xC000);// % m_iMemSize;
 	if (Addr >= m_pMemory.size())		// // //
 		return 0;
+	if (m_pProgress && Addr >= m_pProgress->load(std::memory_order_acquire))		// // //
+		return 0xAA;		// not converted yet, hold the delta counter
 	return m_pMemory[Addr];
 }
 
-void CSampleMem::SetMem(array_view<uint8_t> Memory) {
+void CSampleMem::SetMem(array_view<uint8_t> Memory, const std::atomic<std::size_t> *Progress) {
 	m_pMemory = Memory;
+	m_pProgress = Progress;		// // //
 }
 
 void CSampleMem::Clear() {
 	m_pMemory.clear();
+	m_pProgress = nullptr;		// // //
+}
+
+void CSampleMem::SaveState(apu_state_t &State) const {		// // //
+	AppendState(State, m_pMemory.data(), m_pMemory.size(), m_pProgress);
+}
+
+void CSampleMem::LoadState(const apu_state_t &State, std::size_t &Pos) {		// // //
+	decltype(m_pMemory.data()) Data;
+	decltype(m_pMemory.size()) Size;
+	ReadState(State, Pos, Data, Size, m_pProgress);
+	m_pMemory = array_view<uint8_t> {Data, Size};
 }
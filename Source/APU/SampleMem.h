@@ -23,18 +23,25 @@
 
 #pragma once
 
+#include <atomic>		// // //
 #include <cstdint>
 #include "array_view.h"
+#include "APU/APUState.h"		// // //
 
 // class for simulating CPU memory, used by the DPCM channel
 class CSampleMem		// // //
 {
 public:
 	uint8_t ReadMem(uint16_t Address) const;
-	void SetMem(array_view<uint8_t> Buffer);
+	// // // if Progress is given, only bytes below its value are read from the buffer
+	void SetMem(array_view<uint8_t> Buffer, const std::atomic<std::size_t> *Progress = nullptr);
 	void Clear();
+	// // // the memory is identified by its address, as the samples are shared between players
+	void SaveState(apu_state_t &State) const;
+	void LoadState(const apu_state_t &State, std::size_t &Pos);
 
 private:
 	array_view<uint8_t> m_pMemory;
+	const std::atomic<std::size_t> *m_pProgress = nullptr;		// // //
 };
 
@@ -33,6 +33,11 @@ CSoundChip::CSoundChip(CMixer &Mixer, std::uint8_t nInstance) :		// // //
 CSoundChip::~CSoundChip() noexcept {
 }
 
+void CSoundChip::SkipFrame()		// // //
+{
+	EndFrame();
+}
+
 double CSoundChip::GetFreq(int Channel) const		// // //
 {
 	return 0.0;
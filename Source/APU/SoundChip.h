@@ -26,6 +26,7 @@
 #include <cstdint>		// // //
 #include <memory>		// // //
 #include "APU/Types_fwd.h"		// // //
+#include "APU/APUState.h"		// // //
 
 class CMixer;
 class CRegisterLogger;		// // //
@@ -40,6 +41,14 @@ public:
 	virtual void	Reset() = 0;
 	virtual void	Process(uint32_t Time) = 0;
 	virtual void	EndFrame() = 0;
+	// // // Ends a frame whose audio is discarded; the chip has already processed the whole
+	// frame, and only output that is not kept in the emulation state may be skipped. Ends the
+	// frame normally by default
+	virtual void	SkipFrame();
+	// // // Appends the complete emulation state of the chip, including its registers
+	virtual void	SaveState(apu_state_t &State) const = 0;
+	// // // Restores the state saved by a chip of the same type, reading it from Pos onwards
+	virtual void	LoadState(const apu_state_t &State, std::size_t &Pos) = 0;
 
 	virtual void	Write(uint16_t Address, uint8_t Value) = 0;
 	virtual uint8_t	Read(uint16_t Address, bool &Mapped) = 0;
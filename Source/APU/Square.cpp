@@ -158,6 +158,22 @@ double CSquare::GetFrequency() const		// // //
 	return CPU_RATE / 16. / (m_iPeriod + 1.);
 }
 
+void CSquare::SaveState(apu_state_t &State) const		// // //
+{
+	C2A03Chan::SaveState(State);
+	AppendState(State, m_iDutyLength, m_iDutyCycle, m_iLooping, m_iEnvelopeFix, m_iEnvelopeSpeed,
+		m_iEnvelopeVolume, m_iFixedVolume, m_iEnvelopeCounter, m_iSweepEnabled, m_iSweepPeriod,
+		m_iSweepMode, m_iSweepShift, m_iSweepCounter, m_iSweepResult, m_bSweepWritten);
+}
+
+void CSquare::LoadState(const apu_state_t &State, std::size_t &Pos)		// // //
+{
+	C2A03Chan::LoadState(State, Pos);
+	ReadState(State, Pos, m_iDutyLength, m_iDutyCycle, m_iLooping, m_iEnvelopeFix, m_iEnvelopeSpeed,
+		m_iEnvelopeVolume, m_iFixedVolume, m_iEnvelopeCounter, m_iSweepEnabled, m_iSweepPeriod,
+		m_iSweepMode, m_iSweepShift, m_iSweepCounter, m_iSweepResult, m_bSweepWritten);
+}
+
 void CSquare::LengthCounterUpdate()
 {
 	if ((m_iLooping == 0) && (m_iLengthCounter > 0))
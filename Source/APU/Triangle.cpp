@@ -128,6 +128,18 @@ double CTriangle::GetFrequency() const		// // //
 	return CPU_RATE / 32. / (m_iPeriod + 1.);
 }
 
+void CTriangle::SaveState(apu_state_t &State) const		// // //
+{
+	C2A03Chan::SaveState(State);
+	AppendState(State, m_iLoop, m_iLinearLoad, m_iHalt, m_iLinearCounter, m_iStepGen);
+}
+
+void CTriangle::LoadState(const apu_state_t &State, std::size_t &Pos)		// // //
+{
+	C2A03Chan::LoadState(State, Pos);
+	ReadState(State, Pos, m_iLoop, m_iLinearLoad, m_iHalt, m_iLinearCounter, m_iStepGen);
+}
+
 void CTriangle::LengthCounterUpdate()
 {
 	if ((m_iLoop == 0) && (m_iLengthCounter > 0))
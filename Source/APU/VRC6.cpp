@@ -85,6 +85,20 @@ void CVRC6_Pulse::Process(int Time)
 	m_iTime += Time;
 }
 
+void CVRC6_Pulse::SaveState(apu_state_t &State) const		// // //
+{
+	CChannel::SaveState(State);
+	AppendState(State, m_iDutyCycle, m_iVolume, m_iGate, m_iEnabled, m_iPeriod,
+		m_iPeriodLow, m_iPeriodHigh, m_iCounter, m_iDutyCycleCounter);
+}
+
+void CVRC6_Pulse::LoadState(const apu_state_t &State, std::size_t &Pos)		// // //
+{
+	CChannel::LoadState(State, Pos);
+	ReadState(State, Pos, m_iDutyCycle, m_iVolume, m_iGate, m_iEnabled, m_iPeriod,
+		m_iPeriodLow, m_iPeriodHigh, m_iCounter, m_iDutyCycleCounter);
+}
+
 double CVRC6_Pulse::GetFrequency() const		// // //
 {
 	if (m_iGate || !m_iEnabled || !m_iPeriod)
@@ -157,6 +171,20 @@ void CVRC6_Sawtooth::Process(int Time)
 	m_iTime += Time;
 }
 
+void CVRC6_Sawtooth::SaveState(apu_state_t &State) const		// // //
+{
+	CChannel::SaveState(State);
+	AppendState(State, m_iPhaseAccumulator, m_iPhaseInput, m_iEnabled, m_iResetReg, m_iPeriod,
+		m_iPeriodLow, m_iPeriodHigh, m_iCounter);
+}
+
+void CVRC6_Sawtooth::LoadState(const apu_state_t &State, std::size_t &Pos)		// // //
+{
+	CChannel::LoadState(State, Pos);
+	ReadState(State, Pos, m_iPhaseAccumulator, m_iPhaseInput, m_iEnabled, m_iResetReg, m_iPeriod,
+		m_iPeriodLow, m_iPeriodHigh, m_iCounter);
+}
+
 double CVRC6_Sawtooth::GetFrequency() const		// // //
 {
 	if (!m_iEnabled || !m_iPeriod)
@@ -236,3 +264,17 @@ double CVRC6::GetFreq(int Channel) const		// // //
 	}
 	return 0.;
 }
+
+void CVRC6::SaveState(apu_state_t &State) const		// // //
+{
+	m_Pulse1.SaveState(State);
+	m_Pulse2.SaveState(State);
+	m_Sawtooth.SaveState(State);
+}
+
+void CVRC6::LoadState(const apu_state_t &State, std::size_t &Pos)		// // //
+{
+	m_Pulse1.LoadState(State, Pos);
+	m_Pulse2.LoadState(State, Pos);
+	m_Sawtooth.LoadState(State, Pos);
+}
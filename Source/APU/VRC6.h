@@ -33,6 +33,8 @@ public:
 	void Write(uint16_t Address, uint8_t Value);
 	void Process(int Time);
 	double GetFrequency() const;		// // //
+	void SaveState(apu_state_t &State) const;		// // //
+	void LoadState(const apu_state_t &State, std::size_t &Pos);		// // //
 
 private:
 	uint8_t	m_iDutyCycle,
@@ -53,6 +55,8 @@ public:
 	void Write(uint16_t Address, uint8_t Value);
 	void Process(int Time);
 	double GetFrequency() const;		// // //
+	void SaveState(apu_state_t &State) const;		// // //
+	void LoadState(const apu_state_t &State, std::size_t &Pos);		// // //
 
 private:
 	uint8_t	m_iPhaseAccumulator,
@@ -79,6 +83,8 @@ public:
 	uint8_t Read(uint16_t Address, bool &Mapped) override;
 
 	double GetFreq(int Channel) const override;		// // //
+	void SaveState(apu_state_t &State) const override;		// // //
+	void LoadState(const apu_state_t &State, std::size_t &Pos) override;		// // //
 
 private:
 	CVRC6_Pulse	m_Pulse1;		// // //
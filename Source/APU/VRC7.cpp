@@ -23,6 +23,7 @@
 #include "APU/VRC7.h"
 #include "APU/Mixer.h"		// // //
 #include "RegisterState.h"		// // //
+#include <functional>		// // //
 
 const float  CVRC7::AMPLIFY	  = 4.6f;		// Mixing amplification, VRC7 patch 14 is 4,88 times stronger than a 50% square @ v=15
 const uint32_t CVRC7::OPL_CLOCK = 3579545;	// Clock frequency
@@ -45,6 +46,7 @@ void CVRC7::Reset()
 {
 	m_iBufferPtr = 0;
 	m_iTime = 0;
+	m_iLastSample = 0;		// // //
 }
 
 void CVRC7::SetSampleSpeed(uint32_t SampleRate, double ClockRate, uint32_t FrameRate)
@@ -64,8 +66,10 @@ void CVRC7::SetVolume(float Volume)
 	m_fVolume = Volume * AMPLIFY;
 }
 
+#ifndef FT0CC_EXT_BUILD		// // //
 #include "FamiTrackerEnv.h"	//sh8bit
 #include "SoundGen.h"
+#endif
 
 void CVRC7::Write(uint16_t Address, uint8_t Value)
 {
@@ -75,7 +79,9 @@ void CVRC7::Write(uint16_t Address, uint8_t Value)
 			break;
 		case 0x9030:
 			OPLL_writeReg(m_pOPLLInt.get(), m_iSoundReg, Value);
+#ifndef FT0CC_EXT_BUILD		// // //
 			FTEnv.GetSoundGenerator()->VGMLogOPLLWrite(m_iSoundReg, Value);//sh8bit
+#endif
 			break;
 	}
 }
@@ -97,8 +103,6 @@ void CVRC7::EndFrame()
 {
 	uint32_t WantSamples = m_pMixer->GetMixSampleCount(m_iTime);
 
-	static int32_t LastSample = 0;
-
 	// Generate VRC7 samples
 	while (m_iBufferPtr < WantSamples) {
 		int32_t RawSample = OPLL_calc(m_pOPLLInt.get());
@@ -117,16 +121,81 @@ void CVRC7::EndFrame()
 		if (Sample < -32768)
 			Sample = -32768;
 
-		m_iBuffer[m_iBufferPtr++] = int16_t((Sample + LastSample) >> 1);
-		LastSample = Sample;
+		m_iBuffer[m_iBufferPtr++] = int16_t((Sample + m_iLastSample) >> 1);		// // //
+		m_iLastSample = Sample;
 	}
 
 	m_pMixer->MixSamples((blip_sample_t*)m_iBuffer.data(), WantSamples);		// // //
 
+	// Get channel levels
+	for (std::size_t i = 0; i < MAX_CHANNELS_VRC7; ++i)		// // //
+		m_pMixer->StoreChannelLevel(stChannelID {sound_chip_t::VRC7, static_cast<std::uint8_t>(i)}, OPLL_getchanvol(m_pOPLLInt.get(), i));
+
+	m_iBufferPtr -= WantSamples;
+	m_iTime = 0;
+}
+
+void CVRC7::SkipFrame()		// // //
+{
+	uint32_t WantSamples = m_pMixer->GetMixSampleCount(m_iTime);
+	if (WantSamples > m_iBufferPtr) {
+		OPLL_skip(m_pOPLLInt.get(), WantSamples - m_iBufferPtr);
+		m_iBufferPtr = WantSamples;
+	}
+
 	m_iBufferPtr -= WantSamples;
 	m_iTime = 0;
 }
 
+void CVRC7::SaveState(apu_state_t &State) const		// // //
+{
+	const OPLL &opll = *m_pOPLLInt;
+	AppendState(State, opll.adr, opll.out, opll.realstep, opll.oplltime, opll.opllstep, opll.prev, opll.next,
+		opll.sprev, opll.snext, opll.pan, opll.reg, opll.slot_on_flag, opll.pm_phase, opll.lfo_pm,
+		opll.am_phase, opll.lfo_am, opll.quality, opll.noise_seed, opll.patch_number, opll.key_status,
+		opll.patch_update, opll.mask);
+	for (const auto &patch : opll.patch)
+		AppendState(State, patch.TL, patch.FB, patch.EG, patch.ML, patch.AR, patch.DR, patch.SL,
+			patch.RR, patch.KR, patch.KL, patch.AM, patch.PM, patch.WF);
+
+	// slots use the chip's patches by position, other patches and the wave tables are shared
+	const OPLL_PATCH *First = std::begin(opll.patch);
+	const OPLL_PATCH *Last = std::end(opll.patch);
+	for (const auto &slot : opll.slot) {
+		const bool Owned = !std::less<> { }(slot.patch, First) && std::less<> { }(slot.patch, Last);
+		AppendState(State, Owned ? slot.patch - First : std::ptrdiff_t {-1}, Owned ? nullptr : slot.patch,
+			slot.type, slot.feedback, slot.output, slot.sintbl, slot.phase, slot.dphase, slot.pgout,
+			slot.fnum, slot.block, slot.volume, slot.sustine, slot.tll, slot.rks, slot.eg_mode,
+			slot.eg_phase, slot.eg_dphase, slot.egout);
+	}
+
+	AppendState(State, m_iTime, m_iBufferPtr, m_iLastSample, m_iSoundReg);
+}
+
+void CVRC7::LoadState(const apu_state_t &State, std::size_t &Pos)		// // //
+{
+	OPLL &opll = *m_pOPLLInt;
+	ReadState(State, Pos, opll.adr, opll.out, opll.realstep, opll.oplltime, opll.opllstep, opll.prev, opll.next,
+		opll.sprev, opll.snext, opll.pan, opll.reg, opll.slot_on_flag, opll.pm_phase, opll.lfo_pm,
+		opll.am_phase, opll.lfo_am, opll.quality, opll.noise_seed, opll.patch_number, opll.key_status,
+		opll.patch_update, opll.mask);
+	for (auto &patch : opll.patch)
+		ReadState(State, Pos, patch.TL, patch.FB, patch.EG, patch.ML, patch.AR, patch.DR, patch.SL,
+			patch.RR, patch.KR, patch.KL, patch.AM, patch.PM, patch.WF);
+
+	for (auto &slot : opll.slot) {
+		std::ptrdiff_t Index;
+		ReadState(State, Pos, Index, slot.patch,
+			slot.type, slot.feedback, slot.output, slot.sintbl, slot.phase, slot.dphase, slot.pgout,
+			slot.fnum, slot.block, slot.volume, slot.sustine, slot.tll, slot.rks, slot.eg_mode,
+			slot.eg_phase, slot.eg_dphase, slot.egout);
+		if (Index != -1)
+			slot.patch = std::begin(opll.patch) + Index;
+	}
+
+	ReadState(State, Pos, m_iTime, m_iBufferPtr, m_iLastSample, m_iSoundReg);
+}
+
 void CVRC7::Process(uint32_t Time)
 {
 	// This cannot run in sync, fetch all samples at end of frame instead
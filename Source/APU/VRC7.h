@@ -25,7 +25,7 @@
 
 #include "APU/SoundChip.h"
 //#include "APU/ext/emu2413.h"		// // //
-#include "APU/ext/YM2413_Emu.h"	//sh8bit, can be reverted to the other core, but percussion in this one seem to sound more legit
+#include "APU/ext/Ym2413_Emu.h"	//sh8bit, can be reverted to the other core, but percussion in this one seem to sound more legit
 #include <vector>		// // //
 
 struct OPLL_deleter {
@@ -46,6 +46,7 @@ public:
 	void Reset() override;
 	void Process(uint32_t Time) override;
 	void EndFrame() override;
+	void SkipFrame() override;		// // //
 
 	void Write(uint16_t Address, uint8_t Value) override;
 	uint8_t Read(uint16_t Address, bool &Mapped) override;
@@ -53,6 +54,8 @@ public:
 	void Log(uint16_t Address, uint8_t Value) override;		// // //
 
 	double GetFreq(int Channel) const override;		// // //
+	void SaveState(apu_state_t &State) const override;		// // //
+	void LoadState(const apu_state_t &State, std::size_t &Pos) override;		// // //
 
 protected:
 	static const float  AMPLIFY;
@@ -65,6 +68,7 @@ private:
 	uint32_t	m_iMaxSamples = 0;
 	std::vector<int16_t> m_iBuffer;		// // //
 	uint32_t	m_iBufferPtr;
+	int32_t		m_iLastSample = 0;		// // //
 
 	float		m_fVolume = 1.f;
 
@@ -388,4 +388,20 @@ bool NES_FDS::Read (uint32_t adr, uint32_t & val)
     return false;
 }
 
+void NES_FDS::SaveState (apu_state_t &State) const		// // //
+{
+    AppendState(State, fout, option, master_io, master_vol, wave, freq, phase,
+        wav_write, wav_halt, env_halt, mod_halt, mod_pos, mod_write_pos,
+        env_mode, env_disable, env_timer, env_speed, env_out, master_env_speed,
+        rc_accum, rc_k, rc_l);
+}
+
+void NES_FDS::LoadState (const apu_state_t &State, std::size_t &Pos)		// // //
+{
+    ReadState(State, Pos, fout, option, master_io, master_vol, wave, freq, phase,
+        wav_write, wav_halt, env_halt, mod_halt, mod_pos, mod_write_pos,
+        env_mode, env_disable, env_timer, env_speed, env_out, master_env_speed,
+        rc_accum, rc_k, rc_l);
+}
+
 } // namespace
@@ -24,6 +24,7 @@
 #pragma once
 
 #include <cstdint>
+#include "APU/APUState.h"		// // //
 
 // // // new FDS emulation core taken straight from rainwarrior's NSFPlay
 
@@ -90,6 +91,8 @@ public:
     void SetRate (double);
     void SetClock (double);
     void SetOption (int, int);
+    void SaveState (apu_state_t &State) const;		// // //
+    void LoadState (const apu_state_t &State, std::size_t &Pos);		// // //
 };
 
 } // namespace xgm
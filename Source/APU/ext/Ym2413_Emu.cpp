@@ -55,8 +55,6 @@
 #include <string.h>
 #include <math.h>
 
-// Added by jsr to the em2413.c, reintegrated here sh8bit
-static e_int16 opll_volumes[15];		// // //
 
 #define EMU2413_COMPACTION
 #define INLINE inline 
@@ -1063,6 +1061,9 @@ OPLL_reset (OPLL * opll)
   opll->noise_seed = 0xffff;
   opll->mask = 0;
 
+  for (i = 0; i < 15; i++)		// // //
+    opll->volumes[i] = 0;
+
   for (i = 0; i <18; i++)
     OPLL_SLOT_reset(&opll->slot[i], i%2);
 
@@ -1438,7 +1439,7 @@ calc (OPLL * opll)
 		  inst += ch_out;
 	  }
 	  absvol = abs(ch_out);
-	  if (absvol > opll_volumes[i]) opll_volumes[i] = absvol;
+	  if (absvol > opll->volumes[i]) opll->volumes[i] = absvol;
   }
 
 
@@ -1461,7 +1462,7 @@ calc (OPLL * opll)
 	  }
   }
   absvol = abs(ch_out);
-  if (absvol > opll_volumes[6]) opll_volumes[6] = absvol;
+  if (absvol > opll->volumes[6]) opll->volumes[6] = absvol;
 
   /* CH7 */
   ch_out = 0;
@@ -1491,7 +1492,7 @@ calc (OPLL * opll)
 	  ch_out = ch_mix;
   }
   absvol = abs(ch_out);
-  if (absvol > opll_volumes[7]) opll_volumes[7] = absvol;
+  if (absvol > opll->volumes[7]) opll->volumes[7] = absvol;
 
   /* CH8 */
   ch_out = 0;
@@ -1521,7 +1522,7 @@ calc (OPLL * opll)
 	  ch_out = ch_mix;
   }
   absvol = abs(ch_out);
-  if (absvol > opll_volumes[8]) opll_volumes[8] = absvol;
+  if (absvol > opll->volumes[8]) opll->volumes[8] = absvol;
 
   out = inst + (perc << 1);
   //return (e_int16) out << 3;
@@ -1556,6 +1557,31 @@ OPLL_calc (OPLL * opll)
 }
 #endif
 
+// // // advances the LFOs and the noise generator by the given number of samples without
+// computing any output, slots are left untouched
+void
+OPLL_skip (OPLL * opll, e_uint32 count)
+{
+  while (count--)
+  {
+#ifndef EMU2413_COMPACTION
+    if (opll->quality)
+    {
+      while (opll->realstep > opll->oplltime)
+      {
+        opll->oplltime += opll->opllstep;
+        update_ampm (opll);
+        update_noise (opll);
+      }
+      opll->oplltime -= opll->realstep;
+      continue;
+    }
+#endif
+    update_ampm (opll);
+    update_noise (opll);
+  }
+}
+
 e_uint32
 OPLL_setMask (OPLL * opll, e_uint32 mask)
 {
@@ -2119,9 +2145,9 @@ void Ym2413_Emu::run( int pair_count, sample_t* out )
 	}
 }
 
-e_int16 OPLL_getchanvol(int i)
+e_int16 OPLL_getchanvol(OPLL * opll, int i)		// // //
 {
-	e_int16 retval = opll_volumes[i];
-	opll_volumes[i] = 0;
+	e_int16 retval = opll->volumes[i];
+	opll->volumes[i] = 0;
 	return retval;
 }
\ No newline at end of file
@@ -119,6 +119,9 @@ extern "C" {
 
 		e_uint32 mask;
 
+		/* Channel meters, added by jsr to the em2413.c, reintegrated here sh8bit */
+		e_int16 volumes[15];		// // //
+
 	} OPLL;
 
 	/* Create Object */
@@ -139,6 +142,7 @@ extern "C" {
 	/* Synthsize */
 	EMU2413_API e_int16 OPLL_calc(OPLL *);
 	EMU2413_API void OPLL_calc_stereo(OPLL *, e_int32 out[2]);
+	EMU2413_API void OPLL_skip(OPLL *, e_uint32 count);		// // //
 
 	/* Misc */
 	EMU2413_API void OPLL_setPatch(OPLL *, const e_uint8 *dump);
@@ -153,7 +157,7 @@ extern "C" {
 	EMU2413_API e_uint32 OPLL_setMask(OPLL *, e_uint32 mask);
 	EMU2413_API e_uint32 OPLL_toggleMask(OPLL *, e_uint32 mask);
 
-	EMU2413_API e_int16 OPLL_getchanvol(int i);
+	EMU2413_API e_int16 OPLL_getchanvol(OPLL *, int i);		// // //
 
 #define dump2patch OPLL_dump2patch
 
@@ -0,0 +1,88 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+#include "AtomicFile.h"
+#include <cstdio>
+#include <stdexcept>
+#include <system_error>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+std::FILE *OpenForWrite(const fs::path &fname, bool Append = false) {
+#ifdef _MSC_VER
+	std::FILE *f = nullptr;
+	return ::_wfopen_s(&f, fname.c_str(), Append ? L"ab" : L"wb") == 0 ? f : nullptr;
+#else
+	return std::fopen(fname.c_str(), Append ? "ab" : "wb");
+#endif
+}
+
+bool SyncFile(std::FILE *f) {
+	if (std::fflush(f) != 0)
+		return false;
+#ifdef _WIN32
+	return ::_commit(::_fileno(f)) == 0;
+#else
+	return ::fsync(::fileno(f)) == 0;
+#endif
+}
+
+} // namespace
+
+void WriteFileAtomic(const fs::path &fname, array_view<unsigned char> Data) {
+	// The temporary file must live in the same directory, otherwise the rename is not atomic
+	fs::path TempFile = fname;
+	TempFile += ".tmp";
+
+	std::FILE *f = OpenForWrite(TempFile);
+	if (!f)
+		throw std::runtime_error {"Cannot create temporary file " + TempFile.u8string()};
+
+	bool Success = std::fwrite(Data.data(), 1, Data.size(), f) == Data.size();
+	Success = SyncFile(f) && Success;
+	Success = std::fclose(f) == 0 && Success;
+
+	std::error_code err;
+	if (Success)
+		fs::rename(TempFile, fname, err);
+	if (!Success || err) {
+		fs::remove(TempFile, err);
+		throw std::runtime_error {"Cannot write to " + fname.u8string()};
+	}
+}
+
+void AppendFileSynced(const fs::path &fname, array_view<unsigned char> Data) {
+	std::FILE *f = OpenForWrite(fname, true);
+	if (!f)
+		throw std::runtime_error {"Cannot open " + fname.u8string()};
+
+	bool Success = std::fwrite(Data.data(), 1, Data.size(), f) == Data.size();
+	Success = SyncFile(f) && Success;
+	Success = std::fclose(f) == 0 && Success;
+	if (!Success)
+		throw std::runtime_error {"Cannot write to " + fname.u8string()};
+}
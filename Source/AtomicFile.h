@@ -0,0 +1,37 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+#pragma once
+
+#include "array_view.h"
+#include "ft0cc/fs.h"
+
+// // // Writes an entire file to a temporary sibling, flushes it to disk, then
+// renames it over the destination, so that the destination is never observed
+// partially written. Throws std::runtime_error on failure.
+
+void WriteFileAtomic(const fs::path &fname, array_view<unsigned char> Data);
+
+// // // Appends data to the end of a file and flushes it to disk. A crash may leave
+// a partial tail, which readers of the file must be able to detect.
+void AppendFileSynced(const fs::path &fname, array_view<unsigned char> Data);
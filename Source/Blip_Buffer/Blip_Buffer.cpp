@@ -43,7 +43,7 @@ Blip_Buffer::Blip_Buffer()
 		long i = LONG_MIN;
 		assert( (i >> 1) == LONG_MIN / 2 );
 		i = LONG_MIN;
-		assert( (i >> 31) == -1 );
+		assert( (i >> (sizeof (long) * CHAR_BIT - 1)) == -1 ); // // // long is 64-bit on LP64
 
 		// casting to smaller signed type truncates bits and extends sign
 		i = (SHRT_MAX + 1) * 5;
@@ -165,6 +165,19 @@ void Blip_Buffer::remove_samples( long count )
 	}
 }
 
+long Blip_Buffer::buffered_count() const		// // //
+{
+	return samples_avail() + buffer_extra;
+}
+
+void Blip_Buffer::restore( blip_resampled_time_t offset, long reader, const void* buf )		// // //
+{
+	clear();
+	offset_ = offset;
+	reader_accum = reader;
+	memcpy( buffer_, buf, buffered_count() * sizeof (buf_t_) );
+}
+
 // Blip_Synth_
 
 Blip_Synth_::Blip_Synth_( short* p, int w ) :
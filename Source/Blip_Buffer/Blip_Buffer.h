@@ -82,6 +82,13 @@ public:
 	blip_resampled_time_t resampled_duration( int t ) const     { return t * factor_; }
 	blip_resampled_time_t resampled_time( blip_time_t t ) const { return t * factor_ + offset_; }
 	blip_resampled_time_t clock_rate_factor( long clock_rate ) const;
+
+	// // // Number of buffered samples that still affect the output, including the ones not
+	// completed yet, and the accumulator of the high-pass filter used when reading samples
+	long buffered_count() const;
+	long reader_state() const { return reader_accum; }
+	// // // Restores the values above, with buffered_count() samples from buf
+	void restore( blip_resampled_time_t offset, long reader, const void* buf );
 public:
 	Blip_Buffer();
 	~Blip_Buffer();
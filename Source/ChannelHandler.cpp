@@ -922,8 +922,11 @@ int CChannelHandler::LimitVolume(int Volume) const		// // //
 		return 0;
 
 	Volume = std::clamp(Volume, 0, m_iMaxVolume);
-	if (Volume == 0 && !FTEnv.GetSettings()->General.bCutVolume && m_iInstVolume > 0 && m_iVolume > 0)		// // //
-		return 1;
+	if (Volume == 0 && m_iInstVolume > 0 && m_iVolume > 0)		// // //
+#ifndef FT0CC_EXT_BUILD
+		if (!FTEnv.GetSettings()->General.bCutVolume)
+#endif
+			return 1;
 	return Volume;
 }
 
@@ -126,7 +126,9 @@ void CChannelHandlerFDS::HandleRelease()
 
 int CChannelHandlerFDS::CalculateVolume() const		// // //
 {
+#ifndef FT0CC_EXT_BUILD
 	if (!FTEnv.GetSettings()->General.bFDSOldVolume)		// // // match NSF setting
+#endif
 		return LimitVolume(((m_iInstVolume + 1) * ((m_iVolume >> VOL_COLUMN_SHIFT) + 1) - 1) / 16 - GetTremolo());
 	return CChannelHandler::CalculateVolume();
 }
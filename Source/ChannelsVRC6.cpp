@@ -160,7 +160,9 @@ int CVRC6Sawtooth::CalculateVolume() const		// // //
 		use_64_steps = pHandler->IsDutyIgnored();
 
 	if (use_64_steps) {
+#ifndef FT0CC_EXT_BUILD
 		if (!FTEnv.GetSettings()->General.bFDSOldVolume)		// // // match NSF setting
+#endif
 			return LimitVolume(((m_iInstVolume + 1) * ((m_iVolume >> VOL_COLUMN_SHIFT) + 1) - 1) / 16 - GetTremolo());
 		return CChannelHandler::CalculateVolume();
 	}
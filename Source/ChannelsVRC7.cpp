@@ -30,11 +30,11 @@
 #include "InstHandlerVRC7.h"		// // //
 #include "ChipHandlerVRC7.h"		// // //
 
-extern int g_iPercMode;	//sh8bit
-extern int g_iPercModePrev;
-extern int g_iPercVolumeBD;
-extern int g_iPercVolumeSDHH;
-extern int g_iPercVolumeTOMCY;
+int g_iPercMode = 0;	//sh8bit global variables for the percussion mode
+int g_iPercModePrev = 0;
+int g_iPercVolumeBD = 0;
+int g_iPercVolumeSDHH = 0;
+int g_iPercVolumeTOMCY = 0;
 
 namespace {
 
@@ -25,6 +25,7 @@
 
 #include <vector>
 #include <memory>
+#include <utility>		// // //
 
 class CChannelHandler;
 class CAPUInterface;
@@ -160,8 +160,8 @@ void CCommandLineExport::CommandLineExport(const CStringW &fileIn, const CString
 	}
 	else if (0 == ext.CompareNoCase(L".txt")) {
 		CTextExport textExport;
-		CStringA result = textExport.ExportFile((LPCWSTR)fileOut, *pExportDoc);		// // //
-		if (result.GetLength() > 0) {
+		std::string result = textExport.ExportFile((LPCWSTR)fileOut, *pExportDoc);		// // //
+		if (!result.empty()) {
 			if (bLog) {
 				fLog.WriteString(L"Error: ");
 				fLog.WriteString(conv::to_wide(result).data());
@@ -51,6 +51,8 @@ const LPCWSTR CConfigGeneral::CONFIG_STR[] = {		// // //
 	L"Hexadecimal keypad",
 	L"Multi-frame selection",
 	L"Check version on startup",
+	L"Auto save",		// // //
+	L"Parallel WAV export",		// // //
 };
 
 const LPCWSTR CConfigGeneral::CONFIG_DESC[] = {		// // //
@@ -77,6 +79,8 @@ const LPCWSTR CConfigGeneral::CONFIG_DESC[] = {		// // //
 	L"Use the extra keys on the keypad as hexadecimal digits in the pattern editor.",
 	L"Allow pattern selections to span across multiple frames.",
 	L"Check for new 0CC-FamiTracker versions on startup if an internet connection could be established.",
+	L"Save a recovery copy of the module to the temporary folder 10 seconds after each change, and offer to restore it after a crash.",		// // //
+	L"Render WAV files on all processor cores. The result is the same as a regular export; it is only used if all channels are exported.",		// // //
 };
 
 // CConfigGeneral dialog
@@ -163,6 +167,8 @@ BOOL CConfigGeneral::OnApply()
 	pSettings->General.bHexKeypad			= m_bHexKeypad;
 	pSettings->General.bMultiFrameSel		= m_bMultiFrameSel;
 	pSettings->General.bCheckVersion		= m_bCheckVersion;
+	pSettings->General.bAutoSave			= m_bAutoSave;		// // //
+	pSettings->General.bParallelWave		= m_bParallelWave;		// // //
 
 	pSettings->Keys.iKeyNoteCut				= m_iKeyNoteCut;
 	pSettings->Keys.iKeyNoteRelease			= m_iKeyNoteRelease;
@@ -209,6 +215,8 @@ BOOL CConfigGeneral::OnInitDialog()
 	m_bHexKeypad			= pSettings->General.bHexKeypad;
 	m_bMultiFrameSel		= pSettings->General.bMultiFrameSel;
 	m_bCheckVersion			= pSettings->General.bCheckVersion;
+	m_bAutoSave				= pSettings->General.bAutoSave;		// // //
+	m_bParallelWave			= pSettings->General.bParallelWave;		// // //
 
 	m_iKeyNoteCut			= pSettings->Keys.iKeyNoteCut;
 	m_iKeyNoteRelease		= pSettings->Keys.iKeyNoteRelease;
@@ -267,6 +275,8 @@ BOOL CConfigGeneral::OnInitDialog()
 		m_bHexKeypad,
 		m_bMultiFrameSel,
 		m_bCheckVersion,
+		m_bAutoSave,		// // //
+		m_bParallelWave,		// // //
 	};
 
 	CListCtrl *pList = static_cast<CListCtrl*>(GetDlgItem(IDC_CONFIG_LIST));
@@ -338,6 +348,8 @@ void CConfigGeneral::OnLvnItemchangedConfigList(NMHDR *pNMHDR, LRESULT *pResult)
 		&CConfigGeneral::m_bHexKeypad,
 		&CConfigGeneral::m_bMultiFrameSel,
 		&CConfigGeneral::m_bCheckVersion,
+		&CConfigGeneral::m_bAutoSave,		// // //
+		&CConfigGeneral::m_bParallelWave,		// // //
 	};
 
 	if (pNMLV->uChanged & LVIF_STATE) {
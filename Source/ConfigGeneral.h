@@ -26,7 +26,7 @@
 #include "stdafx.h"		// // //
 #include "../resource.h"		// // //
 
-inline constexpr std::size_t SETTINGS_BOOL_COUNT = 23u;		// // //
+inline constexpr std::size_t SETTINGS_BOOL_COUNT = 25u;		// // //
 
 // CConfigGeneral dialog
 
@@ -67,6 +67,8 @@ protected:
 	bool	m_bHexKeypad;
 	bool	m_bMultiFrameSel;
 	bool	m_bCheckVersion;
+	bool	m_bAutoSave;		// // //
+	bool	m_bParallelWave;		// // //
 
 	int		m_iEditStyle;
 	int		m_iPageStepSize;
@@ -37,10 +37,35 @@
 #include "WaveRendererFactory.h"		// // //
 #include "str_conv/str_conv.hpp"		// // //
 #include "NumConv.h"		// // //
+#include "APU/Mixer.h"		// // //
 
 const int MAX_LOOP_TIMES = 99;
 const int MAX_PLAY_TIME	 = (99 * 60) + 0;
 
+namespace {
+
+// // // same mixer setup as CSoundGen
+CHeadlessPlayer::mixer_settings_t GetMixerSettings(const CSettings &settings) {
+	CHeadlessPlayer::mixer_settings_t Mixer;
+	Mixer.LowCut = settings.Sound.iBassFilter;
+	Mixer.HighCut = settings.Sound.iTrebleFilter;
+	Mixer.HighDamp = settings.Sound.iTrebleDamping;
+	Mixer.Volume = settings.Sound.iMixVolume;
+	Mixer.Levels = {
+		{CHIP_LEVEL_APU1, settings.ChipLevels.iLevelAPU1 / 10.0f},
+		{CHIP_LEVEL_APU2, settings.ChipLevels.iLevelAPU2 / 10.0f},
+		{CHIP_LEVEL_VRC6, settings.ChipLevels.iLevelVRC6 / 10.0f},
+		{CHIP_LEVEL_VRC7, settings.ChipLevels.iLevelVRC7 / 10.0f},
+		{CHIP_LEVEL_MMC5, settings.ChipLevels.iLevelMMC5 / 10.0f},
+		{CHIP_LEVEL_FDS, settings.ChipLevels.iLevelFDS / 10.0f},
+		{CHIP_LEVEL_N163, settings.ChipLevels.iLevelN163 / 10.0f},
+		{CHIP_LEVEL_S5B, settings.ChipLevels.iLevelS5B / 10.0f},
+	};
+	return Mixer;
+}
+
+} // namespace
+
 // CCreateWaveDlg dialog
 
 IMPLEMENT_DYNAMIC(CCreateWaveDlg, CDialog)
@@ -122,11 +147,24 @@ void CCreateWaveDlg::OnBnClickedBegin()
 	if (!path)
 		return;
 
+	// // // muted channels and VGM logging need the sound generator
+	const CSettings &settings = *FTEnv.GetSettings();
+	bool Parallel = settings.General.bParallelWave && _stricmp(path->extension().string().c_str(), ".vgm") != 0;
+	for (int i = 0; i < m_ctlChannelList.GetCount(); ++i)
+		if (m_ctlChannelList.GetCheck(i) == BST_UNCHECKED)
+			Parallel = false;
+
 	auto pRenderer = [&] () -> std::unique_ptr<CWaveRenderer> {		// // //
+		auto Make = [&] (render_type_t Type, unsigned Param) {
+			return Parallel ?
+				CWaveRendererFactory::MakeParallel(*pModule, Track, Type, Param,
+					static_cast<unsigned>(settings.Sound.iSampleRate), GetMixerSettings(settings)) :
+				CWaveRendererFactory::Make(*pModule, Track, Type, Param);
+		};
 		if (IsDlgButtonChecked(IDC_RADIO_LOOP))
-			return CWaveRendererFactory::Make(*pModule, Track, render_type_t::Loops, GetFrameLoopCount());
+			return Make(render_type_t::Loops, GetFrameLoopCount());
 		if (IsDlgButtonChecked(IDC_RADIO_TIME))
-			return CWaveRendererFactory::Make(*pModule, Track, render_type_t::Seconds, GetTimeLimit());
+			return Make(render_type_t::Seconds, GetTimeLimit());
 		return nullptr;
 	}();
 	if (!pRenderer) {
@@ -0,0 +1,451 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+#include "DPCMEncoder.h"
+#include "ft0cc/doc/dpcm_sample.hpp"
+#include "APU/Types.h"
+#include "APU/DPCM.h"
+#include "resampler/sinc.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+
+namespace {
+
+const int DMC_BIAS = 32;
+const int DMC_MAX = 63;
+
+// Polyphase filter bank for one resampling ratio. Output sample at input position t uses
+// the inputs floor(t) - Half ... floor(t) - Half + Taps - 1, weighted by the coefficients of
+// the phase nearest to t - floor(t).
+struct filter_bank_t {
+	static constexpr unsigned PHASES = 256;
+	static constexpr unsigned BLOCK = 8;		// taps are padded to a multiple of this
+
+	double Ratio;
+	unsigned Half;
+	unsigned Taps;
+	std::vector<float> Coeffs;		// PHASES * Taps
+};
+
+const jarh::sinc &GetSinc() {
+	static const jarh::sinc SINC {512, 32};
+	return SINC;
+}
+
+std::shared_ptr<const filter_bank_t> MakeFilterBank(double Ratio) {
+	// TODO: cutoff is currently fixed to a value (.9f), make it modifiable.
+	const float CUTOFF = .9f;
+	const jarh::sinc &sinc = GetSinc();
+	const float step = std::min(1.f, static_cast<float>(Ratio)) * CUTOFF;
+
+	auto pBank = std::make_shared<filter_bank_t>();
+	pBank->Ratio = Ratio;
+	pBank->Half = static_cast<unsigned>(std::ceil(sinc.range() / step));
+	pBank->Taps = (pBank->Half * 2 + 2 + filter_bank_t::BLOCK - 1) / filter_bank_t::BLOCK * filter_bank_t::BLOCK;
+	pBank->Coeffs.resize(filter_bank_t::PHASES * pBank->Taps);
+
+	auto it = pBank->Coeffs.begin();
+	for (unsigned p = 0; p < filter_bank_t::PHASES; ++p) {
+		float frac = static_cast<float>(p) / filter_bank_t::PHASES;
+		for (unsigned k = 0; k < pBank->Taps; ++k)
+			*it++ = sinc((frac + pBank->Half - static_cast<float>(k)) * step) * step;
+	}
+
+	return pBank;
+}
+
+// Filter banks only depend on the quality level and the sample rate of the wave file, so they
+// are shared between all encoders
+std::shared_ptr<const filter_bank_t> GetFilterBank(int Quality, unsigned SampleRate) {
+	static std::mutex m;
+	static std::map<std::pair<int, unsigned>, std::shared_ptr<const filter_bank_t>> banks;
+
+	std::lock_guard<std::mutex> lock {m};
+	auto &pBank = banks[{Quality, SampleRate}];
+	if (!pBank) {
+		double base_freq = static_cast<double>(MASTER_CLOCK_NTSC) / CDPCM::DMC_PERIODS_NTSC[Quality];
+		pBank = MakeFilterBank(base_freq / SampleRate);
+	}
+	return pBank;
+}
+
+// Written with independent partial sums so that the compiler can vectorize it
+float Convolve(const float *x, const float *c, unsigned n) {
+	std::array<float, filter_bank_t::BLOCK> acc = { };
+	for (unsigned i = 0; i < n; i += filter_bank_t::BLOCK)
+		for (unsigned j = 0; j < filter_bank_t::BLOCK; ++j)
+			acc[j] += x[i + j] * c[i + j];
+	return ((acc[0] + acc[4]) + (acc[1] + acc[5])) + ((acc[2] + acc[6]) + (acc[3] + acc[7]));
+}
+
+// Encodes in blocks of this many delta bits, each block is made visible to the stream's
+// readers as soon as it is done
+const std::size_t STREAM_BLOCK = 4096;
+
+void ResampleRange(const filter_bank_t &bank, const float *Input, std::size_t Begin, std::size_t End, float *Out) {
+	const double step = 1. / bank.Ratio;
+	for (std::size_t n = Begin; n < End; ++n) {
+		double t = n * step;
+		auto i = static_cast<std::size_t>(t);
+		auto phase = static_cast<unsigned>((t - i) * filter_bank_t::PHASES + .5);
+		if (phase == filter_bank_t::PHASES) {
+			++i;
+			phase = 0;
+		}
+		Out[n] = Convolve(&Input[i], &bank.Coeffs[phase * bank.Taps], bank.Taps);
+	}
+}
+
+// Moves the delta counter towards each sample in turn
+class direct_encoder {
+public:
+	template <typename F>
+	void Push(float x, F &&Emit) {
+		int Sample = static_cast<int>(x) + DMC_BIAS;		// truncated like the original importer
+		bool up = Sample >= delta_;
+		delta_ = std::clamp(delta_ + (up ? 1 : -1), 0, DMC_MAX);
+		Emit(up);
+	}
+
+	template <typename F>
+	void Finish(F &&) {
+	}
+
+private:
+	int delta_ = DMC_BIAS;
+};
+
+// Viterbi search for the delta sequence with the least total squared error. Decisions are
+// committed once they are DELAY bits old, by which point the surviving paths have merged in
+// practice, so that the output can be played while the rest of the sample is encoded.
+class trellis_encoder {
+	static constexpr int STATES = DMC_MAX + 1;
+	static constexpr std::size_t DELAY = 1024;
+	static constexpr float INF = std::numeric_limits<float>::infinity();
+
+public:
+	trellis_encoder() {
+		cost_.fill(INF);
+		cost_[DMC_BIAS] = 0.f;
+		from_.reserve(DELAY * 2);
+	}
+
+	template <typename F>
+	void Push(float x, F &&Emit) {
+		x += DMC_BIAS;
+		std::array<float, STATES> next;
+		next.fill(INF);
+		auto &from = from_.emplace_back();
+		for (int s = 0; s < STATES; ++s) {
+			if (cost_[s] == INF)
+				continue;
+			for (int d : {-1, 1}) {
+				int ns = std::clamp(s + d, 0, DMC_MAX);
+				float e = ns - x;
+				if (float c = cost_[s] + e * e; c < next[ns]) {
+					next[ns] = c;
+					from[ns] = static_cast<std::uint8_t>(s);
+				}
+			}
+		}
+		cost_ = next;
+		if (from_.size() == DELAY * 2)
+			Commit(DELAY, Emit);
+	}
+
+	template <typename F>
+	void Finish(F &&Emit) {
+		Commit(0, Emit);
+	}
+
+private:
+	// Emits all but the last Keep decisions of the best path found so far
+	template <typename F>
+	void Commit(std::size_t Keep, F &&Emit) {
+		auto best = std::min_element(cost_.begin(), cost_.end());
+		const float base = *best;
+		std::vector<bool> bits(from_.size());
+		int s = static_cast<int>(best - cost_.begin());
+		for (std::size_t i = from_.size(); i-- > 0; ) {
+			int prev = from_[i][s];
+			bits[i] = s > prev || (s == prev && s == DMC_MAX);
+			s = prev;
+		}
+
+		const std::size_t Count = from_.size() - Keep;
+		for (std::size_t i = 0; i < Count; ++i)
+			Emit(bits[i]);
+		from_.erase(from_.begin(), from_.begin() + Count);
+		for (float &c : cost_)		// keep the path costs small enough for float precision
+			c -= base;
+	}
+
+	std::array<float, STATES> cost_;
+	std::vector<std::array<std::uint8_t, STATES>> from_;
+};
+
+template <typename Encoder>
+void EncodeStream(Encoder &&enc, const std::vector<float> *pResampled, float *pOut, const filter_bank_t &bank,
+	const float *Input, std::size_t Count, float Volume, ft0cc::doc::dpcm_sample &Sample, std::atomic<std::size_t> &Progress) {
+	// when resampling we must clip because of possible ringing.
+	const float MAX_AMP =  (1 << 16) - 1;
+	const float MIN_AMP = -(1 << 16) + 1; // just being symetric
+
+	std::size_t Pos = 0;
+	std::uint8_t Byte = 0;
+	unsigned Bit = 0;
+	auto Emit = [&] (bool up) {
+		Byte |= up << Bit;
+		if (++Bit == 8) {		// the last partial byte is dropped
+			Sample.set_sample_at(Pos++, Byte);
+			Byte = 0;
+			Bit = 0;
+		}
+	};
+
+	const float *x = pResampled ? pResampled->data() : pOut;
+	for (std::size_t b = 0; b < Count; b += STREAM_BLOCK) {
+		const std::size_t e = std::min(Count, b + STREAM_BLOCK);
+		if (!pResampled)
+			ResampleRange(bank, Input, b, e, pOut);
+		for (std::size_t n = b; n < e; ++n)
+			enc.Push(std::clamp(x[n], MIN_AMP, MAX_AMP) * Volume, Emit);
+		Progress.store(Pos, std::memory_order_release);
+	}
+	enc.Finish(Emit);
+}
+
+template <typename T>
+T ReadLE(const unsigned char *p) {
+	std::make_unsigned_t<T> x = 0;
+	for (std::size_t i = 0; i < sizeof(T); ++i)
+		x |= static_cast<std::make_unsigned_t<T>>(p[i]) << (i * 8);
+	return static_cast<T>(x);
+}
+
+} // namespace
+
+CDPCMStream::CDPCMStream(std::shared_ptr<const ft0cc::doc::dpcm_sample> pSample) :
+	sample_(std::move(pSample)), progress_(sample_->size()), done_(true)
+{
+}
+
+const std::shared_ptr<const ft0cc::doc::dpcm_sample> &CDPCMStream::GetSample() const {
+	return sample_;
+}
+
+const std::atomic<std::size_t> &CDPCMStream::GetProgress() const {
+	return progress_;
+}
+
+bool CDPCMStream::IsDone() const {
+	return done_.load(std::memory_order_acquire);
+}
+
+void CDPCMStream::Wait() const {
+	if (worker_.valid())
+		worker_.wait();
+}
+
+CDPCMEncoder::CDPCMEncoder(array_view<unsigned char> WaveData) {
+	const unsigned char *p = WaveData.data();
+	const std::size_t size = WaveData.size();
+	if (size < 12 || std::memcmp(p, "RIFF", 4) != 0 || std::memcmp(p + 8, "WAVE", 4) != 0)
+		throw std::runtime_error {"Not a RIFF wave file"};
+
+	unsigned Format = 0;
+	unsigned BlockAlign = 0;
+	const unsigned char *pData = nullptr;
+	std::size_t DataSize = 0;
+
+	for (std::size_t pos = 12; pos + 8 <= size; ) {
+		const unsigned char *pChunk = p + pos;
+		std::size_t ChunkSize = ReadLE<std::uint32_t>(pChunk + 4);
+		std::size_t Avail = std::min(ChunkSize, size - pos - 8);
+		if (!std::memcmp(pChunk, "fmt ", 4) && Avail >= 16) {
+			Format = ReadLE<std::uint16_t>(pChunk + 8);
+			channels_ = ReadLE<std::uint16_t>(pChunk + 10);
+			rate_ = ReadLE<std::uint32_t>(pChunk + 12);
+			BlockAlign = ReadLE<std::uint16_t>(pChunk + 20);
+			bits_ = ReadLE<std::uint16_t>(pChunk + 22);
+			if (Format == 0xFFFE && Avail >= 26)		// WAVE_FORMAT_EXTENSIBLE
+				Format = ReadLE<std::uint16_t>(pChunk + 32);
+		}
+		else if (!std::memcmp(pChunk, "data", 4)) {
+			pData = pChunk + 8;
+			DataSize = Avail;
+		}
+		pos += 8 + ChunkSize + (ChunkSize & 1);
+	}
+
+	const bool IsPCM = Format == 1 && bits_ >= 8 && bits_ <= 32;
+	const bool IsFloat = Format == 3 && bits_ == 32;
+	if ((!IsPCM && !IsFloat) || !channels_ || !rate_ || !pData || !DataSize || BlockAlign < channels_ * ((bits_ + 7) / 8))
+		throw std::runtime_error {"Unsupported or invalid wave file"};
+
+	// the lowest quality level reads the most input and needs the widest filter; nothing
+	// past the input of the longest possible sample is ever read
+	auto pBank = GetFilterBank(0, rate_);
+	const std::size_t MaxCount = ft0cc::doc::dpcm_sample::max_size * 8;
+	const std::size_t MaxFrames = static_cast<std::size_t>(MaxCount / pBank->Ratio) + 2 + pBank->Taps;
+
+	const unsigned Bytes = (bits_ + 7) / 8;
+	frames_ = std::min(DataSize / BlockAlign, MaxFrames);
+	margin_ = pBank->Taps + 1;
+
+	// zero padding on both ends removes all bounds checks from the filter loop
+	auto pPCM = std::make_shared<std::vector<float>>(margin_ + frames_ + margin_, 0.f);
+	float *pOut = pPCM->data() + margin_;
+	const std::size_t Frames = frames_;
+	for (std::size_t i = 0; i < Frames; ++i) {
+		const unsigned char *pFrame = pData + i * BlockAlign;
+		float sum = 0.f;
+		for (unsigned c = 0; c < channels_; ++c) {
+			const unsigned char *x = pFrame + c * Bytes;
+			if (IsFloat) {
+				std::uint32_t w = ReadLE<std::uint32_t>(x);
+				float f;
+				std::memcpy(&f, &w, sizeof(f));
+				sum += f * 32768.f;
+			}
+			else if (Bytes == 1)
+				sum += static_cast<float>((x[0] - 128) * 256);
+			else		// use the most significant 16 bits
+				sum += static_cast<float>(ReadLE<std::int16_t>(x + Bytes - 2));
+		}
+		pOut[i] = sum / channels_;
+	}
+	pcm_ = std::move(pPCM);
+}
+
+std::unique_ptr<CDPCMEncoder> CDPCMEncoder::FromFile(const fs::path &Path) {
+	std::ifstream file {Path, std::ios::in | std::ios::binary};
+	if (!file)
+		throw std::runtime_error {"Could not open file"};
+	std::vector<unsigned char> buf {std::istreambuf_iterator<char> {file}, std::istreambuf_iterator<char> { }};
+	return std::make_unique<CDPCMEncoder>(buf);
+}
+
+unsigned CDPCMEncoder::GetSampleRate() const {
+	return rate_;
+}
+
+unsigned CDPCMEncoder::GetChannels() const {
+	return channels_;
+}
+
+unsigned CDPCMEncoder::GetBitsPerSample() const {
+	return bits_;
+}
+
+CDPCMEncoder::job_t &CDPCMEncoder::Launch(int Quality, int Volume, dpcm_encode_mode_t Mode, std::launch Policy) {
+	Quality = std::clamp(Quality, 0, QUALITY_RANGE - 1);
+	auto &job = cache_[{Quality, Volume, Mode}];
+	if (job.Stream)
+		return job;
+
+	auto pBank = GetFilterBank(Quality, rate_);
+
+	// one delta bit per output sample
+	const std::size_t MaxCount = ft0cc::doc::dpcm_sample::max_size * 8;
+	const std::size_t Count = !frames_ ? 0 :
+		std::min(MaxCount, static_cast<std::size_t>((frames_ - 1) * pBank->Ratio) + 1);
+
+	// Adjust sample until size is x * $10 + 1 bytes
+	std::size_t Size = Count / 8;
+	while (Size < ft0cc::doc::dpcm_sample::max_size && (Size & 0x0F) != 1)
+		++Size;
+	job.Sample = std::make_shared<ft0cc::doc::dpcm_sample>(Size);
+	for (std::size_t i = Count / 8; i < Size; ++i)
+		job.Sample->set_sample_at(i, ft0cc::doc::dpcm_sample::pad_value);
+
+	job.Stream.reset(new CDPCMStream);
+	job.Stream->sample_ = job.Sample;
+
+	// the resampled signal only depends on the quality level, reuse it when changing the volume
+	std::shared_ptr<const std::vector<float>> pResampled;
+	auto &pSource = resampled_[Quality];
+	if (!pSource)
+		pSource = job.Stream;
+	else if (pSource->IsDone())
+		pResampled = pSource->resampled_;
+
+	const float volume = std::pow(10.f, Volume / 20.f) / 1024.f;		// Convert dB to linear
+	const float *Input = pcm_->data() + margin_ - pBank->Half;
+	job.Stream->worker_ = std::async(Policy, [pStream = job.Stream.get(), pSample = job.Sample.get(),
+		pPCM = pcm_, pBank, pResampled, Input, Count, Size, volume, Mode] {
+		std::shared_ptr<std::vector<float>> pOut;
+		if (!pResampled)
+			pOut = std::make_shared<std::vector<float>>(Count);
+		float *Out = pOut ? pOut->data() : nullptr;
+
+		if (Mode == dpcm_encode_mode_t::Trellis)
+			EncodeStream(trellis_encoder { }, pResampled.get(), Out, *pBank, Input, Count, volume, *pSample, pStream->progress_);
+		else
+			EncodeStream(direct_encoder { }, pResampled.get(), Out, *pBank, Input, Count, volume, *pSample, pStream->progress_);
+
+		pStream->resampled_ = pOut ? std::move(pOut) : std::move(pResampled);
+		pStream->progress_.store(Size, std::memory_order_release);
+		pStream->done_.store(true, std::memory_order_release);
+	});
+
+	return job;
+}
+
+std::shared_ptr<ft0cc::doc::dpcm_sample> CDPCMEncoder::Encode(int Quality, int Volume, dpcm_encode_mode_t Mode) {
+	auto &job = Launch(Quality, Volume, Mode, std::launch::deferred);
+	job.Stream->Wait();
+	return job.Sample;
+}
+
+std::shared_ptr<const CDPCMStream> CDPCMEncoder::EncodeAsync(int Quality, int Volume, dpcm_encode_mode_t Mode) {
+	return Launch(Quality, Volume, Mode, std::launch::async).Stream;
+}
+
+std::vector<std::shared_ptr<ft0cc::doc::dpcm_sample>>
+CDPCMEncoder::EncodeFiles(const std::vector<fs::path> &Paths, int Quality, int Volume, dpcm_encode_mode_t Mode) {
+	std::vector<std::future<std::shared_ptr<ft0cc::doc::dpcm_sample>>> tasks;
+	for (const auto &path : Paths)
+		tasks.push_back(std::async(std::launch::async, [&path, Quality, Volume, Mode] () -> std::shared_ptr<ft0cc::doc::dpcm_sample> {
+			try {
+				auto pSample = FromFile(path)->Encode(Quality, Volume, Mode);
+				pSample->rename(path.stem().u8string());
+				return pSample;
+			}
+			catch (std::runtime_error &) {
+				return nullptr;
+			}
+		}));
+
+	std::vector<std::shared_ptr<ft0cc::doc::dpcm_sample>> samples;
+	for (auto &task : tasks)
+		samples.push_back(task.get());
+	return samples;
+}
@@ -0,0 +1,116 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <vector>
+#include "array_view.h"
+#include "ft0cc/fs.h"
+
+namespace ft0cc::doc {
+class dpcm_sample;
+} // namespace ft0cc::doc
+
+// // // DPCM conversion of wave files, used by the PCM import dialog
+
+enum class dpcm_encode_mode_t {
+	Direct,		// moves the delta counter towards each sample in turn
+	Trellis,	// chooses the delta sequence with the least total squared error
+};
+
+// // // A sample that may still be in the middle of its conversion. The sample has its final
+// size from the start; the first GetProgress() bytes are final and may be read by another
+// thread while the rest are being encoded.
+class CDPCMStream {
+public:
+	// Wraps a sample that has already been converted
+	explicit CDPCMStream(std::shared_ptr<const ft0cc::doc::dpcm_sample> pSample);
+
+	const std::shared_ptr<const ft0cc::doc::dpcm_sample> &GetSample() const;
+	const std::atomic<std::size_t> &GetProgress() const;
+	bool IsDone() const;
+	void Wait() const;
+
+private:
+	friend class CDPCMEncoder;
+	CDPCMStream() = default;
+
+	std::shared_ptr<const ft0cc::doc::dpcm_sample> sample_;
+	std::shared_ptr<const std::vector<float>> resampled_;		// available once done
+	std::atomic<std::size_t> progress_ {0};
+	std::atomic<bool> done_ {false};
+	std::future<void> worker_;		// destroyed first, so that the worker never outlives the stream
+};
+
+class CDPCMEncoder {
+public:
+	static constexpr int QUALITY_RANGE = 16;		// one level per DMC period
+	static constexpr int VOLUME_RANGE = 12;		// +/- dB
+
+	// Decodes a RIFF wave image held in memory, throws std::runtime_error if the file is
+	// not a supported PCM wave file
+	explicit CDPCMEncoder(array_view<unsigned char> WaveData);
+	static std::unique_ptr<CDPCMEncoder> FromFile(const fs::path &Path);
+
+	unsigned GetSampleRate() const;
+	unsigned GetChannels() const;
+	unsigned GetBitsPerSample() const;
+
+	// Results are cached for each set of parameters, as the import dialog asks for the same
+	// sample every time it is previewed
+	std::shared_ptr<ft0cc::doc::dpcm_sample> Encode(int Quality, int Volume, dpcm_encode_mode_t Mode = dpcm_encode_mode_t::Direct);
+
+	// Starts the conversion on a worker thread and returns at once, the stream becomes
+	// playable as soon as its first block is encoded. Shares the cache with Encode.
+	std::shared_ptr<const CDPCMStream> EncodeAsync(int Quality, int Volume, dpcm_encode_mode_t Mode = dpcm_encode_mode_t::Direct);
+
+	// Converts several wave files in parallel, the samples are named after the files; files
+	// that cannot be read produce null entries
+	static std::vector<std::shared_ptr<ft0cc::doc::dpcm_sample>> EncodeFiles(const std::vector<fs::path> &Paths,
+		int Quality, int Volume, dpcm_encode_mode_t Mode = dpcm_encode_mode_t::Direct);
+
+private:
+	struct job_t {
+		std::shared_ptr<ft0cc::doc::dpcm_sample> Sample;
+		std::shared_ptr<CDPCMStream> Stream;
+	};
+
+	job_t &Launch(int Quality, int Volume, dpcm_encode_mode_t Mode, std::launch Policy);
+
+private:
+	std::shared_ptr<const std::vector<float>> pcm_;		// mixed to mono, 16-bit range, zero padded on both ends
+	std::size_t frames_ = 0;
+	std::size_t margin_ = 0;		// size of the zero padding
+	unsigned rate_ = 0;
+	unsigned channels_ = 0;
+	unsigned bits_ = 0;
+
+	std::map<int, std::shared_ptr<const CDPCMStream>> resampled_;		// first stream of each quality level
+	std::map<std::tuple<int, int, dpcm_encode_mode_t>, job_t> cache_;
+};
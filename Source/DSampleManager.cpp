@@ -35,7 +35,10 @@ std::shared_ptr<ft0cc::doc::dpcm_sample> CDSampleManager::GetDSample(unsigned In
 }
 
 std::shared_ptr<ft0cc::doc::dpcm_sample> CDSampleManager::ReleaseDSample(unsigned Index) {
-	return Index < m_pDSample.size() ? std::move(m_pDSample[Index]) : nullptr;
+	if (Index >= m_pDSample.size() || !m_pDSample[Index])		// // //
+		return nullptr;
+	dirty_ = true;
+	return std::move(m_pDSample[Index]);
 }
 
 void CDSampleManager::RemoveDSample(unsigned Index) {
@@ -53,6 +56,8 @@ bool CDSampleManager::SetDSample(unsigned Index, std::shared_ptr<ft0cc::doc::dpc
 		return false;
 	bool Changed = m_pDSample[Index] != pSamp;
 	m_pDSample[Index] = std::move(pSamp);
+	if (Changed)		// // //
+		dirty_ = true;
 	return Changed;
 }
 
@@ -86,3 +91,11 @@ unsigned int CDSampleManager::GetTotalSize() const
 			Size += x->size();
 	return Size;
 }
+
+bool CDSampleManager::IsDirty() const {		// // //
+	return dirty_;
+}
+
+void CDSampleManager::ClearDirty() {		// // //
+	dirty_ = false;
+}
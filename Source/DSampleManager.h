@@ -47,8 +47,13 @@ public:
 	unsigned int GetFirstFree() const;
 	unsigned int GetTotalSize() const;
 
+	// // // set by SetDSample, ReleaseDSample and RemoveDSample, not by samples edited in place
+	bool IsDirty() const;
+	void ClearDirty();
+
 	static const unsigned MAX_DSAMPLES;
 
 private:
 	std::vector<std::shared_ptr<ft0cc::doc::dpcm_sample>> m_pDSample;
+	bool dirty_ = true;		// // //
 };
@@ -27,6 +27,7 @@
 #include "array_view.h"
 #include "NumConv.h"
 #include <cstring>		// // //
+#include <algorithm>		// // //
 #include "Assertion.h"		// // //
 
 //
@@ -66,6 +67,19 @@ void CDocumentFile::Close() {
 	m_pFile->Close();
 }
 
+// // // in-memory document image, used for atomic and background saves
+
+void CDocumentFile::OpenBuffer(std::size_t Reserve) {
+	m_DocumentBuffer.clear();
+	m_DocumentBuffer.reserve(Reserve);
+	m_bBuffered = true;
+}
+
+std::vector<unsigned char> CDocumentFile::ReleaseBuffer() {
+	m_bBuffered = false;
+	return std::move(m_DocumentBuffer);
+}
+
 // CDocumentFile
 
 bool CDocumentFile::Finished() const
@@ -100,9 +114,19 @@ void CDocumentFile::CreateBlock(std::string_view ID, int Version)		// // //
 	m_pBlockData = std::vector<unsigned char>(m_iMaxBlockSize);		// // //
 }
 
-void CDocumentFile::ReallocateBlock()
+void CDocumentFile::ReserveBlock(std::size_t Size)		// // //
 {
-	m_iMaxBlockSize += BLOCK_SIZE;
+	Assert(!m_pBlockData.empty());
+
+	if (m_iBlockPointer + Size >= m_iMaxBlockSize)
+		ReallocateBlock(m_iBlockPointer + Size + 1);
+}
+
+void CDocumentFile::ReallocateBlock(std::size_t Required)		// // //
+{
+	// Grow geometrically so that large blocks are not copied once per BLOCK_SIZE bytes
+	while (m_iMaxBlockSize < Required)
+		m_iMaxBlockSize += std::max(m_iMaxBlockSize, BLOCK_SIZE);
 	m_pBlockData.resize(m_iMaxBlockSize);		// // //
 }
 
@@ -111,19 +135,11 @@ void CDocumentFile::WriteBlock(array_view<unsigned char> Data)		// // //
 	Assert(!m_pBlockData.empty());		// // //
 
 	// Allow block to grow in size
+	ReserveBlock(Data.size());
 
-	unsigned Previous = m_iBlockPointer;
-	while (!Data.empty()) {
-		auto Block = Data.subview(0, BLOCK_SIZE);
-
-		if ((m_iBlockPointer + Block.size()) >= m_iMaxBlockSize)
-			ReallocateBlock();
-
-		Block.copy(m_pBlockData.data() + m_iBlockPointer, Block.size());		// // //
-		m_iBlockPointer += Block.size();
-		Data.remove_front(Block.size());
-	}
-	m_iPreviousPointer = Previous;
+	Data.copy(m_pBlockData.data() + m_iBlockPointer, Data.size());		// // //
+	m_iPreviousPointer = m_iBlockPointer;
+	m_iBlockPointer += Data.size();
 }
 
 template <typename T>
@@ -378,6 +394,11 @@ unsigned CDocumentFile::Read(unsigned char *lpBuf, std::size_t nCount)		// // //
 void CDocumentFile::Write(const unsigned char *lpBuf, std::size_t nCount)		// // //
 {
 	m_iPreviousPosition = m_iFilePosition;
+	if (m_bBuffered) {		// // //
+		m_iFilePosition = m_DocumentBuffer.size();
+		m_DocumentBuffer.insert(m_DocumentBuffer.end(), lpBuf, lpBuf + nCount);
+		return;
+	}
 	m_iFilePosition = m_pFile->GetPosition();
 	m_pFile->WriteBytes({lpBuf, nCount});
 }
@@ -47,6 +47,10 @@ public:
 	void		Open(const fs::path &fname, std::ios::openmode nOpenFlags);		// // //
 	void		Close();
 
+	// // // in-memory document image
+	void		OpenBuffer(std::size_t Reserve = 0);
+	std::vector<unsigned char> ReleaseBuffer();
+
 	bool		Finished() const;
 
 	// Write functions
@@ -54,6 +58,7 @@ public:
 	void		EndDocument();
 
 	void		CreateBlock(std::string_view ID, int Version);		// // //
+	void		ReserveBlock(std::size_t Size);		// // //
 	void		WriteBlock(array_view<unsigned char> Data);		// // //
 	void		WriteBlockInt(int Value);
 	void		WriteBlockChar(char Value);
@@ -109,10 +114,12 @@ private:
 	void WriteBlockData(T Value);
 
 protected:
-	void ReallocateBlock();
+	void ReallocateBlock(std::size_t Required);		// // //
 
 protected:
 	std::unique_ptr<CSimpleFile> m_pFile;		// // //
+	std::vector<unsigned char> m_DocumentBuffer;		// // //
+	bool			m_bBuffered = false;
 
 	unsigned int	m_iFileVersion;
 	bool			m_bFileDone;
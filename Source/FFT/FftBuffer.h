@@ -52,18 +52,19 @@ public:
 	}
 
 	void Transform() {
-		FFT::transform_fwd(samples_, buffer_, window.cbegin());
+		FFT::transform_real_fwd(samples_, buffer_, window.cbegin());		// // //
 	}
 
+	// // // keeps the most recent N samples, oldest first
 	template <typename InputIt>
 	void CopyIn(InputIt Samples, std::size_t SampleCount) {
 		if (SampleCount > GetPoints()) {
-			SampleCount = GetPoints();
 			std::advance(Samples, SampleCount - GetPoints());
+			SampleCount = GetPoints();
 		}
 		std::copy(samples_.cbegin() + SampleCount, samples_.cend(), samples_.begin());
-		std::transform(Samples, Samples + SampleCount, samples_.begin(), [] (auto x) {
-			return std::complex<double>(x, 0);
+		std::transform(Samples, Samples + SampleCount, samples_.end() - SampleCount, [] (auto x) {
+			return static_cast<float>(x);
 		});
 	}
 
@@ -73,7 +74,7 @@ public:
 	}
 
 private:
-	std::array<std::complex<double>, N> samples_;
-	std::array<std::complex<double>, N> buffer_;
-	static constexpr auto window = details::make_hann_window<double, N>();
+	std::array<float, N> samples_ = { };		// // //
+	std::array<std::complex<float>, N / 2 + 1> buffer_ = { };
+	static constexpr auto window = details::make_hann_window<float, N>();
 };
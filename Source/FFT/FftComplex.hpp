@@ -131,6 +131,123 @@ public:
 	}
 };
 
+// // // split tables used by the real-input transform
+template <std::size_t N>
+constexpr std::array<std::size_t, N> make_bitrev_table() {
+	std::array<std::size_t, N> table = { };
+	for (std::size_t i = 0; i < N; ++i)
+		table[i] = reverseBits(i, floor_log2(N));
+	return table;
+}
+
+template <typename T, std::size_t N>
+constexpr std::array<T, N / 2> make_cos_table() {
+	std::array<T, N / 2> table = { };
+	for (std::size_t i = 0; i < N / 2; ++i)
+		table[i] = static_cast<T>(remez_cos(-2 * PI * i / N));
+	return table;
+}
+
+template <typename T, std::size_t N>
+constexpr std::array<T, N / 2> make_sin_table() {
+	std::array<T, N / 2> table = { };
+	for (std::size_t i = 0; i < N / 2; ++i)
+		table[i] = static_cast<T>(remez_sin(-2 * PI * i / N));
+	return table;
+}
+
+// // // Real-input FFT of N points, packed into one N/2-point complex FFT which runs on split
+// real / imaginary arrays with radix-4 passes (two radix-2 levels per pass over the data)
+template <typename T, std::size_t N>
+class RealTransformer {
+	static_assert(N >= 4 && !(N & (N - 1)), "FFT size must be a power of 2");
+
+	static constexpr std::size_t Half = N / 2;
+
+	static constexpr auto bitrev_table = make_bitrev_table<Half>();
+	static constexpr auto cos_table = make_cos_table<T, N>();
+	static constexpr auto sin_table = make_sin_table<T, N>();
+
+public:
+	// Writes the N / 2 + 1 non-negative frequency bins to d_first
+	template <typename InputIt, typename OutputIt, typename InputIt2>
+	void operator()(InputIt first, OutputIt d_first, InputIt2 window) {
+		// Even samples go to the real part, odd samples to the imaginary part
+		for (std::size_t i = 0; i < Half; ++i) {
+			const std::size_t j = bitrev_table[i];
+			re_[j] = static_cast<T>(*first++) * static_cast<T>(*window++);
+			im_[j] = static_cast<T>(*first++) * static_cast<T>(*window++);
+		}
+
+		std::size_t size = 1;
+		if (floor_log2(Half) % 2) {
+			RadixPass2();
+			size = 2;
+		}
+		for (; size < Half; size <<= 2)
+			RadixPass4(size);
+
+		// X[k] = E[k] + W^k O[k], where E = (Z[k] + Z*[-k]) / 2 and O = (Z[k] - Z*[-k]) / 2i
+		for (std::size_t k = 0; k <= Half; ++k) {
+			const std::size_t a = k % Half;
+			const std::size_t b = (Half - k) % Half;
+			const T er = (re_[a] + re_[b]) / 2;
+			const T ei = (im_[a] - im_[b]) / 2;
+			const T or_ = (im_[a] + im_[b]) / 2;
+			const T oi = (re_[b] - re_[a]) / 2;
+			const T c = k < Half ? cos_table[k] : T(-1);
+			const T s = k < Half ? sin_table[k] : T(0);
+			*d_first++ = std::complex<T>(er + c * or_ - s * oi, ei + c * oi + s * or_);
+		}
+	}
+
+private:
+	void RadixPass2() {
+		for (std::size_t i = 0; i < Half; i += 2) {
+			const T ar = re_[i], ai = im_[i];
+			const T br = re_[i + 1], bi = im_[i + 1];
+			re_[i] = ar + br; im_[i] = ai + bi;
+			re_[i + 1] = ar - br; im_[i + 1] = ai - bi;
+		}
+	}
+
+	// Merges the decimation-in-time levels of size 2h and 4h
+	void RadixPass4(std::size_t h) {
+		const std::size_t step1 = N / (2 * h);
+		const std::size_t step2 = N / (4 * h);
+		for (std::size_t i = 0; i < Half; i += 4 * h) {
+			T *xr = re_.data() + i;
+			T *xi = im_.data() + i;
+			for (std::size_t j = 0; j < h; ++j) {
+				const T w1r = cos_table[j * step1], w1i = sin_table[j * step1];
+				const T w2r = cos_table[j * step2], w2i = sin_table[j * step2];
+
+				const T br = xr[j + h] * w1r - xi[j + h] * w1i;
+				const T bi = xr[j + h] * w1i + xi[j + h] * w1r;
+				const T dr = xr[j + 3 * h] * w1r - xi[j + 3 * h] * w1i;
+				const T di = xr[j + 3 * h] * w1i + xi[j + 3 * h] * w1r;
+
+				const T a1r = xr[j] + br, a1i = xi[j] + bi;
+				const T b1r = xr[j] - br, b1i = xi[j] - bi;
+				const T c1r = xr[j + 2 * h] + dr, c1i = xi[j + 2 * h] + di;
+				const T d1r = xr[j + 2 * h] - dr, d1i = xi[j + 2 * h] - di;
+
+				// W_4h^(j + h) = -i W_4h^j
+				const T cr = c1r * w2r - c1i * w2i, ci = c1r * w2i + c1i * w2r;
+				const T dtr = d1r * w2i + d1i * w2r, dti = -(d1r * w2r - d1i * w2i);
+
+				xr[j] = a1r + cr; xi[j] = a1i + ci;
+				xr[j + 2 * h] = a1r - cr; xi[j + 2 * h] = a1i - ci;
+				xr[j + h] = b1r + dtr; xi[j + h] = b1i + dti;
+				xr[j + 3 * h] = b1r - dtr; xi[j + 3 * h] = b1i - dti;
+			}
+		}
+	}
+
+	std::array<T, Half> re_ = { };
+	std::array<T, Half> im_ = { };
+};
+
 } // namespace details
 
 /*
@@ -143,4 +260,13 @@ void transform_fwd(const std::array<std::complex<T>, N> &arr, std::array<std::co
 		details::Radix2Transformer<T, details::floor_log2(N)>()(arr.cbegin(), out.begin(), window);
 }
 
+/*
+ * // // // Computes the non-negative frequency bins of the DFT of the given real vector, whose length
+ * must be a power of 2. This takes about half the work of transform_fwd on the same input.
+ */
+template <typename T, std::size_t N, typename InputIt>
+void transform_real_fwd(const std::array<T, N> &arr, std::array<std::complex<T>, N / 2 + 1> &out, InputIt window) {
+	details::RealTransformer<T, N>()(arr.cbegin(), out.begin(), window);
+}
+
 } // namespace FFT
@@ -50,12 +50,6 @@
 #include <afxpriv.h>
 #endif
 
-int g_iPercMode = 0;	//sh8bit global variables for the percussion mode, being lazy to find them a proper place
-int g_iPercModePrev = 0;
-int g_iPercVolumeBD = 0;
-int g_iPercVolumeSDHH = 0;
-int g_iPercVolumeTOMCY = 0;
-
 // Single instance-stuff
 const WCHAR FT_SHARED_MUTEX_NAME[]	= L"LLTrackerMutex";	// Name of global mutex
 const WCHAR FT_SHARED_MEM_NAME[]	= L"LLTrackerWnd";		// Name of global memory area
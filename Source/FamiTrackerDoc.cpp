@@ -22,6 +22,7 @@
 
 #include "FamiTrackerDoc.h"
 #include "FamiTrackerModule.h"		// // //
+#include "InstrumentManager.h"		// // //
 #include "FamiTrackerEnv.h"		// // //
 #include "FamiTrackerViewMessage.h"		// // //
 #include "ModuleException.h"		// // //
@@ -33,6 +34,7 @@
 #include "ChannelMap.h"		// // //
 #include "FamiTrackerDocIO.h"		// // //
 #include "FamiTrackerDocOldIO.h"		// // //
+#include "AtomicFile.h"		// // //
 #include "str_conv/str_conv.hpp"		// // //
 
 //
@@ -114,9 +116,7 @@ BOOL CFamiTrackerDoc::OnOpenDocument(LPCWSTR lpszPathName)
 	// Update main frame
 	FTEnv.GetSoundGenerator()->ModuleChipChanged();		// // //
 
-#ifdef AUTOSAVE
 	SetupAutoSave();
-#endif
 
 	// Remove modified flag
 	SetModifiedFlag(FALSE);
@@ -190,9 +190,7 @@ void CFamiTrackerDoc::DeleteContents()
 		FTEnv.GetSoundGenerator()->DocumentPropertiesChanged(this);		// // // rebind module
 		FTEnv.GetSoundGenerator()->ModuleChipChanged();
 
-#ifdef AUTOSAVE
 		ClearAutoSave();
-#endif
 
 		// Remove modified flag
 		SetModifiedFlag(FALSE);
@@ -205,10 +203,8 @@ void CFamiTrackerDoc::DeleteContents()
 void CFamiTrackerDoc::SetModifiedFlag(BOOL bModified)
 {
 	// Trigger auto-save in 10 seconds
-#ifdef AUTOSAVE
 	if (bModified)
 		m_iAutoSaveCounter = 10;
-#endif
 
 	BOOL bWasModified = IsModified();
 	CDocument::SetModifiedFlag(bModified);
@@ -226,9 +222,7 @@ void CFamiTrackerDoc::CreateEmpty()
 		// and select VRC7 only
 		GetModule()->SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(sound_chip_t::VRC7, 0));		// // //
 
-#ifdef AUTOSAVE
 		SetupAutoSave();
-#endif
 
 		// Document is avaliable
 		m_bFileLoaded = true;
@@ -252,6 +246,8 @@ void CFamiTrackerDoc::Modify(bool Change) {
 }
 
 void CFamiTrackerDoc::ModifyIrreversible() {
+	// // // instrument and sample editors modify their objects in place
+	GetModule()->GetInstrumentManager()->SetDirty();
 	SetModifiedFlag(TRUE);
 	SetExceededFlag(TRUE);
 }
@@ -298,54 +294,27 @@ void CFamiTrackerDoc::OnFileSaveAs()
 
 BOOL CFamiTrackerDoc::SaveDocument(LPCWSTR lpszPathName) const
 {
-	CDocumentFile DocumentFile;
-	CFileException ex;
-
-	// First write to a temp file (if saving fails, the original is not destroyed)
-	fs::path TempPath = fs::temp_directory_path();
-	WCHAR TempFile[MAX_PATH] = { };
-	GetTempFileNameW(TempPath.c_str(), L"LTM", 0, TempFile);
-
-	try {		// // //
-		DocumentFile.Open(TempFile, std::ios::out | std::ios::binary);
-	}
-	catch (std::runtime_error err) {
-		AfxMessageBox(FormattedW(L"Could not save file: %s", conv::to_wide(err.what()).data()), MB_OK | MB_ICONERROR);
-		return FALSE;
-	}
-
-	if (!CFamiTrackerDocIO {DocumentFile, FTEnv.GetSettings()->Version.iErrorLevel}.Save(*GetModule())) {		// // //
-		// The save process failed, delete temp file
-		DocumentFile.Close();
-		fs::remove(TempFile);
+	// // // Serialize the whole module into memory first, then replace the original
+	// atomically (if saving fails, the original is not destroyed)
+	auto Image = SerializeDocument();
+	if (!Image) {
 		// Display error
 		AfxMessageBox(CStringW(MAKEINTRESOURCEW(IDS_SAVE_ERROR)), MB_OK | MB_ICONERROR);
 		return FALSE;
 	}
 
-	DocumentFile.Close();
-
 	// Save old creation date
 	CFileStatus stat;		// // //
 	CFile::GetStatus(lpszPathName, stat);
 	auto creationTime = stat.m_ctime;
 
-	// Everything is done and the program cannot crash at this point
-	// Replace the original
-
-	if (!fs::copy_file(TempFile, lpszPathName, fs::copy_options::overwrite_existing)) {
-		// Display message if saving failed
-		AfxDebugBreak();		// // //
-		LPWSTR lpMsgBuf;
-		FormatMessageW(FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS,
-			NULL, GetLastError(), MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT), (LPWSTR)&lpMsgBuf, 0, NULL);
-		AfxMessageBox(FormattedW(L"Could not save file: %s", lpMsgBuf), MB_OK | MB_ICONERROR);
-		LocalFree(lpMsgBuf);
-		// Remove temp file
-		fs::remove(TempFile);
+	try {		// // //
+		WriteFileAtomic(lpszPathName, *Image);
+	}
+	catch (std::runtime_error &err) {
+		AfxMessageBox(FormattedW(L"Could not save file: %s", conv::to_wide(err.what()).data()), MB_OK | MB_ICONERROR);
 		return FALSE;
 	}
-	fs::remove(TempFile);
 
 	// Restore creation date
 	CFile::GetStatus(lpszPathName, stat);
@@ -353,11 +322,20 @@ BOOL CFamiTrackerDoc::SaveDocument(LPCWSTR lpszPathName) const
 	CFile::SetStatus(lpszPathName, stat);
 
 	if (auto *pMainFrame = static_cast<CFrameWnd *>(AfxGetMainWnd()))		// // //
-		pMainFrame->SetMessageText(AfxFormattedW(IDS_FILE_SAVED, conv::to_wide(std::to_string(fs::file_size(lpszPathName))).data()));
+		pMainFrame->SetMessageText(AfxFormattedW(IDS_FILE_SAVED, conv::to_wide(std::to_string(Image->size())).data()));
 
 	return TRUE;
 }
 
+std::optional<std::vector<unsigned char>> CFamiTrackerDoc::SerializeDocument() const		// // //
+{
+	CDocumentFile DocumentFile;
+	DocumentFile.OpenBuffer();
+	if (!CFamiTrackerDocIO {DocumentFile, FTEnv.GetSettings()->Version.iErrorLevel}.Save(*GetModule()))
+		return std::nullopt;
+	return DocumentFile.ReleaseBuffer();
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Document load functions
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -472,12 +450,13 @@ bool CFamiTrackerDoc::HasLastLoadFailed() const
 	return m_bFileLoadFailed;
 }
 
-#ifdef AUTOSAVE
-
 // Auto-save (experimental)
 
 void CFamiTrackerDoc::SetupAutoSave()
 {
+	if (!FTEnv.GetSettings()->General.bAutoSave)		// // //
+		return;
+
 	WCHAR TempPath[MAX_PATH], TempFile[MAX_PATH];
 
 	GetTempPathW(MAX_PATH, TempPath);
@@ -488,11 +467,24 @@ void CFamiTrackerDoc::SetupAutoSave()
 	if (file.Open(TempFile, CFile::modeRead)) {
 		file.Close();
 		if (AfxMessageBox(L"It might be possible to recover last document, do you want to try?", MB_YESNO) == IDYES) {
-			OpenDocument(TempFile);
-			SelectExpansionChip(GetModule()->GetSoundChipSet(), GetModule()->GetNamcoChannels());
+			// // // merge the autosave journal into a regular module, then open that
+			try {
+				if (auto Image = CModuleJournal::Replay(TempFile); !Image.empty()) {
+					fs::path Recovered = fs::path {TempFile}.replace_extension(L".0cc");
+					WriteFileAtomic(Recovered, Image);
+					OpenDocument(Recovered.c_str());
+					fs::remove(Recovered);
+					FTEnv.GetSoundGenerator()->ModuleChipChanged();
+					FTEnv.GetSoundGenerator()->DocumentPropertiesChanged(this);
+				}
+			}
+			catch (std::runtime_error &) {
+				TRACE(L"Doc: Could not recover auto save file\n");
+			}
 		}
 		else {
-			fs::remove(TempFile);
+			std::error_code ec;		// // //
+			fs::remove(TempFile, ec);
 		}
 	}
 
@@ -501,6 +493,7 @@ void CFamiTrackerDoc::SetupAutoSave()
 	TRACE(L"\n");
 
 	m_sAutoSaveFile = TempFile;
+	m_AutoSaveJournal.Invalidate();		// // //
 }
 
 void CFamiTrackerDoc::ClearAutoSave()
@@ -508,7 +501,12 @@ void CFamiTrackerDoc::ClearAutoSave()
 	if (m_sAutoSaveFile.GetLength() == 0)
 		return;
 
-	fs::remove(m_sAutoSaveFile);
+	// // // wait for any pending background write before removing the file
+	if (m_AutoSaveTask.valid())
+		m_AutoSaveTask.wait();
+
+	std::error_code ec;		// // //
+	fs::remove((LPCWSTR)m_sAutoSaveFile, ec);
 
 	m_sAutoSaveFile = L"";
 	m_iAutoSaveCounter = 0;
@@ -519,15 +517,38 @@ void CFamiTrackerDoc::ClearAutoSave()
 void CFamiTrackerDoc::AutoSave()
 {
 	// Autosave
-	if (!m_iAutoSaveCounter || !m_bFileLoaded || m_sAutoSaveFile.GetLength() == 0)
+	if (!m_iAutoSaveCounter || !m_bFileLoaded || m_sAutoSaveFile.GetLength() == 0 || !FTEnv.GetSettings()->General.bAutoSave)		// // //
 		return;
 
 	--m_iAutoSaveCounter;
 
 	if (m_iAutoSaveCounter == 0) {
+		// // // do not pile up saves while the previous one is still being written
+		if (m_AutoSaveTask.valid() && m_AutoSaveTask.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+			m_iAutoSaveCounter = 1;
+			return;
+		}
+
 		TRACE(L"Doc: Performing auto save\n");
-		SaveDocument(m_sAutoSaveFile);
+
+		// // // a failed write leaves a gap in the journal, so start it over
+		if (m_AutoSaveTask.valid() && !m_AutoSaveTask.get())
+			m_AutoSaveJournal.Invalidate();
+
+		// // // collect the changes since the last auto save, then write them out on a worker thread
+		auto Commit = Locked([&] {
+			return m_AutoSaveJournal.Commit(*GetModule(), FTEnv.GetSettings()->Version.iErrorLevel);
+		});
+		if (Commit)
+			m_AutoSaveTask = std::async(std::launch::async, [Commit = std::move(*Commit), Path = fs::path {(LPCWSTR)m_sAutoSaveFile}] {
+				try {
+					CModuleJournal::Write(Path, Commit);
+					return true;
+				}
+				catch (std::runtime_error &) {
+					TRACE(L"Doc: Auto save failed\n");
+					return false;
+				}
+			});
 	}
 }
-
-#endif
@@ -26,9 +26,12 @@
 #include "stdafx.h"		// // //
 #include <memory>		// // //
 #include <type_traits>		// // //
+#include <vector>		// // //
+#include <optional>		// // //
+#include <future>		// // //
 #include "ft0cc/fs.h"		// // //
+#include "ModuleJournal.h"		// // //
 
-// #define AUTOSAVE
 // #define DISABLE_SAVE		// // //
 
 // External classes
@@ -58,9 +61,7 @@ public:
 
 
 	// Other
-#ifdef AUTOSAVE
 	void AutoSave();
-#endif
 
 	//
 	// Public functions
@@ -119,11 +120,10 @@ private:
 
 	BOOL			SaveDocument(LPCWSTR lpszPathName) const;
 	BOOL			OpenDocument(LPCWSTR lpszPathName);
+	std::optional<std::vector<unsigned char>> SerializeDocument() const;		// // //
 
-#ifdef AUTOSAVE
 	void			SetupAutoSave();
 	void			ClearAutoSave();
-#endif
 
 	//
 	// Private variables
@@ -140,11 +140,11 @@ private:
 	bool			m_bBackupDone = true;
 	bool			m_bExceeded = false;			// // //
 
-#ifdef AUTOSAVE
 	// Auto save
-	int				m_iAutoSaveCounter;
+	int				m_iAutoSaveCounter = 0;		// // //
 	CStringW			m_sAutoSaveFile;
-#endif
+	CModuleJournal		m_AutoSaveJournal;		// // //
+	std::future<bool>	m_AutoSaveTask;		// // //
 
 	// Thread synchronization
 	mutable CMutex	m_csDocumentLock;
@@ -31,6 +31,8 @@
 #include "str_conv/str_conv.hpp"
 #include "NumConv.h"
 #include "Assertion.h"
+#include <cstring>		// // //
+#include <algorithm>		// // //
 
 #include "FamiTrackerEnv.h"
 #include "SoundChipService.h"
@@ -165,7 +167,7 @@ bool CFamiTrackerDocIO::Load(CFamiTrackerModule &modfile) {
 	return true;
 }
 
-bool CFamiTrackerDocIO::Save(const CFamiTrackerModule &modfile) {
+bool CFamiTrackerDocIO::SaveBlocks(const CFamiTrackerModule &modfile, std::vector<std::string_view> *Changes) {
 	using block_info_t = std::tuple<void (CFamiTrackerDocIO::*)(const CFamiTrackerModule &, int), int, std::string_view>;
 	const block_info_t MODULE_WRITE_FUNC[] = {		// // //
 		{&CFamiTrackerDocIO::SaveParams,		6, FILE_BLOCK_PARAMS},
@@ -186,17 +188,56 @@ bool CFamiTrackerDocIO::Save(const CFamiTrackerModule &modfile) {
 		{&CFamiTrackerDocIO::SaveBookmarks,		1, FILE_BLOCK_BOOKMARKS},			// // //
 	};
 
-	file_.BeginDocument();
+	// // // blocks that depend only on songs or only on instruments
+	const std::string_view SONG_BLOCKS[] = {
+		FILE_BLOCK_HEADER, FILE_BLOCK_FRAMES, FILE_BLOCK_BOOKMARKS,
+	};
+	const std::string_view RESOURCE_BLOCKS[] = {
+		FILE_BLOCK_INSTRUMENTS, FILE_BLOCK_SEQUENCES, FILE_BLOCK_DSAMPLES,
+		FILE_BLOCK_SEQUENCES_VRC6, FILE_BLOCK_SEQUENCES_N163, FILE_BLOCK_SEQUENCES_S5B,
+	};
+
+	bool SongsDirty = modfile.IsStructureDirty();
+	modfile.VisitSongs([&] (const CSongData &song) {
+		if (song.IsDirty())
+			SongsDirty = true;
+	});
+	const bool ResourcesDirty = modfile.GetInstrumentManager()->IsDirty();
+
 	for (auto [fn, ver, name] : MODULE_WRITE_FUNC) {
+		if (Changes) {
+			if (!SongsDirty && std::find(std::begin(SONG_BLOCKS), std::end(SONG_BLOCKS), name) != std::end(SONG_BLOCKS))
+				continue;
+			if (!ResourcesDirty && std::find(std::begin(RESOURCE_BLOCKS), std::end(RESOURCE_BLOCKS), name) != std::end(RESOURCE_BLOCKS))
+				continue;
+			if (name == FILE_BLOCK_PATTERNS) {
+				if (!SongsDirty)
+					continue;
+				fn = &CFamiTrackerDocIO::SavePatternDiff;
+				name = FILE_BLOCK_PATTERN_DIFF;
+			}
+			Changes->push_back(name);
+		}
 		file_.CreateBlock(name.data(), ver);
 		(this->*fn)(modfile, ver);
 		if (!file_.FlushBlock())
 			return false;
 	}
+	return true;
+}
+
+bool CFamiTrackerDocIO::Save(const CFamiTrackerModule &modfile) {
+	file_.BeginDocument();
+	if (!SaveBlocks(modfile, nullptr))		// // //
+		return false;
 	file_.EndDocument();
 	return true;
 }
 
+bool CFamiTrackerDocIO::SaveChanges(const CFamiTrackerModule &modfile, std::vector<std::string_view> &BlockIDs) {		// // //
+	return SaveBlocks(modfile, &BlockIDs);
+}
+
 void CFamiTrackerDocIO::PostLoad(CFamiTrackerModule &modfile) {
 	if (file_.GetFileVersion() <= 0x0201)
 		compat::ReorderSequences(modfile, std::move(m_vTmpSequences));
@@ -954,15 +995,31 @@ void CFamiTrackerDocIO::SavePatterns(const CFamiTrackerModule &modfile, int ver)
 	 *
 	 */
 
+	// Save all rows
+	const unsigned int PatternLen = MAX_PATTERN_LENGTH;
+	//unsigned int PatternLen = Song.GetPatternLength();
+
+	const std::size_t HEADER_SIZE = sizeof(int) * 4;
+	const auto RowSize = [] (unsigned EffColumns) {
+		return sizeof(int) + 4 + EffColumns * 2;
+	};
+
+	// // // size pass, so that the block is allocated only once
+	std::size_t BlockSize = 0;
+	modfile.VisitSongs([&] (const CSongData &x) {
+		x.VisitPatterns([&] (const CPatternData &pattern, stChannelID ch, unsigned index) {
+			if (x.IsPatternInUse(ch, index))
+				if (unsigned Items = pattern.GetNoteCount(PatternLen))
+					BlockSize += HEADER_SIZE + Items * RowSize(x.GetEffectColumnCount(ch));
+		});
+	});
+	file_.ReserveBlock(BlockSize);
+
 	modfile.VisitSongs([&] (const CSongData &x, unsigned song) {
 		x.VisitPatterns([&] (const CPatternData &pattern, stChannelID ch, unsigned index) {
 			if (!x.IsPatternInUse(ch, index))		// // //
 				return;
 
-			// Save all rows
-			unsigned int PatternLen = MAX_PATTERN_LENGTH;
-			//unsigned int PatternLen = Song.GetPatternLength();
-
 			unsigned Items = pattern.GetNoteCount(PatternLen);
 			if (!Items)
 				return;
@@ -970,24 +1027,61 @@ void CFamiTrackerDocIO::SavePatterns(const CFamiTrackerModule &modfile, int ver)
 			file_.WriteBlockInt(modfile.GetChannelOrder().GetChannelIndex(ch));		// Write channel
 			file_.WriteBlockInt(index);		// Write pattern
 			file_.WriteBlockInt(Items);		// Number of items
+			SavePatternRows(pattern, x.GetEffectColumnCount(ch));
+		});
+	});
+}
 
-			pattern.VisitRows(PatternLen, [&] (const stChanNote &note, unsigned row) {
-				if (note == stChanNote { })
-					return;
-				file_.WriteBlockInt(row);
-				file_.WriteBlockChar(value_cast(note.Note));
-				file_.WriteBlockChar(note.Octave);
-				file_.WriteBlockChar(note.Instrument);
-				file_.WriteBlockChar(note.Vol);
-				for (int i = 0, EffColumns = x.GetEffectColumnCount(ch); i < EffColumns; ++i) {
-					file_.WriteBlockChar(value_cast(compat::EFF_CONVERSION_050.second[value_cast(note.Effects[i].fx)]));		// // // 050B
-					file_.WriteBlockChar(note.Effects[i].param);
-				}
-			});
+void CFamiTrackerDocIO::SavePatternDiff(const CFamiTrackerModule &modfile, int ver) {		// // //
+	const auto RowSize = [] (unsigned EffColumns) {
+		return sizeof(int) + 4 + EffColumns * 2;
+	};
+
+	modfile.VisitSongs([&] (const CSongData &x, unsigned song) {
+		x.VisitPatterns([&] (const CPatternData &pattern, stChannelID ch, unsigned index) {
+			if (!x.IsPatternDirty(ch, index))
+				return;
+
+			file_.WriteBlockInt(song);
+			file_.WriteBlockInt(modfile.GetChannelOrder().GetChannelIndex(ch));
+			file_.WriteBlockInt(index);
+
+			// same layout as a PATTERNS entry from the item count onwards
+			unsigned Items = x.IsPatternInUse(ch, index) ? pattern.GetNoteCount(MAX_PATTERN_LENGTH) : 0;
+			if (!Items) {
+				file_.WriteBlockInt(0);
+				return;
+			}
+			const unsigned EffColumns = x.GetEffectColumnCount(ch);
+			file_.WriteBlockInt(static_cast<int>(sizeof(int) + Items * RowSize(EffColumns)));
+			file_.WriteBlockInt(Items);
+			SavePatternRows(pattern, EffColumns);
 		});
 	});
 }
 
+void CFamiTrackerDocIO::SavePatternRows(const CPatternData &pattern, unsigned EffColumns) {		// // //
+	pattern.VisitRows(MAX_PATTERN_LENGTH, [&] (const stChanNote &note, unsigned row) {
+		if (note == stChanNote { })
+			return;
+
+		// // // encode the whole row, then append it in one go
+		unsigned char Buf[sizeof(int) + 4 + MAX_EFFECT_COLUMNS * 2];
+		int Row = row;
+		std::memcpy(Buf, &Row, sizeof(Row));
+		unsigned char *ptr = Buf + sizeof(Row);
+		*ptr++ = static_cast<unsigned char>(value_cast(note.Note));
+		*ptr++ = note.Octave;
+		*ptr++ = note.Instrument;
+		*ptr++ = note.Vol;
+		for (unsigned i = 0; i < EffColumns; ++i) {
+			*ptr++ = static_cast<unsigned char>(value_cast(compat::EFF_CONVERSION_050.second[value_cast(note.Effects[i].fx)]));		// // // 050B
+			*ptr++ = note.Effects[i].param;
+		}
+		file_.WriteBlock({Buf, static_cast<std::size_t>(ptr - Buf)});
+	});
+}
+
 void CFamiTrackerDocIO::LoadDSamples(CFamiTrackerModule &modfile, int ver) {
 	unsigned int Count = AssertRange(
 		static_cast<unsigned char>(file_.GetBlockChar()), 0U, CDSampleManager::MAX_DSAMPLES, "DPCM sample count");
@@ -24,12 +24,17 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include "OldSequence.h"
 #include "ModuleException.h"
 
 class CFamiTrackerModule;
 class CDocumentFile;
+class CPatternData;
+
+// // // pattern entries written by CFamiTrackerDocIO::SaveChanges in place of the PATTERNS block
+inline constexpr std::string_view FILE_BLOCK_PATTERN_DIFF = "PATTERN DIFF";
 
 class CFamiTrackerDocIO {
 public:
@@ -38,7 +43,14 @@ public:
 	bool Load(CFamiTrackerModule &modfile);
 	bool Save(const CFamiTrackerModule &modfile);
 
+	// // // Writes the blocks that may have changed since the module's dirty flags were last
+	// cleared, without the document header. Patterns are written as FILE_BLOCK_PATTERN_DIFF,
+	// where each entry is prefixed with its byte size and a size of 0 removes the pattern.
+	// BlockIDs receives every block considered, including empty ones that were not written.
+	bool SaveChanges(const CFamiTrackerModule &modfile, std::vector<std::string_view> &BlockIDs);
+
 private:
+	bool SaveBlocks(const CFamiTrackerModule &modfile, std::vector<std::string_view> *Changes);		// // //
 	void PostLoad(CFamiTrackerModule &modfile);
 
 	void LoadParams(CFamiTrackerModule &modfile, int ver);
@@ -61,6 +73,8 @@ private:
 
 	void LoadPatterns(CFamiTrackerModule &modfile, int ver);
 	void SavePatterns(const CFamiTrackerModule &modfile, int ver);
+	void SavePatternDiff(const CFamiTrackerModule &modfile, int ver);		// // //
+	void SavePatternRows(const CPatternData &pattern, unsigned EffColumns);		// // //
 
 	void LoadDSamples(CFamiTrackerModule &modfile, int ver);
 	void SaveDSamples(const CFamiTrackerModule &modfile, int ver);
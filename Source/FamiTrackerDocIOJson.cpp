@@ -40,6 +40,8 @@
 #include "ft0cc/doc/dpcm_sample.hpp"
 #include "ft0cc/doc/groove.hpp"
 #include <optional>
+#include <functional>
+#include <algorithm>
 #include "clip.h"
 
 using json = nlohmann::json;
@@ -150,10 +152,10 @@ void to_json(json &j, const stChanNote &note) {
 	for (const auto &cmd_ : note.Effects)
 		if (cmd_.fx != effect_t::none) {
 			j["effects"] = json::array();
-			for (const auto &[fx, param] : note.Effects)
-				if (fx != effect_t::none)
+			for (int i = 0; i < MAX_EFFECT_COLUMNS; ++i)
+				if (const auto &[fx, param] = note.Effects[i]; fx != effect_t::none)
 					j["effects"].push_back(json {
-						{"column", fx},
+						{"column", i},
 						{"name", std::string {EFF_CHAR[value_cast(fx)]}},
 						{"param", param},
 					});
@@ -408,6 +410,7 @@ void to_json(json &j, const CInstrument2A03 &inst) {
 	for (int n = 0; n < NOTE_COUNT; ++n)
 		if (auto d_index = inst.GetSampleIndex(n); d_index != CInstrument2A03::NO_DPCM)
 			j["dpcm_map"].push_back(json {
+				{"note", n},
 				{"dpcm_index", d_index},
 				{"pitch", inst.GetSamplePitch(n) & 0x0Fu},
 				{"loop", inst.GetSampleLoop(n)},
@@ -469,7 +472,7 @@ void to_json(json &j, const dpcm_sample &dpcm) {
 		{"samples", json::array()},
 	};
 	for (std::size_t i = 0, n = dpcm.size(); i < n; ++i)
-		j["values"].push_back(dpcm.sample_at(i));
+		j["samples"].push_back(dpcm.sample_at(i));
 }
 
 void to_json(json &j, const groove &groove) {
@@ -554,3 +557,1144 @@ void from_json(const json &j, groove &g) {
 }
 
 } // namespace ft0cc::doc
+
+
+
+// // // streaming export and import
+
+namespace {
+
+using token_t = CJsonReader::token_t;
+
+std::size_t json_sequence_size(const CSequence &seq) {
+	return 3 + (seq.GetLoopPoint() != (unsigned)-1) + (seq.GetReleasePoint() != (unsigned)-1);
+}
+
+void json_write_sequence_members(CJsonWriter &w, const CSequence &seq, sequence_t seq_type) {
+	w.Key("items");
+	w.BeginArray(seq.GetItemCount());
+	for (unsigned i = 0; i < seq.GetItemCount(); ++i)
+		w.Int(seq.GetItem(i));
+	w.EndArray();
+	if (auto loop = seq.GetLoopPoint(); loop != (unsigned)-1) {
+		w.Key("loop");
+		w.Int(loop);
+	}
+	w.Key("macro_id");
+	w.Int(value_cast(seq_type));
+	if (auto release = seq.GetReleasePoint(); release != (unsigned)-1) {
+		w.Key("release");
+		w.Int(release);
+	}
+	w.Key("setting_id");
+	w.Int(value_cast(seq.GetSetting()));
+}
+
+template <typename T>
+void json_write_array(CJsonWriter &w, array_view<T> values) {
+	w.BeginArray(values.size());
+	for (auto x : values)
+		w.Int(x);
+	w.EndArray();
+}
+
+void json_write_note(CJsonWriter &w, const stChanNote &note) {
+	std::string_view kind = "note";
+	switch (note.Note) {
+	case note_t::none: kind = "none"; break;
+	case note_t::halt: kind = "halt"; break;
+	case note_t::release: kind = "release"; break;
+	case note_t::echo: kind = "echo"; break;
+	default: break;
+	}
+	const bool has_value = note.Note == note_t::echo || is_note(note.Note);
+	const bool has_inst = note.Instrument < MAX_INSTRUMENTS || note.Instrument == HOLD_INSTRUMENT;
+	const bool has_vol = note.Vol < MAX_VOLUME;
+	const auto fx_count = static_cast<std::size_t>(std::count_if(std::begin(note.Effects), std::end(note.Effects),
+		[] (const stEffectCommand &cmd) { return cmd.fx != effect_t::none; }));
+
+	w.BeginObject(1 + (fx_count > 0) + has_inst + has_value + has_vol);
+	if (fx_count > 0) {
+		w.Key("effects");
+		w.BeginArray(fx_count);
+		for (int i = 0; i < MAX_EFFECT_COLUMNS; ++i)
+			if (const auto &[fx, param] = note.Effects[i]; fx != effect_t::none) {
+				w.BeginObject(3);
+				w.Key("column");
+				w.Int(i);
+				w.Key("name");
+				w.String(std::string_view {&EFF_CHAR[value_cast(fx)], 1});
+				w.Key("param");
+				w.Int(param);
+				w.EndObject();
+			}
+		w.EndArray();
+	}
+	if (has_inst) {
+		w.Key("inst_index");
+		w.Int(note.Instrument == HOLD_INSTRUMENT ? -1 : note.Instrument);
+	}
+	w.Key("kind");
+	w.String(kind);
+	if (has_value) {
+		w.Key("value");
+		w.Int(note.Note == note_t::echo ? note.Octave : note.ToMidiNote());
+	}
+	if (has_vol) {
+		w.Key("volume");
+		w.Int(note.Vol);
+	}
+	w.EndObject();
+}
+
+void json_write_pattern(CJsonWriter &w, const CPatternData &pattern) {
+	std::size_t count = 0;
+	pattern.VisitRows([&] (const stChanNote &note) {
+		if (note != stChanNote { })
+			++count;
+	});
+
+	w.BeginArray(count);
+	pattern.VisitRows([&] (const stChanNote &note, unsigned row) {
+		if (note != stChanNote { }) {
+			w.BeginObject(2);
+			w.Key("note");
+			json_write_note(w, note);
+			w.Key("row");
+			w.Int(row);
+			w.EndObject();
+		}
+	});
+	w.EndArray();
+}
+
+void json_write_track(CJsonWriter &w, const CTrackData &track, stChannelID ch, unsigned frames) {
+	w.BeginObject(5);
+	w.Key("chip");
+	w.String(FTEnv.GetSoundChipService()->GetChipShortName(ch.Chip));
+	w.Key("effect_columns");
+	w.Int(track.GetEffectColumnCount());
+	w.Key("frame_list");
+	w.BeginArray(frames);
+	for (unsigned f = 0; f < frames; ++f)
+		w.Int(track.GetFramePattern(f));
+	w.EndArray();
+
+	std::size_t count = 0;
+	track.VisitPatterns([&] (const CPatternData &pattern) {
+		if (pattern.GetNoteCount() > 0)
+			++count;
+	});
+	w.Key("patterns");
+	w.BeginArray(count);
+	track.VisitPatterns([&] (const CPatternData &pattern, std::size_t index) {
+		if (pattern.GetNoteCount() > 0) {
+			w.BeginObject(2);
+			w.Key("index");
+			w.Int(index);
+			w.Key("notes");
+			json_write_pattern(w, pattern);
+			w.EndObject();
+		}
+	});
+	w.EndArray();
+
+	w.Key("subindex");
+	w.Int(ch.Subindex);
+	w.EndObject();
+}
+
+void json_write_highlight(CJsonWriter &w, const stHighlight &hl) {
+	w.BeginArray(2);
+	w.Int(hl.First);
+	w.Int(hl.Second);
+	w.EndArray();
+}
+
+void json_write_song(CJsonWriter &w, const CSongData &song, const CChannelOrder &order) {
+	w.BeginObject(9);
+
+	w.Key("bookmarks");
+	w.BeginArray(song.GetBookmarks().GetCount());
+	for (const auto &bm : song.GetBookmarks()) {
+		w.BeginObject(5);
+		w.Key("frame");
+		w.Int(bm->m_iFrame);
+		w.Key("highlight");
+		json_write_highlight(w, bm->m_Highlight);
+		w.Key("name");
+		w.String(bm->m_sName);
+		w.Key("persist");
+		w.Bool(bm->m_bPersist);
+		w.Key("row");
+		w.Int(bm->m_iRow);
+		w.EndObject();
+	}
+	w.EndArray();
+
+	w.Key("frames");
+	w.Int(song.GetFrameCount());
+	w.Key("highlight");
+	json_write_highlight(w, song.GetRowHighlight());
+	w.Key("rows");
+	w.Int(song.GetPatternLength());
+	w.Key("speed");
+	w.Int(song.GetSongSpeed());
+	w.Key("tempo");
+	w.Int(song.GetSongTempo());
+	w.Key("title");
+	w.String(song.GetTitle());
+
+	std::size_t count = 0;
+	song.VisitTracks([&] (const CTrackData &, stChannelID ch) {
+		if (order.HasChannel(ch))
+			++count;
+	});
+	w.Key("tracks");
+	w.BeginArray(count);
+	song.VisitTracks([&] (const CTrackData &track, stChannelID ch) {
+		if (order.HasChannel(ch))
+			json_write_track(w, track, ch, song.GetFrameCount());
+	});
+	w.EndArray();
+
+	w.Key("uses_groove");
+	w.Bool(song.GetSongGroove());
+	w.EndObject();
+}
+
+void json_write_sequence_flags(CJsonWriter &w, const CSeqInstrument &inst) {
+	std::size_t count = 0;
+	for (auto t : enum_values<sequence_t>())
+		if (inst.GetSeqEnable(t))
+			++count;
+
+	w.Key("sequence_flags");
+	w.BeginArray(count);
+	for (auto t : enum_values<sequence_t>())
+		if (inst.GetSeqEnable(t)) {
+			w.BeginObject(2);
+			w.Key("macro_id");
+			w.Int(value_cast(t));
+			w.Key("seq_index");
+			w.Int(inst.GetSeqIndex(t));
+			w.EndObject();
+		}
+	w.EndArray();
+}
+
+void json_write_instrument(CJsonWriter &w, const CInstrument &inst, unsigned index) {
+	// members are written in sorted order, "dpcm_map" goes before "index"
+	const auto WriteCommon = [&] (std::size_t n, auto &&f) {
+		w.BeginObject(n);
+		w.Key("chip");
+		w.String(GetChipName(inst.GetType()));
+		f();
+		w.EndObject();
+	};
+	const auto WriteIndex = [&] {
+		w.Key("index");
+		w.Int(index);
+	};
+	const auto WriteName = [&] {
+		w.Key("name");
+		w.String(inst.GetName());
+	};
+
+	if (auto p2A03 = dynamic_cast<const CInstrument2A03 *>(&inst))
+		WriteCommon(5, [&] {
+			std::size_t count = 0;
+			for (int n = 0; n < NOTE_COUNT; ++n)
+				if (p2A03->GetSampleIndex(n) != CInstrument2A03::NO_DPCM)
+					++count;
+			w.Key("dpcm_map");
+			w.BeginArray(count);
+			for (int n = 0; n < NOTE_COUNT; ++n)
+				if (auto d_index = p2A03->GetSampleIndex(n); d_index != CInstrument2A03::NO_DPCM) {
+					w.BeginObject(5);
+					w.Key("delta");
+					w.Int(p2A03->GetSampleDeltaValue(n));
+					w.Key("dpcm_index");
+					w.Int(d_index);
+					w.Key("loop");
+					w.Bool(p2A03->GetSampleLoop(n));
+					w.Key("note");
+					w.Int(n);
+					w.Key("pitch");
+					w.Int(p2A03->GetSamplePitch(n) & 0x0Fu);
+					w.EndObject();
+				}
+			w.EndArray();
+			WriteIndex();
+			WriteName();
+			json_write_sequence_flags(w, *p2A03);
+		});
+	else if (auto pVRC7 = dynamic_cast<const CInstrumentVRC7 *>(&inst))
+		WriteCommon(4, [&] {
+			WriteIndex();
+			WriteName();
+			w.Key("patch");
+			if (pVRC7->GetPatch() > 0)
+				w.Int(pVRC7->GetPatch());
+			else {
+				w.BeginArray(8);
+				for (int i = 0; i < 8; ++i)
+					w.Int(pVRC7->GetCustomReg(i));
+				w.EndArray();
+			}
+		});
+	else if (auto pFDS = dynamic_cast<const CInstrumentFDS *>(&inst))
+		WriteCommon(5 + pFDS->GetModulationEnable(), [&] {
+			WriteIndex();
+			if (pFDS->GetModulationEnable()) {
+				w.Key("modulation");
+				w.BeginObject(4);
+				w.Key("delay");
+				w.Int(pFDS->GetModulationDelay());
+				w.Key("depth");
+				w.Int(pFDS->GetModulationDepth());
+				w.Key("rate");
+				w.Int(pFDS->GetModulationSpeed());
+				w.Key("table");
+				json_write_array(w, pFDS->GetModTable());
+				w.EndObject();
+			}
+			WriteName();
+
+			const sequence_t FDS_SEQUENCES[] = {sequence_t::Volume, sequence_t::Arpeggio, sequence_t::Pitch};
+			w.Key("sequences");
+			w.BeginArray(std::count_if(std::begin(FDS_SEQUENCES), std::end(FDS_SEQUENCES),
+				[&] (sequence_t t) { return pFDS->GetSeqEnable(t); }));
+			for (auto t : FDS_SEQUENCES)
+				if (pFDS->GetSeqEnable(t)) {
+					const CSequence &seq = *pFDS->GetSequence(t);
+					w.BeginObject(json_sequence_size(seq));
+					json_write_sequence_members(w, seq, t);
+					w.EndObject();
+				}
+			w.EndArray();
+
+			w.Key("wave");
+			json_write_array(w, pFDS->GetSamples());
+		});
+	else if (auto pN163 = dynamic_cast<const CInstrumentN163 *>(&inst))
+		WriteCommon(6, [&] {
+			WriteIndex();
+			WriteName();
+			json_write_sequence_flags(w, *pN163);
+			w.Key("wave_position");
+			w.Int(pN163->GetWavePos());
+			w.Key("waves");
+			w.BeginArray(pN163->GetWaveCount());
+			for (int i = 0; i < pN163->GetWaveCount(); ++i)
+				json_write_array(w, pN163->GetSamples(i));
+			w.EndArray();
+		});
+	else if (auto pSeq = dynamic_cast<const CSeqInstrument *>(&inst))
+		WriteCommon(4, [&] {
+			WriteIndex();
+			WriteName();
+			json_write_sequence_flags(w, *pSeq);
+		});
+	else
+		WriteCommon(3, [&] {
+			WriteIndex();
+			WriteName();
+		});
+}
+
+// void (*F)(std::string_view key), called on the first token of each member value
+template <typename F>
+void json_read_object(CJsonReader &r, F f) {
+	r.Expect(token_t::begin_object);
+	std::string key;
+	while (r.Next() == token_t::key) {
+		key = r.GetString();
+		r.Next();
+		f(std::string_view {key});
+	}
+}
+
+// void (*F)(), called on the first token of each element
+template <typename F>
+void json_read_array(CJsonReader &r, F f) {
+	r.Expect(token_t::begin_array);
+	while (r.Next() != token_t::end_array)
+		f();
+}
+
+template <typename T>
+T json_check_between(std::int64_t v, std::string_view k, T lo, T hi) {
+	if (v < static_cast<std::int64_t>(lo) || static_cast<std::int64_t>(hi) < v)
+		throw std::invalid_argument {"Value at " + std::string {k} + " must be between [" +
+			std::to_string(lo) + ", " + std::to_string(hi) + "], got " + std::to_string(v)};
+	return static_cast<T>(v);
+}
+
+template <typename T>
+T json_read_between(const CJsonReader &r, std::string_view k, T lo, T hi) {
+	return json_check_between(r.GetInt(), k, lo, hi);
+}
+
+sound_chip_t json_read_chip(const CJsonReader &r) {
+	const auto name = r.GetString();
+	auto chip = sound_chip_t::none;
+	FTEnv.GetSoundChipService()->ForeachType([&] (sound_chip_t c) {
+		if (FTEnv.GetSoundChipService()->GetChipShortName(c) == name)
+			chip = c;
+	});
+	if (chip == sound_chip_t::none)
+		throw std::invalid_argument {"Unknown sound chip: " + std::string {name}};
+	return chip;
+}
+
+stHighlight json_read_highlight(CJsonReader &r) {
+	stHighlight hl;
+	unsigned i = 0;
+	json_read_array(r, [&] {
+		switch (i++) {
+		case 0: hl.First = json_read_between(r, "highlight", 0, MAX_PATTERN_LENGTH); break;
+		case 1: hl.Second = json_read_between(r, "highlight", 0, MAX_PATTERN_LENGTH); break;
+		default: r.Skip();
+		}
+	});
+	return hl;
+}
+
+stChanNote json_read_note(CJsonReader &r, sound_chip_t chip) {		// // //
+	stChanNote note;
+	std::string kind;
+	std::optional<std::int64_t> value;
+
+	json_read_object(r, [&] (std::string_view k) {
+		if (k == "kind")
+			kind = r.GetString();
+		else if (k == "value")
+			value = r.GetInt();
+		else if (k == "volume")
+			note.Vol = json_read_between(r, k, 0, MAX_VOLUME - 1);
+		else if (k == "inst_index") {
+			auto inst = json_read_between(r, k, -1, MAX_INSTRUMENTS - 1);
+			note.Instrument = inst == -1 ? HOLD_INSTRUMENT : inst;
+		}
+		else if (k == "effects")
+			json_read_array(r, [&] {
+				std::optional<int> col;
+				std::string name;
+				int param = 0;
+				json_read_object(r, [&] (std::string_view fk) {
+					if (fk == "column")
+						col = json_read_between(r, fk, 0, MAX_EFFECT_COLUMNS - 1);
+					else if (fk == "name")
+						name = r.GetString();
+					else if (fk == "param")
+						param = json_read_between(r, fk, 0, 255);
+					else
+						r.Skip();
+				});
+				if (!col)
+					throw std::invalid_argument {"Effect column is missing"};
+				if (name.size() != 1u)
+					throw std::invalid_argument {"Effect name must be 1 character long"};
+				effect_t effect = FTEnv.GetSoundChipService()->TranslateEffectName(name.front(), chip);		// // //
+				if (effect == effect_t::none)
+					throw std::invalid_argument {"Invalid effect name"};
+				note.Effects[*col].fx = effect;
+				note.Effects[*col].param = param;
+			});
+		else
+			r.Skip();
+	});
+
+	if (kind == "note") {
+		if (!value)
+			throw std::invalid_argument {"Note value is missing"};
+		int midiNote = json_check_between(*value, "value", 0, 95);
+		note.Note = ft0cc::doc::pitch_from_midi(midiNote);
+		note.Octave = ft0cc::doc::oct_from_midi(midiNote);
+	}
+	else if (kind == "halt")
+		note.Note = note_t::halt;
+	else if (kind == "release")
+		note.Note = note_t::release;
+	else if (kind == "echo") {
+		if (!value)
+			throw std::invalid_argument {"Echo buffer index is missing"};
+		note.Note = note_t::echo;
+		note.Octave = json_check_between(*value, "value", (std::size_t)0u, ECHO_BUFFER_LENGTH - 1);
+	}
+
+	return note;
+}
+
+void json_read_pattern(CJsonReader &r, CPatternData &pattern, sound_chip_t chip) {		// // //
+	json_read_array(r, [&] {
+		stChanNote note;
+		std::optional<unsigned> row;
+		json_read_object(r, [&] (std::string_view k) {
+			if (k == "note")
+				note = json_read_note(r, chip);		// // //
+			else if (k == "row")
+				row = json_read_between(r, k, 0, MAX_PATTERN_LENGTH - 1);
+			else
+				r.Skip();
+		});
+		if (!row)
+			throw std::invalid_argument {"Pattern row index is missing"};
+		pattern.SetNoteOn(*row, note);
+	});
+}
+
+void json_read_track(CJsonReader &r, CSongData &song) {
+	// the channel is only known after all members are read, but effect names depend on the chip
+	CTrackData track;
+	auto chip = sound_chip_t::none;
+	std::optional<std::uint8_t> subindex;
+
+	json_read_object(r, [&] (std::string_view k) {
+		if (k == "chip")
+			chip = json_read_chip(r);
+		else if (k == "subindex")
+			subindex = json_read_between(r, k, 0, 0xFF);
+		else if (k == "effect_columns")
+			track.SetEffectColumnCount(json_read_between(r, k, 1, MAX_EFFECT_COLUMNS));
+		else if (k == "frame_list") {
+			unsigned f = 0;
+			json_read_array(r, [&] {
+				if (f >= MAX_FRAMES)
+					throw std::invalid_argument {"Too many frames"};
+				track.SetFramePattern(f++, json_read_between(r, "frame_list", 0, MAX_PATTERN - 1));
+			});
+		}
+		else if (k == "patterns") {
+			if (chip == sound_chip_t::none)		// // //
+				throw std::invalid_argument {"Track chip must precede its patterns"};
+			json_read_array(r, [&] {
+				std::optional<unsigned> index;
+				CPatternData pattern;
+				json_read_object(r, [&] (std::string_view pk) {
+					if (pk == "index")
+						index = json_read_between(r, pk, 0, MAX_PATTERN - 1);
+					else if (pk == "notes")
+						json_read_pattern(r, pattern, chip);		// // //
+					else
+						r.Skip();
+				});
+				if (!index)
+					throw std::invalid_argument {"Pattern index is missing"};
+				track.GetPattern(*index) = std::move(pattern);
+			});
+		}
+		else
+			r.Skip();
+	});
+
+	if (chip == sound_chip_t::none || !subindex)
+		throw std::invalid_argument {"Track channel is missing"};
+	CTrackData *pTrack = song.GetTrack(stChannelID {chip, *subindex});
+	if (!pTrack)
+		throw std::invalid_argument {"Invalid track channel"};
+	*pTrack = std::move(track);
+}
+
+void json_read_song(CJsonReader &r, CSongData &song) {
+	json_read_object(r, [&] (std::string_view k) {
+		if (k == "speed")
+			song.SetSongSpeed(json_read_between(r, k, 0, MAX_TEMPO));
+		else if (k == "tempo")
+			song.SetSongTempo(json_read_between(r, k, 0, MAX_TEMPO));
+		else if (k == "frames")
+			song.SetFrameCount(json_read_between(r, k, 1, MAX_FRAMES));
+		else if (k == "rows")
+			song.SetPatternLength(json_read_between(r, k, 1, MAX_PATTERN_LENGTH));
+		else if (k == "title")
+			song.SetTitle(r.GetString());
+		else if (k == "uses_groove")
+			song.SetSongGroove(r.GetBool());
+		else if (k == "highlight")
+			song.SetRowHighlight(json_read_highlight(r));
+		else if (k == "bookmarks") {
+			CBookmarkCollection bookmarks;
+			json_read_array(r, [&] {
+				auto pMark = std::make_unique<CBookmark>();
+				json_read_object(r, [&] (std::string_view bk) {
+					if (bk == "frame")
+						pMark->m_iFrame = json_read_between(r, bk, 0, MAX_FRAMES - 1);
+					else if (bk == "row")
+						pMark->m_iRow = json_read_between(r, bk, 0, MAX_PATTERN_LENGTH - 1);
+					else if (bk == "name")
+						pMark->m_sName = r.GetString();
+					else if (bk == "persist")
+						pMark->m_bPersist = r.GetBool();
+					else if (bk == "highlight")
+						pMark->m_Highlight = json_read_highlight(r);
+					else
+						r.Skip();
+				});
+				bookmarks.AddBookmark(std::move(pMark));
+			});
+			song.SetBookmarks(std::move(bookmarks));
+		}
+		else if (k == "tracks")
+			json_read_array(r, [&] {
+				json_read_track(r, song);
+			});
+		else
+			r.Skip();
+	});
+}
+
+// reads the members written by json_write_sequence_members, other members are passed to f
+template <typename F>
+std::shared_ptr<CSequence> json_read_sequence_members(CJsonReader &r, F f) {
+	std::optional<sequence_t> seq_type;
+	std::vector<std::int8_t> items;
+	unsigned loop = (unsigned)-1;
+	unsigned release = (unsigned)-1;
+	int setting = 0;
+
+	json_read_object(r, [&] (std::string_view k) {
+		if (k == "macro_id")
+			seq_type = enum_cast<sequence_t>(json_read_between(r, k, 0, (int)SEQ_COUNT - 1));
+		else if (k == "items")
+			json_read_array(r, [&] {
+				if (items.size() >= MAX_SEQUENCE_ITEMS)
+					throw std::invalid_argument {"Too many sequence items"};
+				items.push_back(json_read_between(r, "items", -128, 127));
+			});
+		else if (k == "loop")
+			loop = json_read_between(r, k, 0, MAX_SEQUENCE_ITEMS - 1);
+		else if (k == "release")
+			release = json_read_between(r, k, 0, MAX_SEQUENCE_ITEMS - 1);
+		else if (k == "setting_id")
+			setting = json_read_between(r, k, 0, 0xFF);
+		else
+			f(k);
+	});
+
+	if (!seq_type)
+		throw std::invalid_argument {"Sequence macro_id is missing"};
+	auto pSeq = std::make_shared<CSequence>(*seq_type);
+	pSeq->SetItemCount(items.size());
+	for (std::size_t i = 0; i < items.size(); ++i)
+		pSeq->SetItem(i, items[i]);
+	pSeq->SetLoopPoint(loop);
+	pSeq->SetReleasePoint(release);
+	pSeq->SetSetting(static_cast<seq_setting_t>(setting));
+	return pSeq;
+}
+
+std::optional<inst_type_t> json_read_inst_type(const CJsonReader &r) {
+	for (auto t : {INST_2A03, INST_VRC6, INST_VRC7, INST_FDS, INST_N163, INST_S5B})
+		if (GetChipName(t) == r.GetString())
+			return t;
+	return std::nullopt;
+}
+
+void json_read_sequence(CJsonReader &r, CFamiTrackerModule &modfile) {
+	std::optional<inst_type_t> inst_type;
+	std::optional<unsigned> index;
+
+	auto pSeq = json_read_sequence_members(r, [&] (std::string_view k) {
+		if (k == "chip")
+			inst_type = json_read_inst_type(r);
+		else if (k == "index")
+			index = json_read_between(r, k, 0, MAX_SEQUENCES - 1);
+		else
+			r.Skip();
+	});
+
+	if (!inst_type || *inst_type == INST_VRC7 || *inst_type == INST_FDS || !index)
+		throw std::invalid_argument {"Sequence chip or index is missing"};
+	const sequence_t seq_type = pSeq->GetSequenceType();
+	modfile.GetInstrumentManager()->SetSequence(*inst_type, seq_type, *index, std::move(pSeq));
+}
+
+template <typename T>
+T &json_instrument_cast(CInstrument &inst, const std::string &k) {
+	if (auto *pInst = dynamic_cast<T *>(&inst))
+		return *pInst;
+	throw std::invalid_argument {"Instrument member " + k + " does not belong to the instrument's chip"};
+}
+
+template <typename T>
+std::vector<T> json_read_int_array(CJsonReader &r, std::string_view k, std::size_t n, T lo, T hi) {
+	std::vector<T> values;
+	json_read_array(r, [&] {
+		if (values.size() >= n)
+			throw std::invalid_argument {"Too many values at " + std::string {k}};
+		values.push_back(json_read_between(r, k, lo, hi));
+	});
+	return values;
+}
+
+void json_read_instrument(CJsonReader &r, CFamiTrackerModule &modfile) {
+	// the chip is only known after all members are read, so they are applied afterwards
+	std::optional<inst_type_t> inst_type;
+	std::optional<unsigned> index;
+	std::string name;
+	std::vector<std::function<void (CInstrument &)>> members;
+
+	json_read_object(r, [&] (std::string_view k) {
+		const std::string key {k};
+		if (k == "chip")
+			inst_type = json_read_inst_type(r);
+		else if (k == "index")
+			index = json_read_between(r, k, 0, MAX_INSTRUMENTS - 1);
+		else if (k == "name")
+			name = r.GetString();
+		else if (k == "sequence_flags")
+			json_read_array(r, [&] {
+				std::optional<sequence_t> seq_type;
+				int seq_index = 0;
+				json_read_object(r, [&] (std::string_view sk) {
+					if (sk == "macro_id")
+						seq_type = enum_cast<sequence_t>(json_read_between(r, sk, 0, (int)SEQ_COUNT - 1));
+					else if (sk == "seq_index")
+						seq_index = json_read_between(r, sk, 0, MAX_SEQUENCES - 1);
+					else
+						r.Skip();
+				});
+				if (!seq_type)
+					throw std::invalid_argument {"Sequence flag macro_id is missing"};
+				members.push_back([=] (CInstrument &inst) {
+					auto &seqInst = json_instrument_cast<CSeqInstrument>(inst, key);
+					seqInst.SetSeqEnable(*seq_type, true);
+					seqInst.SetSeqIndex(*seq_type, seq_index);
+				});
+			});
+		else if (k == "dpcm_map")
+			json_read_array(r, [&] {
+				std::optional<int> note;
+				std::optional<unsigned> d_index;
+				int pitch = 0xF;
+				bool loop = false;
+				int delta = -1;
+				json_read_object(r, [&] (std::string_view dk) {
+					if (dk == "note")
+						note = json_read_between(r, dk, 0, NOTE_COUNT - 1);
+					else if (dk == "dpcm_index")
+						d_index = json_read_between(r, dk, 0u, CDSampleManager::MAX_DSAMPLES - 1);
+					else if (dk == "pitch")
+						pitch = json_read_between(r, dk, 0, 0xF);
+					else if (dk == "loop")
+						loop = r.GetBool();
+					else if (dk == "delta")
+						delta = json_read_between(r, dk, -1, 0x7F);
+					else
+						r.Skip();
+				});
+				if (!note || !d_index)
+					throw std::invalid_argument {"DPCM assignment note or dpcm_index is missing"};
+				members.push_back([=] (CInstrument &inst) {
+					auto &inst2A03 = json_instrument_cast<CInstrument2A03>(inst, key);
+					inst2A03.SetSampleIndex(*note, *d_index);
+					inst2A03.SetSamplePitch(*note, static_cast<char>(pitch));
+					inst2A03.SetSampleLoop(*note, loop);
+					inst2A03.SetSampleDeltaValue(*note, static_cast<char>(delta));
+				});
+			});
+		else if (k == "patch") {
+			if (r.GetToken() == token_t::begin_array) {
+				auto regs = json_read_int_array(r, k, 8, 0, 0xFF);
+				members.push_back([=] (CInstrument &inst) {
+					auto &instVRC7 = json_instrument_cast<CInstrumentVRC7>(inst, key);
+					instVRC7.SetPatch(0);
+					for (std::size_t i = 0; i < regs.size(); ++i)
+						instVRC7.SetCustomReg(i, static_cast<unsigned char>(regs[i]));
+				});
+			}
+			else {
+				unsigned patch = json_read_between(r, k, 0, 0xF);
+				members.push_back([=] (CInstrument &inst) {
+					json_instrument_cast<CInstrumentVRC7>(inst, key).SetPatch(patch);
+				});
+			}
+		}
+		else if (k == "wave") {
+			auto wave = json_read_int_array<unsigned char>(r, k, CInstrumentFDS::WAVE_SIZE, 0, 0x3F);
+			members.push_back([=] (CInstrument &inst) {
+				json_instrument_cast<CInstrumentFDS>(inst, key).SetSamples(wave);
+			});
+		}
+		else if (k == "modulation") {
+			int delay = 0, depth = 0, rate = 0;
+			std::vector<unsigned char> table;
+			json_read_object(r, [&] (std::string_view mk) {
+				if (mk == "delay")
+					delay = json_read_between(r, mk, 0, 0xFF);
+				else if (mk == "depth")
+					depth = json_read_between(r, mk, 0, 0x3F);
+				else if (mk == "rate")
+					rate = json_read_between(r, mk, 0, 0xFFF);
+				else if (mk == "table")
+					table = json_read_int_array<unsigned char>(r, mk, CInstrumentFDS::MOD_SIZE, 0, 7);
+				else
+					r.Skip();
+			});
+			members.push_back([=] (CInstrument &inst) {
+				auto &instFDS = json_instrument_cast<CInstrumentFDS>(inst, key);
+				instFDS.SetModulationEnable(true);
+				instFDS.SetModTable(table);
+				instFDS.SetModulationDelay(delay);
+				instFDS.SetModulationDepth(depth);
+				instFDS.SetModulationSpeed(rate);
+			});
+		}
+		else if (k == "sequences")
+			json_read_array(r, [&] {
+				auto pSeq = json_read_sequence_members(r, [&] (std::string_view) {
+					r.Skip();
+				});
+				members.push_back([=] (CInstrument &inst) {
+					json_instrument_cast<CInstrumentFDS>(inst, key).SetSequence(pSeq->GetSequenceType(), pSeq);
+				});
+			});
+		else if (k == "wave_position") {
+			int pos = json_read_between(r, k, 0, CInstrumentN163::MAX_WAVE_SIZE - 1);
+			members.push_back([=] (CInstrument &inst) {
+				json_instrument_cast<CInstrumentN163>(inst, key).SetWavePos(pos);
+			});
+		}
+		else if (k == "waves") {
+			std::vector<std::vector<int>> waves;
+			json_read_array(r, [&] {
+				if (waves.size() >= static_cast<std::size_t>(CInstrumentN163::MAX_WAVE_COUNT))
+					throw std::invalid_argument {"Too many N163 waves"};
+				waves.push_back(json_read_int_array(r, k, CInstrumentN163::MAX_WAVE_SIZE, 0, 0xF));
+				if (waves.back().size() != waves.front().size() || waves.back().size() < 4u)
+					throw std::invalid_argument {"N163 waves must have the same size of at least 4"};
+			});
+			if (!waves.empty())
+				members.push_back([=] (CInstrument &inst) {
+					auto &instN163 = json_instrument_cast<CInstrumentN163>(inst, key);
+					instN163.SetWaveSize(waves.front().size());
+					instN163.SetWaveCount(waves.size());
+					for (std::size_t i = 0; i < waves.size(); ++i)
+						instN163.SetSamples(i, waves[i]);
+				});
+		}
+		else
+			r.Skip();
+	});
+
+	if (!inst_type || !index)
+		throw std::invalid_argument {"Instrument chip or index is missing"};
+	auto *pManager = modfile.GetInstrumentManager();
+	std::shared_ptr<CInstrument> pInst = pManager->CreateNew(*inst_type);
+	pInst->SetName(name);
+	for (const auto &f : members)
+		f(*pInst);
+	pManager->InsertInstrument(*index, std::move(pInst));
+}
+
+} // namespace
+
+void WriteModuleJson(std::ostream &os, const CFamiTrackerModule &modfile, json_format_t fmt) {
+	CJsonWriter w {os, fmt};
+	const auto &order = modfile.GetChannelOrder();
+	const auto *pManager = modfile.GetInstrumentManager();
+
+	w.BeginObject(9);
+
+	w.Key("channels");
+	w.BeginArray(order.GetChannelCount());
+	order.ForeachChannel([&] (stChannelID ch) {
+		w.BeginObject(2);
+		w.Key("chip");
+		w.String(FTEnv.GetSoundChipService()->GetChipShortName(ch.Chip));
+		w.Key("subindex");
+		w.Int(ch.Subindex);
+		w.EndObject();
+	});
+	w.EndArray();
+
+	std::size_t detunes = 0;
+	for (int i = 0; i < 6; ++i)
+		for (int n = 0; n < NOTE_COUNT; ++n)
+			if (modfile.GetDetuneOffset(i, n))
+				++detunes;
+	w.Key("detunes");
+	w.BeginArray(detunes);
+	for (int i = 0; i < 6; ++i)
+		for (int n = 0; n < NOTE_COUNT; ++n)
+			if (auto offs = modfile.GetDetuneOffset(i, n)) {
+				w.BeginObject(3);
+				w.Key("note");
+				w.Int(n);
+				w.Key("offset");
+				w.Int(offs);
+				w.Key("table_id");
+				w.Int(i);
+				w.EndObject();
+			}
+	w.EndArray();
+
+	const CDSampleManager &dmanager = *pManager->GetDSampleManager();
+	w.Key("dpcm_samples");
+	w.BeginArray(dmanager.GetDSampleCount());
+	for (unsigned i = 0; i < CDSampleManager::MAX_DSAMPLES; ++i)
+		if (auto sample = dmanager.GetDSample(i)) {
+			w.BeginObject(3);
+			w.Key("index");
+			w.Int(i);
+			w.Key("name");
+			w.String(sample->name());
+			w.Key("samples");
+			w.BeginArray(sample->size());
+			for (std::size_t s = 0, n = sample->size(); s < n; ++s)
+				w.Int(sample->sample_at(s));
+			w.EndArray();
+			w.EndObject();
+		}
+	w.EndArray();
+
+	w.Key("global");
+	w.BeginObject(6);
+	w.Key("detune");
+	w.BeginObject(2);
+	w.Key("cents");
+	w.Int(modfile.GetTuningCent());
+	w.Key("semitones");
+	w.Int(modfile.GetTuningSemitone());
+	w.EndObject();
+	w.Key("engine_speed");
+	w.Int(modfile.GetEngineSpeed());
+	w.Key("fxx_split_point");
+	w.Int(modfile.GetSpeedSplitPoint());
+	w.Key("linear_pitch");
+	w.Bool(modfile.GetLinearPitch());
+	w.Key("machine");
+	w.String(modfile.GetMachine() == machine_t::PAL ? "pal" : "ntsc");
+	w.Key("vibrato_style");
+	w.String(modfile.GetVibratoStyle() == vibrato_t::Up ? "old" : "new");
+	w.EndObject();
+
+	w.Key("grooves");
+	w.BeginArray(modfile.GetGrooveCount());
+	for (unsigned i = 0; i < MAX_GROOVE; ++i)
+		if (auto pGroove = modfile.GetGroove(i)) {
+			w.BeginObject(2);
+			w.Key("index");
+			w.Int(i);
+			w.Key("values");
+			w.BeginArray(pGroove->size());
+			for (auto x : *pGroove)
+				w.Int(x);
+			w.EndArray();
+			w.EndObject();
+		}
+	w.EndArray();
+
+	w.Key("instruments");
+	w.BeginArray(pManager->GetInstrumentCount());
+	for (unsigned i = 0; i < MAX_INSTRUMENTS; ++i)
+		if (auto pInst = pManager->GetInstrument(i))
+			json_write_instrument(w, *pInst, i);
+	w.EndArray();
+
+	w.Key("metadata");
+	w.BeginObject(5);
+	w.Key("artist");
+	w.String(modfile.GetModuleArtist());
+	w.Key("comment");
+	w.String(modfile.GetComment());
+	w.Key("copyright");
+	w.String(modfile.GetModuleCopyright());
+	w.Key("show_comment_on_open");
+	w.Bool(modfile.ShowsCommentOnOpen());
+	w.Key("title");
+	w.String(modfile.GetModuleName());
+	w.EndObject();
+
+	const inst_type_t SEQUENCE_CHIPS[] = {INST_2A03, INST_VRC6, INST_N163, INST_S5B};
+	const auto ForeachSequence = [&] (auto f) {
+		for (auto inst_type : SEQUENCE_CHIPS) {
+			const CSequenceManager &smanager = *pManager->GetSequenceManager(inst_type);
+			for (auto t : enum_values<sequence_t>())
+				if (const auto *seqcol = smanager.GetCollection(t))
+					for (unsigned i = 0; i < MAX_SEQUENCES; ++i)
+						if (auto pSeq = seqcol->GetSequence(i))
+							f(*pSeq, inst_type, t, i);
+		}
+	};
+	std::size_t sequences = 0;
+	ForeachSequence([&] (const CSequence &, inst_type_t, sequence_t, unsigned) {
+		++sequences;
+	});
+	w.Key("sequences");
+	w.BeginArray(sequences);
+	ForeachSequence([&] (const CSequence &seq, inst_type_t inst_type, sequence_t t, unsigned i) {
+		w.BeginObject(2 + json_sequence_size(seq));
+		w.Key("chip");
+		w.String(GetChipName(inst_type));
+		w.Key("index");
+		w.Int(i);
+		json_write_sequence_members(w, seq, t);
+		w.EndObject();
+	});
+	w.EndArray();
+
+	w.Key("songs");
+	w.BeginArray(modfile.GetSongCount());
+	modfile.VisitSongs([&] (const CSongData &song) {
+		json_write_song(w, song, order);
+	});
+	w.EndArray();
+
+	w.EndObject();
+}
+
+void ReadModuleJson(std::istream &is, CFamiTrackerModule &modfile, json_format_t fmt) {
+	CJsonReader r {is, fmt};
+	r.Next();
+
+	json_read_object(r, [&] (std::string_view k) {
+		if (k == "channels") {
+			CSoundChipSet chips;
+			unsigned n163chs = 0;
+			json_read_array(r, [&] {
+				json_read_object(r, [&] (std::string_view ck) {
+					if (ck == "chip") {
+						auto chip = json_read_chip(r);
+						chips = chips.WithChip(chip);
+						if (chip == sound_chip_t::N163)
+							++n163chs;
+					}
+					else
+						r.Skip();
+				});
+			});
+			modfile.SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(chips, n163chs));
+		}
+		else if (k == "metadata") {
+			std::string comment {modfile.GetComment()};
+			bool show = modfile.ShowsCommentOnOpen();
+			json_read_object(r, [&] (std::string_view mk) {
+				if (mk == "title")
+					modfile.SetModuleName(r.GetString());
+				else if (mk == "artist")
+					modfile.SetModuleArtist(r.GetString());
+				else if (mk == "copyright")
+					modfile.SetModuleCopyright(r.GetString());
+				else if (mk == "comment")
+					comment = r.GetString();
+				else if (mk == "show_comment_on_open")
+					show = r.GetBool();
+				else
+					r.Skip();
+			});
+			modfile.SetComment(comment, show);
+		}
+		else if (k == "global")
+			json_read_object(r, [&] (std::string_view gk) {
+				if (gk == "machine")
+					modfile.SetMachine(r.GetString() == "pal" ? machine_t::PAL : machine_t::NTSC);
+				else if (gk == "engine_speed")
+					modfile.SetEngineSpeed(json_read_between(r, gk, 0, 0xFFFF));
+				else if (gk == "vibrato_style")
+					modfile.SetVibratoStyle(r.GetString() == "old" ? vibrato_t::Up : vibrato_t::Bidir);
+				else if (gk == "linear_pitch")
+					modfile.SetLinearPitch(r.GetBool());
+				else if (gk == "fxx_split_point")
+					modfile.SetSpeedSplitPoint(json_read_between(r, gk, 0, 0xFF));
+				else if (gk == "detune") {
+					int semitones = modfile.GetTuningSemitone();
+					int cents = modfile.GetTuningCent();
+					json_read_object(r, [&] (std::string_view dk) {
+						if (dk == "semitones")
+							semitones = json_read_between(r, dk, -12, 12);
+						else if (dk == "cents")
+							cents = json_read_between(r, dk, -100, 100);
+						else
+							r.Skip();
+					});
+					modfile.SetTuning(semitones, cents);
+				}
+				else
+					r.Skip();
+			});
+		else if (k == "songs") {
+			unsigned index = 0;
+			json_read_array(r, [&] {
+				if (index >= MAX_TRACKS)
+					throw std::invalid_argument {"Too many songs"};
+				json_read_song(r, *modfile.GetSong(index++));
+			});
+		}
+		else if (k == "sequences")
+			json_read_array(r, [&] {
+				json_read_sequence(r, modfile);
+			});
+		else if (k == "dpcm_samples")
+			json_read_array(r, [&] {
+				std::optional<int> index;
+				std::vector<ft0cc::doc::dpcm_sample::sample_t> samples;
+				std::string name;
+				json_read_object(r, [&] (std::string_view dk) {
+					if (dk == "index")
+						index = json_read_between(r, dk, 0, static_cast<int>(CDSampleManager::MAX_DSAMPLES) - 1);
+					else if (dk == "name")
+						name = r.GetString();
+					else if (dk == "samples")
+						json_read_array(r, [&] {
+							if (samples.size() >= ft0cc::doc::dpcm_sample::max_size)
+								throw std::invalid_argument {"DPCM sample is too large"};
+							samples.push_back(json_read_between(r, dk, 0, 0xFF));
+						});
+					else
+						r.Skip();
+				});
+				if (!index)
+					throw std::invalid_argument {"DPCM sample index is missing"};
+				modfile.GetInstrumentManager()->SetDSample(*index,
+					std::make_shared<ft0cc::doc::dpcm_sample>(std::move(samples), name));
+			});
+		else if (k == "grooves")
+			json_read_array(r, [&] {
+				std::optional<unsigned> index;
+				auto pGroove = std::make_shared<ft0cc::doc::groove>();
+				json_read_object(r, [&] (std::string_view gk) {
+					if (gk == "index")
+						index = json_read_between(r, gk, 0, MAX_GROOVE - 1);
+					else if (gk == "values") {
+						std::size_t i = 0;
+						json_read_array(r, [&] {
+							if (i >= ft0cc::doc::groove::max_size)
+								throw std::invalid_argument {"Groove is too long"};
+							pGroove->resize(i + 1);
+							pGroove->set_entry(i++, json_read_between(r, gk, 1, 0xFF));
+						});
+					}
+					else
+						r.Skip();
+				});
+				if (!index)
+					throw std::invalid_argument {"Groove index is missing"};
+				modfile.SetGroove(*index, std::move(pGroove));
+			});
+		else if (k == "detunes")
+			json_read_array(r, [&] {
+				int table = -1, note = -1, offset = 0;
+				json_read_object(r, [&] (std::string_view dk) {
+					if (dk == "table_id")
+						table = json_read_between(r, dk, 0, 5);
+					else if (dk == "note")
+						note = json_read_between(r, dk, 0, NOTE_COUNT - 1);
+					else if (dk == "offset")
+						offset = json_read_between(r, dk, -0x800, 0x7FF);
+					else
+						r.Skip();
+				});
+				if (table == -1 || note == -1)
+					throw std::invalid_argument {"Detune table or note is missing"};
+				modfile.SetDetuneOffset(table, note, offset);
+			});
+		else if (k == "instruments")
+			json_read_array(r, [&] {
+				json_read_instrument(r, modfile);
+			});
+		else
+			r.Skip();
+	});
+}
@@ -24,6 +24,8 @@
 #pragma once
 
 #include "json/json.hpp"
+#include "JsonStream.h"
+#include <iosfwd>
 
 class stChanNote;
 class CPatternData;
@@ -75,6 +77,11 @@ void from_json(const nlohmann::json &j, CFamiTrackerModule &modfile);
 void from_json(const nlohmann::json &j, CSequence &seq);
 void from_json(const nlohmann::json &j, CDSampleManager &dmanager);
 
+// // // streaming variants of the module schema, byte-identical to serializing the DOM with
+// dump(), to_cbor() or to_msgpack(); the reader fills pattern data without building a DOM
+void WriteModuleJson(std::ostream &os, const CFamiTrackerModule &modfile, json_format_t fmt = json_format_t::text);
+void ReadModuleJson(std::istream &is, CFamiTrackerModule &modfile, json_format_t fmt = json_format_t::text);
+
 namespace ft0cc::doc {
 
 class dpcm_sample;
@@ -94,6 +94,7 @@ CSoundChipSet CFamiTrackerModule::GetSoundChipSet() const {
 
 void CFamiTrackerModule::SetChannelMap(std::unique_ptr<CChannelMap> pMap) {
 	m_pChannelMap = std::move(pMap);
+	m_bStructureDirty = true;		// // //
 	if (HasExpansionChips())
 		SetMachine(machine_t::NTSC);
 }
@@ -334,6 +335,7 @@ bool CFamiTrackerModule::AllocateSong(unsigned index) {
 bool CFamiTrackerModule::InsertSong(unsigned index, std::unique_ptr<CSongData> pSong) {		// // //
 	if (index <= GetSongCount() && index < MAX_TRACKS) {
 		m_pTracks.insert(m_pTracks.begin() + index, std::move(pSong));
+		m_bStructureDirty = true;		// // //
 		return true;
 	}
 	return false;
@@ -341,6 +343,7 @@ bool CFamiTrackerModule::InsertSong(unsigned index, std::unique_ptr<CSongData> p
 
 std::unique_ptr<CSongData> CFamiTrackerModule::ReplaceSong(unsigned index, std::unique_ptr<CSongData> pSong) {		// // //
 	m_pTracks[index].swap(pSong);
+	m_bStructureDirty = true;		// // //
 	return pSong;
 }
 
@@ -351,6 +354,7 @@ std::unique_ptr<CSongData> CFamiTrackerModule::ReleaseSong(unsigned index) {		//
 	// Move down all other tracks
 	auto song = std::move(m_pTracks[index]);
 	m_pTracks.erase(m_pTracks.cbegin() + index);		// // //
+	m_bStructureDirty = true;
 	return song;
 }
 
@@ -360,6 +364,7 @@ void CFamiTrackerModule::RemoveSong(unsigned index) {
 
 void CFamiTrackerModule::SwapSongs(unsigned lhs, unsigned rhs) {
 	m_pTracks[lhs].swap(m_pTracks[rhs]);		// // //
+	m_bStructureDirty = true;
 }
 
 std::shared_ptr<ft0cc::doc::groove> CFamiTrackerModule::GetGroove(unsigned index) {
@@ -491,3 +496,23 @@ void CFamiTrackerModule::RemoveUnusedDSamples() {
 					pInst->SetSampleIndex(n, CInstrument2A03::NO_DPCM);
 	});
 }
+
+bool CFamiTrackerModule::IsStructureDirty() const {		// // //
+	return m_bStructureDirty;
+}
+
+void CFamiTrackerModule::SetDirty() {
+	m_bStructureDirty = true;
+	GetInstrumentManager()->SetDirty();
+	VisitSongs([] (CSongData &song) {
+		song.SetDirty();
+	});
+}
+
+void CFamiTrackerModule::ClearDirty() {
+	m_bStructureDirty = false;
+	GetInstrumentManager()->ClearDirty();
+	VisitSongs([] (CSongData &song) {
+		song.ClearDirty();
+	});
+}
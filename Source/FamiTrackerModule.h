@@ -175,6 +175,12 @@ public:
 	void RemoveUnusedInstruments();
 	void RemoveUnusedDSamples();		// // //
 
+	// // // dirty tracking for incremental saving
+	// songs were inserted, removed or reordered, or the channel layout changed
+	bool IsStructureDirty() const;
+	void SetDirty();
+	void ClearDirty();
+
 private:
 	bool AllocateSong(unsigned index);
 
@@ -202,4 +208,6 @@ private:
 	std::unique_ptr<CInstrumentManager> m_pInstrumentManager;
 
 	std::array<std::shared_ptr<ft0cc::doc::groove>, 32/*MAX_GROOVE*/> m_pGrooveTable;		// // // Grooves
+
+	bool m_bStructureDirty = true;		// // //
 };
@@ -1176,6 +1176,11 @@ void CFamiTrackerView::OnUpdate(CView* /*pSender*/, LPARAM lHint, CObject* /*pHi
 		m_pPatternEditor->InvalidatePatternData();
 		RedrawPatternEditor();
 		break;
+	// // // Individual notes have been edited, the pattern editor already knows which
+	case UPDATE_CELL:
+		InvalidateFrameEditor();
+		RedrawPatternEditor();
+		break;
 	// Frame data has been edited
 	case UPDATE_FRAME:
 		InvalidateFrameEditor();
@@ -1818,7 +1823,7 @@ void CFamiTrackerView::PlayNote(std::size_t Index, int MidiNote, unsigned int Ve
 		stChannelID ret = m_pNoteQueue->Trigger(MidiNote, Channel);
 		if (order.HasChannel(ret)) {
 			SplitKeyboardAdjust(NoteData, ret);
-			FTEnv.GetSoundGenerator()->QueueNote(ret, NoteData, NOTE_PRIO_2);		// // //
+			FTEnv.GetSoundGenerator()->QueueNote(ret, NoteData, NOTE_PRIO_2, m_MIDIEventTime);		// // //
 			FTEnv.GetSoundGenerator()->ForceReloadInstrument(ret);		// // //
 		}
 	}
@@ -1851,7 +1856,7 @@ void CFamiTrackerView::ReleaseNote(std::size_t Index, int MidiNote) const {
 		stChannelID ch = m_pNoteQueue->Cut(MidiNote, Channel);
 //		stChannelID ch = m_pNoteQueue->Release(MidiNote, Channel);
 		if (order.HasChannel(ch))
-			FTEnv.GetSoundGenerator()->QueueNote(ch, NoteData, NOTE_PRIO_2);
+			FTEnv.GetSoundGenerator()->QueueNote(ch, NoteData, NOTE_PRIO_2, m_MIDIEventTime);		// // //
 
 		if (FTEnv.GetSettings()->General.bPreviewFullRow) {
 			NoteData.Note = note_t::halt;
@@ -1880,7 +1885,7 @@ void CFamiTrackerView::HaltNote(std::size_t Index, int MidiNote) const {
 	if (order.HasChannel(Channel)) {
 		stChannelID ch = m_pNoteQueue->Cut(MidiNote, Channel);
 		if (order.HasChannel(ch))
-			FTEnv.GetSoundGenerator()->QueueNote(ch, NoteData, NOTE_PRIO_2);
+			FTEnv.GetSoundGenerator()->QueueNote(ch, NoteData, NOTE_PRIO_2, m_MIDIEventTime);		// // //
 
 		if (FTEnv.GetSettings()->General.bPreviewFullRow) {
 			NoteData.Instrument = MAX_INSTRUMENTS;
@@ -3016,8 +3021,10 @@ void CFamiTrackerView::TranslateMidiMessage()
 	if (!pMIDI || !pSongView)
 		return;
 
-	unsigned char Message, Channel, Data1, Data2;
-	while (pMIDI->ReadMessage(Message, Channel, Data1, Data2)) {
+	stMidiEvent Msg;		// // //
+	while (pMIDI->ReadMessage(Msg)) {
+		unsigned char Message = Msg.Message, Channel = Msg.Channel, Data1 = Msg.Data1, Data2 = Msg.Data2;
+		m_MIDIEventTime = Msg.Time;		// // // notes are scheduled relative to the message's arrival
 
 		if (Message != 0x0F) {
 			if (!FTEnv.GetSettings()->Midi.bMidiChannelMap)
@@ -3033,8 +3040,10 @@ void CFamiTrackerView::TranslateMidiMessage()
 		if (Message == MIDI_MSG_NOTE_ON || Message == MIDI_MSG_NOTE_OFF) {
 			// Remove two octaves from MIDI notes
 			Data1 -= 24;
-			if (Data1 > 127)
+			if (Data1 > 127) {
+				m_MIDIEventTime = { };		// // //
 				return;
+			}
 		}
 
 		switch (Message) {
@@ -3071,6 +3080,8 @@ void CFamiTrackerView::TranslateMidiMessage()
 		}
 	}
 
+	m_MIDIEventTime = { };		// // //
+
 	if (Status.GetLength() > 0)
 		GetParentFrame()->SetMessageText(Status);
 }
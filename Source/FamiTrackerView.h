@@ -30,6 +30,7 @@
 #include <array>		// // //
 #include <optional>		// // //
 #include <unordered_map>		// // //
+#include <chrono>		// // //
 
 #include "PatternNote.h"		// // //
 #include "PatternEditorTypes.h"		// // //
@@ -339,6 +340,7 @@ private:
 
 	// MIDI
 	unsigned int		m_iLastMIDINote;
+	std::chrono::steady_clock::time_point m_MIDIEventTime;		// // // arrival of the MIDI message being handled, if any
 
 	// Drawing
 	std::unique_ptr<CPatternEditor> m_pPatternEditor;			// // // Pointer to the pattern editor object
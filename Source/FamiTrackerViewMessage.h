@@ -43,4 +43,5 @@ enum update_mode_t {
 	UPDATE_HIGHLIGHT,		// Row highlight option has changed
 	UPDATE_COLUMNS,			// Effect columns has changed
 	UPDATE_CLOSE,			// Document is closing (TODO remove)
+	UPDATE_CELL,			// // // Individual notes have been edited, see CPatternEditor::InvalidateCell
 };
@@ -39,29 +39,13 @@
 
 namespace {
 
-enum {
-	WC_NOTE = 0,
-	WC_OCT,
-	WC_INST,
-	WC_VOL,
-	WC_EFF,
-	WC_PARAM,
-};
-
-} // namespace
-
-searchTerm::searchTerm() :
-	Note(std::make_unique<NoteRange>()),
-	Oct(std::make_unique<CharRange>()),
-	Inst(std::make_unique<CharRange>(0, MAX_INSTRUMENTS)),
-	Vol(std::make_unique<CharRange>(0, MAX_VOLUME)),
-	EffParam(std::make_unique<CharRange>()),
-	Definite(),
-	EffNumber()
-{
+std::string GetFieldText(const CEdit &Field) {		// // //
+	CStringW str;
+	Field.GetWindowTextW(str);
+	return conv::to_utf8(str);
 }
 
-
+} // namespace
 
 CFindCursor::CFindCursor(CSongView &view, const CCursorPos &Pos, const CSelection &Scope) :
 	CPatternIterator(view, Pos),
@@ -180,6 +164,13 @@ bool CFindCursor::Contains() const
 		return InStart && InEnd;
 }
 
+bool CFindCursor::IsMatch(const CPatternIndex::match_t &Matches) const		// // //
+{
+	const stChannelID ch = song_view_.GetChannelOrder().TranslateChannel(m_iChannel);
+	auto it = Matches.find({ch, song_view_.GetFramePattern(m_iChannel, TranslateFrame())});
+	return it != Matches.end() && it->second.test(m_iRow);
+}
+
 
 
 // CFileResultsBox dialog
@@ -503,12 +494,6 @@ END_MESSAGE_MAP()
 
 // CFindDlg message handlers
 
-const WCHAR CFindDlg::m_pNoteName[7] = {L'C', L'D', L'E', L'F', L'G', L'A', L'B'};
-const WCHAR CFindDlg::m_pNoteSign[3] = {L'b', L'-', L'#'};
-const note_t CFindDlg::m_iNoteOffset[7] = {note_t::C, note_t::D, note_t::E, note_t::F, note_t::G, note_t::A, note_t::B};
-
-
-
 BOOL CFindDlg::OnInitDialog()
 {
 	CDialog::OnInitDialog();
@@ -570,392 +555,56 @@ void CFindDlg::OnUpdateFields(UINT nID)
 	UpdateFields();
 }
 
-void CFindDlg::ParseNote(searchTerm &Term, CStringW str, bool Half)
-{
-	if (!Half) Term.Definite[WC_NOTE] = Term.Definite[WC_OCT] = false;
-
-	if (str.IsEmpty()) {
-		if (!Half) {
-			Term.Definite[WC_NOTE] = true;
-			Term.Definite[WC_OCT] = true;
-			Term.Note->Set(note_t::none);
-			Term.Oct->Set(0);
-		}
-		else {
-			//Term.Note->Max = Term.Note->Min;
-			//Term.Oct->Max = Term.Oct->Min;
-		}
-		return;
-	}
-
-	RaiseIf(Half && (!Term.Note->IsSingle() || !Term.Oct->IsSingle()),
-		L"Cannot use wildcards in a range search query.");
-
-	if (str == L"-" || str == L"---") {
-		RaiseIf(Half, L"Cannot use note cut in a range search query.");
-		Term.Definite[WC_NOTE] = true;
-		Term.Definite[WC_OCT] = true;
-		Term.Note->Set(note_t::halt);
-		Term.Oct->Min = 0; Term.Oct->Max = 7;
-		return;
-	}
-
-	if (str == L"=" || str == L"===") {
-		RaiseIf(Half, L"Cannot use note release in a range search query.");
-		Term.Definite[WC_NOTE] = true;
-		Term.Definite[WC_OCT] = true;
-		Term.Note->Set(note_t::release);
-		Term.Oct->Min = 0; Term.Oct->Max = 7;
-		return;
-	}
-
-	if (str == L".") {
-		RaiseIf(Half, L"Cannot use wildcards in a range search query.");
-		Term.Definite[WC_NOTE] = true;
-		Term.Note->Min = note_t::C;
-		Term.Note->Max = note_t::echo;
-		return;
-	}
-
-	if (str.GetAt(0) == L'^') {
-		RaiseIf(Half && !Term.Definite[WC_OCT], L"Cannot use wildcards in a range search query.");
-		Term.Definite[WC_NOTE] = true;
-		Term.Definite[WC_OCT] = true;
-		Term.Note->Set(note_t::echo);
-		if (str.Delete(0)) {
-			if (str.GetAt(0) == L'-')
-				str.Delete(0);
-			int BufPos = conv::to_int(str).value_or(ECHO_BUFFER_LENGTH);
-			RaiseIf(BufPos >= ECHO_BUFFER_LENGTH,
-				L"Echo buffer access \"^%s\" is out of range, maximum is %d.", (LPCWSTR)str, ECHO_BUFFER_LENGTH - 1);
-			Term.Oct->Set(BufPos, Half);
-		}
-		else {
-			Term.Oct->Min = 0; Term.Oct->Max = ECHO_BUFFER_LENGTH - 1;
-		}
-		return;
-	}
-
-	if (str.Mid(1, 2) != L"-#") for (int i = 0; i < 7; ++i) {
-		if (str.Left(1).MakeUpper() == m_pNoteName[i]) {
-			Term.Definite[WC_NOTE] = true;
-			int Note = value_cast(m_iNoteOffset[i]);
-			int Oct = 0;
-			for (int j = 0; j < 3; ++j) if (str[1] == m_pNoteSign[j]) {
-				Note += j - 1;
-				str.Delete(0); break;
-			}
-			if (str.Delete(0)) {
-				Term.Definite[WC_OCT] = true;
-				RaiseIf(str.SpanIncluding(L"0123456789") != str, L"Unknown note octave.");
-				Oct = conv::to_int(str).value_or(-1);
-				RaiseIf(Oct >= OCTAVE_RANGE || Oct < 0,
-					L"Note octave \"%s\" is out of range, maximum is %d.", (LPCWSTR)str, OCTAVE_RANGE - 1);
-				Term.Oct->Set(Oct, Half);
-			}
-			else RaiseIf(Half, L"Cannot use wildcards in a range search query.");
-			while (Note > value_cast(note_t::B)) { Note -= NOTE_RANGE; if (Term.Definite[WC_OCT]) Term.Oct->Set(++Oct, Half); }
-			while (Note < value_cast(note_t::C)) { Note += NOTE_RANGE; if (Term.Definite[WC_OCT]) Term.Oct->Set(--Oct, Half); }
-			Term.Note->Set(enum_cast<note_t>(Note), Half);
-			RaiseIf(Term.Definite[WC_OCT] && (Oct >= OCTAVE_RANGE || Oct < 0),
-				L"Note octave \"%s\" is out of range, check if the note contains Cb or B#.", (LPCWSTR)str);
-			return;
-		}
-	}
-
-	if (str.Right(2) == L"-#" && str.GetLength() == 3) {
-		int NoteValue = GetHex(str.Left(1));
-		Term.Definite[WC_NOTE] = true;
-		Term.Definite[WC_OCT] = true;
-		if (str.Left(1) == L".") {
-			Term.Note->Min = note_t::C; Term.Note->Max = note_t::Ds;
-			Term.Oct->Min = 0; Term.Oct->Max = 1;
-		}
-		else {
-			Term.Note->Set(ft0cc::doc::pitch_from_midi(NoteValue), Half);
-			Term.Oct->Set(ft0cc::doc::oct_from_midi(NoteValue), Half);
-		}
-		Term.NoiseChan = true;
-		return;
-	}
-
-	if (str.SpanIncluding(L"0123456789") == str) {
-		int NoteValue = conv::to_int(str).value_or(-1);
-		RaiseIf(NoteValue == 0 && str.GetAt(0) != L'0', L"Invalid note \"%s\".", (LPCWSTR)str);
-		RaiseIf(NoteValue >= NOTE_COUNT || NoteValue < 0,
-			L"Note value \"%s\" is out of range, maximum is %d.", (LPCWSTR)str, NOTE_COUNT - 1);
-		Term.Definite[WC_NOTE] = true;
-		Term.Definite[WC_OCT] = true;
-		Term.Note->Set(ft0cc::doc::pitch_from_midi(NoteValue), Half);
-		Term.Oct->Set(ft0cc::doc::oct_from_midi(NoteValue), Half);
-		return;
-	}
-
-	RaiseIf(true, L"Unknown note query.");
-}
-
-void CFindDlg::ParseInst(searchTerm &Term, CStringW str, bool Half)
-{
-	Term.Definite[WC_INST] = true;
-	if (str.IsEmpty()) {
-		if (!Half)
-			Term.Inst->Set(MAX_INSTRUMENTS);
-		return;
-	}
-	RaiseIf(Half && !Term.Inst->IsSingle(), L"Cannot use wildcards in a range search query.");
-
-	if (str == L".") {
-		RaiseIf(Half, L"Cannot use wildcards in a range search query.");
-		Term.Inst->Min = 0;
-		Term.Inst->Max = MAX_INSTRUMENTS - 1;
-	}
-	else if (str == L"&&") {		// // // 050B
-		RaiseIf(Half, L"Cannot use && in a range search query.");
-		Term.Inst->Set(HOLD_INSTRUMENT);
-	}
-	else if (!str.IsEmpty()) {
-		unsigned char Val = GetHex(str);
-		RaiseIf(Val >= MAX_INSTRUMENTS,
-			L"Instrument \"%s\" is out of range, maximum is %X.", (LPCWSTR)str, MAX_INSTRUMENTS - 1);
-		Term.Inst->Set(Val, Half);
-	}
-}
-
-void CFindDlg::ParseVol(searchTerm &Term, CStringW str, bool Half)
-{
-	Term.Definite[WC_VOL] = true;
-	if (str.IsEmpty()) {
-		if (!Half)
-			Term.Vol->Set(MAX_VOLUME);
-		return;
-	}
-	RaiseIf(Half && !Term.Vol->IsSingle(), L"Cannot use wildcards in a range search query.");
-
-	if (str == L".") {
-		RaiseIf(Half, L"Cannot use wildcards in a range search query.");
-		Term.Vol->Min = 0;
-		Term.Vol->Max = MAX_VOLUME - 1;
-	}
-	else if (!str.IsEmpty()) {
-		unsigned char Val = GetHex(str);
-		RaiseIf(Val >= MAX_VOLUME,
-			L"Channel volume \"%s\" is out of range, maximum is %X.", (LPCWSTR)str, MAX_VOLUME - 1);
-		Term.Vol->Set(Val, Half);
-	}
-}
-
-void CFindDlg::ParseEff(searchTerm &Term, CStringW str, bool Half)
-{
-	RaiseIf(str.GetLength() == 2, L"Effect \"%s\" is too short.", (LPCWSTR)str.Left(1));
-
-	if (str.IsEmpty()) {
-		Term.Definite[WC_EFF] = true;
-		Term.Definite[WC_PARAM] = true;
-		Term.EffNumber[value_cast(effect_t::none)] = true;
-		Term.EffParam->Set(0);
-	}
-	else if (str == L".") {
-		Term.Definite[WC_EFF] = true;
-		for (auto fx : enum_values<effect_t>())
-			Term.EffNumber[value_cast(fx)] = true;
-	}
-	else {
-		char Name = conv::to_utf8(str.Left(1)).front();
-		bool found = false;
-		for (auto fx : enum_values<effect_t>()) {
-			if (Name == EFF_CHAR[value_cast(fx)]) {
-				Term.Definite[WC_EFF] = true;
-				Term.EffNumber[value_cast(fx)] = true;
-				found = true;
-			}
-		}
-		RaiseIf(!found, L"Unknown effect \"%s\" found in search query.", (LPCWSTR)str.Left(1));
-	}
-	if (str.GetLength() > 1) {
-		Term.Definite[WC_PARAM] = true;
-		Term.EffParam->Set(GetHex(str.Right(2)));
-	}
-}
-
 void CFindDlg::GetFindTerm()
 {
 	RaiseIf(m_cSearchArea.GetCurSel() == 4 && !m_pView->GetPatternEditor()->IsSelecting(),
 		L"Cannot use \"Selection\" as the search scope if there is no active pattern selection.");
 
-	CStringW str = L"";
-	searchTerm newTerm;
-
+	searchFields Fields;		// // //
 	if (IsDlgButtonChecked(IDC_CHECK_FIND_NOTE)) {
-		m_cFindNoteField.GetWindowTextW(str);
-		bool empty = str.IsEmpty();
-		ParseNote(newTerm, str, false);
-		m_cFindNoteField2.GetWindowTextW(str);
-		ParseNote(newTerm, str, !empty);
-		RaiseIf((newTerm.Note->Min == note_t::echo && is_note(newTerm.Note->Max) ||
-			newTerm.Note->Max == note_t::echo && is_note(newTerm.Note->Min)) &&
-			newTerm.Definite[WC_OCT],
-			L"Cannot use both notes and echo buffer in a range search query.");
+		Fields.Note = GetFieldText(m_cFindNoteField);
+		Fields.Note2 = GetFieldText(m_cFindNoteField2);
 	}
 	if (IsDlgButtonChecked(IDC_CHECK_FIND_INST)) {
-		m_cFindInstField.GetWindowTextW(str);
-		bool empty = str.IsEmpty();
-		ParseInst(newTerm, str, false);
-		m_cFindInstField2.GetWindowTextW(str);
-		ParseInst(newTerm, str, !empty);
+		Fields.Inst = GetFieldText(m_cFindInstField);
+		Fields.Inst2 = GetFieldText(m_cFindInstField2);
 	}
 	if (IsDlgButtonChecked(IDC_CHECK_FIND_VOL)) {
-		m_cFindVolField.GetWindowTextW(str);
-		bool empty = str.IsEmpty();
-		ParseVol(newTerm, str, false);
-		m_cFindVolField2.GetWindowTextW(str);
-		ParseVol(newTerm, str, !empty);
-	}
-	if (IsDlgButtonChecked(IDC_CHECK_FIND_EFF)) {
-		m_cFindEffField.GetWindowTextW(str);
-		ParseEff(newTerm, str, false);
-	}
-
-	for (int i = 0; i <= 6; ++i) {
-		RaiseIf(i == 6, L"Search query is empty.");
-		if (newTerm.Definite[i]) break;
+		Fields.Vol = GetFieldText(m_cFindVolField);
+		Fields.Vol2 = GetFieldText(m_cFindVolField2);
 	}
+	if (IsDlgButtonChecked(IDC_CHECK_FIND_EFF))
+		Fields.Eff = GetFieldText(m_cFindEffField);
 
-	m_searchTerm = std::move(newTerm);
+	m_searchTerm = CSearchTermParser::ParseFind(Fields);
+	m_pSearchQuery = std::make_unique<CSearchQuery>(m_searchTerm, m_cEffectColumn.GetCurSel(),
+		IsDlgButtonChecked(IDC_CHECK_FIND_NEGATE) == BST_CHECKED);
 }
 
 void CFindDlg::GetReplaceTerm()
 {
-	CStringW str = L"";
-	searchTerm newTerm;
-
-	if (IsDlgButtonChecked(IDC_CHECK_REPLACE_NOTE)) {
-		m_cReplaceNoteField.GetWindowTextW(str);
-		ParseNote(newTerm, str, false);
-	}
-	if (IsDlgButtonChecked(IDC_CHECK_REPLACE_INST)) {
-		m_cReplaceInstField.GetWindowTextW(str);
-		ParseInst(newTerm, str, false);
-	}
-	if (IsDlgButtonChecked(IDC_CHECK_REPLACE_VOL)) {
-		m_cReplaceVolField.GetWindowTextW(str);
-		ParseVol(newTerm, str, false);
-	}
-	if (IsDlgButtonChecked(IDC_CHECK_REPLACE_EFF)) {
-		m_cReplaceEffField.GetWindowTextW(str);
-		ParseEff(newTerm, str, false);
-	}
-
-	for (int i = 0; i <= 6; ++i) {
-		RaiseIf(i == 6, L"Replacement query is empty.");
-		if (newTerm.Definite[i]) break;
-	}
-
-	if ((newTerm.Note->Min == note_t::halt || newTerm.Note->Min == note_t::release) && newTerm.Note->Min == newTerm.Note->Max)
-		newTerm.Oct->Min = newTerm.Oct->Max = 0;
-
-	RaiseIf(newTerm.Definite[WC_NOTE] && !newTerm.Note->IsSingle() ||
-			newTerm.Definite[WC_OCT] && !newTerm.Oct->IsSingle() ||
-			newTerm.Definite[WC_INST] && !newTerm.Inst->IsSingle() ||
-			newTerm.Definite[WC_VOL] && !newTerm.Vol->IsSingle() ||
-			newTerm.Definite[WC_PARAM] && !newTerm.EffParam->IsSingle(),
-			L"Replacement query cannot contain wildcards.");
-
-	if (IsDlgButtonChecked(IDC_CHECK_FIND_REMOVE)) {
-		RaiseIf(newTerm.Definite[WC_NOTE] && !newTerm.Definite[WC_OCT],
-				L"Replacement query cannot contain a note with an unspecified octave if "
-				L"the option \"Remove original data\" is enabled.");
-		RaiseIf(newTerm.Definite[WC_EFF] && !newTerm.Definite[WC_PARAM],
-				L"Replacement query cannot contain an effect with an unspecified parameter if "
-				L"the option \"Remove original data\" is enabled.");
-	}
-
-	m_replaceTerm = toReplace(newTerm);
-}
+	searchFields Fields;		// // //
+	if (IsDlgButtonChecked(IDC_CHECK_REPLACE_NOTE))
+		Fields.Note = GetFieldText(m_cReplaceNoteField);
+	if (IsDlgButtonChecked(IDC_CHECK_REPLACE_INST))
+		Fields.Inst = GetFieldText(m_cReplaceInstField);
+	if (IsDlgButtonChecked(IDC_CHECK_REPLACE_VOL))
+		Fields.Vol = GetFieldText(m_cReplaceVolField);
+	if (IsDlgButtonChecked(IDC_CHECK_REPLACE_EFF))
+		Fields.Eff = GetFieldText(m_cReplaceEffField);
 
-unsigned CFindDlg::GetHex(LPCWSTR str) {
-	auto val = conv::to_int(str, 16);
-	RaiseIf(!val, L"Invalid hexadecimal \"%s\".", (LPCWSTR)str);
-	return *val;
+	m_replaceTerm = CSearchTermParser::ParseReplace(Fields, IsDlgButtonChecked(IDC_CHECK_FIND_REMOVE) == BST_CHECKED);
 }
 
-replaceTerm CFindDlg::toReplace(const searchTerm &x) const
+bool CFindDlg::CompareFields(const stChanNote &Target, bool Noise, int EffCount)
 {
-	replaceTerm Term;
-	Term.Note.Note = x.Note->Min;
-	Term.Note.Octave = x.Oct->Min;
-	Term.Note.Instrument = x.Inst->Min;
-	Term.Note.Vol = x.Vol->Min;
-	Term.NoiseChan = x.NoiseChan;
-	if (x.EffNumber[value_cast(effect_t::none)])
-		Term.Note.Effects[0].fx = effect_t::none;
-	else
-		for (auto fx : enum_values<effect_t>())
-			if (x.EffNumber[value_cast(fx)]) {
-				Term.Note.Effects[0].fx = fx;
-				break;
-			}
-	Term.Note.Effects[0].param = x.EffParam->Min;
-	memcpy(Term.Definite, x.Definite, sizeof(bool) * 6);
-
-	return Term;
+	return m_pSearchQuery->IsMatch(Target, Noise, EffCount);		// // //
 }
 
-bool CFindDlg::CompareFields(const stChanNote &Target, bool Noise, int EffCount)
+CPatternIndex::match_t CFindDlg::FindMatches()		// // //
 {
-	int EffColumn = m_cEffectColumn.GetCurSel();
-	if (EffColumn > EffCount && EffColumn != 4) EffColumn = EffCount;
-	bool Negate = IsDlgButtonChecked(IDC_CHECK_FIND_NEGATE) == BST_CHECKED;
-	bool EffectMatch = false;
-
-	bool Melodic = is_note(m_searchTerm.Note->Min) && // ||
-				   is_note(m_searchTerm.Note->Max) &&
-				   m_searchTerm.Definite[WC_OCT];
-
-	if (m_searchTerm.Definite[WC_NOTE]) {
-		if (m_searchTerm.NoiseChan) {
-			if (!Noise && Melodic) return false;
-			if (!is_note(m_searchTerm.Note->Min) || !is_note(m_searchTerm.Note->Max)) {
-				if (!m_searchTerm.Note->IsMatch(Target.Note)) return Negate;
-			}
-			else {
-				int NoiseNote = Target.ToMidiNote() % 16;
-				int Low = ft0cc::doc::midi_note(m_searchTerm.Oct->Min, m_searchTerm.Note->Min) % 16;
-				int High = ft0cc::doc::midi_note(m_searchTerm.Oct->Max, m_searchTerm.Note->Max) % 16;
-				if ((NoiseNote < Low && NoiseNote < High) || (NoiseNote > Low && NoiseNote > High))
-					return Negate;
-			}
-		}
-		else {
-			if (Noise && Melodic) return false;
-			if (Melodic) {
-				if (!is_note(Target.Note))
-					return Negate;
-				int NoteValue = Target.ToMidiNote();
-				int Low = ft0cc::doc::midi_note(m_searchTerm.Oct->Min, m_searchTerm.Note->Min);
-				int High = ft0cc::doc::midi_note(m_searchTerm.Oct->Max, m_searchTerm.Note->Max);
-				if ((NoteValue < Low && NoteValue < High) || (NoteValue > Low && NoteValue > High))
-					return Negate;
-			}
-			else {
-				if (!m_searchTerm.Note->IsMatch(Target.Note)) return Negate;
-				if (m_searchTerm.Definite[WC_OCT] && !m_searchTerm.Oct->IsMatch(Target.Octave))
-					return Negate;
-			}
-		}
-	}
-	if (m_searchTerm.Definite[WC_INST] && !m_searchTerm.Inst->IsMatch(Target.Instrument)) return Negate;
-	if (m_searchTerm.Definite[WC_VOL] && !m_searchTerm.Vol->IsMatch(Target.Vol)) return Negate;
-	int Limit = MAX_EFFECT_COLUMNS - 1;
-	if (EffCount < Limit) Limit = EffCount;
-	if (EffColumn < Limit) Limit = EffColumn;
-	for (int i = EffColumn % MAX_EFFECT_COLUMNS; i <= Limit; ++i) {
-		if ((!m_searchTerm.Definite[WC_EFF] || m_searchTerm.EffNumber[value_cast(Target.Effects[i].fx)])
-		&& (!m_searchTerm.Definite[WC_PARAM] || m_searchTerm.EffParam->IsMatch(Target.Effects[i].param)))
-			EffectMatch = true;
-	}
-	if (!EffectMatch) return Negate;
-
-	return !Negate;
+	return m_PatternIndex.Find(*m_pView->GetModuleData(), static_cast<CMainFrame*>(AfxGetMainWnd())->GetSelectedTrack(),
+		m_searchTerm, m_cEffectColumn.GetCurSel(), IsDlgButtonChecked(IDC_CHECK_FIND_NEGATE) == BST_CHECKED);
 }
 
 template <typename... T>
@@ -1013,46 +662,10 @@ bool CFindDlg::Replace(CCompoundAction *pAction)
 	if (m_bFound) {
 		ASSERT(m_pFindCursor != nullptr);
 
-		stChanNote Target;
-		if (!IsDlgButtonChecked(IDC_CHECK_FIND_REMOVE))
-			Target = m_pFindCursor->Get();
-
-		if (m_replaceTerm.Definite[WC_NOTE])
-			Target.Note = m_replaceTerm.Note.Note;
-
-		if (m_replaceTerm.Definite[WC_OCT])
-			Target.Octave = m_replaceTerm.Note.Octave;
-
-		if (m_replaceTerm.Definite[WC_INST])
-			Target.Instrument = m_replaceTerm.Note.Instrument;
-
-		if (m_replaceTerm.Definite[WC_VOL])
-			Target.Vol = m_replaceTerm.Note.Vol;
-
-		if (m_replaceTerm.Definite[WC_EFF] || m_replaceTerm.Definite[WC_PARAM]) {
-			std::vector<int> MatchedColumns;
-			if (m_cEffectColumn.GetCurSel() < MAX_EFFECT_COLUMNS)
-				MatchedColumns.push_back(m_cEffectColumn.GetCurSel());
-			else {
-				const int c = pSongView->GetEffectColumnCount(m_pFindCursor->m_iChannel);
-				for (int i = 0; i <= c; ++i)
-					if ((!m_searchTerm.Definite[WC_EFF] || m_searchTerm.EffNumber[value_cast(Target.Effects[i].fx)]) &&
-						(!m_searchTerm.Definite[WC_PARAM] || m_searchTerm.EffParam->IsMatch(Target.Effects[i].param)))
-						MatchedColumns.push_back(i);
-			}
-
-			if (m_replaceTerm.Definite[WC_EFF]) {
-				effect_t fx = FTEnv.GetSoundChipService()->TranslateEffectName(EFF_CHAR[value_cast(m_replaceTerm.Note.Effects[0].fx)],
-					pSongView->GetChannelOrder().TranslateChannel(m_pFindCursor->m_iChannel).Chip);
-				if (fx != effect_t::none)
-					for (const int &i : MatchedColumns)
-						Target.Effects[i].fx = fx;
-			}
-
-			if (m_replaceTerm.Definite[WC_PARAM])
-				for (const int &i : MatchedColumns)
-					Target.Effects[i].param = m_replaceTerm.Note.Effects[0].param;
-		}
+		const stChanNote Target = m_pSearchQuery->Replace(m_pFindCursor->Get(), m_replaceTerm,		// // //
+			IsDlgButtonChecked(IDC_CHECK_FIND_REMOVE) == BST_CHECKED,
+			pSongView->GetChannelOrder().TranslateChannel(m_pFindCursor->m_iChannel).Chip,
+			pSongView->GetEffectColumnCount(m_pFindCursor->m_iChannel));
 
 		if (pAction)
 			pAction->JoinAction(std::make_unique<CPActionReplaceNote>(Target,
@@ -1210,14 +823,15 @@ void CFindDlg::OnBnClickedButtonFindAll()
 	m_iSearchDirection = IsDlgButtonChecked(IDC_CHECK_VERTICAL_SEARCH) ?
 		CFindCursor::direction_t::DOWN : CFindCursor::direction_t::RIGHT;
 
+	const auto Matches = FindMatches();		// // //
 	PrepareCursor(true);
 	m_cResultsBox.SetRedraw(FALSE);
 	m_cResultsBox.ClearResults();
 	do {
-		const auto &Target = m_pFindCursor->Get();
-		bool isNoise = IsAPUNoise(Order.TranslateChannel(m_pFindCursor->m_iChannel));
-		if (CompareFields(Target, isNoise, pSongView->GetEffectColumnCount(m_pFindCursor->m_iChannel)))
-			m_cResultsBox.AddResult(Target, *m_pFindCursor, isNoise);
+		if (m_pFindCursor->IsMatch(Matches)) {
+			bool isNoise = IsAPUNoise(Order.TranslateChannel(m_pFindCursor->m_iChannel));
+			m_cResultsBox.AddResult(m_pFindCursor->Get(), *m_pFindCursor, isNoise);
+		}
 		m_pFindCursor->Move(m_iSearchDirection);
 	} while (!m_pFindCursor->AtStart());
 
@@ -1231,19 +845,18 @@ void CFindDlg::OnBnClickedButtonReplaceall()
 {
 	if (!PrepareReplace()) return;
 
-	CSongView *pSongView = m_pView->GetSongView();
-	const CChannelOrder &Order = pSongView->GetChannelOrder();
 	unsigned int Count = 0;
 
 	m_iSearchDirection = IsDlgButtonChecked(IDC_CHECK_VERTICAL_SEARCH) ?
 		CFindCursor::direction_t::DOWN : CFindCursor::direction_t::RIGHT;
 
+	// // // replacements are only applied once the compound action is added, so the matches
+	// obtained before the loop stay valid throughout
+	const auto Matches = FindMatches();
 	auto pAction = std::make_unique<CCompoundAction>();
 	PrepareCursor(true);
 	do {
-		const auto &Target = m_pFindCursor->Get();
-		bool isNoise = IsAPUNoise(Order.TranslateChannel(m_pFindCursor->m_iChannel));
-		if (CompareFields(Target, isNoise, pSongView->GetEffectColumnCount(m_pFindCursor->m_iChannel))) {
+		if (m_pFindCursor->IsMatch(Matches)) {
 			m_bFound = true;
 			Replace(static_cast<CCompoundAction *>(pAction.get()));
 			++Count;
@@ -28,72 +28,14 @@
 
 #include <memory>
 #include <string>
-#include <limits>
 
-#include "PatternNote.h"
+#include "SearchTerm.h"		// // //
+#include "SearchQuery.h"		// // //
+#include "PatternIndex.h"		// // //
 #include "PatternEditorTypes.h"
 #include "SelectionRange.h"
 #include "APU/Types_fwd.h"
 
-namespace details {
-
-template <typename T, bool>
-struct underlying_type {
-	using type = T;
-};
-template <typename T>
-struct underlying_type<T, true> {
-	using type = std::underlying_type_t<T>;
-};
-template <typename T>
-using underlying_type_t = typename underlying_type<T, std::is_enum_v<T>>::type;
-
-} // namespace details
-
-template <typename T>
-struct FindRange {
-	constexpr FindRange() noexcept = default;
-	constexpr FindRange(T a, T b) noexcept : Min(a), Max(b) { }
-
-	constexpr void Set(T x, bool Half = false) noexcept {
-		if (!Half)
-			Min = x;
-		Max = x;
-	}
-	constexpr bool IsMatch(T x) const noexcept {
-		return (x >= Min && x <= Max) || (x >= Max && x <= Min);
-	}
-	constexpr bool IsSingle() const noexcept {
-		return Min == Max;
-	}
-
-	T Min = static_cast<T>(std::numeric_limits<details::underlying_type_t<T>>::min());
-	T Max = static_cast<T>(std::numeric_limits<details::underlying_type_t<T>>::max());
-};
-
-using CharRange = FindRange<unsigned char>;
-using NoteRange = FindRange<note_t>;
-
-class searchTerm
-{
-public:
-	searchTerm();
-
-	std::unique_ptr<NoteRange> Note;
-	std::unique_ptr<CharRange> Oct, Inst, Vol;
-	bool EffNumber[enum_count<effect_t>() + 1] = { };
-	std::unique_ptr<CharRange> EffParam;
-	bool Definite[6] = { };
-	bool NoiseChan = false;
-};
-
-struct replaceTerm
-{
-	stChanNote Note;
-	bool Definite[6];
-	bool NoiseChan;
-};
-
 class CFamiTrackerView;
 class CSongView;
 class CCompoundAction;
@@ -149,19 +91,16 @@ public:
 		\return True if the scope contains the cursor itself. */
 	bool Contains() const;
 
+	/*!	\brief Checks whether the cursor lies on a row returned by a pattern index lookup.
+		\param Matches The matching rows of the current song, as returned by CPatternIndex::Find.
+		\return True if the row under the cursor is one of the matches. */
+	bool IsMatch(const CPatternIndex::match_t &Matches) const;		// // //
+
 private:
 	CCursorPos m_cpBeginPos;
 	const CSelection m_Scope;
 };
 
-// Exception for find dialog
-
-class CFindException : public std::runtime_error
-{
-public:
-	CFindException(const char *msg) : std::runtime_error(msg) { }
-};
-
 // CFindResultsBox dialog
 
 class CFindResultsBox : public CDialog
@@ -225,20 +164,14 @@ public:
 protected:
 	virtual void DoDataExchange(CDataExchange* pDX);    // DDX/DDV support
 
-	void ParseNote(searchTerm &Term, CStringW str, bool Half);
-	void ParseInst(searchTerm &Term, CStringW str, bool Half);
-	void ParseVol(searchTerm &Term, CStringW str, bool Half);
-	void ParseEff(searchTerm &Term, CStringW str, bool Half);
 	void GetFindTerm();
 	void GetReplaceTerm();
 
 	bool CompareFields(const stChanNote &Target, bool Noise, int EffCount);
+	CPatternIndex::match_t FindMatches();		// // //
 
 	template <typename... T>
 	void RaiseIf(bool Check, LPCWSTR Str, T&&... args);
-	unsigned GetHex(LPCWSTR str);
-
-	replaceTerm toReplace(const searchTerm &x) const;
 
 	bool PrepareFind();
 	bool PrepareReplace();
@@ -256,16 +189,14 @@ protected:
 
 	searchTerm m_searchTerm = { };
 	replaceTerm m_replaceTerm = { };
+	std::unique_ptr<CSearchQuery> m_pSearchQuery;		// // //
 	bool m_bFound, m_bSkipFirst, m_bReplacing;
 
 	std::unique_ptr<CFindCursor> m_pFindCursor;
 	CFindCursor::direction_t m_iSearchDirection;
 
 	CFindResultsBox m_cResultsBox;
-
-	static const WCHAR m_pNoteName[7];
-	static const WCHAR m_pNoteSign[3];
-	static const note_t m_iNoteOffset[7];
+	CPatternIndex m_PatternIndex;		// // //
 
 	DECLARE_MESSAGE_MAP()
 public:
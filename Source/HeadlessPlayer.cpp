@@ -0,0 +1,309 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+#include "HeadlessPlayer.h"
+#include "FamiTrackerModule.h"
+#include "SongData.h"
+#include "ChannelOrder.h"
+#include "SoundChipSet.h"
+#include "SoundDriver.h"
+#include "PlayerCursor.h"
+#include "TempoCounter.h"
+#include "SongView.h"		// // //
+#include "SongLengthScanner.h"		// // //
+#include "SongState.h"		// // //
+#include "APU/APU.h"
+#include "APU/2A03.h"		// // //
+#include "APU/Types.h"
+
+CHeadlessPlayer::CHeadlessPlayer(const CFamiTrackerModule &modfile, unsigned SampleRate) :
+	CHeadlessPlayer(modfile, SampleRate, mixer_settings_t { })
+{
+}
+
+CHeadlessPlayer::CHeadlessPlayer(const CFamiTrackerModule &modfile, unsigned SampleRate, mixer_settings_t Mixer) :
+	modfile_(modfile),
+	sample_rate_(SampleRate),		// // //
+	mixer_(std::move(Mixer))
+{
+	Setup();
+}
+
+CHeadlessPlayer::~CHeadlessPlayer() {
+}
+
+void CHeadlessPlayer::Setup() {		// // //
+	driver_ = std::make_unique<CSoundDriver>(this);
+	apu_ = std::make_unique<CAPU>(this);
+	tempo_ = std::make_shared<CTempoCounter>(modfile_);
+
+	driver_->SetupTracks();
+	driver_->AssignModule(modfile_);
+	driver_->LoadAPU(*apu_);
+	driver_->SetTempoCounter(tempo_);
+	driver_->ConfigureDocument();
+
+	machine_t Machine = modfile_.GetMachine();
+	apu_->SetupSound(sample_rate_, 1, Machine);
+	for (auto [Chip, Level] : mixer_.Levels)		// // //
+		apu_->SetChipLevel(Chip, Level);
+	apu_->SetupMixer(mixer_.LowCut, mixer_.HighCut, mixer_.HighDamp, mixer_.Volume);
+	apu_->SetExternalSound(modfile_.GetSoundChipSet());
+	ResetAPU();
+
+	int Rate = modfile_.GetFrameRate();
+	update_cycles_ = (Machine == machine_t::NTSC ? MASTER_CLOCK_NTSC : MASTER_CLOCK_PAL) / Rate;
+	apu_->ChangeMachineRate(Machine, Rate);
+}
+
+void CHeadlessPlayer::StartPlayer(unsigned Track) {
+	driver_->StartPlayer(std::make_unique<CPlayerCursor>(*modfile_.GetSong(Track), Track));
+	tempo_->LoadTempo(*modfile_.GetSong(Track));
+	track_ = Track;		// // //
+	frames_ = 0;
+	samples_ = 0;
+
+	// same order as CSoundGen::BeginPlayer followed by CSoundGen::MakeSilent
+	ResetAPU();
+	apu_->Reset();
+	driver_->ResetTracks();
+}
+
+void CHeadlessPlayer::StopPlayer() {
+	driver_->StopPlayer();
+}
+
+bool CHeadlessPlayer::IsPlaying() const {
+	return driver_->IsPlaying();
+}
+
+bool CHeadlessPlayer::RenderFrame() {
+	audio_.clear();
+	return PlayFrame(true);
+}
+
+bool CHeadlessPlayer::PlayFrame(bool Render) {		// // //
+	{
+		auto probe = timer_.Measure(tick_part_t::driver);
+		driver_->Tick();
+	}
+
+	// see CSoundGen::UpdateAPU
+	{
+		auto probe = timer_.Measure(tick_part_t::emulation);
+		int cycles = update_cycles_;
+		sound_chip_t LastChip = sound_chip_t::none;
+		driver_->ForeachActiveTrack([&] (CChannelHandler &, CTrackerChannel &, stChannelID ID) {
+			int Delay = (ID.Chip == LastChip) ? 150 : 250;
+			if (Delay < cycles) {
+				cycles -= Delay;
+				apu_->AddTime(Delay);
+				apu_->Process();
+			}
+			LastChip = ID.Chip;
+		});
+
+		for (unsigned Next; (Next = driver_->GetNextNoteDelay()) < static_cast<unsigned>(update_cycles_); ) {		// // //
+			unsigned Elapsed = update_cycles_ - cycles;
+			if (Next > Elapsed) {
+				apu_->AddTime(Next - Elapsed);
+				apu_->Process();
+				cycles -= Next - Elapsed;
+			}
+			driver_->PlayDelayedNotes(Next);
+		}
+
+		apu_->AddTime(cycles);
+		apu_->Process();
+		if (Render)
+			apu_->EndFrame();
+		else
+			samples_ += apu_->SkipFrame();		// // //
+	}
+	timer_.EndTick();
+	++frames_;
+
+	if (driver_->ShouldHalt()) {
+		driver_->StopPlayer();
+		return false;
+	}
+	return true;
+}
+
+void CHeadlessPlayer::Restart() {		// // //
+	// resetting the APU does not reset every chip completely
+	Setup();
+	StartPlayer(track_);
+}
+
+bool CHeadlessPlayer::SeekTick(std::uint64_t Tick) {		// // //
+	if (Tick < frames_)
+		Restart();
+	bool Playing = IsPlaying();
+	while (Playing && frames_ < Tick)
+		Playing = RenderFrame();
+	audio_.clear();
+	return Playing;
+}
+
+bool CHeadlessPlayer::SeekRow(unsigned Frame, unsigned Row, unsigned Tick) {		// // //
+	auto pTimeline = CTempoTimeline::Get(modfile_, *modfile_.MakeSongView(track_, false));
+	auto Index = pTimeline->FindRow(Frame, Row);
+	return Index && SeekTick(pTimeline->GetTick(*Index) + Tick);
+}
+
+bool CHeadlessPlayer::SeekSample(std::uint64_t Sample) {		// // //
+	if (Sample < samples_)
+		Restart();
+	bool Playing = IsPlaying();
+	while (Playing && samples_ <= Sample)
+		Playing = RenderFrame();
+	if (samples_ <= Sample) {
+		audio_.clear();
+		return false;
+	}
+	audio_.erase(audio_.begin(), audio_.end() - static_cast<std::ptrdiff_t>(samples_ - Sample));
+	return true;
+}
+
+bool CHeadlessPlayer::SkipTick(std::uint64_t Tick) {		// // //
+	if (Tick < frames_)
+		Restart();
+	bool Playing = IsPlaying();
+	while (Playing && frames_ < Tick)
+		Playing = PlayFrame(false);
+	audio_.clear();
+	return Playing;
+}
+
+CHeadlessPlayer::checkpoint_t CHeadlessPlayer::SaveCheckpoint() const {		// // //
+	checkpoint_t Checkpoint;
+	Checkpoint.Tick = frames_;
+	Checkpoint.Sample = samples_;
+	apu_->SaveState(Checkpoint.State);
+	if (auto *p2A03 = dynamic_cast<C2A03 *>(apu_->GetSoundChip(sound_chip_t::APU)))
+		Checkpoint.pSample = p2A03->GetSample();
+	return Checkpoint;
+}
+
+bool CHeadlessPlayer::LoadCheckpoint(unsigned Track, const checkpoint_t &Checkpoint) {		// // //
+	auto pTimeline = CTempoTimeline::Get(modfile_, *modfile_.MakeSongView(Track, false));
+	unsigned Index = pTimeline->GetIndex(Checkpoint.Tick);
+	if (pTimeline->GetTick(Index) != Checkpoint.Tick)
+		return false;
+	auto [Frame, Row] = pTimeline->GetPosition(Index);
+
+	// same order as CSoundGen::BeginPlayer with channel state retrieval
+	const CSongData &song = *modfile_.GetSong(Track);
+	driver_->StartPlayer(std::make_unique<CPlayerCursor>(song, Track, Frame, Row));
+	tempo_->LoadTempo(song);
+	track_ = Track;
+	frames_ = static_cast<unsigned>(Checkpoint.Tick);
+	samples_ = Checkpoint.Sample;
+
+	ResetAPU();
+	apu_->Reset();
+	driver_->ResetTracks();
+
+	CSongState state;
+	state.Retrieve(modfile_, Track, Frame, Row);
+	driver_->LoadSoundState(state);
+
+	if (Checkpoint.pSample)
+		if (auto *p2A03 = dynamic_cast<C2A03 *>(apu_->GetSoundChip(sound_chip_t::APU)))
+			p2A03->WriteSample(Checkpoint.pSample);
+	return apu_->LoadState(Checkpoint.State);
+}
+
+const std::vector<int16_t> &CHeadlessPlayer::GetFrameAudio() const {
+	return audio_;
+}
+
+unsigned CHeadlessPlayer::GetFrameCount() const {
+	return frames_;
+}
+
+std::uint64_t CHeadlessPlayer::GetSampleCount() const {		// // //
+	return samples_;
+}
+
+const CTickTimer &CHeadlessPlayer::GetTickTimer() const {
+	return timer_;
+}
+
+const CFamiTrackerModule &CHeadlessPlayer::GetModule() const {
+	return modfile_;
+}
+
+CSoundDriver &CHeadlessPlayer::GetSoundDriver() const {
+	return *driver_;
+}
+
+CAPU &CHeadlessPlayer::GetAPU() const {
+	return *apu_;
+}
+
+void CHeadlessPlayer::ResetAPU() {
+	apu_->Reset();
+
+	apu_->Write(0x4015, 0x0F);
+	apu_->Write(0x4017, 0x00);
+	apu_->Write(0x4023, 0x02);		// FDS enable
+	apu_->Write(0x5015, 0x03);		// MMC5
+}
+
+CInstrumentManager *CHeadlessPlayer::GetInstrumentManager() const {
+	return modfile_.GetInstrumentManager();
+}
+
+void CHeadlessPlayer::OnTick() {
+}
+
+void CHeadlessPlayer::OnStepRow() {
+}
+
+void CHeadlessPlayer::OnPlayNote(stChannelID chan, const stChanNote &note) {
+}
+
+void CHeadlessPlayer::OnUpdateRow(int frame, int row) {
+}
+
+bool CHeadlessPlayer::IsChannelMuted(stChannelID chan) const {
+	return false;
+}
+
+bool CHeadlessPlayer::ShouldStopPlayer() const {
+	return false;
+}
+
+int CHeadlessPlayer::GetArpNote(stChannelID chan) const {
+	return -1;
+}
+
+void CHeadlessPlayer::FlushBuffer(array_view<int16_t> Buffer) {
+	audio_.insert(audio_.end(), Buffer.begin(), Buffer.end());
+	samples_ += Buffer.size();		// // //
+}
+
+bool CHeadlessPlayer::PlayBuffer() {
+	return true;
+}
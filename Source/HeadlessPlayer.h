@@ -0,0 +1,155 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+#pragma once
+
+#include "SoundGenBase.h"
+#include "Common.h"
+#include "TickTimer.h"
+#include "APU/APUState.h"		// // //
+#include <memory>
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+namespace ft0cc::doc {
+class dpcm_sample;
+} // namespace ft0cc::doc
+
+class CFamiTrackerModule;
+class CSoundDriver;
+class CTempoCounter;
+class CAPU;
+enum chip_level_t : unsigned char;		// // //
+
+// // // Plays a module without an audio device or a document, in the same order of driver
+// ticks and APU updates as CSoundGen; each call to RenderFrame produces one frame of audio
+
+class CHeadlessPlayer : public CSoundGenBase, public IAudioCallback {
+public:
+	static constexpr unsigned DEFAULT_SAMPLE_RATE = 44100;
+
+	// // // Mixer settings, the defaults are the tracker's default sound settings
+	struct mixer_settings_t {
+		int LowCut = 30;
+		int HighCut = 12000;
+		int HighDamp = 24;
+		int Volume = 100;
+		std::vector<std::pair<chip_level_t, float>> Levels;		// see CAPU::SetChipLevel
+	};
+
+	// // // State of the chips at the start of a row, saved by SaveCheckpoint
+	struct checkpoint_t {
+		std::uint64_t Tick = 0;
+		std::uint64_t Sample = 0;
+		apu_state_t State;
+		std::shared_ptr<const ft0cc::doc::dpcm_sample> pSample;
+	};
+
+	explicit CHeadlessPlayer(const CFamiTrackerModule &modfile, unsigned SampleRate = DEFAULT_SAMPLE_RATE);
+	CHeadlessPlayer(const CFamiTrackerModule &modfile, unsigned SampleRate, mixer_settings_t Mixer);		// // //
+	~CHeadlessPlayer();
+
+	void StartPlayer(unsigned Track);
+	void StopPlayer();
+	bool IsPlaying() const;
+
+	// Runs one frame, returns false if the player was halted
+	bool RenderFrame();
+
+	// // // Fast-forward to a position of the current song, restarting it first if the position
+	// has already been played. The sound driver and the chips run exactly as they would in
+	// RenderFrame, since the VRC7 envelopes only advance while its samples are computed, so
+	// playback continues exactly as if the song had been played from the start; only the
+	// audio is discarded. Each returns false if the song halts before the position is reached.
+
+	// Seeks to the given number of frames from the start of the song
+	bool SeekTick(std::uint64_t Tick);
+	// Seeks to the given tick of a row, the first time that row is played
+	bool SeekRow(unsigned Frame, unsigned Row, unsigned Tick = 0);
+	// Seeks to the given number of samples from the start of the song; GetFrameAudio then
+	// returns the rest of the frame that contains the sample
+	bool SeekSample(std::uint64_t Sample);
+
+	// // // Fast-forwards to the given number of frames from the start of the song like SeekTick,
+	// but the audio is dropped before the mixer resamples it and the VRC7 computes no samples.
+	// Every other chip ends up in the same state as in a full playback; the VRC7 operators and
+	// the mixer's high-pass filter only match again after some frames have been rendered.
+	// Returns false if the song halts before the position.
+	bool SkipTick(std::uint64_t Tick);
+
+	// // // Saves the position and the chip state of the current song, which must be at the
+	// start of a row
+	checkpoint_t SaveCheckpoint() const;
+	// // // Starts a song at a checkpoint saved by a player of the same module and settings. The
+	// chips are restored exactly, but the sound driver only gets the state that CSongState
+	// retrieves from the song's checkpoints, without the notes, sequences and effects that are
+	// still running, so playback only matches that of a player started from the beginning
+	// once those have ended. Returns false if the checkpoint is not at the start of a row of
+	// the song or if its chips differ.
+	bool LoadCheckpoint(unsigned Track, const checkpoint_t &Checkpoint);
+
+	const std::vector<int16_t> &GetFrameAudio() const;
+	unsigned GetFrameCount() const;
+	std::uint64_t GetSampleCount() const;		// // //
+	const CTickTimer &GetTickTimer() const;
+
+	const CFamiTrackerModule &GetModule() const;
+	CSoundDriver &GetSoundDriver() const;
+	CAPU &GetAPU() const;
+
+private:
+	void Setup();		// // //
+	bool PlayFrame(bool Render);		// // //
+	void Restart();		// // //
+	void ResetAPU();
+
+	// CSoundGenBase
+	CInstrumentManager *GetInstrumentManager() const override;
+	void OnTick() override;
+	void OnStepRow() override;
+	void OnPlayNote(stChannelID chan, const stChanNote &note) override;
+	void OnUpdateRow(int frame, int row) override;
+	bool IsChannelMuted(stChannelID chan) const override;
+	bool ShouldStopPlayer() const override;
+	int GetArpNote(stChannelID chan) const override;
+
+	// IAudioCallback
+	void FlushBuffer(array_view<int16_t> Buffer) override;
+	bool PlayBuffer() override;
+
+private:
+	const CFamiTrackerModule &modfile_;
+	std::unique_ptr<CSoundDriver> driver_;
+	std::unique_ptr<CAPU> apu_;
+	std::shared_ptr<CTempoCounter> tempo_;
+
+	std::vector<int16_t> audio_;
+	int update_cycles_ = 0;
+	unsigned sample_rate_;		// // //
+	mixer_settings_t mixer_;		// // //
+	unsigned track_ = 0;		// // //
+	unsigned frames_ = 0;
+	std::uint64_t samples_ = 0;		// // //
+	CTickTimer timer_;
+};
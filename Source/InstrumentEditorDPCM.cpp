@@ -372,8 +372,10 @@ void CInstrumentEditorDPCM::OnBnClickedImport()
 {
 	CPCMImport	ImportDialog;
 
-	if (auto pImported = ImportDialog.ShowDialog()) {		// // //
-		InsertSample(std::move(pImported));
+	if (auto Imported = ImportDialog.ShowDialog(); !Imported.empty()) {		// // //
+		for (auto &pImported : Imported)
+			if (!InsertSample(std::move(pImported)))
+				break;
 		BuildSampleList();
 	}
 }
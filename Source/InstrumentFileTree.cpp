@@ -23,13 +23,50 @@
 // The instrument file tree, used in the instrument toolbar to quickly load an instrument
 
 #include "InstrumentFileTree.h"
+#include <ShlObj.h>		// // //
+#include <algorithm>		// // //
+
+namespace {
+
+// // // the index is kept with the user's local application data
+fs::path GetIndexPath() {
+	fs::path Path;
+	PWSTR Folder = nullptr;
+	if (SUCCEEDED(::SHGetKnownFolderPath(FOLDERID_LocalAppData, 0, nullptr, &Folder)))
+		Path = fs::path {Folder} / L"0CC-LLTracker" / L"instruments.idx";
+	::CoTaskMemFree(Folder);
+	return Path;
+}
+
+std::size_t GetDepth(const fs::path &Path) {		// // //
+	return std::distance(Path.begin(), Path.end());
+}
+
+fs::path GetElement(const fs::path &Path, std::size_t Index) {		// // //
+	return *std::next(Path.begin(), Index);
+}
+
+} // namespace
+
+CInstrumentFileTree::CInstrumentFileTree() : m_Library(GetIndexPath())		// // //
+{
+}
+
+CInstrumentFileTree::~CInstrumentFileTree()		// // //
+{
+}
 
-CStringW CInstrumentFileTree::GetFile(int Index) const
+fs::path CInstrumentFileTree::GetFile(int Index) const		// // //
 {
 	ASSERT(Index >= MENU_BASE + 2);
 	return m_fileList[Index - MENU_BASE - 2];
 }
 
+CInstrumentLibrary &CInstrumentFileTree::GetLibrary()		// // //
+{
+	return m_Library;
+}
+
 void CInstrumentFileTree::Changed()
 {
 	m_bShouldRebuild = true;
@@ -38,17 +75,34 @@ void CInstrumentFileTree::Changed()
 bool CInstrumentFileTree::ShouldRebuild() const
 {
 	// Check if tree expired, to allow changes in the file system to be visible
-	return (GetTickCount() > m_iTimeout) || m_bShouldRebuild;
+	return (GetTickCount() > m_iTimeout) || m_bShouldRebuild || m_Library.GetGeneration() != m_iGeneration;		// // //
 }
 
 bool CInstrumentFileTree::BuildMenuTree(const CStringW &instrumentPath)		// // //
 {
-	CWaitCursor wait;
+	const bool bEmpty = instrumentPath.GetLength() == 0;
+	if (!bEmpty) {
+		// // // the library scans the folder in the background, the menu shows the last results
+		m_Library.SetFolder(fs::path {(LPCWSTR)instrumentPath});
+		if (m_bShouldRebuild || GetTickCount() > m_iTimeout) {
+			m_Library.StartScan();
+			m_iTimeout = GetTickCount() + CACHE_TIMEOUT;
+			m_bShouldRebuild = false;
+		}
+		if (!m_Library.GetEntries() && m_Library.IsScanning()) {
+			// no index yet
+			CWaitCursor wait;
+			m_Library.WaitForScan();
+		}
+		if (m_RootMenu.m_hMenu && m_Library.GetGeneration() == m_iGeneration)
+			return true;
+	}
 
 	TRACE(L"Clearing instrument file tree...\n");		// // //
 
 	m_fileList.clear();
 	m_menuArray.clear();
+	m_RootMenu.DestroyMenu();		// // //
 	m_iTotalMenusAdded = 0;
 
 	TRACE(L"Building instrument file tree...\n");
@@ -59,14 +113,16 @@ bool CInstrumentFileTree::BuildMenuTree(const CStringW &instrumentPath)		// // /
 	m_RootMenu.AppendMenuW(MFT_SEPARATOR);
 	m_RootMenu.SetDefaultItem(0, TRUE);
 
-	if (instrumentPath.GetLength() == 0) {
+	if (bEmpty) {
 		m_bShouldRebuild = true;
 		m_RootMenu.AppendMenuW(MFT_STRING | MFS_DISABLED, MENU_BASE + 2, L"(select a directory)");
 	}
 	else {
 		m_iFileIndex = 2;
+		m_iGeneration = m_Library.GetGeneration();		// // //
+		auto pEntries = m_Library.GetEntries();
 
-		if (!ScanDirectory(instrumentPath, m_RootMenu, 0)) {		// // //
+		if (!pEntries || !AddEntries(pEntries->begin(), pEntries->end(), m_RootMenu, 0)) {		// // //
 			// No files found
 			m_RootMenu.AppendMenuW(MFT_STRING | MFS_DISABLED, MENU_BASE + 2, L"(no files found)");
 			m_bShouldRebuild = true;
@@ -74,9 +130,6 @@ bool CInstrumentFileTree::BuildMenuTree(const CStringW &instrumentPath)		// // /
 		else {
 			m_fileList.shrink_to_fit();		// // //
 			m_menuArray.shrink_to_fit();
-
-			m_iTimeout = GetTickCount() + CACHE_TIMEOUT;
-			m_bShouldRebuild = false;
 		}
 	}
 
@@ -85,38 +138,40 @@ bool CInstrumentFileTree::BuildMenuTree(const CStringW &instrumentPath)		// // /
 	return true;
 }
 
-bool CInstrumentFileTree::ScanDirectory(const CStringW &path, CMenu &Menu, int level) {		// // //
-	CFileFind fileFinder;
+bool CInstrumentFileTree::AddEntries(entry_iterator Begin, entry_iterator End, CMenu &Menu, std::size_t level) {		// // //
+	// Entries of the same folder are adjacent; files have exactly level + 1 path elements
+	const auto IsFile = [level] (const stLibraryEntry &x) {
+		return GetDepth(x.Path) == level + 1;
+	};
 	bool bNoFile = true;
 
-	if (level > RECURSION_LIMIT)
-		return false;
-
-	BOOL working = fileFinder.FindFile(path + L"\\*.*");
-
 	// First scan directories
-	while (working) {
-		working = fileFinder.FindNextFileW();
-
-		if (fileFinder.IsDirectory() && !fileFinder.IsHidden() && !fileFinder.IsDots() && m_iTotalMenusAdded++ < MAX_MENUS) {
+	for (auto it = Begin; it != End; ) {
+		if (IsFile(*it)) {
+			++it;
+			continue;
+		}
+		const fs::path Name = GetElement(it->Path, level);
+		auto next = std::find_if(it, End, [&] (const stLibraryEntry &x) {
+			return IsFile(x) || GetElement(x.Path, level) != Name;
+		});
+		if (m_iTotalMenusAdded++ < MAX_MENUS) {
 			auto &SubMenu = *m_menuArray.emplace_back(std::make_unique<CMenu>());		// // //
 			SubMenu.CreatePopupMenu();
-			// Recursive scan
-			bool bEnabled = ScanDirectory(path + L"\\" + fileFinder.GetFileName(), SubMenu, level + 1);
-			Menu.AppendMenuW(MFT_STRING | MF_POPUP | (bEnabled ? MFS_ENABLED : MFS_DISABLED), (UINT_PTR)SubMenu.m_hMenu, fileFinder.GetFileName());
+			bool bEnabled = AddEntries(it, next, SubMenu, level + 1);
+			Menu.AppendMenuW(MFT_STRING | MF_POPUP | (bEnabled ? MFS_ENABLED : MFS_DISABLED), (UINT_PTR)SubMenu.m_hMenu, Name.c_str());
 			bNoFile = false;
 		}
+		it = next;
 	}
 
-	working = fileFinder.FindFile(path + L"\\*.lti");
-
 	// Then files
-	while (working) {
-		working = fileFinder.FindNextFileW();
-		Menu.AppendMenuW(MFT_STRING | MFS_ENABLED, MENU_BASE + m_iFileIndex++, fileFinder.GetFileTitle());
-		m_fileList.push_back(path + L"\\" + fileFinder.GetFileName());		// // //
-		bNoFile = false;
-	}
+	for (auto it = Begin; it != End; ++it)
+		if (IsFile(*it)) {
+			Menu.AppendMenuW(MFT_STRING | MFS_ENABLED, MENU_BASE + m_iFileIndex++, it->Path.stem().c_str());
+			m_fileList.push_back(m_Library.GetFolder() / it->Path);		// // //
+			bNoFile = false;
+		}
 
 	return !bNoFile;
 }
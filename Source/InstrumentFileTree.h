@@ -26,36 +26,43 @@
 #include "stdafx.h"		// // //
 #include <vector>		// // //
 #include <memory>		// // //
+#include "InstrumentLibrary.h"		// // //
 
 // CInstrumentFileTree
 
 class CInstrumentFileTree
 {
 public:
+	CInstrumentFileTree();		// // //
+	~CInstrumentFileTree();		// // //
+
 	bool BuildMenuTree(const CStringW &instrumentPath);		// // //
 	CMenu &GetMenu();		// // //
-	CStringW GetFile(int Index) const;
+	fs::path GetFile(int Index) const;		// // //
+	CInstrumentLibrary &GetLibrary();		// // //
 	bool ShouldRebuild() const;
 	void Changed();
 
 public:
 	// Limits, to avoid very deep recursions
-	static const int RECURSION_LIMIT = 6;
 	static const int MAX_MENUS = 200;
 
 	static const int MENU_BASE = 0x9000;	// Choose a range where no strings are located
 
-	static const int CACHE_TIMEOUT = 60000;	// 1 minute
+	static const int CACHE_TIMEOUT = 60000;	// 1 minute, between background scans
 
 protected:
-	bool ScanDirectory(const CStringW &path, CMenu &Menu, int level);		// // //
+	using entry_iterator = CInstrumentLibrary::entries_t::const_iterator;		// // //
+	bool AddEntries(entry_iterator Begin, entry_iterator End, CMenu &Menu, std::size_t level);		// // //
 
 private:
+	CInstrumentLibrary m_Library;		// // //
 	CMenu m_RootMenu;		// // //
 	int m_iFileIndex = 0;
-	std::vector<CStringW> m_fileList;		// // //
+	std::vector<fs::path> m_fileList;		// // //
 	std::vector<std::unique_ptr<CMenu>> m_menuArray;		// // //
-	DWORD m_iTimeout;
+	DWORD m_iTimeout = 0;
 	bool m_bShouldRebuild = true;
+	unsigned m_iGeneration = 0;		// // // of the library entries in the menu
 	int m_iTotalMenusAdded;
 };
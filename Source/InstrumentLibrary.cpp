@@ -0,0 +1,429 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+#include "InstrumentLibrary.h"
+#include "InstrumentManager.h"
+#include "InstrumentService.h"
+#include "InstrumentIO.h"
+#include "Instrument2A03.h"
+#include "DSampleManager.h"
+#include "Sequence.h"
+#include "FamiTrackerEnv.h"
+#include "ModuleException.h"
+#include "MappedFile.h"
+#include "AtomicFile.h"
+#include "SimpleFile.h"
+#include "NumConv.h"
+#include "ft0cc/doc/dpcm_sample.hpp"
+#include <algorithm>
+#include <optional>
+#include <array>
+#include <cctype>
+#include <utility>
+#include <tuple>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+namespace {
+
+const std::string_view INST_HEADER = "LTI";
+const unsigned I_CURRENT_VER_MAJ = 2;		// 050B
+const unsigned I_CURRENT_VER_MIN = 5;
+
+const std::string_view INDEX_HEADER = "LTIX";
+const int INDEX_VERSION = 1;
+
+bool IsHidden(const fs::path &Path) {
+#ifdef _WIN32
+	DWORD Attr = ::GetFileAttributesW(Path.c_str());
+	return Attr != INVALID_FILE_ATTRIBUTES && (Attr & FILE_ATTRIBUTE_HIDDEN);
+#else
+	auto Name = Path.filename().native();
+	return !Name.empty() && Name.front() == '.';
+#endif
+}
+
+std::string ToLower(std::string str) {
+	std::transform(str.begin(), str.end(), str.begin(), [] (unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	return str;
+}
+
+bool IsInstrumentFile(const fs::path &Path) {
+	return ToLower(Path.extension().u8string()) == ".lti";
+}
+
+// compares paths element-wise ignoring case, so that each folder's entries stay adjacent
+bool PathLessNoCase(const fs::path &lhs, const fs::path &rhs) {
+	return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [] (const fs::path &l, const fs::path &r) {
+		return ToLower(l.u8string()) < ToLower(r.u8string());
+	});
+}
+
+// FNV-1a
+std::uint64_t HashContents(std::string_view sv) {
+	std::uint64_t h = 0xCBF29CE484222325u;
+	for (unsigned char c : sv)
+		h = (h ^ c) * 0x100000001B3u;
+	return h;
+}
+
+// Reads the type and the name of an instrument file without loading the instrument
+std::optional<std::pair<inst_type_t, std::string_view>> ParseHeader(std::string_view Data) {
+	const std::size_t NamePos = INST_HEADER.size() + 4 + 4;
+	if (Data.size() < NamePos || Data.substr(0, INST_HEADER.size()) != INST_HEADER)
+		return std::nullopt;
+	Data.remove_prefix(INST_HEADER.size());
+	unsigned Maj = conv::from_digit(Data[0]);
+	unsigned Min = conv::from_digit(Data[2]);
+	if (Data[1] != '.' || Maj > 9 || Min > 9 || std::tie(Maj, Min) > std::tie(I_CURRENT_VER_MAJ, I_CURRENT_VER_MIN))
+		return std::nullopt;
+	auto Type = static_cast<inst_type_t>(static_cast<unsigned char>(Data[3]));
+	std::uint32_t Len = 0;
+	for (int i = 3; i >= 0; --i)
+		Len = (Len << 8) | static_cast<unsigned char>(Data[4 + i]);
+	if (Len > Data.size() - 8)
+		return std::nullopt;
+	return std::pair {Type != INST_NONE ? Type : INST_2A03, Data.substr(8, Len)};
+}
+
+// little-endian, as CSimpleFile reads it
+void AppendInt(std::vector<unsigned char> &Data, std::uint64_t x, std::size_t Bytes) {
+	for (std::size_t i = 0; i < Bytes; ++i)
+		Data.push_back(static_cast<unsigned char>(x >> (i * 8)));
+}
+
+void AppendString(std::vector<unsigned char> &Data, std::string_view sv) {
+	AppendInt(Data, sv.size(), 4);
+	Data.insert(Data.end(), sv.begin(), sv.end());
+}
+
+std::uint64_t ReadInt64(CSimpleFile &file) {
+	std::uint64_t lo = file.ReadUint32();
+	return lo | (static_cast<std::uint64_t>(file.ReadUint32()) << 32);
+}
+
+std::shared_ptr<const CInstrumentManager> ParseInstrument(const fs::path &Path, module_error_level_t err_lv) {
+	CSimpleFile file {Path, std::ios::in | std::ios::binary};
+	if (!file)
+		throw CModuleException::WithMessage("Unable to open file:\n" + Path.u8string());
+
+	if (file.ReadStringN(INST_HEADER.size()) != INST_HEADER)
+		throw CModuleException::WithMessage("Not an instrument file:\n" + Path.u8string());
+	unsigned iInstMaj = conv::from_digit(file.ReadInt8());
+	if (file.ReadInt8() != '.')
+		throw CModuleException::WithMessage("Unsupported instrument file version");
+	unsigned iInstMin = conv::from_digit(file.ReadInt8());
+	if (std::tie(iInstMaj, iInstMin) > std::tie(I_CURRENT_VER_MAJ, I_CURRENT_VER_MIN))
+		throw CModuleException::WithMessage("Unsupported instrument file version");
+
+	auto pManager = std::make_shared<CInstrumentManager>();
+	inst_type_t InstType = static_cast<inst_type_t>(file.ReadInt8());
+	auto pInstrument = pManager->CreateNew(InstType != INST_NONE ? InstType : INST_2A03);
+	if (!pInstrument)
+		throw CModuleException::WithMessage("Failed to create instrument");
+	pInstrument->OnBlankInstrument();
+	FTEnv.GetInstrumentService()->GetInstrumentIO(InstType, err_lv)->ReadFromFTI(*pInstrument, file, iInstMaj * 10 + iInstMin);
+	pManager->InsertInstrument(0, std::move(pInstrument));
+	return pManager;
+}
+
+} // namespace
+
+bool stLibraryEntry::operator==(const stLibraryEntry &other) const {
+	return Path == other.Path && ModifiedTime == other.ModifiedTime && Size == other.Size &&
+		Hash == other.Hash && Type == other.Type && Name == other.Name;
+}
+
+CInstrumentLibrary::CInstrumentLibrary(fs::path IndexFile) : index_file_(std::move(IndexFile)) {
+}
+
+CInstrumentLibrary::~CInstrumentLibrary() {
+	StopScan();
+}
+
+void CInstrumentLibrary::SetFolder(const fs::path &Folder) {
+	if (Folder == folder_)
+		return;
+	StopScan();
+	folder_ = Folder;
+	{
+		std::lock_guard<std::mutex> lock {mutex_};
+		entries_.reset();
+	}
+	LoadIndex();
+	++generation_;
+}
+
+const fs::path &CInstrumentLibrary::GetFolder() const {
+	return folder_;
+}
+
+void CInstrumentLibrary::StartScan() {
+	if (scanning_ || folder_.empty())
+		return;
+	if (thread_.joinable())
+		thread_.join();
+	scanning_ = true;
+	thread_ = std::thread {[this, Folder = folder_, Previous = GetEntries()] {
+		try {
+			Scan(Folder, Previous);
+		}
+		catch (std::exception &) {
+			// keep the previous entries
+		}
+		scanning_ = false;
+	}};
+}
+
+void CInstrumentLibrary::WaitForScan() {
+	if (thread_.joinable())
+		thread_.join();
+}
+
+bool CInstrumentLibrary::IsScanning() const {
+	return scanning_;
+}
+
+void CInstrumentLibrary::StopScan() {
+	cancel_ = true;
+	WaitForScan();
+	cancel_ = false;
+}
+
+std::shared_ptr<const CInstrumentLibrary::entries_t> CInstrumentLibrary::GetEntries() const {
+	std::lock_guard<std::mutex> lock {mutex_};
+	return entries_;
+}
+
+unsigned CInstrumentLibrary::GetGeneration() const {
+	return generation_;
+}
+
+void CInstrumentLibrary::Scan(fs::path Folder, std::shared_ptr<const entries_t> Previous) {
+	// unchanged files are not read again
+	std::unordered_map<fs::path::string_type, const stLibraryEntry *> Known;
+	if (Previous)
+		for (const auto &x : *Previous)
+			Known.try_emplace(x.Path.native(), &x);
+
+	entries_t Entries;
+	std::error_code ec;
+	for (fs::recursive_directory_iterator it {Folder, fs::directory_options::skip_permission_denied, ec}, end;
+		!ec && it != end; it.increment(ec)) {
+		if (cancel_)
+			return;
+
+		std::error_code fec;
+		const fs::directory_entry &File = *it;
+		if (File.is_directory(fec)) {
+			if (it.depth() >= RECURSION_LIMIT || IsHidden(File.path()))
+				it.disable_recursion_pending();
+			continue;
+		}
+		if (!IsInstrumentFile(File.path()))
+			continue;
+
+		stLibraryEntry Entry;
+		Entry.Path = File.path().lexically_relative(Folder);
+		Entry.ModifiedTime = File.last_write_time(fec).time_since_epoch().count();
+		Entry.Size = File.file_size(fec);
+		if (fec)
+			continue;
+
+		if (auto k = Known.find(Entry.Path.native());
+			k != Known.end() && k->second->ModifiedTime == Entry.ModifiedTime && k->second->Size == Entry.Size) {
+			Entries.push_back(*k->second);
+			continue;
+		}
+
+		try {
+			CMappedFile Contents {File.path()};
+			Entry.Hash = HashContents(Contents.GetText());
+			if (auto Header = ParseHeader(Contents.GetText())) {
+				Entry.Type = Header->first;
+				Entry.Name = Header->second;
+			}
+			else
+				Entry.Type = INST_NONE;
+		}
+		catch (std::runtime_error &) {
+			continue;
+		}
+		Entries.push_back(std::move(Entry));
+	}
+
+	std::sort(Entries.begin(), Entries.end(), [] (const stLibraryEntry &lhs, const stLibraryEntry &rhs) {
+		return PathLessNoCase(lhs.Path, rhs.Path);
+	});
+
+	if (cancel_ || (Previous && *Previous == Entries))
+		return;
+	SaveIndex(Entries);
+	{
+		std::lock_guard<std::mutex> lock {mutex_};
+		entries_ = std::make_shared<const entries_t>(std::move(Entries));
+	}
+	++generation_;
+}
+
+void CInstrumentLibrary::LoadIndex() {
+	if (index_file_.empty())
+		return;
+	try {
+		CSimpleFile file {index_file_, std::ios::in | std::ios::binary};
+		if (!file || file.ReadStringN(INDEX_HEADER.size()) != INDEX_HEADER || file.ReadInt32() != INDEX_VERSION)
+			return;
+		if (fs::u8path(file.ReadString()) != folder_)
+			return;
+
+		auto pEntries = std::make_shared<entries_t>(file.ReadUint32());
+		for (auto &x : *pEntries) {
+			x.Path = fs::u8path(file.ReadString());
+			x.ModifiedTime = static_cast<std::int64_t>(ReadInt64(file));
+			x.Size = ReadInt64(file);
+			x.Hash = ReadInt64(file);
+			x.Type = static_cast<inst_type_t>(file.ReadUint8());
+			x.Name = file.ReadString();
+		}
+		if (file.ReadStringN(INDEX_HEADER.size()) != INDEX_HEADER)		// truncated
+			return;
+
+		std::lock_guard<std::mutex> lock {mutex_};
+		entries_ = std::move(pEntries);
+	}
+	catch (std::exception &) {
+		// rebuilt by the next scan
+	}
+}
+
+void CInstrumentLibrary::SaveIndex(const entries_t &Entries) const {
+	if (index_file_.empty())
+		return;
+
+	std::vector<unsigned char> Data;
+	Data.insert(Data.end(), INDEX_HEADER.begin(), INDEX_HEADER.end());
+	AppendInt(Data, INDEX_VERSION, 4);
+	AppendString(Data, folder_.u8string());
+	AppendInt(Data, Entries.size(), 4);
+	for (const auto &x : Entries) {
+		AppendString(Data, x.Path.u8string());
+		AppendInt(Data, static_cast<std::uint64_t>(x.ModifiedTime), 8);
+		AppendInt(Data, x.Size, 8);
+		AppendInt(Data, x.Hash, 8);
+		AppendInt(Data, x.Type, 1);
+		AppendString(Data, x.Name);
+	}
+	Data.insert(Data.end(), INDEX_HEADER.begin(), INDEX_HEADER.end());
+
+	std::error_code ec;
+	fs::create_directories(index_file_.parent_path(), ec);
+	try {
+		WriteFileAtomic(index_file_, Data);
+	}
+	catch (std::runtime_error &) {
+		// the entries are still published, and the index is written again by the next scan
+	}
+}
+
+std::shared_ptr<const CInstrumentManager> CInstrumentLibrary::GetInstrument(const fs::path &Path, module_error_level_t err_lv) {
+	std::error_code ec;
+	auto Time = fs::last_write_time(Path, ec).time_since_epoch().count();
+	auto Size = fs::file_size(Path, ec);
+	if (ec)
+		throw CModuleException::WithMessage("Unable to open file:\n" + Path.u8string());
+
+	std::string Key = Path.u8string();
+	Key.push_back('\0');
+	Key += std::to_string(Time);
+	Key.push_back('\0');
+	Key += std::to_string(Size);
+	Key.push_back('\0');
+	Key += std::to_string(err_lv);
+
+	if (auto it = cache_index_.find(Key); it != cache_index_.end()) {
+		cache_.splice(cache_.begin(), cache_, it->second);
+		return it->second->Manager;
+	}
+
+	auto pManager = ParseInstrument(Path, err_lv);
+	cache_.push_front({Key, pManager});
+	cache_index_.insert_or_assign(std::move(Key), cache_.begin());
+	if (cache_.size() > MAX_CACHED_INSTRUMENTS) {
+		cache_index_.erase(cache_.back().Key);
+		cache_.pop_back();
+	}
+	return pManager;
+}
+
+std::unique_ptr<CInstrument> CInstrumentLibrary::Instantiate(const CInstrumentManager &Source, CInstrumentManager &Target) {
+	auto pInst = Source.GetInstrument(0)->Clone();
+	pInst->RegisterManager(&Target);
+	const inst_type_t Type = pInst->GetType();
+
+	// FDS instruments own their sequences
+	auto *pSeqInst = dynamic_cast<CSeqInstrument *>(pInst.get());
+	if (!pSeqInst || Type == INST_FDS)
+		return pInst;
+
+	for (auto t : enum_values<sequence_t>())
+		if (pSeqInst->GetSeqEnable(t)) {
+			int Index = Target.GetFreeSequenceIndex(Type, t, nullptr);
+			if (Index == -1)
+				throw CModuleException::WithMessage("Document has no free sequence slot");
+			*Target.GetSequence(Type, t, Index) = *Source.GetSequence(Type, t, pSeqInst->GetSeqIndex(t));
+			pSeqInst->SetSeqIndex(t, Index);
+		}
+
+	if (auto *p2A03 = dynamic_cast<CInstrument2A03 *>(pSeqInst)) {
+		// reuse identical samples
+		const auto &TargetConst = Target;
+		unsigned TotalSize = Target.GetDSampleManager()->GetTotalSize();
+		std::array<int, MAX_DSAMPLES> SampleMap;
+		SampleMap.fill(-1);
+		for (int n = 0; n < NOTE_COUNT; ++n) {
+			unsigned Index = p2A03->GetSampleIndex(n);
+			if (Index == CInstrument2A03::NO_DPCM)
+				continue;
+			auto pSample = Index < MAX_DSAMPLES ? Source.GetDSample(Index) : nullptr;
+			if (!pSample) {
+				p2A03->SetSampleIndex(n, CInstrument2A03::NO_DPCM);
+				continue;
+			}
+			int &Mapped = SampleMap[Index];
+			for (int j = 0; j < MAX_DSAMPLES && Mapped == -1; ++j)
+				if (auto s = TargetConst.GetDSample(j); s && *s == *pSample)
+					Mapped = j;
+			if (Mapped == -1) {
+				if (TotalSize + pSample->size() > MAX_SAMPLE_SPACE)
+					throw CModuleException::WithMessage("Insufficient DPCM sample space (maximum " + conv::from_int(MAX_SAMPLE_SPACE / 1024) + " KB)");
+				Mapped = Target.AddDSample(std::make_shared<ft0cc::doc::dpcm_sample>(*pSample));
+				if (Mapped == -1)
+					throw CModuleException::WithMessage("Document has no free DPCM sample slot");
+				TotalSize += pSample->size();
+			}
+			p2A03->SetSampleIndex(n, Mapped);
+		}
+	}
+
+	return pInst;
+}
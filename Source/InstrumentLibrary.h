@@ -0,0 +1,119 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include "ft0cc/fs.h"
+
+class CInstrument;
+class CInstrumentManager;
+enum inst_type_t : unsigned;
+enum module_error_level_t : unsigned char;
+
+// // // An instrument file found by CInstrumentLibrary
+struct stLibraryEntry {
+	fs::path Path;					// relative to the library folder
+	std::int64_t ModifiedTime = 0;
+	std::uint64_t Size = 0;
+	std::uint64_t Hash = 0;			// of the file contents
+	inst_type_t Type = { };			// INST_NONE if the file is not a valid instrument
+	std::string Name;
+
+	bool operator==(const stLibraryEntry &other) const;
+};
+
+// // // Index of the instrument files in a folder. The index is stored in a file, and is
+// updated by a background scan that only reads the files whose modification time or size
+// has changed. Parsed instruments are cached, so that loading the same file again does not
+// read it from the disk.
+
+class CInstrumentLibrary {
+public:
+	// Limits, to avoid very deep recursions
+	static constexpr int RECURSION_LIMIT = 6;
+	static constexpr std::size_t MAX_CACHED_INSTRUMENTS = 256;
+
+	using entries_t = std::vector<stLibraryEntry>;
+
+	// The index is not saved if IndexFile is empty
+	explicit CInstrumentLibrary(fs::path IndexFile);
+	~CInstrumentLibrary();
+
+	// Switches to another folder, loading its entries from the index file if possible
+	void SetFolder(const fs::path &Folder);
+	const fs::path &GetFolder() const;
+
+	// Starts a background scan of the folder, unless one is already running
+	void StartScan();
+	void WaitForScan();
+	bool IsScanning() const;
+
+	// Returns the entries sorted by path ignoring case; the generation changes whenever they do
+	std::shared_ptr<const entries_t> GetEntries() const;
+	unsigned GetGeneration() const;
+
+	// Returns the instrument in a file as the only instrument of an instrument manager.
+	// Throws CModuleException if the file cannot be loaded.
+	std::shared_ptr<const CInstrumentManager> GetInstrument(const fs::path &Path, module_error_level_t err_lv);
+
+	// Copies an instrument returned by GetInstrument, adding its sequences and DPCM samples
+	// to another instrument manager, in the same way as CInstrumentIO::ReadFromFTI.
+	// Throws CModuleException if the manager runs out of sequences or samples.
+	static std::unique_ptr<CInstrument> Instantiate(const CInstrumentManager &Source, CInstrumentManager &Target);
+
+private:
+	void StopScan();
+	void Scan(fs::path Folder, std::shared_ptr<const entries_t> Previous);
+	void LoadIndex();
+	void SaveIndex(const entries_t &Entries) const;
+
+private:
+	struct cache_entry_t {
+		std::string Key;
+		std::shared_ptr<const CInstrumentManager> Manager;
+	};
+
+	const fs::path index_file_;
+	fs::path folder_;
+
+	mutable std::mutex mutex_;
+	std::shared_ptr<const entries_t> entries_;
+	std::atomic<unsigned> generation_ {0};
+
+	std::thread thread_;
+	std::atomic<bool> scanning_ {false};
+	std::atomic<bool> cancel_ {false};
+
+	// most recently used first
+	std::list<cache_entry_t> cache_;
+	std::unordered_map<std::string, std::list<cache_entry_t>::iterator> cache_index_;
+};
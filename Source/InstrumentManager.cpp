@@ -34,7 +34,8 @@ const int CInstrumentManager::MAX_INSTRUMENTS = 64;
 const int CInstrumentManager::SEQ_MANAGER_COUNT = 5;
 
 CInstrumentManager::CInstrumentManager() :
-	m_pInstruments(MAX_INSTRUMENTS),
+	table_(std::make_unique<instrument_table_t>(MAX_INSTRUMENTS)),		// // //
+	published_(table_.get()),
 	m_pDSampleManager(std::make_unique<CDSampleManager>())
 {
 	for (int i = 0; i < SEQ_MANAGER_COUNT; ++i)
@@ -43,28 +44,76 @@ CInstrumentManager::CInstrumentManager() :
 
 CInstrumentManager::~CInstrumentManager()
 {
-	for (auto &ptr : m_pInstruments)
+	for (auto &ptr : *table_)		// // //
 		if (ptr)
 			ptr->RegisterManager(nullptr);
 }
 
+//
+// Instrument table
+//
+
+CInstrumentManager::CTableReader::CTableReader(const CInstrumentManager &manager) :		// // //
+	manager_(manager)
+{
+	// announce the reader before loading the table, see CInstrumentManager::Publish
+	manager_.readers_.fetch_add(1u);
+	table_ = manager_.published_.load();
+}
+
+CInstrumentManager::CTableReader::~CTableReader() {
+	manager_.readers_.fetch_sub(1u);
+}
+
+const CInstrumentManager::instrument_table_t &CInstrumentManager::CTableReader::operator*() const {
+	return *table_;
+}
+
+const CInstrumentManager::instrument_table_t *CInstrumentManager::CTableReader::operator->() const {
+	return table_;
+}
+
+template <typename F>
+void CInstrumentManager::ModifyTable(F f) {		// // //
+	std::lock_guard<std::mutex> lock(m_InstrumentLock);
+	auto pTable = std::make_unique<instrument_table_t>(*table_);
+	if (f(*pTable))
+		Publish(std::move(pTable));
+}
+
+void CInstrumentManager::Publish(std::unique_ptr<instrument_table_t> pTable) {		// // //
+	published_.store(pTable.get());
+	retired_.push_back(std::move(table_));
+	table_ = std::move(pTable);
+
+	// a reader that has not been counted yet will load the new table, so the replaced tables
+	// can be deleted once no readers are active
+	if (readers_.load() == 0u)
+		retired_.clear();
+}
+
 //
 // Instrument methods
 //
 
 std::shared_ptr<CInstrument> CInstrumentManager::GetInstrument(unsigned int Index) const
 {
-	std::lock_guard<std::mutex> lock(m_InstrumentLock);
-	return Index < m_pInstruments.size() ? m_pInstruments[Index] : nullptr;
+	CTableReader table {*this};		// // //
+	return Index < table->size() ? (*table)[Index] : nullptr;
 }
 
 std::shared_ptr<CInstrument> CInstrumentManager::ReleaseInstrument(unsigned int Index) {
-	std::lock_guard<std::mutex> lock(m_InstrumentLock);
-	if (Index >= m_pInstruments.size())
-		return nullptr;
-	if (m_pInstruments[Index])
-		m_pInstruments[Index]->RegisterManager(nullptr);
-	return std::move(m_pInstruments[Index]);
+	std::shared_ptr<CInstrument> pInst;
+	ModifyTable([&] (instrument_table_t &table) {		// // //
+		if (Index >= table.size())
+			return false;
+		dirty_ = true;		// // //
+		if (table[Index])
+			table[Index]->RegisterManager(nullptr);
+		pInst = std::move(table[Index]);
+		return true;
+	});
+	return pInst;
 }
 
 std::unique_ptr<CInstrument> CInstrumentManager::CreateNew(inst_type_t InstType)
@@ -78,34 +127,37 @@ bool CInstrumentManager::InsertInstrument(unsigned int Index, std::shared_ptr<CI
 {
 	if (!pInst)
 		return false;
-	m_InstrumentLock.lock();
-	if (Index < m_pInstruments.size()) {
-		if (m_pInstruments[Index] != pInst) {
-			if (m_pInstruments[Index])
-				m_pInstruments[Index]->RegisterManager(nullptr);
-			m_pInstruments[Index] = pInst;
-			m_InstrumentLock.unlock();
-			pInst->RegisterManager(this);
-		}
-		else
-			m_InstrumentLock.unlock();
-		return true;
-	}
-	m_InstrumentLock.unlock();
-	return false;
+	bool Valid = false;
+	bool Changed = false;
+	ModifyTable([&] (instrument_table_t &table) {		// // //
+		if (Index >= table.size())
+			return false;
+		Valid = true;
+		if (table[Index] == pInst)
+			return false;
+		if (table[Index])
+			table[Index]->RegisterManager(nullptr);
+		table[Index] = pInst;
+		dirty_ = true;		// // //
+		return Changed = true;
+	});
+	if (Changed)
+		pInst->RegisterManager(this);
+	return Valid;
 }
 
 bool CInstrumentManager::RemoveInstrument(unsigned int Index)
 {
-	std::lock_guard<std::mutex> lock(m_InstrumentLock);
-	if (Index >= m_pInstruments.size())
-		return false;
-	if (m_pInstruments[Index]) {
-		m_pInstruments[Index]->RegisterManager(nullptr);
-		m_pInstruments[Index].reset();
-		return true;
-	}
-	return false;
+	bool Removed = false;
+	ModifyTable([&] (instrument_table_t &table) {		// // //
+		if (Index >= table.size() || !table[Index])
+			return false;
+		table[Index]->RegisterManager(nullptr);
+		table[Index].reset();
+		dirty_ = true;		// // //
+		return Removed = true;
+	});
+	return Removed;
 }
 
 int CInstrumentManager::CloneInstrument(unsigned OldIndex, unsigned NewIndex) {		// // //
@@ -133,41 +185,50 @@ bool CInstrumentManager::DeepCloneInstrument(unsigned OldIndex, unsigned NewInde
 }
 
 void CInstrumentManager::SwapInstruments(unsigned int IndexA, unsigned int IndexB) {
-	std::lock_guard<std::mutex> lock(m_InstrumentLock);
-	m_pInstruments[IndexA].swap(m_pInstruments[IndexB]);
+	ModifyTable([&] (instrument_table_t &table) {		// // //
+		table[IndexA].swap(table[IndexB]);
+		dirty_ = true;		// // //
+		return true;
+	});
 }
 
 void CInstrumentManager::ClearAll()
 {
-	std::lock_guard<std::mutex> lock(m_InstrumentLock);
-	for (auto &ptr : m_pInstruments) {
-		if (ptr)
-			ptr->RegisterManager(nullptr);
-		ptr.reset();
-	}
-	for (int i = 0; i < SEQ_MANAGER_COUNT; ++i)
-		m_pSequenceManager[i] = std::make_unique<CSequenceManager>(i == 2 ? 3 : SEQ_COUNT);
-	m_pDSampleManager = std::make_unique<CDSampleManager>();
+	ModifyTable([&] (instrument_table_t &table) {		// // //
+		for (auto &ptr : table) {
+			if (ptr)
+				ptr->RegisterManager(nullptr);
+			ptr.reset();
+		}
+		for (int i = 0; i < SEQ_MANAGER_COUNT; ++i)
+			m_pSequenceManager[i] = std::make_unique<CSequenceManager>(i == 2 ? 3 : SEQ_COUNT);
+		m_pDSampleManager = std::make_unique<CDSampleManager>();
+		dirty_ = true;		// // //
+		return true;
+	});
 }
 
 bool CInstrumentManager::HasInstrument(unsigned int Index) const
 {
-	return Index < MAX_INSTRUMENTS && m_pInstruments[Index] != nullptr;
+	CTableReader table {*this};		// // //
+	return Index < MAX_INSTRUMENTS && (*table)[Index] != nullptr;
 }
 
 unsigned int CInstrumentManager::GetInstrumentCount() const
 {
+	CTableReader table {*this};		// // //
 	unsigned x = 0;
 	for (int i = 0; i < MAX_INSTRUMENTS; ++i)
-		if (m_pInstruments[i])
+		if ((*table)[i])
 			++x;
 	return x;
 }
 
 unsigned int CInstrumentManager::GetFirstUnused() const
 {
+	CTableReader table {*this};		// // //
 	for (int i = 0; i < MAX_INSTRUMENTS; ++i)
-		if (!m_pInstruments[i])
+		if (!(*table)[i])
 			return i;
 	return INVALID_INSTRUMENT;
 }
@@ -206,7 +267,8 @@ int CInstrumentManager::GetTotalSequenceCount(inst_type_t InstType) const {
 
 inst_type_t CInstrumentManager::GetInstrumentType(unsigned int Index) const
 {
-	return !HasInstrument(Index) ? INST_NONE : m_pInstruments[Index]->GetType();
+	auto pInst = GetInstrument(Index);		// // //
+	return pInst ? pInst->GetType() : INST_NONE;
 }
 
 //
@@ -247,8 +309,10 @@ std::shared_ptr<CSequence> CInstrumentManager::GetSequence(inst_type_t InstType,
 void CInstrumentManager::SetSequence(inst_type_t InstType, sequence_t SeqType, int Index, std::shared_ptr<CSequence> pSeq)
 {
 	if (auto pManager = GetSequenceManager(InstType))
-		if (auto pCol = pManager->GetCollection(SeqType))
+		if (auto pCol = pManager->GetCollection(SeqType)) {
 			pCol->SetSequence(Index, std::move(pSeq));
+			dirty_ = true;		// // //
+		}
 }
 
 int CInstrumentManager::AddSequence(inst_type_t InstType, sequence_t SeqType, std::shared_ptr<CSequence> pSeq, CSeqInstrument *pInst)
@@ -271,7 +335,7 @@ std::shared_ptr<const ft0cc::doc::dpcm_sample> CInstrumentManager::GetDSample(in
 
 void CInstrumentManager::SetDSample(int Index, std::shared_ptr<ft0cc::doc::dpcm_sample> pSamp)
 {
-	m_pDSampleManager->SetDSample(Index, std::move(pSamp));
+	m_pDSampleManager->SetDSample(Index, std::move(pSamp));		// // // marks the sample manager dirty
 }
 
 int CInstrumentManager::AddDSample(std::shared_ptr<ft0cc::doc::dpcm_sample> pSamp)
@@ -281,3 +345,16 @@ int CInstrumentManager::AddDSample(std::shared_ptr<ft0cc::doc::dpcm_sample> pSam
 		SetDSample(Index, std::move(pSamp));
 	return Index;
 }
+
+bool CInstrumentManager::IsDirty() const {		// // //
+	return dirty_ || m_pDSampleManager->IsDirty();
+}
+
+void CInstrumentManager::SetDirty() {
+	dirty_ = true;
+}
+
+void CInstrumentManager::ClearDirty() {
+	dirty_ = false;
+	m_pDSampleManager->ClearDirty();		// // //
+}
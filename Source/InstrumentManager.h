@@ -27,6 +27,7 @@
 #include <vector>
 #include <memory>
 #include <mutex>
+#include <atomic>		// // //
 
 class CInstrument;
 class CSequenceManager;
@@ -79,17 +80,24 @@ public:
 	void SetDSample(int Index, std::shared_ptr<ft0cc::doc::dpcm_sample> pSamp) override;
 	int AddDSample(std::shared_ptr<ft0cc::doc::dpcm_sample> pSamp) override;
 
+	// // // dirty tracking for incremental saving
+	// instruments, sequences and samples edited in place must call SetDirty themselves
+	bool IsDirty() const;
+	void SetDirty();
+	void ClearDirty();
+
 	// void (*F)(CInstrument &inst [, std::size_t index])
 	template <typename F>
 	void VisitInstruments(F f) {
+		CTableReader table {*this};		// // //
 		if constexpr (std::is_invocable_v<F, CInstrument &>) {
-			for (auto &x : m_pInstruments)
+			for (auto &x : *table)
 				if (x)
 					f(*x);
 		}
 		else if constexpr (std::is_invocable_v<F, CInstrument &, std::size_t>) {
 			std::size_t index = 0;
-			for (auto &x : m_pInstruments) {
+			for (auto &x : *table) {
 				if (x)
 					f(*x, index);
 				++index;
@@ -102,14 +110,15 @@ public:
 	// void (*F)(const CInstrument &inst [, std::size_t index])
 	template <typename F>
 	void VisitInstruments(F f) const {
+		CTableReader table {*this};		// // //
 		if constexpr (std::is_invocable_v<F, const CInstrument &>) {
-			for (auto &x : m_pInstruments)
+			for (auto &x : *table)
 				if (x)
 					f(*x);
 		}
 		else if constexpr (std::is_invocable_v<F, const CInstrument &, std::size_t>) {
 			std::size_t index = 0;
-			for (auto &x : m_pInstruments) {
+			for (auto &x : *table) {
 				if (x)
 					f(*x, index);
 				++index;
@@ -123,11 +132,43 @@ public:
 	static const int MAX_INSTRUMENTS;
 
 private:
-	std::vector<std::shared_ptr<CInstrument>> m_pInstruments;
+	// // // The instrument table is never modified once published. Editing functions copy it,
+	// modify the copy and swap it in, so that the sound thread can read the table without
+	// locking. A replaced table is kept until no reader may still be using it.
+	using instrument_table_t = std::vector<std::shared_ptr<CInstrument>>;
+
+	// Holds the current instrument table for reading; does not block the editing functions
+	class CTableReader {
+	public:
+		explicit CTableReader(const CInstrumentManager &manager);
+		~CTableReader();
+		CTableReader(const CTableReader &) = delete;
+		CTableReader &operator=(const CTableReader &) = delete;
+
+		const instrument_table_t &operator*() const;
+		const instrument_table_t *operator->() const;
+
+	private:
+		const CInstrumentManager &manager_;
+		const instrument_table_t *table_;
+	};
+
+	// bool (*F)(instrument_table_t &table), called on a copy of the table with m_InstrumentLock
+	// held; the copy replaces the table if F returns true
+	template <typename F>
+	void ModifyTable(F f);
+	void Publish(std::unique_ptr<instrument_table_t> pTable);
+
+private:
+	std::unique_ptr<const instrument_table_t> table_;		// // //
+	std::atomic<const instrument_table_t *> published_ {nullptr};
+	mutable std::atomic<unsigned> readers_ {0u};
+	std::vector<std::unique_ptr<const instrument_table_t>> retired_;
 	std::vector<std::unique_ptr<CSequenceManager>> m_pSequenceManager;
 	std::unique_ptr<CDSampleManager> m_pDSampleManager;
 
-	mutable std::mutex m_InstrumentLock;		// // //
+	std::mutex m_InstrumentLock;		// // // serializes editing functions only
+	bool dirty_ = true;		// // //
 
 private:
 	static const int SEQ_MANAGER_COUNT;
@@ -0,0 +1,739 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+#include "JsonStream.h"
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <charconv>
+#include <algorithm>
+#include <utility>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+constexpr std::size_t BUFFER_SIZE = 0x10000;
+
+} // namespace
+
+
+
+CJsonWriter::CJsonWriter(std::ostream &os, json_format_t fmt) : os_(os), fmt_(fmt) {
+	buf_.reserve(BUFFER_SIZE);
+}
+
+CJsonWriter::~CJsonWriter() noexcept {
+	Flush();
+}
+
+void CJsonWriter::BeginObject(std::size_t n) {
+	BeginValue();
+	switch (fmt_) {
+	case json_format_t::text: Put('{'); break;
+	case json_format_t::cbor: PutCBORHeader(0xA0u, n); break;
+	case json_format_t::msgpack: PutMsgPackHeader(n, 0x80u, 0x0Fu, 0xDEu); break;
+	}
+	stack_.push_back({true, n});
+	first_ = true;
+}
+
+void CJsonWriter::EndObject() {
+	EndContainer(true);
+}
+
+void CJsonWriter::BeginArray(std::size_t n) {
+	BeginValue();
+	switch (fmt_) {
+	case json_format_t::text: Put('['); break;
+	case json_format_t::cbor: PutCBORHeader(0x80u, n); break;
+	case json_format_t::msgpack: PutMsgPackHeader(n, 0x90u, 0x0Fu, 0xDCu); break;
+	}
+	stack_.push_back({false, n});
+	first_ = true;
+}
+
+void CJsonWriter::EndArray() {
+	EndContainer(false);
+}
+
+void CJsonWriter::Key(std::string_view key) {
+	if (stack_.empty() || !stack_.back().object || after_key_)
+		throw std::logic_error {"JSON key written outside of an object"};
+	if (fmt_ == json_format_t::text && !first_)
+		Put(',');
+	first_ = false;
+	PutString(key);
+	if (fmt_ == json_format_t::text)
+		Put(':');
+	after_key_ = true;
+}
+
+void CJsonWriter::Null() {
+	BeginValue();
+	switch (fmt_) {
+	case json_format_t::text: PutText("null"); break;
+	case json_format_t::cbor: Put(0xF6u); break;
+	case json_format_t::msgpack: Put(0xC0u); break;
+	}
+}
+
+void CJsonWriter::Bool(bool x) {
+	BeginValue();
+	switch (fmt_) {
+	case json_format_t::text: PutText(x ? "true" : "false"); break;
+	case json_format_t::cbor: Put(x ? 0xF5u : 0xF4u); break;
+	case json_format_t::msgpack: Put(x ? 0xC3u : 0xC2u); break;
+	}
+}
+
+void CJsonWriter::Int(std::int64_t x) {
+	BeginValue();
+	switch (fmt_) {
+	case json_format_t::text: {
+		char str[24];
+		auto [end, ec] = std::to_chars(std::begin(str), std::end(str), x);
+		(void)ec;
+		PutText(std::string_view {str, static_cast<std::size_t>(end - str)});
+	} break;
+	case json_format_t::cbor:
+		if (x >= 0)
+			PutCBORHeader(0x00u, static_cast<std::uint64_t>(x));
+		else
+			PutCBORHeader(0x20u, static_cast<std::uint64_t>(-(x + 1)));
+		break;
+	case json_format_t::msgpack:
+		// use the smallest representation, positive integers are always unsigned
+		if (x >= 0) {
+			auto u = static_cast<std::uint64_t>(x);
+			if (u <= 0x7Fu)
+				Put(static_cast<unsigned char>(u));
+			else if (u <= 0xFFu)
+				Put(0xCCu), PutBigEndian(u, 1);
+			else if (u <= 0xFFFFu)
+				Put(0xCDu), PutBigEndian(u, 2);
+			else if (u <= 0xFFFFFFFFu)
+				Put(0xCEu), PutBigEndian(u, 4);
+			else
+				Put(0xCFu), PutBigEndian(u, 8);
+		}
+		else {
+			auto u = static_cast<std::uint64_t>(x);
+			if (x >= -32)
+				Put(static_cast<unsigned char>(u));
+			else if (x >= std::numeric_limits<std::int8_t>::min())
+				Put(0xD0u), PutBigEndian(u, 1);
+			else if (x >= std::numeric_limits<std::int16_t>::min())
+				Put(0xD1u), PutBigEndian(u, 2);
+			else if (x >= std::numeric_limits<std::int32_t>::min())
+				Put(0xD2u), PutBigEndian(u, 4);
+			else
+				Put(0xD3u), PutBigEndian(u, 8);
+		}
+		break;
+	}
+}
+
+void CJsonWriter::String(std::string_view str) {
+	BeginValue();
+	PutString(str);
+}
+
+void CJsonWriter::Flush() {
+	if (!buf_.empty()) {
+		os_.write(buf_.data(), buf_.size());
+		buf_.clear();
+	}
+}
+
+void CJsonWriter::BeginValue() {
+	if (!stack_.empty()) {
+		auto &f = stack_.back();
+		if (f.object && !after_key_)
+			throw std::logic_error {"JSON object member written without a key"};
+		if (!f.remaining)
+			throw std::logic_error {"JSON container has more elements than declared"};
+		--f.remaining;
+	}
+	if (fmt_ == json_format_t::text && !after_key_ && !first_)
+		Put(',');
+	after_key_ = false;
+	first_ = false;
+}
+
+void CJsonWriter::EndContainer(bool object) {
+	if (stack_.empty() || stack_.back().object != object || after_key_)
+		throw std::logic_error {"Mismatched JSON container"};
+	if (stack_.back().remaining)
+		throw std::logic_error {"JSON container has fewer elements than declared"};
+	stack_.pop_back();
+	if (fmt_ == json_format_t::text)
+		Put(object ? '}' : ']');
+	first_ = false;
+}
+
+void CJsonWriter::Put(unsigned char c) {
+	buf_.push_back(static_cast<char>(c));
+	if (buf_.size() >= BUFFER_SIZE)
+		Flush();
+}
+
+void CJsonWriter::PutText(std::string_view str) {
+	buf_.insert(buf_.end(), str.begin(), str.end());
+	if (buf_.size() >= BUFFER_SIZE)
+		Flush();
+}
+
+void CJsonWriter::PutString(std::string_view str) {
+	switch (fmt_) {
+	case json_format_t::text: {
+		static constexpr char HEX[] = "0123456789abcdef";
+		Put('"');
+		for (char ch : str) {
+			auto c = static_cast<unsigned char>(ch);
+			switch (c) {
+			case '"':  PutText("\\\""); break;
+			case '\\': PutText("\\\\"); break;
+			case '\b': PutText("\\b"); break;
+			case '\f': PutText("\\f"); break;
+			case '\n': PutText("\\n"); break;
+			case '\r': PutText("\\r"); break;
+			case '\t': PutText("\\t"); break;
+			default:
+				if (c < 0x20u) {
+					PutText("\\u00");
+					Put(HEX[c >> 4]);
+					Put(HEX[c & 0x0Fu]);
+				}
+				else
+					Put(c);
+			}
+		}
+		Put('"');
+	} break;
+	case json_format_t::cbor:
+		PutCBORHeader(0x60u, str.size());
+		PutText(str);
+		break;
+	case json_format_t::msgpack:
+		if (str.size() > 0x1Fu && str.size() <= 0xFFu)
+			Put(0xD9u), PutBigEndian(str.size(), 1);
+		else
+			PutMsgPackHeader(str.size(), 0xA0u, 0x1Fu, 0xDAu);
+		PutText(str);
+		break;
+	}
+}
+
+void CJsonWriter::PutBigEndian(std::uint64_t x, unsigned bytes) {
+	while (bytes--)
+		Put(static_cast<unsigned char>(x >> (bytes * 8)));
+}
+
+void CJsonWriter::PutCBORHeader(unsigned char major, std::uint64_t n) {
+	if (n <= 0x17u)
+		Put(static_cast<unsigned char>(major | n));
+	else if (n <= 0xFFu)
+		Put(major | 0x18u), PutBigEndian(n, 1);
+	else if (n <= 0xFFFFu)
+		Put(major | 0x19u), PutBigEndian(n, 2);
+	else if (n <= 0xFFFFFFFFu)
+		Put(major | 0x1Au), PutBigEndian(n, 4);
+	else
+		Put(major | 0x1Bu), PutBigEndian(n, 8);
+}
+
+void CJsonWriter::PutMsgPackHeader(std::uint64_t n, unsigned char fix, std::uint64_t fixmax, unsigned char tag16) {
+	if (n <= fixmax)
+		Put(static_cast<unsigned char>(fix | n));
+	else if (n <= 0xFFFFu)
+		Put(tag16), PutBigEndian(n, 2);
+	else if (n <= 0xFFFFFFFFu)
+		Put(tag16 + 1), PutBigEndian(n, 4);
+	else
+		throw std::length_error {"MessagePack container is too large"};
+}
+
+
+
+CJsonReader::CJsonReader(std::istream &is, json_format_t fmt) : sb_(*is.rdbuf()), fmt_(fmt) {
+}
+
+CJsonReader::token_t CJsonReader::Next() {
+	str_.clear();
+	if (stack_.empty() && std::exchange(started_, true))
+		return tok_ = token_t::none;
+	return tok_ = fmt_ == json_format_t::text ? NextText() : NextBinary();
+}
+
+CJsonReader::token_t CJsonReader::GetToken() const noexcept {
+	return tok_;
+}
+
+void CJsonReader::Expect(token_t tok) const {
+	if (tok_ != tok)
+		Error("Unexpected token");
+}
+
+bool CJsonReader::GetBool() const {
+	Expect(token_t::boolean);
+	return bool_;
+}
+
+std::int64_t CJsonReader::GetInt() const {
+	Expect(token_t::integer);
+	return int_;
+}
+
+double CJsonReader::GetFloat() const {
+	if (tok_ == token_t::integer)
+		return static_cast<double>(int_);
+	Expect(token_t::floating);
+	return float_;
+}
+
+std::string_view CJsonReader::GetString() const {
+	if (tok_ != token_t::key)
+		Expect(token_t::string);
+	return str_;
+}
+
+void CJsonReader::Skip() {
+	std::size_t depth = 0;
+	while (true) {
+		switch (tok_) {
+		case token_t::none:
+			Error("Unexpected end of input");
+		case token_t::begin_array: case token_t::begin_object:
+			++depth;
+			break;
+		case token_t::end_array: case token_t::end_object:
+			if (!depth)
+				Error("Expected value");
+			--depth;
+			break;
+		case token_t::key:
+			if (!depth)
+				Error("Expected value");
+			break;
+		default:
+			break;
+		}
+		if (!depth)
+			return;
+		Next();
+	}
+}
+
+void CJsonReader::Error(std::string_view msg) const {
+	throw std::runtime_error {"JSON error at byte " + std::to_string(pos_) + ": " + std::string {msg}};
+}
+
+CJsonReader::token_t CJsonReader::NextText() {
+	if (stack_.empty())
+		return ReadTextValue(SkipSpace());
+
+	auto &f = stack_.back();
+	int c = SkipSpace();
+	if (f.object && !f.key_next) {
+		if (c != ':')
+			Error("Expected ':'");
+		f.key_next = true;
+		return ReadTextValue(SkipSpace());
+	}
+
+	if (c == (f.object ? '}' : ']')) {
+		bool object = f.object;
+		stack_.pop_back();
+		return object ? token_t::end_object : token_t::end_array;
+	}
+	if (!std::exchange(f.first, false)) {
+		if (c != ',')
+			Error("Expected ',' or end of container");
+		c = SkipSpace();
+	}
+	if (!f.object)
+		return ReadTextValue(c);
+
+	if (c != '"')
+		Error("Expected object key");
+	ReadTextString();
+	f.key_next = false;
+	return token_t::key;
+}
+
+CJsonReader::token_t CJsonReader::NextBinary() {
+	if (stack_.empty())
+		return fmt_ == json_format_t::cbor ? ReadCBORValue(Get()) : ReadMsgPackValue(Get());
+
+	auto &f = stack_.back();
+	const bool object = f.object;
+	const bool key = object && f.key_next;
+	if (f.indefinite ? Peek() == 0xFF : !f.remaining && (!object || key)) {
+		if (f.indefinite)
+			Get();
+		if (object && !key)
+			Error("Expected object value");
+		stack_.pop_back();
+		return object ? token_t::end_object : token_t::end_array;
+	}
+
+	if (!f.indefinite && (!object || key))
+		--f.remaining;
+	if (object)
+		f.key_next = !key;
+	auto tok = fmt_ == json_format_t::cbor ? ReadCBORValue(Get()) : ReadMsgPackValue(Get());
+	if (!key)
+		return tok;
+	if (tok != token_t::string)
+		Error("Expected object key");
+	return token_t::key;
+}
+
+CJsonReader::token_t CJsonReader::ReadTextValue(int c) {
+	switch (c) {
+	case '{':
+		return BeginContainer(true, false, 0);
+	case '[':
+		return BeginContainer(false, false, 0);
+	case '"':
+		ReadTextString();
+		return token_t::string;
+	case 't':
+		ReadLiteral("rue");
+		bool_ = true;
+		return token_t::boolean;
+	case 'f':
+		ReadLiteral("alse");
+		bool_ = false;
+		return token_t::boolean;
+	case 'n':
+		ReadLiteral("ull");
+		return token_t::null;
+	default:
+		if (c == '-' || (c >= '0' && c <= '9'))
+			return ReadTextNumber(c);
+	}
+	Error(c == EOF ? "Unexpected end of input" : "Unexpected character");
+}
+
+CJsonReader::token_t CJsonReader::ReadTextNumber(int c) {
+	bool integral = true;
+	str_.push_back(static_cast<char>(c));
+	while (true) {
+		c = Peek();
+		if (c == '.' || c == 'e' || c == 'E' || c == '+')
+			integral = false;
+		else if (c != '-' && !(c >= '0' && c <= '9'))
+			break;
+		str_.push_back(static_cast<char>(Get()));
+	}
+
+	const char *b = str_.data();
+	const char *e = b + str_.size();
+	if (integral) {
+		auto [end, ec] = std::from_chars(b, e, int_);
+		if (ec == std::errc { } && end == e)
+			return token_t::integer;
+	}
+	char *end = nullptr;
+	float_ = std::strtod(b, &end);
+	if (end != e)
+		Error("Invalid number");
+	return token_t::floating;
+}
+
+CJsonReader::token_t CJsonReader::ReadCBORValue(int c) {
+	if (c == EOF)
+		Error("Unexpected end of input");
+
+	int info = c & 0x1F;
+	switch (c >> 5) {
+	case 0: {
+		auto n = GetCBORArgument(info);
+		if (n > static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max()))
+			Error("Integer out of range");
+		int_ = static_cast<std::int64_t>(n);
+		return token_t::integer;
+	}
+	case 1: {
+		auto n = GetCBORArgument(info);
+		if (n > static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max()))
+			Error("Integer out of range");
+		int_ = -1 - static_cast<std::int64_t>(n);
+		return token_t::integer;
+	}
+	case 2:
+		Error("Byte strings are not supported");
+	case 3:
+		if (info == 0x1F) {
+			while ((c = Get()) != 0xFF) {
+				if ((c >> 5) != 3 || (c & 0x1F) == 0x1F)
+					Error("Invalid string chunk");
+				ReadBytes(GetCBORArgument(c & 0x1F));
+			}
+		}
+		else
+			ReadBytes(GetCBORArgument(info));
+		return token_t::string;
+	case 4:
+		return info == 0x1F ? BeginContainer(false, true, 0) : BeginContainer(false, false, GetCBORArgument(info));
+	case 5:
+		return info == 0x1F ? BeginContainer(true, true, 0) : BeginContainer(true, false, GetCBORArgument(info));
+	case 6: // tags are ignored
+		GetCBORArgument(info);
+		return ReadCBORValue(Get());
+	}
+
+	switch (info) {
+	case 20: case 21:
+		bool_ = info == 21;
+		return token_t::boolean;
+	case 22: case 23:
+		return token_t::null;
+	case 25: {
+		auto half = static_cast<unsigned>(GetBigEndian(2));
+		int exp = (half >> 10) & 0x1F;
+		int mant = half & 0x3FF;
+		double x = exp == 0 ? std::ldexp(mant, -24) :
+			exp != 0x1F ? std::ldexp(mant + 0x400, exp - 25) :
+			mant == 0 ? std::numeric_limits<double>::infinity() : std::numeric_limits<double>::quiet_NaN();
+		float_ = (half & 0x8000u) ? -x : x;
+		return token_t::floating;
+	}
+	case 26: {
+		auto bits = static_cast<std::uint32_t>(GetBigEndian(4));
+		float x;
+		std::memcpy(&x, &bits, sizeof(x));
+		float_ = x;
+		return token_t::floating;
+	}
+	case 27: {
+		auto bits = GetBigEndian(8);
+		std::memcpy(&float_, &bits, sizeof(float_));
+		return token_t::floating;
+	}
+	}
+	Error("Unsupported CBOR value");
+}
+
+CJsonReader::token_t CJsonReader::ReadMsgPackValue(int c) {
+	if (c == EOF)
+		Error("Unexpected end of input");
+
+	if (c <= 0x7F || c >= 0xE0) {
+		int_ = c <= 0x7F ? c : c - 0x100;
+		return token_t::integer;
+	}
+	if (c <= 0x8F)
+		return BeginContainer(true, false, c & 0x0F);
+	if (c <= 0x9F)
+		return BeginContainer(false, false, c & 0x0F);
+	if (c <= 0xBF) {
+		ReadBytes(c & 0x1F);
+		return token_t::string;
+	}
+
+	switch (c) {
+	case 0xC0:
+		return token_t::null;
+	case 0xC2: case 0xC3:
+		bool_ = c == 0xC3;
+		return token_t::boolean;
+	case 0xCA: {
+		auto bits = static_cast<std::uint32_t>(GetBigEndian(4));
+		float x;
+		std::memcpy(&x, &bits, sizeof(x));
+		float_ = x;
+		return token_t::floating;
+	}
+	case 0xCB: {
+		auto bits = GetBigEndian(8);
+		std::memcpy(&float_, &bits, sizeof(float_));
+		return token_t::floating;
+	}
+	case 0xCC: case 0xCD: case 0xCE: case 0xCF: {
+		auto n = GetBigEndian(1u << (c - 0xCC));
+		if (n > static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max()))
+			Error("Integer out of range");
+		int_ = static_cast<std::int64_t>(n);
+		return token_t::integer;
+	}
+	case 0xD0: int_ = static_cast<std::int8_t>(GetBigEndian(1)); return token_t::integer;
+	case 0xD1: int_ = static_cast<std::int16_t>(GetBigEndian(2)); return token_t::integer;
+	case 0xD2: int_ = static_cast<std::int32_t>(GetBigEndian(4)); return token_t::integer;
+	case 0xD3: int_ = static_cast<std::int64_t>(GetBigEndian(8)); return token_t::integer;
+	case 0xD9: case 0xDA: case 0xDB:
+		ReadBytes(GetBigEndian(1u << (c - 0xD9)));
+		return token_t::string;
+	case 0xDC: case 0xDD:
+		return BeginContainer(false, false, GetBigEndian(c == 0xDC ? 2 : 4));
+	case 0xDE: case 0xDF:
+		return BeginContainer(true, false, GetBigEndian(c == 0xDE ? 2 : 4));
+	}
+	Error("Unsupported MessagePack value");
+}
+
+CJsonReader::token_t CJsonReader::BeginContainer(bool object, bool indefinite, std::uint64_t n) {
+	stack_.push_back({object, true, true, indefinite, n});
+	return object ? token_t::begin_object : token_t::begin_array;
+}
+
+int CJsonReader::Get() {
+	int c = sb_.sbumpc();
+	if (c != EOF)
+		++pos_;
+	return c;
+}
+
+int CJsonReader::Peek() {
+	return sb_.sgetc();
+}
+
+int CJsonReader::SkipSpace() {
+	int c;
+	do
+		c = Get();
+	while (c == ' ' || c == '\t' || c == '\n' || c == '\r');
+	return c;
+}
+
+std::uint64_t CJsonReader::GetBigEndian(unsigned bytes) {
+	std::uint64_t x = 0;
+	while (bytes--) {
+		int c = Get();
+		if (c == EOF)
+			Error("Unexpected end of input");
+		x = (x << 8) | static_cast<unsigned>(c);
+	}
+	return x;
+}
+
+std::uint64_t CJsonReader::GetCBORArgument(int info) {
+	if (info < 24)
+		return info;
+	if (info < 28)
+		return GetBigEndian(1u << (info - 24));
+	Error("Invalid CBOR argument");
+}
+
+void CJsonReader::ReadBytes(std::uint64_t n) {
+	// read in chunks so that a corrupt length fails at the end of input instead of allocating
+	while (n) {
+		auto chunk = static_cast<std::size_t>(std::min<std::uint64_t>(n, BUFFER_SIZE));
+		auto oldsize = str_.size();
+		str_.resize(oldsize + chunk);
+		auto count = static_cast<std::size_t>(sb_.sgetn(str_.data() + oldsize, chunk));
+		pos_ += count;
+		if (count != chunk)
+			Error("Unexpected end of input");
+		n -= chunk;
+	}
+}
+
+std::uint32_t CJsonReader::ReadHexEscape() {
+	std::uint32_t cp = 0;
+	for (int i = 0; i < 4; ++i) {
+		int c = Get();
+		cp <<= 4;
+		if (c >= '0' && c <= '9')
+			cp |= c - '0';
+		else if (c >= 'A' && c <= 'F')
+			cp |= c - 'A' + 10;
+		else if (c >= 'a' && c <= 'f')
+			cp |= c - 'a' + 10;
+		else
+			Error("Invalid unicode escape");
+	}
+	return cp;
+}
+
+void CJsonReader::ReadTextString() {
+	while (true) {
+		int c = Get();
+		switch (c) {
+		case '"':
+			return;
+		case EOF:
+			Error("Unexpected end of input");
+		case '\\':
+			switch (c = Get()) {
+			case '"': case '\\': case '/': str_.push_back(static_cast<char>(c)); break;
+			case 'b': str_.push_back('\b'); break;
+			case 'f': str_.push_back('\f'); break;
+			case 'n': str_.push_back('\n'); break;
+			case 'r': str_.push_back('\r'); break;
+			case 't': str_.push_back('\t'); break;
+			case 'u': {
+				std::uint32_t cp = ReadHexEscape();
+				if (cp >= 0xD800u && cp <= 0xDBFFu) {
+					if (Get() != '\\' || Get() != 'u')
+						Error("Unpaired surrogate");
+					std::uint32_t lo = ReadHexEscape();
+					if (lo < 0xDC00u || lo > 0xDFFFu)
+						Error("Unpaired surrogate");
+					cp = 0x10000u + ((cp - 0xD800u) << 10) + (lo - 0xDC00u);
+				}
+				else if (cp >= 0xDC00u && cp <= 0xDFFFu)
+					Error("Unpaired surrogate");
+				PutUTF8(cp);
+			} break;
+			default:
+				Error("Invalid escape sequence");
+			}
+			break;
+		default:
+			if (c < 0x20)
+				Error("Control character in string");
+			str_.push_back(static_cast<char>(c));
+		}
+	}
+}
+
+void CJsonReader::ReadLiteral(std::string_view rest) {
+	for (char c : rest)
+		if (Get() != c)
+			Error("Invalid literal");
+}
+
+void CJsonReader::PutUTF8(std::uint32_t cp) {
+	if (cp < 0x80u)
+		str_.push_back(static_cast<char>(cp));
+	else if (cp < 0x800u) {
+		str_.push_back(static_cast<char>(0xC0u | (cp >> 6)));
+		str_.push_back(static_cast<char>(0x80u | (cp & 0x3Fu)));
+	}
+	else if (cp < 0x10000u) {
+		str_.push_back(static_cast<char>(0xE0u | (cp >> 12)));
+		str_.push_back(static_cast<char>(0x80u | ((cp >> 6) & 0x3Fu)));
+		str_.push_back(static_cast<char>(0x80u | (cp & 0x3Fu)));
+	}
+	else {
+		str_.push_back(static_cast<char>(0xF0u | (cp >> 18)));
+		str_.push_back(static_cast<char>(0x80u | ((cp >> 12) & 0x3Fu)));
+		str_.push_back(static_cast<char>(0x80u | ((cp >> 6) & 0x3Fu)));
+		str_.push_back(static_cast<char>(0x80u | (cp & 0x3Fu)));
+	}
+}
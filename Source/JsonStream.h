@@ -0,0 +1,156 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+#pragma once
+
+#include <iosfwd>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// // // streaming access to the JSON module schema, without building a DOM
+
+enum class json_format_t : unsigned char {
+	text,
+	cbor,
+	msgpack,
+};
+
+// Writes JSON values directly to a stream. Container sizes are given in advance since
+// both binary formats store them in the container header; in text mode they are only
+// checked.
+class CJsonWriter {
+public:
+	CJsonWriter(std::ostream &os, json_format_t fmt);
+	~CJsonWriter() noexcept;
+
+	void BeginObject(std::size_t n);
+	void EndObject();
+	void BeginArray(std::size_t n);
+	void EndArray();
+	void Key(std::string_view key);
+
+	void Null();
+	void Bool(bool x);
+	void Int(std::int64_t x);
+	void String(std::string_view str);
+
+	void Flush();
+
+private:
+	void BeginValue();
+	void EndContainer(bool object);
+	void Put(unsigned char c);
+	void PutText(std::string_view str);
+	void PutString(std::string_view str);
+	void PutBigEndian(std::uint64_t x, unsigned bytes);
+	void PutCBORHeader(unsigned char major, std::uint64_t n);
+	void PutMsgPackHeader(std::uint64_t n, unsigned char fix, std::uint64_t fixmax, unsigned char tag16);
+
+	struct frame_t {
+		bool object;
+		std::size_t remaining;
+	};
+
+	std::ostream &os_;
+	json_format_t fmt_;
+	std::vector<char> buf_;
+	std::vector<frame_t> stack_;
+	bool first_ = true;
+	bool after_key_ = false;
+};
+
+// Pull parser over the same three formats. Next() reads one token at a time; values are
+// only valid until the following call.
+class CJsonReader {
+public:
+	enum class token_t : unsigned char {
+		none,
+		null,
+		boolean,
+		integer,
+		floating,
+		string,
+		key,
+		begin_array,
+		end_array,
+		begin_object,
+		end_object,
+	};
+
+	CJsonReader(std::istream &is, json_format_t fmt);
+
+	token_t Next();
+	token_t GetToken() const noexcept;
+
+	void Expect(token_t tok) const;
+	bool GetBool() const;
+	std::int64_t GetInt() const;
+	double GetFloat() const;
+	std::string_view GetString() const;
+
+	// Skips the value starting at the current token.
+	void Skip();
+
+	[[noreturn]] void Error(std::string_view msg) const;
+
+private:
+	struct frame_t {
+		bool object;
+		bool key_next;
+		bool first;
+		bool indefinite;
+		std::uint64_t remaining;
+	};
+
+	token_t NextText();
+	token_t NextBinary();
+	token_t ReadTextValue(int c);
+	token_t ReadTextNumber(int c);
+	token_t ReadCBORValue(int c);
+	token_t ReadMsgPackValue(int c);
+	token_t BeginContainer(bool object, bool indefinite, std::uint64_t n);
+
+	int Get();
+	int Peek();
+	int SkipSpace();
+	std::uint64_t GetBigEndian(unsigned bytes);
+	std::uint64_t GetCBORArgument(int info);
+	void ReadBytes(std::uint64_t n);
+	std::uint32_t ReadHexEscape();
+	void ReadTextString();
+	void ReadLiteral(std::string_view rest);
+	void PutUTF8(std::uint32_t cp);
+
+	std::streambuf &sb_;
+	json_format_t fmt_;
+	std::vector<frame_t> stack_;
+	token_t tok_ = token_t::none;
+	bool bool_ = false;
+	std::int64_t int_ = 0;
+	double float_ = 0.;
+	std::string str_;
+	std::size_t pos_ = 0;
+	bool started_ = false;
+};
@@ -58,8 +58,8 @@ CMIDI::CMIDI() :
 	m_bInStarted(false),
 	m_iInDevice(0),
 	m_iOutDevice(0),
-	m_iQueueHead(0),
-	m_iQueueTail(0),
+	m_EventRing(MAX_QUEUE),		// // //
+	m_iQuant(0),
 	m_hMIDIIn(NULL),
 	m_hMIDIOut(NULL),
 	m_iTimingCounter(0)
@@ -143,9 +143,7 @@ bool CMIDI::OpenDevices(void)
 		midiOutReset(m_hMIDIOut);
 	}
 
-	m_csQueue.Lock();
-	m_iQueueHead = m_iQueueTail = 0;
-	m_csQueue.Unlock();
+	m_EventRing.clear();		// // //
 
 	return true;
 }
@@ -213,17 +211,15 @@ void CMIDI::SetOutputDevice(int Device)
 
 void CMIDI::Enqueue(unsigned char MsgType, unsigned char MsgChannel, unsigned char Data1, unsigned char Data2)
 {
-	m_csQueue.Lock();
-
-	m_iMsgTypeQueue[m_iQueueHead] = MsgType;
-	m_iMsgChanQueue[m_iQueueHead] = MsgChannel;
-	m_iData1Queue[m_iQueueHead]   = Data1;
-	m_iData2Queue[m_iQueueHead]   = Data2;
-	m_iQuantization[m_iQueueHead] = m_iTimingCounter;
-
-	m_iQueueHead = (m_iQueueHead + 1) % MAX_QUEUE;
-
-	m_csQueue.Unlock();
+	// // // the input callback is the only producer, messages are dropped if the view falls behind
+	stMidiEvent Msg;
+	Msg.Message = MsgType;
+	Msg.Channel = MsgChannel;
+	Msg.Data1 = Data1;
+	Msg.Data2 = Data2;
+	Msg.Quantization = static_cast<unsigned char>(m_iTimingCounter);
+	Msg.Time = std::chrono::steady_clock::now();		// dwParam2 is only accurate to a millisecond
+	m_EventRing.push(Msg);
 }
 
 void CMIDI::Event(unsigned char Status, unsigned char Data1, unsigned char Data2)
@@ -265,27 +261,12 @@ void CMIDI::Event(unsigned char Status, unsigned char Data1, unsigned char Data2
 	}
 }
 
-bool CMIDI::ReadMessage(unsigned char & Message, unsigned char & Channel, unsigned char & Data1, unsigned char & Data2)
+bool CMIDI::ReadMessage(stMidiEvent &Msg)		// // //
 {
-	bool Result = false;
-
-	m_csQueue.Lock();
-
-	if (m_iQueueHead != m_iQueueTail) {
-		Result = true;
-
-		Message = m_iMsgTypeQueue[m_iQueueTail];
-		Channel = m_iMsgChanQueue[m_iQueueTail];
-		Data1	= m_iData1Queue[m_iQueueTail];
-		Data2	= m_iData2Queue[m_iQueueTail];
-		m_iQuant = m_iQuantization[m_iQueueTail];
-
-		m_iQueueTail = (m_iQueueTail + 1) % MAX_QUEUE;
-	}
-
-	m_csQueue.Unlock();
-
-	return Result;
+	if (!m_EventRing.pop(Msg))
+		return false;
+	m_iQuant = Msg.Quantization;
+	return true;
 }
 
 int CMIDI::GetQuantization() const
@@ -26,6 +26,8 @@
 #include "stdafx.h"		// // //
 #include <mmsystem.h>
 #include <cstdint>
+#include <chrono>		// // //
+#include "spsc_ring.h"		// // //
 
 const int MIDI_MSG_NOTE_OFF			= 0x08;
 const int MIDI_MSG_NOTE_ON			= 0x09;
@@ -39,6 +41,16 @@ namespace ft0cc::doc {		// // //
 enum class pitch : std::uint8_t;
 } // namespace ft0cc::doc
 
+// // // A MIDI input message, stamped with the time it was received
+struct stMidiEvent {
+	unsigned char Message = 0;
+	unsigned char Channel = 0;
+	unsigned char Data1 = 0;
+	unsigned char Data2 = 0;
+	unsigned char Quantization = 0;
+	std::chrono::steady_clock::time_point Time;
+};
+
 // CMIDI command target
 
 class CMIDI {
@@ -54,7 +66,7 @@ public:
 	bool	OpenDevices();
 	bool	CloseDevices();
 
-	bool	ReadMessage(unsigned char &Message, unsigned char &Channel, unsigned char &Data1, unsigned char &Data2);
+	bool	ReadMessage(stMidiEvent &Msg);		// // //
 	void	WriteNote(unsigned char Channel, ft0cc::doc::pitch Note, unsigned char Octave, unsigned char Velocity);		// // //
 	void	ResetOutput();
 	void	ToggleInput();
@@ -100,15 +112,8 @@ private:
 	bool	m_bMasterSync;
 	bool	m_bInStarted;
 
-	// MIDI queue
-	int		m_iQueueHead;
-	int		m_iQueueTail;
-
-	char	m_iMsgTypeQueue[MAX_QUEUE];
-	char	m_iMsgChanQueue[MAX_QUEUE];
-	char	m_iData1Queue[MAX_QUEUE];
-	char	m_iData2Queue[MAX_QUEUE];
-	char	m_iQuantization[MAX_QUEUE];
+	// // // MIDI queue, filled by the input callback and drained by the view
+	spsc_ring<stMidiEvent> m_EventRing;
 
 	int		m_iQuant;
 	int		m_iTimingCounter;
@@ -116,7 +121,4 @@ private:
 	// Device handles
 	HMIDIIN	 m_hMIDIIn;
 	HMIDIOUT m_hMIDIOut;
-
-	// Thread sync
-	CCriticalSection m_csQueue;
 };
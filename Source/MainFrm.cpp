@@ -428,9 +428,7 @@ int CMainFrame::OnCreate(LPCREATESTRUCT lpCreateStruct)
 	SetTimer((UINT_PTR)timer_id_t::AUDIO_CHECK, 500, NULL);
 
 	// Auto save
-#ifdef AUTOSAVE
 	SetTimer((UINT_PTR)timer_id_t::AUTOSAVE, 1000, NULL);
-#endif
 
 	m_wndOctaveBar.CheckDlgButton(IDC_FOLLOW, FTEnv.GetSettings()->bFollowMode);
 	m_wndOctaveBar.CheckDlgButton(IDC_CHECK_COMPACT, false);		// // //
@@ -1277,6 +1275,29 @@ bool CMainFrame::LoadInstrument(unsigned Index, const CStringW &filename) {		//
 	return err(IDS_INST_LIMIT);
 }
 
+bool CMainFrame::LoadLibraryInstrument(unsigned Index, const fs::path &filename) {		// // //
+	if (Index == INVALID_INSTRUMENT) {
+		AfxMessageBox(IDS_INST_LIMIT, MB_ICONERROR);
+		return false;
+	}
+
+	// the file is only parsed again if it has changed
+	const auto err_lv = FTEnv.GetSettings()->Version.iErrorLevel;
+	try {
+		auto pSource = m_pInstrumentFileTree->GetLibrary().GetInstrument(filename, err_lv);
+		return GetDoc().Locked([&] {
+			auto *pManager = GetDoc().GetModule()->GetInstrumentManager();
+			return pManager->InsertInstrument(Index, CInstrumentLibrary::Instantiate(*pSource, *pManager));
+		});
+	}
+	catch (CModuleException &e) {
+		if (err_lv > MODULE_ERROR_DEFAULT)
+			e.AppendFooter("\n\nTry lowering the module error level in the configuration menu.");
+		AfxMessageBox(conv::to_wide(e.GetErrorString()).data(), MB_ICONERROR);
+		return false;
+	}
+}
+
 std::shared_ptr<CInstrument> CMainFrame::GetSelectedInstrument() const {		// // //
 	int index = GetSelectedInstrumentIndex();
 	return index != INVALID_INSTRUMENT ? GetDoc().GetModule()->GetInstrumentManager()->GetInstrument(index) : nullptr;
@@ -1708,17 +1729,11 @@ void CMainFrame::OnTimer(UINT_PTR nIDEvent) {		// // //
 		case timer_id_t::AUDIO_CHECK:
 			CheckAudioStatus();
 			break;
-#ifdef AUTOSAVE
 		// Auto save
-		case timer_id_t::AUTOSAVE: {
-			/*
-				CFamiTrackerDoc *pDoc = dynamic_cast<CFamiTrackerDoc*>(GetActiveDocument());
-				if (pDoc != NULL)
-					pDoc->AutoSave();
-					*/
-			}
+		case timer_id_t::AUTOSAVE:
+			if (auto *pDoc = dynamic_cast<CFamiTrackerDoc *>(GetActiveDocument()))		// // //
+				pDoc->AutoSave();
 			break;
-#endif
 	}
 
 	CFrameWnd::OnTimer(nIDEvent);
@@ -1988,8 +2003,8 @@ void CMainFrame::OnFileExportText()
 	auto initPath = FTEnv.GetSettings()->GetPath(PATH_NSF);		// // //
 	if (auto path = GetSavePath(Doc.GetFileTitle(), initPath.c_str(), IDS_FILTER_TXT, L"*.txt")) {
 		CTextExport Exporter;
-		CStringA sResult = Exporter.ExportFile(*path, Doc);
-		if (!sResult.IsEmpty())
+		std::string sResult = Exporter.ExportFile(*path, Doc);		// // //
+		if (!sResult.empty())
 			AfxMessageBox(conv::to_wide(sResult).data(), MB_OK | MB_ICONERROR);
 		Doc.UpdateAllViews(NULL, UPDATE_PROPERTIES);
 	}
@@ -2007,8 +2022,8 @@ void CMainFrame::OnFileExportRows()		// // //
 	auto initPath = FTEnv.GetSettings()->GetPath(PATH_NSF);		// // //
 	if (auto path = GetSavePath(Doc.GetFileTitle(), initPath.c_str(), IDS_FILTER_CSV, L"*.csv")) {
 		CTextExport Exporter;
-		CStringA sResult = Exporter.ExportRows(*path, *Doc.GetModule());
-		if (!sResult.IsEmpty())
+		std::string sResult = Exporter.ExportRows(*path, *Doc.GetModule());		// // //
+		if (!sResult.empty())
 			AfxMessageBox(conv::to_wide(sResult).data(), MB_OK | MB_ICONERROR);
 	}
 }
@@ -2170,24 +2185,22 @@ void CMainFrame::OnModuleEstimateSongLength()		// // //
 	CSongLengthScanner scanner {*GetDoc().GetModule(), *GetTrackerView()->GetSongView()};
 	auto [Intro, Loop] = scanner.GetSecondsCount();
 	auto [IntroRows, LoopRows] = scanner.GetRowCount();
-
-	int Rate = GetDoc().GetModule()->GetFrameRate();
+	auto [IntroTicks, LoopTicks] = scanner.GetTickCount();		// // //
 
 	const LPCWSTR fmt = L"Estimated duration:\n"
 		L"Intro: %lld:%02lld.%02lld (%d rows, %lld ticks)\n"
-		L"Loop: %lld:%02lld.%02lld (%d rows, %lld ticks)\n"
-		L"Tick counts are subject to rounding errors!";
+		L"Loop: %lld:%02lld.%02lld (%d rows, %lld ticks)";
 	AfxMessageBox(FormattedW(fmt,
 		static_cast<long long>(Intro + .5 / 6000) / 60,
 		static_cast<long long>(Intro + .005) % 60,
 		static_cast<long long>(Intro * 100 + .5) % 100,
 		IntroRows,
-		static_cast<long long>(Intro * Rate + .5),
+		static_cast<long long>(IntroTicks),
 		static_cast<long long>(Loop + .5 / 6000) / 60,
 		static_cast<long long>(Loop + .005) % 60,
 		static_cast<long long>(Loop * 100 + .5) % 100,
 		LoopRows,
-		static_cast<long long>(Loop * Rate + .5)));
+		static_cast<long long>(LoopTicks)));
 }
 
 void CMainFrame::UpdateTrackBox()
@@ -2627,7 +2640,7 @@ void CMainFrame::OnLoadInstrumentMenu(NMHDR * pNotifyStruct, LRESULT * result)
 		if (retValue >= CInstrumentFileTree::MENU_BASE + 2) { // A file
 			auto &Im = *GetDoc().GetModule()->GetInstrumentManager();		// // //
 			int Index = Im.GetFirstUnused();
-			if (!LoadInstrument(Index, m_pInstrumentFileTree->GetFile(retValue)))
+			if (!LoadLibraryInstrument(Index, m_pInstrumentFileTree->GetFile(retValue)))		// // //
 				return;
 			SelectInstrument(Index);
 			UpdateInstrumentList();
@@ -33,6 +33,7 @@
 #include "ControlPanelDlg.h"
 #include <memory>		// // //
 #include <tuple>		// // //
+#include "ft0cc/fs.h"		// // //
 
 enum {
 	WM_USER_DISPLAY_MESSAGE_STRING = WM_USER,
@@ -166,6 +167,7 @@ private:
 	void	ClearInstrumentList();
 	void	SetInstrumentEditName(std::wstring_view pText);		// // //
 	bool	LoadInstrument(unsigned Index, const CStringW &filename);		// // //
+	bool	LoadLibraryInstrument(unsigned Index, const fs::path &filename);		// // //
 	std::shared_ptr<CInstrument> GetSelectedInstrument() const;		// // //
 
 	void	SetFrameEditorPosition(frame_edit_pos_t Position);		// // //
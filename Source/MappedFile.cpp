@@ -0,0 +1,105 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+#include "MappedFile.h"
+#include <stdexcept>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+CMappedFile::CMappedFile(const fs::path &fname) {
+#ifdef _WIN32
+	file_ = ::CreateFileW(fname.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file_ == INVALID_HANDLE_VALUE) {
+		file_ = nullptr;
+		throw std::runtime_error {"Unable to open file:\n" + fname.u8string()};
+	}
+
+	LARGE_INTEGER sz = { };
+	if (!::GetFileSizeEx(file_, &sz)) {
+		::CloseHandle(file_);
+		throw std::runtime_error {"Unable to read file:\n" + fname.u8string()};
+	}
+	size_ = static_cast<std::size_t>(sz.QuadPart);
+	if (size_ == 0)		// empty files cannot be mapped
+		return;
+
+	mapping_ = ::CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping_)
+		data_ = static_cast<const char *>(::MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+	if (!data_) {
+		if (mapping_)
+			::CloseHandle(mapping_);
+		::CloseHandle(file_);
+		throw std::runtime_error {"Unable to read file:\n" + fname.u8string()};
+	}
+#else
+	int fd = ::open(fname.c_str(), O_RDONLY);
+	if (fd == -1)
+		throw std::runtime_error {"Unable to open file:\n" + fname.u8string()};
+
+	struct stat st = { };
+	if (::fstat(fd, &st) == -1) {
+		::close(fd);
+		throw std::runtime_error {"Unable to read file:\n" + fname.u8string()};
+	}
+	size_ = static_cast<std::size_t>(st.st_size);
+	if (size_ > 0) {
+		void *p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (p == MAP_FAILED) {
+			::close(fd);
+			throw std::runtime_error {"Unable to read file:\n" + fname.u8string()};
+		}
+		::madvise(p, size_, MADV_SEQUENTIAL);
+		data_ = static_cast<const char *>(p);
+	}
+	::close(fd);		// the mapping stays valid
+#endif
+}
+
+CMappedFile::~CMappedFile() noexcept {
+#ifdef _WIN32
+	if (data_)
+		::UnmapViewOfFile(data_);
+	if (mapping_)
+		::CloseHandle(mapping_);
+	if (file_)
+		::CloseHandle(file_);
+#else
+	if (data_)
+		::munmap(const_cast<char *>(data_), size_);
+#endif
+}
+
+std::string_view CMappedFile::GetText() const noexcept {
+	return {data_, size_};
+}
+
+std::size_t CMappedFile::GetSize() const noexcept {
+	return size_;
+}
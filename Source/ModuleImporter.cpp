@@ -29,12 +29,19 @@
 #include "DSampleManager.h"
 #include "Sequence.h"
 #include "SongData.h"
+#include "ModuleMerger.h"		// // //
 #include "ft0cc/doc/groove.hpp"
 
 CModuleImporter::CModuleImporter(CFamiTrackerModule &modfile, CFamiTrackerModule &imported,
 	import_mode_t instMode, import_mode_t grooveMode) :
 	modfile_(modfile), imported_(imported), inst_mode_(instMode), groove_mode_(grooveMode)
 {
+	if (inst_mode_ == import_mode_t::merge_identical) {		// // //
+		merger_ = std::make_unique<CModuleMerger>(modfile_);
+		merger_->AddModule(imported_);
+		return;
+	}
+
 	auto *pInst = modfile_.GetInstrumentManager();
 	auto *pImportedInst = imported_.GetInstrumentManager();
 	unsigned ii = 0;
@@ -82,7 +89,24 @@ CModuleImporter::CModuleImporter(CFamiTrackerModule &modfile, CFamiTrackerModule
 			}
 }
 
+CModuleImporter::~CModuleImporter() = default;		// // //
+
 bool CModuleImporter::Validate() const {
+	if (merger_) {		// // //
+		const stMergeReport &report = merger_->Plan();
+		if (report.Songs > MAX_TRACKS)
+			AfxMessageBox(IDS_IMPORT_FAILED, MB_ICONEXCLAMATION);
+		else if (report.Instruments > MAX_INSTRUMENTS)
+			AfxMessageBox(IDS_IMPORT_INSTRUMENT_COUNT, MB_ICONERROR);
+		else if (report.Sequences > MAX_SEQUENCES)
+			AfxMessageBox(IDS_IMPORT_SEQUENCE_COUNT, MB_ICONERROR);
+		else if (report.Samples > MAX_DSAMPLES || report.SampleSize > MAX_SAMPLE_SPACE)
+			AfxMessageBox(IDS_IMPORT_SAMPLE_SLOTS, MB_ICONEXCLAMATION);
+		else if (report.Grooves > MAX_GROOVE)
+			AfxMessageBox(IDS_IMPORT_GROOVE_SLOTS, MB_ICONEXCLAMATION);
+		return report.Fits();
+	}
+
 	if (modfile_.GetSongCount() + imported_.GetSongCount() > MAX_TRACKS) {
 		AfxMessageBox(IDS_IMPORT_FAILED, MB_ICONEXCLAMATION);
 		return false;
@@ -131,6 +155,12 @@ bool CModuleImporter::Validate() const {
 }
 
 void CModuleImporter::DoImport(bool doDetune) {
+	if (merger_) {		// // //
+		if (merger_->Merge() && doDetune)
+			ImportDetune();
+		return;
+	}
+
 	ImportInstruments();
 	ImportGrooves();
 	if (doDetune)
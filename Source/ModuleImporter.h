@@ -29,16 +29,19 @@
 #include "ft0cc/enum_traits.h"
 
 class CFamiTrackerModule;
+class CModuleMerger;		// // //
 
 ENUM_CLASS_STANDARD(import_mode_t, std::uint8_t) {
 	none, duplicate_all, overwrite_all, import_missing,
-	min = duplicate_all, max = import_missing,
+	merge_identical,		// // // instrument mode only, shares identical resources through CModuleMerger
+	min = duplicate_all, max = merge_identical,
 };
 
 class CModuleImporter {
 public:
 	CModuleImporter(CFamiTrackerModule &modfile, CFamiTrackerModule &imported,
 		import_mode_t instMode, import_mode_t grooveMode);
+	~CModuleImporter();		// // //
 
 	bool Validate() const;
 	void DoImport(bool doDetune);
@@ -58,4 +61,6 @@ private:
 
 	import_mode_t inst_mode_ = import_mode_t::none;
 	import_mode_t groove_mode_ = import_mode_t::none;
+
+	std::unique_ptr<CModuleMerger> merger_;		// // // also imports the grooves and songs
 };
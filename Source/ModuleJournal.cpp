@@ -0,0 +1,299 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+#include "ModuleJournal.h"
+#include "FamiTrackerModule.h"
+#include "FamiTrackerDocIO.h"
+#include "DocumentFile.h"
+#include "SimpleFile.h"
+#include "AtomicFile.h"
+#include <array>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+// // // Journal layout:
+//
+// - JOURNAL_HEADER_ID followed by JOURNAL_VER;
+// - any number of records that use the document block layout (16-byte ID,
+//   version, size, data), where a record of size 0 removes the block;
+// - each commit is terminated by a COMMIT_ID record whose version tells whether
+//   it is a snapshot, and whose data is a checksum of the commit's records.
+//
+// Commits not followed by a valid terminator are torn writes and are ignored.
+
+namespace {
+
+constexpr std::string_view JOURNAL_HEADER_ID = {"LLTracker Journ\0", 16};
+constexpr std::uint32_t JOURNAL_VER = 1;
+constexpr std::string_view COMMIT_ID = "COMMIT";
+constexpr int COMMIT_DELTA = 0;
+constexpr int COMMIT_SNAPSHOT = 1;
+
+constexpr std::size_t RECORD_HEADER_SIZE = CDocumentFile::BLOCK_HEADER_SIZE + sizeof(int) * 2;
+constexpr std::size_t PATTERN_ENTRY_HEADER_SIZE = sizeof(int) * 4;
+
+// compact the journal once it grows this many times larger than its snapshot
+constexpr std::size_t COMPACT_RATIO = 4;
+constexpr unsigned MAX_COMMITS = 256;
+
+std::uint32_t Checksum(const unsigned char *Data, std::size_t Size) {
+	// FNV-1a
+	std::uint32_t h = 2166136261u;
+	for (std::size_t i = 0; i < Size; ++i)
+		h = (h ^ Data[i]) * 16777619u;
+	return h;
+}
+
+int ReadInt(const unsigned char *Data) {
+	int x;
+	std::memcpy(&x, Data, sizeof(x));
+	return x;
+}
+
+void AppendInt(std::vector<unsigned char> &Data, int x) {
+	unsigned char Buf[sizeof(x)];
+	std::memcpy(Buf, &x, sizeof(x));
+	Data.insert(Data.end(), std::begin(Buf), std::end(Buf));
+}
+
+void AppendRecord(std::vector<unsigned char> &Data, std::string_view ID, int Version, array_view<unsigned char> Body) {
+	std::array<char, CDocumentFile::BLOCK_HEADER_SIZE> Name = { };
+	ID.copy(Name.data(), std::min(ID.size(), Name.size() - 1));
+	Data.insert(Data.end(), Name.begin(), Name.end());
+	AppendInt(Data, Version);
+	AppendInt(Data, static_cast<int>(Body.size()));
+	Data.insert(Data.end(), Body.begin(), Body.end());
+}
+
+// a single record of a document image or a journal
+struct record_t {
+	std::string_view ID;
+	int Version;
+	array_view<unsigned char> Body;
+	std::size_t Next;		// offset of the following record
+};
+
+std::optional<record_t> ParseRecord(array_view<unsigned char> Data, std::size_t Pos) {
+	if (Data.size() < RECORD_HEADER_SIZE || Pos > Data.size() - RECORD_HEADER_SIZE)
+		return std::nullopt;
+	const char *Name = reinterpret_cast<const char *>(Data.data() + Pos);
+	std::string_view ID {Name, static_cast<std::size_t>(std::find(Name, Name + CDocumentFile::BLOCK_HEADER_SIZE, '\0') - Name)};
+	int Version = ReadInt(Data.data() + Pos + CDocumentFile::BLOCK_HEADER_SIZE);
+	int Size = ReadInt(Data.data() + Pos + CDocumentFile::BLOCK_HEADER_SIZE + sizeof(int));
+	Pos += RECORD_HEADER_SIZE;
+	if (Size < 0 || static_cast<std::size_t>(Size) > Data.size() - Pos)
+		return std::nullopt;
+	return record_t {ID, Version, Data.subview(Pos, Size), Pos + Size};
+}
+
+} // namespace
+
+std::optional<CModuleJournal::commit_t> CModuleJournal::Commit(CFamiTrackerModule &modfile, module_error_level_t err_lv) {
+	const bool Snapshot = need_snapshot_ || modfile.IsStructureDirty() ||
+		commits_ >= MAX_COMMITS || journal_size_ > snapshot_size_ * COMPACT_RATIO;
+	if (Snapshot) {
+		modfile.SetDirty();
+		blocks_.clear();
+	}
+
+	CDocumentFile File;
+	File.OpenBuffer();
+	std::vector<std::string_view> BlockIDs;
+	if (!CFamiTrackerDocIO {File, err_lv}.SaveChanges(modfile, BlockIDs)) {
+		need_snapshot_ = true;
+		return std::nullopt;
+	}
+	const std::vector<unsigned char> Image = File.ReleaseBuffer();
+	modfile.ClearDirty();
+
+	commit_t commit;
+	commit.Snapshot = Snapshot;
+	auto &Data = commit.Data;
+	if (Snapshot) {
+		Data.assign(JOURNAL_HEADER_ID.begin(), JOURNAL_HEADER_ID.end());
+		AppendInt(Data, JOURNAL_VER);
+	}
+	const std::size_t CommitBegin = Data.size();
+
+	std::vector<std::string_view> Written;
+	std::size_t Pos = 0;
+	while (auto Rec = ParseRecord(Image, Pos)) {
+		const std::size_t Begin = std::exchange(Pos, Rec->Next);
+		Written.push_back(Rec->ID);
+		array_view<unsigned char> Raw = array_view<unsigned char> {Image}.subview(Begin, Pos - Begin);
+		if (Rec->ID != FILE_BLOCK_PATTERN_DIFF) {
+			// only keep blocks that differ from the last commit
+			auto it = blocks_.find(Rec->ID);
+			if (it != blocks_.end() && array_view<unsigned char> {it->second} == Raw)
+				continue;
+			blocks_.insert_or_assign(std::string {Rec->ID}, std::vector<unsigned char>(Raw.begin(), Raw.end()));
+		}
+		Data.insert(Data.end(), Raw.begin(), Raw.end());
+	}
+
+	// empty blocks are omitted by the document file, so record their removal
+	for (auto ID : BlockIDs)
+		if (std::find(Written.begin(), Written.end(), ID) == Written.end())
+			if (auto it = blocks_.find(ID); it != blocks_.end()) {
+				blocks_.erase(it);
+				AppendRecord(Data, ID, 0, { });
+			}
+
+	if (Data.size() == CommitBegin)
+		return std::nullopt;
+
+	unsigned char Sum[sizeof(std::uint32_t)];
+	const std::uint32_t h = Checksum(Data.data() + CommitBegin, Data.size() - CommitBegin);
+	std::memcpy(Sum, &h, sizeof(h));
+	AppendRecord(Data, COMMIT_ID, Snapshot ? COMMIT_SNAPSHOT : COMMIT_DELTA, Sum);
+
+	if (Snapshot) {
+		snapshot_size_ = Data.size();
+		journal_size_ = Data.size();
+		commits_ = 0;
+		need_snapshot_ = false;
+	}
+	else {
+		journal_size_ += Data.size();
+		++commits_;
+	}
+	return commit;
+}
+
+void CModuleJournal::Invalidate() {
+	need_snapshot_ = true;
+}
+
+void CModuleJournal::Write(const fs::path &fname, const commit_t &commit) {
+	if (commit.Snapshot)
+		WriteFileAtomic(fname, commit.Data);
+	else
+		AppendFileSynced(fname, commit.Data);
+}
+
+std::vector<unsigned char> CModuleJournal::Replay(const fs::path &fname) {
+	std::error_code err;
+	const auto FileSize = fs::file_size(fname, err);
+	CSimpleFile file(fname, std::ios::in | std::ios::binary);
+	if (err || !file)
+		throw std::runtime_error {"Cannot open " + fname.u8string()};
+	std::vector<unsigned char> Journal(static_cast<std::size_t>(FileSize));
+	if (file.ReadBytes(Journal.data(), Journal.size()) != Journal.size())
+		throw std::runtime_error {"Cannot read " + fname.u8string()};
+
+	const std::size_t HEADER_SIZE = JOURNAL_HEADER_ID.size() + sizeof(JOURNAL_VER);
+	if (Journal.size() < HEADER_SIZE || std::memcmp(Journal.data(), JOURNAL_HEADER_ID.data(), JOURNAL_HEADER_ID.size()) != 0 ||
+		static_cast<std::uint32_t>(ReadInt(Journal.data() + JOURNAL_HEADER_ID.size())) != JOURNAL_VER)
+		throw std::runtime_error {"File is not an autosave journal"};
+
+	// merged state: document blocks in order of appearance, and pattern entries
+	// keyed by (song, channel, pattern), which replace the pattern diff block
+	std::vector<std::pair<std::string, record_t>> Blocks;
+	std::map<std::array<int, 3>, array_view<unsigned char>> Patterns;
+	bool HasSnapshot = false;
+
+	const auto Apply = [&] (const record_t &Rec) {
+		auto it = std::find_if(Blocks.begin(), Blocks.end(), [&] (const auto &x) { return x.first == Rec.ID; });
+		if (Rec.ID == FILE_BLOCK_PATTERN_DIFF) {
+			for (std::size_t Pos = 0; Rec.Body.size() - Pos >= PATTERN_ENTRY_HEADER_SIZE; ) {
+				const unsigned char *Entry = Rec.Body.data() + Pos;
+				std::array<int, 3> Key = {ReadInt(Entry), ReadInt(Entry + sizeof(int)), ReadInt(Entry + sizeof(int) * 2)};
+				int Size = ReadInt(Entry + sizeof(int) * 3);
+				Pos += PATTERN_ENTRY_HEADER_SIZE;
+				if (Size < 0 || static_cast<std::size_t>(Size) > Rec.Body.size() - Pos)
+					break;
+				if (Size)
+					Patterns.insert_or_assign(Key, Rec.Body.subview(Pos, Size));
+				else
+					Patterns.erase(Key);
+				Pos += Size;
+			}
+			if (it == Blocks.end())
+				Blocks.emplace_back(std::string {Rec.ID}, Rec);
+			else
+				it->second.Version = Rec.Version;
+		}
+		else if (Rec.Body.empty()) {
+			if (it != Blocks.end())
+				Blocks.erase(it);
+		}
+		else if (it == Blocks.end())
+			Blocks.emplace_back(std::string {Rec.ID}, Rec);
+		else
+			it->second = Rec;
+	};
+
+	std::vector<record_t> Pending;
+	std::size_t CommitBegin = HEADER_SIZE;
+	std::size_t Pos = HEADER_SIZE;
+	while (auto Rec = ParseRecord(Journal, Pos)) {
+		const std::size_t Begin = std::exchange(Pos, Rec->Next);
+		if (Rec->ID != COMMIT_ID) {
+			Pending.push_back(*Rec);
+			continue;
+		}
+
+		std::uint32_t Sum;
+		if (Rec->Body.size() != sizeof(Sum))
+			break;
+		std::memcpy(&Sum, Rec->Body.data(), sizeof(Sum));
+		if (Sum != Checksum(Journal.data() + CommitBegin, Begin - CommitBegin))
+			break;
+
+		if (Rec->Version == COMMIT_SNAPSHOT) {
+			Blocks.clear();
+			Patterns.clear();
+			HasSnapshot = true;
+		}
+		if (HasSnapshot)
+			for (const auto &x : Pending)
+				Apply(x);
+		Pending.clear();
+		CommitBegin = Pos;
+	}
+
+	if (!HasSnapshot)
+		return { };
+
+	CDocumentFile File;
+	File.OpenBuffer(Journal.size());
+	File.BeginDocument();
+	for (const auto &[ID, Rec] : Blocks) {
+		if (ID == FILE_BLOCK_PATTERN_DIFF) {
+			File.CreateBlock("PATTERNS", Rec.Version);
+			for (const auto &[Key, Entry] : Patterns) {
+				for (int x : Key)
+					File.WriteBlockInt(x);
+				File.WriteBlock(Entry);
+			}
+		}
+		else {
+			File.CreateBlock(ID, Rec.Version);
+			File.WriteBlock(Rec.Body);
+		}
+		File.FlushBlock();
+	}
+	File.EndDocument();
+	return File.ReleaseBuffer();
+}
@@ -0,0 +1,64 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+#pragma once
+
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+#include "ModuleException.h"
+#include "ft0cc/fs.h"
+
+class CFamiTrackerModule;
+
+// // // Append-only journal of module changes for crash recovery. Each commit
+// contains the document blocks that changed since the previous commit, while a
+// snapshot commit contains every block and starts the journal over.
+
+class CModuleJournal {
+public:
+	struct commit_t {
+		std::vector<unsigned char> Data;
+		bool Snapshot = false;		// replaces the journal file instead of extending it
+	};
+
+	// Serializes the changes since the last commit and clears the dirty flags of
+	// the module. Returns nothing if no block has changed.
+	std::optional<commit_t> Commit(CFamiTrackerModule &modfile, module_error_level_t err_lv);
+	// Forces the next commit to be a snapshot, e.g. after a failed write
+	void Invalidate();
+
+	// Writes a commit to the journal file. Throws std::runtime_error on failure.
+	static void Write(const fs::path &fname, const commit_t &commit);
+	// Merges all complete commits of a journal file into a module document image.
+	// Returns an empty image if the journal does not contain a complete snapshot.
+	static std::vector<unsigned char> Replay(const fs::path &fname);
+
+private:
+	std::map<std::string, std::vector<unsigned char>, std::less<>> blocks_;		// last committed version of each block
+	std::size_t snapshot_size_ = 0;
+	std::size_t journal_size_ = 0;
+	unsigned commits_ = 0;
+	bool need_snapshot_ = true;
+};
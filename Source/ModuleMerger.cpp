@@ -0,0 +1,337 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+#include "ModuleMerger.h"
+#include "FamiTrackerModule.h"
+#include "FamiTrackerEnv.h"
+#include "SoundChipService.h"
+#include "ChannelMap.h"
+#include "InstrumentManager.h"
+#include "InstrumentService.h"
+#include "InstrumentIO.h"
+#include "Instrument2A03.h"
+#include "DSampleManager.h"
+#include "Sequence.h"
+#include "SongData.h"
+#include "DocumentFile.h"
+#include "ft0cc/doc/dpcm_sample.hpp"
+#include "ft0cc/doc/groove.hpp"
+#include <unordered_map>
+#include <string>
+#include <numeric>
+#include <algorithm>
+
+namespace {
+
+// instrument types that share sequence lists
+const inst_type_t SEQ_INST[] = {INST_2A03, INST_VRC6, INST_N163, INST_S5B};
+
+int FindSequenceList(inst_type_t Type) {
+	auto it = std::find(std::begin(SEQ_INST), std::end(SEQ_INST), Type);
+	return it != std::end(SEQ_INST) ? static_cast<int>(it - std::begin(SEQ_INST)) : -1;
+}
+
+// Assigns the slots of one kind of resource; identical resources share a slot
+class CResourcePool {
+public:
+	explicit CResourcePool(unsigned Capacity) : used_(Capacity) {
+	}
+
+	void Reserve(unsigned Slot, std::string Key) {
+		used_[Slot] = true;
+		++count_;
+		index_.try_emplace(std::move(Key), Slot);
+	}
+
+	// Returns the slot of the resource, and whether it is a new one; slots past the
+	// capacity are handed out once the pool is full
+	std::pair<unsigned, bool> Insert(std::string Key) {
+		if (auto it = index_.find(Key); it != index_.end())
+			return {it->second, false};
+		unsigned Slot = count_;
+		if (count_ < used_.size()) {
+			while (used_[next_])
+				++next_;
+			Slot = next_;
+			used_[Slot] = true;
+		}
+		++count_;
+		index_.emplace(std::move(Key), Slot);
+		return {Slot, true};
+	}
+
+	unsigned GetCount() const {
+		return count_;
+	}
+
+private:
+	std::vector<bool> used_;
+	std::unordered_map<std::string, unsigned> index_;
+	unsigned count_ = 0;
+	unsigned next_ = 0;
+};
+
+std::string SequenceKey(const CSequence &seq) {
+	std::string Key;
+	for (unsigned x : {seq.GetItemCount(), seq.GetLoopPoint(), seq.GetReleasePoint(), static_cast<unsigned>(seq.GetSetting())})
+		Key.append(reinterpret_cast<const char *>(&x), sizeof(x));
+	for (unsigned i = 0, n = seq.GetItemCount(); i < n; ++i)
+		Key.push_back(static_cast<char>(seq.GetItem(i)));
+	return Key;
+}
+
+std::string SampleKey(const ft0cc::doc::dpcm_sample &sample) {
+	return std::string(reinterpret_cast<const char *>(sample.data()), sample.size());
+}
+
+std::string GrooveKey(const ft0cc::doc::groove &groove) {
+	return std::string(groove.begin(), groove.end());
+}
+
+// the instrument's data in the INSTRUMENTS block, without the block header and the name
+std::string InstrumentKey(const CInstrument &inst) {
+	CDocumentFile file;
+	file.OpenBuffer();
+	file.CreateBlock("INSTRUMENTS", 0);
+	FTEnv.GetInstrumentService()->GetInstrumentIO(inst.GetType(), MODULE_ERROR_DEFAULT)->WriteToModule(inst, file, 0);
+	file.FlushBlock();
+	const std::vector<unsigned char> Data = file.ReleaseBuffer();
+	const std::size_t Header = CDocumentFile::BLOCK_HEADER_SIZE + 2 * sizeof(int);
+	const std::size_t Name = sizeof(int) + inst.GetName().size();
+	return std::string(Data.begin() + Header, Data.end() - Name);
+}
+
+} // namespace
+
+bool stMergeReport::Fits() const {
+	return Songs <= MAX_TRACKS && Instruments <= MAX_INSTRUMENTS && Sequences <= MAX_SEQUENCES &&
+		Samples <= MAX_DSAMPLES && SampleSize <= MAX_SAMPLE_SPACE && Grooves <= MAX_GROOVE;
+}
+
+CModuleMerger::CModuleMerger(CFamiTrackerModule &modfile) : modfile_(modfile) {
+}
+
+CModuleMerger::~CModuleMerger() {
+}
+
+void CModuleMerger::AddModule(CFamiTrackerModule &imported) {
+	imports_.emplace_back().modfile = &imported;
+}
+
+const stMergeReport &CModuleMerger::Plan() {
+	report_ = stMergeReport { };
+	chips_ = modfile_.GetSoundChipSet();
+	n163chs_ = modfile_.GetNamcoChannels();
+
+	auto *pInsts = modfile_.GetInstrumentManager();
+	auto *pSamps = modfile_.GetDSampleManager();
+
+	// resources of the target module
+	CResourcePool InstPool {MAX_INSTRUMENTS};
+	std::vector<CResourcePool> SeqPools(std::size(SEQ_INST) * SEQ_COUNT, CResourcePool {MAX_SEQUENCES});
+	CResourcePool SamplePool {MAX_DSAMPLES};
+	CResourcePool GroovePool {MAX_GROOVE};
+
+	// empty sequences are kept as well if an instrument uses them
+	std::vector<bool> SeqUsed(SeqPools.size() * MAX_SEQUENCES);
+	pInsts->VisitInstruments([&] (const CInstrument &inst, std::size_t i) {
+		InstPool.Reserve(i, InstrumentKey(inst));
+		if (int List = FindSequenceList(inst.GetType()); List >= 0)
+			if (auto *pSeqInst = dynamic_cast<const CSeqInstrument *>(&inst))
+				for (auto t : enum_values<sequence_t>())
+					if (pSeqInst->GetSeqEnable(t))
+						SeqUsed[(List * SEQ_COUNT + value_cast(t)) * MAX_SEQUENCES + pSeqInst->GetSeqIndex(t)] = true;
+	});
+	for (std::size_t List = 0; List < std::size(SEQ_INST); ++List)
+		for (auto t : enum_values<sequence_t>()) {
+			std::size_t Pool = List * SEQ_COUNT + value_cast(t);
+			for (unsigned i = 0; i < MAX_SEQUENCES; ++i)
+				if (auto pSeq = pInsts->GetSequence(SEQ_INST[List], t, i))
+					if (pSeq->GetItemCount() > 0 || SeqUsed[Pool * MAX_SEQUENCES + i])
+						SeqPools[Pool].Reserve(i, SequenceKey(*pSeq));
+		}
+	for (unsigned i = 0; i < MAX_DSAMPLES; ++i)
+		if (auto pSample = pSamps->GetDSample(i))
+			SamplePool.Reserve(i, SampleKey(*pSample));
+	for (unsigned i = 0; i < MAX_GROOVE; ++i)
+		if (auto pGroove = modfile_.GetGroove(i))
+			GroovePool.Reserve(i, GrooveKey(*pGroove));
+	report_.Songs = modfile_.GetSongCount();
+	report_.SampleSize = pSamps->GetTotalSize();
+
+	for (auto &imp : imports_) {
+		auto &src = *imp.modfile;
+		auto *pSrcInsts = src.GetInstrumentManager();
+		auto *pSrcSamps = src.GetDSampleManager();
+
+		imp.instruments.clear();
+		imp.sequences.clear();
+		imp.samples.clear();
+		imp.grooves.clear();
+		std::iota(imp.inst_map.begin(), imp.inst_map.end(), 0);
+		std::iota(imp.groove_map.begin(), imp.groove_map.end(), 0);
+
+		chips_ = chips_.MergedWith(src.GetSoundChipSet());
+		n163chs_ = std::max(n163chs_, static_cast<unsigned>(src.GetNamcoChannels()));
+		report_.Songs += src.GetSongCount();
+
+		for (unsigned i = 0; i < MAX_GROOVE; ++i)
+			if (auto pGroove = src.GetGroove(i)) {
+				auto [Slot, New] = GroovePool.Insert(GrooveKey(*pGroove));
+				imp.groove_map[i] = Slot;
+				if (New)
+					imp.grooves.emplace_back(i, Slot);
+				else
+					++report_.SharedGrooves;
+			}
+
+		// sequences and samples are translated when an instrument first uses them
+		std::vector<int> SeqMap(SeqPools.size() * MAX_SEQUENCES, -1);
+		std::array<int, MAX_DSAMPLES> SampleMap;
+		SampleMap.fill(-1);
+
+		pSrcInsts->VisitInstruments([&] (const CInstrument &inst, std::size_t i) {
+			std::shared_ptr<CInstrument> pInst = inst.Clone();
+
+			if (int List = FindSequenceList(inst.GetType()); List >= 0)
+				if (auto *pSeqInst = dynamic_cast<CSeqInstrument *>(pInst.get())) {
+					for (auto t : enum_values<sequence_t>())
+						if (pSeqInst->GetSeqEnable(t)) {
+							std::size_t Pool = List * SEQ_COUNT + value_cast(t);
+							unsigned Index = pSeqInst->GetSeqIndex(t);
+							int &Target = SeqMap[Pool * MAX_SEQUENCES + Index];
+							if (Target < 0) {
+								auto pSeq = pSrcInsts->GetSequence(inst.GetType(), t, Index);
+								auto [Slot, New] = SeqPools[Pool].Insert(SequenceKey(pSeq ? *pSeq : CSequence {t}));
+								Target = Slot;
+								if (New)
+									imp.sequences.push_back({inst.GetType(), t, Index, Slot});
+								else
+									++report_.SharedSequences;
+							}
+							pSeqInst->SetSeqIndex(t, Target);
+						}
+
+					if (auto *p2A03 = dynamic_cast<CInstrument2A03 *>(pSeqInst))
+						for (int n = 0; n < NOTE_COUNT; ++n)
+							if (unsigned Index = p2A03->GetSampleIndex(n); Index != CInstrument2A03::NO_DPCM) {
+								auto pSample = Index < MAX_DSAMPLES ? pSrcSamps->GetDSample(Index) : nullptr;
+								if (!pSample) {
+									p2A03->SetSampleIndex(n, CInstrument2A03::NO_DPCM);
+									continue;
+								}
+								int &Target = SampleMap[Index];
+								if (Target < 0) {
+									auto [Slot, New] = SamplePool.Insert(SampleKey(*pSample));
+									Target = Slot;
+									if (New) {
+										imp.samples.emplace_back(Index, Slot);
+										report_.SampleSize += pSample->size();
+									}
+									else
+										++report_.SharedSamples;
+								}
+								p2A03->SetSampleIndex(n, Target);
+							}
+				}
+
+			auto [Slot, New] = InstPool.Insert(InstrumentKey(*pInst));
+			imp.inst_map[i] = Slot;
+			if (New)
+				imp.instruments.emplace_back(Slot, std::move(pInst));
+			else
+				++report_.SharedInstruments;
+		});
+	}
+
+	report_.Instruments = InstPool.GetCount();
+	for (const auto &x : SeqPools)
+		report_.Sequences = std::max(report_.Sequences, x.GetCount());
+	report_.Samples = SamplePool.GetCount();
+	report_.Grooves = GroovePool.GetCount();
+
+	return report_;
+}
+
+bool CModuleMerger::Merge() {
+	if (!Plan().Fits())
+		return false;
+	Commit();
+	return true;
+}
+
+const stMergeReport &CModuleMerger::GetReport() const {
+	return report_;
+}
+
+void CModuleMerger::Commit() {
+	// union of sound chip configurations
+	auto UpdateChips = [&] (CFamiTrackerModule &modfile) {
+		if (modfile.GetSoundChipSet() != chips_ || static_cast<unsigned>(modfile.GetNamcoChannels()) != n163chs_)
+			modfile.SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(chips_, n163chs_));
+	};
+	UpdateChips(modfile_);
+
+	auto *pInsts = modfile_.GetInstrumentManager();
+	auto *pSamps = modfile_.GetDSampleManager();
+
+	for (auto &imp : imports_) {
+		auto &src = *imp.modfile;
+		auto *pSrcInsts = src.GetInstrumentManager();
+		auto *pSrcSamps = src.GetDSampleManager();
+		UpdateChips(src);
+
+		for (const auto &x : imp.sequences)
+			if (auto pSeq = pSrcInsts->GetSequence(x.InstType, x.SeqType, x.Index))
+				*pInsts->GetSequence(x.InstType, x.SeqType, x.Target) = *pSeq;
+		for (auto [i, Target] : imp.samples)
+			pSamps->SetDSample(Target, pSrcSamps->ReleaseDSample(i));
+		for (auto [i, Target] : imp.grooves)
+			modfile_.SetGroove(Target, src.GetGroove(i));
+		for (auto &[Target, pInst] : imp.instruments)
+			pInsts->InsertInstrument(Target, std::move(pInst));
+
+		ImportSongs(imp);
+	}
+
+	pInsts->SetDirty();
+	imports_.clear();
+}
+
+void CModuleMerger::ImportSongs(import_t &imp) {
+	const auto &InstMap = imp.inst_map;
+	const auto &GrooveMap = imp.groove_map;
+
+	while (auto pSong = imp.modfile->ReleaseSong(0)) {
+		if (pSong->GetSongGroove() && pSong->GetSongSpeed() < MAX_GROOVE)
+			pSong->SetSongSpeed(GrooveMap[pSong->GetSongSpeed()]);
+		pSong->VisitPatterns([&] (CPatternData &pat) {
+			pat.VisitRows([&] (stChanNote &note) {
+				note.Instrument = InstMap[note.Instrument];
+				for (auto &[fx, param] : note.Effects)
+					if (fx == effect_t::GROOVE)
+						param = GrooveMap[param];
+			});
+		});
+		modfile_.InsertSong(modfile_.GetSongCount(), std::move(pSong));
+	}
+}
@@ -0,0 +1,105 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+#pragma once
+
+#include <array>
+#include <vector>
+#include <memory>
+#include "SoundChipSet.h"
+
+class CFamiTrackerModule;
+class CInstrument;
+enum inst_type_t : unsigned;
+enum class sequence_t : unsigned;
+
+// // // Resource counts of a merged module, compared against the limits of the format
+struct stMergeReport {
+	unsigned Songs = 0;
+	unsigned Instruments = 0;
+	unsigned Sequences = 0;		// of the fullest sequence list
+	unsigned Samples = 0;
+	unsigned SampleSize = 0;
+	unsigned Grooves = 0;
+
+	// imported resources identical to one already in the merged module
+	unsigned SharedInstruments = 0;
+	unsigned SharedSequences = 0;
+	unsigned SharedSamples = 0;
+	unsigned SharedGrooves = 0;
+
+	bool Fits() const;
+};
+
+// // // Merges any number of modules into one. Instruments, sequences, DPCM samples and
+// grooves are deduplicated by content against those of the target module and of every
+// module added before; an imported instrument is compared after its sequence and sample
+// references are translated, and names are ignored. Only the sequences and samples that
+// the imported instruments use are imported. All songs are appended to the target, and
+// their patterns are translated with one lookup table per module.
+
+class CModuleMerger {
+public:
+	explicit CModuleMerger(CFamiTrackerModule &modfile);
+	~CModuleMerger();
+
+	// The songs and the DPCM samples of the module are moved out of it by Merge
+	void AddModule(CFamiTrackerModule &imported);
+
+	// Computes the merged resources without modifying any module
+	const stMergeReport &Plan();
+	// Merges all added modules if the result fits within the limits, otherwise leaves
+	// every module unchanged and returns false
+	bool Merge();
+
+	const stMergeReport &GetReport() const;
+
+private:
+	struct seq_import_t {
+		inst_type_t InstType;
+		sequence_t SeqType;
+		unsigned Index;
+		unsigned Target;
+	};
+
+	struct import_t {
+		CFamiTrackerModule *modfile = nullptr;
+		std::array<unsigned char, 256> inst_map = { };		// note instrument -> merged index
+		std::array<unsigned char, 256> groove_map = { };	// Oxx parameter -> merged index
+		std::vector<std::pair<unsigned, std::shared_ptr<CInstrument>>> instruments;
+		std::vector<seq_import_t> sequences;
+		std::vector<std::pair<unsigned, unsigned>> samples;		// imported index, merged index
+		std::vector<std::pair<unsigned, unsigned>> grooves;
+	};
+
+	void Commit();
+	void ImportSongs(import_t &imp);
+
+private:
+	CFamiTrackerModule &modfile_;
+	std::vector<import_t> imports_;
+	stMergeReport report_;
+	CSoundChipSet chips_;
+	unsigned n163chs_ = 0;
+	bool planned_ = false;
+};
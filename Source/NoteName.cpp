@@ -59,7 +59,10 @@ std::string GetNoteString(note_t note, int octave) {
 	default:
 		if (is_note(note))
 #ifndef AFL_FUZZ_ENABLED
-			return std::string((FTEnv.GetSettings()->Appearance.bDisplayFlats ? NOTE_NAME_FLAT : NOTE_NAME)[value_cast(note) - 1]) + std::to_string(octave);
+		{
+			const CSettings *pSettings = FTEnv.GetSettings();		// // // null in headless builds
+			return std::string((pSettings && pSettings->Appearance.bDisplayFlats ? NOTE_NAME_FLAT : NOTE_NAME)[value_cast(note) - 1]) + std::to_string(octave);
+		}
 #else
 			return std::string((NOTE_NAME)[value_cast(note) - 1]) + std::to_string(octave);
 #endif
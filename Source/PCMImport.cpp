@@ -27,113 +27,11 @@
 #include "Settings.h"
 #include "SoundGen.h"
 #include "APU/DPCM.h"
+#include "DPCMEncoder.h"		// // //
 #include "FileDialogs.h"		// // //
-#include "resampler/resample.hpp"
-#include "resampler/resample.inl"
-#include <algorithm>		// // //
 #include "str_conv/str_conv.hpp"		// // //
 #include <MMSystem.h>		// // //
 
-const int CPCMImport::QUALITY_RANGE = 16;
-const int CPCMImport::VOLUME_RANGE = 12;		// +/- dB
-
-// Implement a resampler using CRTP idiom
-class resampler : public jarh::resample<resampler>
-{
-	typedef jarh::resample<resampler> base;
-public:
-	resampler(const jarh::sinc &sinc, float ratio, int channels, int smpsize,
-			  size_t nbsamples, CFile &cfile)
-	// TODO: cutoff is currently fixed to a value (.9f), make it modifiable.
-	 : base(sinc), channels_(channels), smpsize_(smpsize),
-	   nbsamples_(nbsamples), remain_(nbsamples), cfile_(cfile)
-	{
-		init(ratio, .9f);
-	}
-
-	bool initstream()
-	{
-		// Don't seek to the begin of wave chunk, as it is already done.
-		// This stream will not be reinitialized, then.
-		remain_ = nbsamples_;
-		return true;
-	}
-
-	float *fill(float *first, float *end)
-	{
-		int val;
-		for(;first != end && remain_ && ReadSample(val); ++first, --remain_)
-		{
-			*first = (float)val;
-		}
-		return first;
-	}
-
-private:
-	bool ReadSample(int &v)
-	{
-		int ret = 0, nbytes = 0;
-		if (smpsize_ == 2) {
-			// 16 bit samples
-			short sample_word[2];
-			if (channels_ == 2) {
-				ret = cfile_.Read(sample_word, nbytes = 2*sizeof(short));
-				v = (sample_word[0] + sample_word[1]) / 2;
-			}
-			else {
-				ret = cfile_.Read(sample_word, nbytes = sizeof(short));
-				v = *sample_word;
-			}
-		}
-		else if (smpsize_ == 1) {
-			// 8 bit samples
-			unsigned char sample_byte[2];
-			if (channels_ == 2) {
-				ret = cfile_.Read(sample_byte, nbytes = 2);
-				// convert to a proper signed representation
-				// shift left only by 7; because we want a mean
-				v = ((int)sample_byte[0] + (int)sample_byte[1] - 256) << 7;
-			}
-			else {
-				ret = cfile_.Read(sample_byte, nbytes = 1);
-				v = ((int)(*sample_byte) - 128) << 8;
-			}
-		}
-		else if (smpsize_ == 3) {
-			// 24 bit samples
-	        unsigned char sample_byte[6];
-			if (channels_ == 2) {
-				ret = cfile_.Read(sample_byte, nbytes = 6);
-				v = (*((signed short*)(sample_byte + 1)) + *((signed short*)(sample_byte + 4))) / 2;
-			}
-			else {
-				ret = cfile_.Read(sample_byte, nbytes = 3);
-				v = *((signed short*)(sample_byte + 1));
-			}
-		}
-		else if (smpsize_ == 4) {
-			// 32 bit samples
-	        int sample_word[2];
-			if (channels_ == 2) {
-				ret = cfile_.Read(sample_word, nbytes = 8);
-				v = ((sample_word[0] >> 16) + (sample_word[1] >> 16)) / 2;
-			}
-			else {
-				ret = cfile_.Read(sample_word, nbytes = 4);
-				v = sample_word[0] >> 16;
-			}
-		}
-
-		return ret == nbytes;
-	}
-
-	CFile &cfile_;
-	int    channels_;
-	int    smpsize_;
-	size_t nbsamples_;
-	size_t remain_;
-};
-
 // Derive a new class from CFileDialog with implemented preview of audio files
 
 class CFileSoundDialog : public CFileDialog
@@ -168,11 +66,7 @@ void CFileSoundDialog::OnFileNameChange()
 
 IMPLEMENT_DYNAMIC(CPCMImport, CDialog)
 CPCMImport::CPCMImport(CWnd* pParent /*=NULL*/)
-	: CDialog(CPCMImport::IDD, pParent),
-	m_pCachedSample(NULL),
-	m_iCachedQuality(0),
-	m_iCachedVolume(0),
-	m_psinc(std::make_unique<jarh::sinc>(512, 32)) // sinc object. TODO: parametrise
+	: CDialog(CPCMImport::IDD, pParent)
 {
 }
 
@@ -191,37 +85,46 @@ BEGIN_MESSAGE_MAP(CPCMImport, CDialog)
 	ON_BN_CLICKED(IDCANCEL, OnBnClickedCancel)
 	ON_BN_CLICKED(IDOK, OnBnClickedOk)
 	ON_BN_CLICKED(IDC_PREVIEW, &CPCMImport::OnBnClickedPreview)
+	ON_BN_CLICKED(IDC_PCM_TRELLIS, &CPCMImport::OnBnClickedTrellis)
 END_MESSAGE_MAP()
 
-std::shared_ptr<ft0cc::doc::dpcm_sample> CPCMImport::ShowDialog() {		// // //
-	// Return imported sample, or NULL if cancel/error
+std::vector<std::shared_ptr<ft0cc::doc::dpcm_sample>> CPCMImport::ShowDialog() {		// // //
+	// Return imported samples, or nothing if cancel/error
 
-	CFileSoundDialog OpenFileDialog(TRUE, 0, 0, OFN_HIDEREADONLY, LoadDefaultFilter(IDS_FILTER_WAV, L"*.wav"));
+	CFileSoundDialog OpenFileDialog(TRUE, 0, 0, OFN_HIDEREADONLY | OFN_FILEMUSTEXIST | OFN_ALLOWMULTISELECT | OFN_EXPLORER, LoadDefaultFilter(IDS_FILTER_WAV, L"*.wav"));
 
 	auto path = FTEnv.GetSettings()->GetPath(PATH_WAV);		// // //
 	OpenFileDialog.m_pOFN->lpstrInitialDir = path.c_str();
 	if (OpenFileDialog.DoModal() == IDCANCEL)
-		return nullptr;
+		return { };
 
 	// Stop any preview
 	PlaySoundW(NULL, NULL, SND_NODEFAULT | SND_SYNC);
 
-	FTEnv.GetSettings()->SetPath(fs::path {(LPCWSTR)OpenFileDialog.GetPathName()}.parent_path(), PATH_WAV);
+	// // // the first file is shown in the dialog
+	m_BatchPaths.clear();
+	POSITION Pos = OpenFileDialog.GetStartPosition();
+	while (Pos)
+		m_BatchPaths.emplace_back((LPCWSTR)OpenFileDialog.GetNextPathName(Pos));
+	if (m_BatchPaths.empty())
+		return { };
+
+	FTEnv.GetSettings()->SetPath(m_BatchPaths.front().parent_path(), PATH_WAV);
 
-	m_strPath	  = OpenFileDialog.GetPathName();
-	m_strFileName = OpenFileDialog.GetFileName();
-	m_pImported.reset();		// // //
+	m_strPath	  = m_BatchPaths.front().c_str();
+	m_strFileName = m_BatchPaths.front().filename().c_str();
+	m_BatchPaths.erase(m_BatchPaths.begin());
+	m_Imported.clear();		// // //
 
 	// Open file and read header
 	if (!OpenWaveFile())
-		return NULL;
+		return { };
 
 	CDialog::DoModal();
 
-	// Close file
-	m_fSampleFile.Close();
+	m_pEncoder.reset();		// // //
 
-	return m_pImported;
+	return std::move(m_Imported);
 }
 
 // CPCMImport message handlers
@@ -234,16 +137,18 @@ BOOL CPCMImport::OnInitDialog()
 	CSliderCtrl *pVolumeSlider = static_cast<CSliderCtrl*>(GetDlgItem(IDC_VOLUME));
 
 	// Initial volume & quality
-	m_iQuality = QUALITY_RANGE - 1;	// Max quality
+	m_iQuality = CDPCMEncoder::QUALITY_RANGE - 1;	// Max quality
 	m_iVolume = 0;					// 0dB
 
-	pQualitySlider->SetRange(0, QUALITY_RANGE - 1);
+	pQualitySlider->SetRange(0, CDPCMEncoder::QUALITY_RANGE - 1);
 	pQualitySlider->SetPos(m_iQuality);
 
-	pVolumeSlider->SetRange(0, VOLUME_RANGE * 2);
-	pVolumeSlider->SetPos(m_iVolume + VOLUME_RANGE);
+	pVolumeSlider->SetRange(0, CDPCMEncoder::VOLUME_RANGE * 2);
+	pVolumeSlider->SetPos(m_iVolume + CDPCMEncoder::VOLUME_RANGE);
 	pVolumeSlider->SetTicFreq(3);	// 3dB/tick
 
+	CheckDlgButton(IDC_PCM_TRELLIS, m_bTrellis ? BST_CHECKED : BST_UNCHECKED);		// // //
+
 	UpdateText();
 
 	SetDlgItemTextW(IDC_SAMPLESIZE, AfxFormattedW(IDS_DPCM_IMPORT_SIZE_FORMAT, L"(unknown)"));		// // //
@@ -262,7 +167,7 @@ void CPCMImport::OnHScroll(UINT nSBCode, UINT nPos, CScrollBar* pScrollBar)
 	CSliderCtrl *pVolumeSlider = static_cast<CSliderCtrl*>(GetDlgItem(IDC_VOLUME));
 
 	m_iQuality = pQualitySlider->GetPos();
-	m_iVolume = pVolumeSlider->GetPos() - VOLUME_RANGE;
+	m_iVolume = pVolumeSlider->GetPos() - CDPCMEncoder::VOLUME_RANGE;
 
 	UpdateText();
 	UpdateFileInfo();
@@ -280,7 +185,7 @@ void CPCMImport::OnBnClickedCancel()
 {
 	m_iQuality = 0;
 	m_iVolume = 0;
-	m_pImported = NULL;
+	m_Imported.clear();		// // //
 
 	FTEnv.GetSoundGenerator()->CancelPreviewSample();
 
@@ -296,8 +201,16 @@ void CPCMImport::OnBnClickedOk()
 		// Set the name
 		pSample->rename(conv::to_utf8(m_strFileName));
 
-		m_pImported = std::move(pSample);
-		m_pCachedSample.reset();
+		m_Imported.push_back(std::move(pSample));
+
+		// // // convert the other selected files in parallel
+		if (!m_BatchPaths.empty()) {
+			CWaitCursor wait;
+			auto Mode = m_bTrellis ? dpcm_encode_mode_t::Trellis : dpcm_encode_mode_t::Direct;
+			for (auto &pBatch : CDPCMEncoder::EncodeFiles(m_BatchPaths, m_iQuality, m_iVolume, Mode))
+				if (pBatch)
+					m_Imported.push_back(std::move(pBatch));
+		}
 
 		OnOK();
 	}
@@ -305,20 +218,25 @@ void CPCMImport::OnBnClickedOk()
 
 void CPCMImport::OnBnClickedPreview()
 {
-	if (auto pSample = GetSample()) {		// // //
-		SetDlgItemTextW(IDC_SAMPLESIZE, AfxFormattedW(IDS_DPCM_IMPORT_SIZE_FORMAT, FormattedW(L"%i", pSample->size())));
-
-		// Preview the sample
-		FTEnv.GetSoundGenerator()->PreviewSample(std::move(pSample), 0, m_iQuality);
+	if (m_pEncoder) {		// // //
+		// // // Preview the sample while it is being converted, the size is known in advance
+		auto pStream = m_pEncoder->EncodeAsync(m_iQuality, m_iVolume, m_bTrellis ? dpcm_encode_mode_t::Trellis : dpcm_encode_mode_t::Direct);
+		SetDlgItemTextW(IDC_SAMPLESIZE, AfxFormattedW(IDS_DPCM_IMPORT_SIZE_FORMAT, FormattedW(L"%i", pStream->GetSample()->size())));
+		FTEnv.GetSoundGenerator()->PreviewSample(std::move(pStream), 0, m_iQuality);
 	}
 }
 
+void CPCMImport::OnBnClickedTrellis()		// // //
+{
+	m_bTrellis = IsDlgButtonChecked(IDC_PCM_TRELLIS) == BST_CHECKED;
+}
+
 void CPCMImport::UpdateFileInfo()
 {
 	SetDlgItemTextW(IDC_SAMPLE_RATE, AfxFormattedW(IDS_DPCM_IMPORT_WAVE_FORMAT,
-		FormattedW(L"%i", m_iSamplesPerSec),
-		FormattedW(L"%i", m_iSampleSize * 8),
-		(m_iChannels == 2) ? L"Stereo" : L"Mono"));		// // //
+		FormattedW(L"%i", m_pEncoder->GetSampleRate()),
+		FormattedW(L"%i", m_pEncoder->GetBitsPerSample()),
+		(m_pEncoder->GetChannels() == 2) ? L"Stereo" : L"Mono"));		// // //
 
 	float base_freq = (float)MASTER_CLOCK_NTSC / (float)CDPCM::DMC_PERIODS_NTSC[m_iQuality];
 
@@ -326,205 +244,30 @@ void CPCMImport::UpdateFileInfo()
 }
 
 std::shared_ptr<ft0cc::doc::dpcm_sample> CPCMImport::GetSample() {		// // //
-	if (!m_pCachedSample || m_iCachedQuality != m_iQuality || m_iCachedVolume != m_iVolume) {
-		// // // Display wait cursor
-		CWaitCursor wait;
-
-		m_pCachedSample = ConvertFile();		// // //
-	}
-
-	m_iCachedQuality = m_iQuality;
-	m_iCachedVolume = m_iVolume;
-
-	return m_pCachedSample;
-}
-
-std::shared_ptr<ft0cc::doc::dpcm_sample> CPCMImport::ConvertFile() {		// // //
-	// Converts a WAV file to a DPCM sample
-	const int DMC_BIAS = 32;
+	// // // Display wait cursor, the encoder returns cached samples for known settings
+	CWaitCursor wait;
 
-	unsigned char DeltaAcc = 0;	// DPCM sample accumulator
-	int Delta = DMC_BIAS;		// Delta counter
-	int AccReady = 8;
-
-	float volume = powf(10, float(m_iVolume) / 20.0f);		// Convert dB to linear
-
-	// Seek to start of samples
-	m_fSampleFile.Seek(m_ullSampleStart, CFile::begin);
-
-	// Allocate space
-	std::vector<uint8_t> pSamples(ft0cc::doc::dpcm_sample::max_size);		// // //
-
-	// Determine resampling factor
-	float base_freq = (float)MASTER_CLOCK_NTSC / (float)CDPCM::DMC_PERIODS_NTSC[m_iQuality];
-	float resample_factor = base_freq / (float)m_iSamplesPerSec;
-
-	resampler resmpler(*m_psinc, resample_factor, m_iChannels, m_iSampleSize, m_iWaveSize, m_fSampleFile);
-	float val;
-	// Conversion
-	while (resmpler.get(val) && (pSamples.size() < ft0cc::doc::dpcm_sample::max_size)) {		// // //
-
-		// when resampling we must clip because of possible ringing.
-		const float MAX_AMP =  (1 << 16) - 1;
-		const float MIN_AMP = -(1 << 16) + 1; // just being symetric
-		val = std::clamp(val, MIN_AMP, MAX_AMP);
-
-		// Volume done this way so it acts as before
-		int Sample = (int)((val * volume) / 1024.f) + DMC_BIAS;
-
-		DeltaAcc >>= 1;
-
-		// PCM -> DPCM
-		if (Sample >= Delta) {
-			++Delta;
-			if (Delta > 63)
-				Delta = 63;
-			DeltaAcc |= 0x80;
-		}
-		else if (Sample < Delta) {
-			--Delta;
-			if (Delta < 0)
-				Delta = 0;
-		}
-
-		if (--AccReady == 0) {
-			// Store sample
-			pSamples.push_back(DeltaAcc);
-			AccReady = 8;
-		}
-	}
-
-	// TODO: error handling with th efile
-	// if (!resmpler.eof())
-	//      throw ?? or something else.
-
-	// Adjust sample until size is x * $10 + 1 bytes
-	while (pSamples.size() < ft0cc::doc::dpcm_sample::max_size && ((pSamples.size() & 0x0F) - 1) != 0)		// // //
-		pSamples.push_back(0xAA);
-
-	// Center end of sample (not yet working)
-#if 0
-	int CenterPos = (iSamples << 3) - 1;
-	while (Delta != DMC_BIAS && CenterPos > 0) {
-		if (Delta > DMC_BIAS) {
-			int BitPos = CenterPos & 0x07;
-			if ((pSamples[CenterPos >> 3] & (1 << BitPos)))
-				--Delta;
-			pSamples[CenterPos >> 3] = pSamples[CenterPos >> 3] & ~(1 << BitPos);
-		}
-		else if (Delta < DMC_BIAS) {
-			int BitPos = CenterPos & 0x07;
-			if ((pSamples[CenterPos >> 3] & (1 << BitPos)) == 0)
-				++Delta;
-			pSamples[CenterPos >> 3] = pSamples[CenterPos >> 3] | (1 << BitPos);
-		}
-		--CenterPos;
-	}
-#endif
-
-	// Return a sample object
-	return std::make_shared<ft0cc::doc::dpcm_sample>(std::move(pSamples), "");		// // //
+	return m_pEncoder->Encode(m_iQuality, m_iVolume, m_bTrellis ? dpcm_encode_mode_t::Trellis : dpcm_encode_mode_t::Direct);
 }
 
 bool CPCMImport::OpenWaveFile()
 {
-	// Open and read wave file header
-	PCMWAVEFORMAT WaveFormat = { };		// // //
-	char Header[4] = { };
-	bool Scanning = true;
-	bool WaveFormatFound = false;
-	bool ValidWave = false;
-	unsigned int BlockSize;
-	unsigned int FileSize;
-	CFileException ex;
-
-	m_iWaveSize = 0;
-	m_ullSampleStart = 0;
-
+	// // // Open and decode wave file
 	TRACE(L"DPCM import: Loading wave file %s...\n", (LPCWSTR)m_strPath);
 
-	if (!m_fSampleFile.Open(m_strPath, CFile::modeRead, &ex)) {
-		WCHAR szCause[255] = { };
-		ex.GetErrorMessage(szCause, std::size(szCause));
-		AfxMessageBox(FormattedW(L"Could not open file: %s", szCause));		// // //
-		return false;
-	}
-
-	m_fSampleFile.Read(Header, 4);
-
-	if (memcmp(Header, "RIFF", 4) != 0) {
-		// Invalid format
-		Scanning = false;
-		ValidWave = false;
-	}
-	else {
-		// Read file size
-		m_fSampleFile.Read(&FileSize, 4);
+	try {
+		m_pEncoder = CDPCMEncoder::FromFile((LPCWSTR)m_strPath);
 	}
-
-	// Now improved, should handle most files
-	while (Scanning) {
-		if (m_fSampleFile.Read(Header, 4) < 4) {
-			Scanning = false;
-			TRACE(L"DPCM import: End of file reached\n");
-		}
-
-		if (!memcmp(Header, "WAVE", 4)) {
-			ValidWave = true;
-		}
-		else if (Scanning) {
-			m_fSampleFile.Read(&BlockSize, 4);
-
-			if (!memcmp(Header, "fmt ", 4)) {
-				// Read the wave-format
-				TRACE(L"DPCM import: Found fmt block\n");
-				int ReadSize = BlockSize;
-				if (ReadSize > sizeof(PCMWAVEFORMAT))
-					ReadSize = sizeof(PCMWAVEFORMAT);
-
-				m_fSampleFile.Read(&WaveFormat, ReadSize);
-				m_fSampleFile.Seek(BlockSize - ReadSize, CFile::current);
-				WaveFormatFound = true;
-
-				if (WaveFormat.wf.wFormatTag != WAVE_FORMAT_PCM) {
-					// Invalid audio format
-					Scanning = false;
-					ValidWave = false;
-					TRACE(L"DPCM import: Unrecognized wave format (%i)\n", WaveFormat.wf.wFormatTag);
-				}
-
-			}
-			else if (!memcmp(Header, "data", 4)) {
-				// Actual wave-data, store the position
-				TRACE(L"DPCM import: Found data block\n");
-				m_iWaveSize = BlockSize;
-				m_ullSampleStart = m_fSampleFile.GetPosition();
-				m_fSampleFile.Seek(BlockSize, CFile::current);
-			}
-			else {
-				// Unrecognized block
-				TRACE(L"DPCM import: Unrecognized block %c%c%c%c\n", Header[0], Header[1], Header[2], Header[3]);
-				m_fSampleFile.Seek(BlockSize, CFile::current);
-			}
-		}
-	}
-
-	if (!ValidWave || !WaveFormatFound || m_iWaveSize == 0) {
+	catch (std::runtime_error &e) {
 		// Failed to load file properly, display error message and quit
-		TRACE(L"DPCM import: Unsupported or invalid wave file\n");
-		m_fSampleFile.Close();
+		TRACE(L"DPCM import: %S\n", e.what());
+		m_pEncoder.reset();
 		AfxMessageBox(IDS_DPCM_IMPORT_INVALID_WAVEFILE, MB_ICONEXCLAMATION);
 		return false;
 	}
 
-	// Save file info
-	m_iChannels		  = WaveFormat.wf.nChannels;
-	m_iSampleSize	  = WaveFormat.wf.nBlockAlign / WaveFormat.wf.nChannels;
-	m_iBlockAlign	  = WaveFormat.wf.nBlockAlign;
-	m_iAvgBytesPerSec = WaveFormat.wf.nAvgBytesPerSec;
-	m_iSamplesPerSec  = WaveFormat.wf.nSamplesPerSec;
-
-	TRACE(L"DPCM import: Scan done (%i Hz, %i bits, %i channels)\n", m_iSamplesPerSec, m_iSampleSize, m_iChannels);
+	TRACE(L"DPCM import: Scan done (%i Hz, %i bits, %i channels)\n",
+		m_pEncoder->GetSampleRate(), m_pEncoder->GetBitsPerSample(), m_pEncoder->GetChannels());
 
 	return true;
 }
@@ -25,14 +25,14 @@
 #include "stdafx.h"		// // //
 #include "../resource.h"		// // //
 #include <memory>		// // //
+#include <vector>		// // //
+#include "ft0cc/fs.h"		// // //
 
 namespace ft0cc::doc {
 class dpcm_sample;
 } // namespace ft0cc::doc
 
-namespace jarh {
-	class sinc;
-}
+class CDPCMEncoder;		// // //
 
 class CPCMImport : public CDialog
 {
@@ -45,36 +45,23 @@ public:
 // Dialog Data
 	enum { IDD = IDD_PCMIMPORT };
 
-	std::shared_ptr<ft0cc::doc::dpcm_sample> ShowDialog();		// // //
+	// // // Several files may be selected, the rest are converted with the settings chosen for the first one
+	std::vector<std::shared_ptr<ft0cc::doc::dpcm_sample>> ShowDialog();
 
 protected:
-	std::shared_ptr<ft0cc::doc::dpcm_sample> m_pImported;		// // //
-	std::shared_ptr<ft0cc::doc::dpcm_sample> m_pCachedSample;
+	std::vector<std::shared_ptr<ft0cc::doc::dpcm_sample>> m_Imported;		// // //
+	std::vector<fs::path> m_BatchPaths;		// // //
 
 	CStringW		m_strPath, m_strFileName;
-	CFile		m_fSampleFile;
-	ULONGLONG	m_ullSampleStart;
 
 	int m_iQuality;
 	int m_iVolume;
-	int m_iSampleSize;
-	int m_iChannels;
-	int m_iBlockAlign;
-	int m_iAvgBytesPerSec;
-	int m_iSamplesPerSec;
-	int m_iCachedQuality;
-	int m_iCachedVolume;
-	unsigned int m_iWaveSize;
+	bool m_bTrellis = false;		// // //
 
-	std::unique_ptr<jarh::sinc> m_psinc;		// // //
-
-protected:
-	static const int QUALITY_RANGE;
-	static const int VOLUME_RANGE;
+	std::unique_ptr<CDPCMEncoder> m_pEncoder;		// // //
 
 protected:
 	std::shared_ptr<ft0cc::doc::dpcm_sample> GetSample();		// // //
-	std::shared_ptr<ft0cc::doc::dpcm_sample> ConvertFile();
 
 	bool OpenWaveFile();
 	void UpdateFileInfo();
@@ -90,4 +77,5 @@ public:
 	afx_msg void OnBnClickedCancel();
 	afx_msg void OnBnClickedOk();
 	afx_msg void OnBnClickedPreview();
+	afx_msg void OnBnClickedTrellis();		// // //
 };
@@ -0,0 +1,362 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+#include "ParallelRenderer.h"
+#include "FamiTrackerModule.h"
+#include "SongView.h"
+#include "SongLengthScanner.h"
+#include "APU/APU.h"
+#include "APU/RegisterTrace.h"
+#include <algorithm>
+#include <future>
+#include <list>
+#include <optional>
+#include <tuple>
+
+namespace {
+
+// number of rows searched for the start of a frame
+constexpr unsigned MAX_FRAME_SEARCH = 256;
+
+// Reads the register writes of a trace frame by frame. A trace only records a DPCM sample when
+// it differs from the last recorded one, so sample events are folded into the writes to the
+// DPCM registers instead, which then compare equal in traces that began at different frames.
+class trace_reader_t {
+public:
+	struct event_t {
+		CRegisterTrace::event_type_t Type;
+		std::uint32_t Cycle;
+		std::uint16_t Address = 0;
+		std::uint8_t Value = 0;
+		const ft0cc::doc::dpcm_sample *pSample = nullptr;
+
+		bool operator==(const event_t &other) const {
+			return std::tie(Type, Cycle, Address, Value, pSample) ==
+				std::tie(other.Type, other.Cycle, other.Address, other.Value, other.pSample);
+		}
+	};
+
+	trace_reader_t(const CRegisterTrace &trace, std::uint64_t Frame) : trace_(&trace), frame_(Frame) {
+	}
+
+	std::uint64_t GetFrame() const {
+		return frame_;
+	}
+
+	// Reads the events of the next frame, returns false if the trace ends before the frame does
+	bool ReadFrame(std::vector<event_t> &Events) {
+		Events.clear();
+		std::uint32_t Cycle = 0;
+		for (CRegisterTrace::event_t Event; trace_->ReadEvent(pos_, Event); ) {
+			Cycle += Event.Delta;
+			switch (Event.Type) {
+			case CRegisterTrace::event_type_t::sample:
+				sample_ = trace_->GetSample(Event.Sample).get();
+				break;
+			case CRegisterTrace::event_type_t::write:
+				Events.push_back({Event.Type, Cycle, Event.Address, Event.Value,
+					Event.Address >= 0x4010 && Event.Address <= 0x4015 ? sample_ : nullptr});
+				break;
+			case CRegisterTrace::event_type_t::end_frame:
+				Events.push_back({Event.Type, Cycle});
+				++frame_;
+				return true;
+			default:
+				Events.push_back({Event.Type, Cycle});
+			}
+		}
+		return false;
+	}
+
+	void SkipTo(std::uint64_t Frame) {
+		std::vector<event_t> Events;
+		while (frame_ < Frame && ReadFrame(Events))
+			;
+	}
+
+private:
+	const CRegisterTrace *trace_;
+	std::size_t pos_ = 0;
+	std::uint64_t frame_;
+	const ft0cc::doc::dpcm_sample *sample_ = nullptr;
+};
+
+struct segment_t {
+	std::unique_ptr<CHeadlessPlayer> pPlayer;
+	std::uint64_t Checkpoint = 0;		// frame at which the player starts
+	std::uint64_t Begin = 0;		// first frame of the segment
+	std::uint64_t End = 0;		// end of the segment including the overlap
+	std::uint64_t SeamEnd = 0;		// end of the overlap with the previous segment
+	std::vector<int16_t> Samples;		// audio from Begin onwards
+	std::vector<std::size_t> FrameEnds;
+	apu_state_t SeamState;		// APU state at SeamEnd
+	apu_state_t EndState;		// APU state after the last rendered frame
+	bool Halted = false;
+	bool Exact = false;		// the player started at the beginning of the song
+	std::promise<std::optional<CHeadlessPlayer::checkpoint_t>> Start;		// set by the scout
+	CRegisterTrace Trace;		// writes from the checkpoint onwards, unless Exact
+	std::optional<trace_reader_t> Writes;
+
+	std::uint64_t GetRenderedEnd() const {
+		return Begin + FrameEnds.size();
+	}
+	std::size_t GetFrameBegin(std::uint64_t Frame) const {
+		return Frame > Begin ? FrameEnds[Frame - Begin - 1] : 0;
+	}
+};
+
+// Playback index of the first row at or after the given index that starts a frame
+unsigned FindFrameStart(const CTempoTimeline &timeline, unsigned Index) {
+	for (unsigned i = 0; i < MAX_FRAME_SEARCH; ++i)
+		if (timeline.GetPosition(Index + i).Row == 0)
+			return Index + i;
+	return Index;
+}
+
+// Tick of the row being played at the given tick, or of the start of its frame if it is near
+std::uint64_t FindCheckpoint(const CTempoTimeline &timeline, std::uint64_t Tick) {
+	unsigned Index = timeline.GetIndex(Tick);
+	for (unsigned i = 0; i < MAX_FRAME_SEARCH && Index > 0; ++i, --Index)
+		if (timeline.GetPosition(Index).Row == 0)
+			return timeline.GetTick(Index);
+	return timeline.GetTick(timeline.GetIndex(Tick));
+}
+
+// First frame of each segment
+std::vector<std::uint64_t> SplitSong(const CTempoTimeline &timeline, std::uint64_t Ticks, unsigned Segments, unsigned MinLength) {
+	// a song that halts is never played past its end
+	auto [Intro, Loop] = timeline.GetTickCount();
+	const std::uint64_t Length = Loop ? Ticks : std::min(Ticks, Intro);
+
+	std::vector<std::uint64_t> Begins {0};
+	for (unsigned i = 1; i < Segments; ++i) {
+		std::uint64_t Tick = timeline.GetTick(FindFrameStart(timeline, timeline.GetIndex(Length * i / Segments)));
+		if (Tick >= Begins.back() + MinLength && Tick + MinLength <= Length)
+			Begins.push_back(Tick);
+	}
+	return Begins;
+}
+
+// Fast-forwards through the song, handing every segment its checkpoint, and records the
+// register writes of the whole song
+void RunScout(CHeadlessPlayer &player, CRegisterTrace &trace, unsigned Track, std::vector<segment_t> &segs,
+	std::uint64_t Ticks, const std::atomic<bool> &Cancel)
+{
+	player.GetAPU().SetRegisterTrace(&trace);
+	player.StartPlayer(Track);
+	bool Playing = true;
+	auto SkipTo = [&] (std::uint64_t Tick) {
+		while (Playing && !Cancel && player.GetFrameCount() < Tick)
+			Playing = player.SkipTick(player.GetFrameCount() + 1);
+		return Playing && !Cancel;
+	};
+	for (auto &seg : segs)
+		if (!seg.Exact)
+			seg.Start.set_value(SkipTo(seg.Checkpoint) ? std::optional {player.SaveCheckpoint()} : std::nullopt);
+	SkipTo(Ticks);
+	player.GetAPU().SetRegisterTrace(nullptr);
+}
+
+void PlaySegment(segment_t &seg, std::uint64_t End, std::atomic<std::uint64_t> &Rendered, const std::atomic<bool> &Cancel) {
+	while (!seg.Halted && !Cancel && seg.GetRenderedEnd() < End) {
+		seg.Halted = !seg.pPlayer->RenderFrame();
+		const auto &audio = seg.pPlayer->GetFrameAudio();
+		seg.Samples.insert(seg.Samples.end(), audio.begin(), audio.end());
+		seg.FrameEnds.push_back(seg.Samples.size());
+		if (seg.GetRenderedEnd() == seg.SeamEnd)
+			seg.pPlayer->GetAPU().SaveState(seg.SeamState);
+		++Rendered;
+	}
+	seg.EndState.clear();
+	seg.pPlayer->GetAPU().SaveState(seg.EndState);
+}
+
+void RenderSegment(segment_t &seg, unsigned Track, std::atomic<std::uint64_t> &Rendered, const std::atomic<bool> &Cancel) {
+	auto &player = *seg.pPlayer;
+	if (seg.Exact)
+		player.StartPlayer(Track);
+	else {
+		player.GetAPU().SetRegisterTrace(&seg.Trace);
+		auto Start = seg.Start.get_future().get();
+		seg.Halted = !Start || !player.LoadCheckpoint(Track, *Start) || !player.SeekTick(seg.Begin);
+	}
+	PlaySegment(seg, seg.End, Rendered, Cancel);
+}
+
+// The seam matches if both segments rendered the overlap completely with the same audio, and
+// if the APU state of the previous segment, which ends at the seam, is that of the next one
+bool MatchSeam(const segment_t &prev, const segment_t &next, std::uint64_t End) {
+	if (prev.GetRenderedEnd() != End || next.GetRenderedEnd() < End || prev.EndState != next.SeamState)
+		return false;
+	for (std::uint64_t f = next.Begin; f < End; ++f)
+		if (prev.FrameEnds[f - prev.Begin] - prev.GetFrameBegin(f) != next.FrameEnds[f - next.Begin] - next.GetFrameBegin(f))
+			return false;
+	auto it = prev.Samples.begin();
+	return std::equal(it + prev.GetFrameBegin(next.Begin), it + prev.GetFrameBegin(End),
+		next.Samples.begin(), next.Samples.begin() + next.GetFrameBegin(End));
+}
+
+// Compares the register writes of a segment with those of the scout from the given frame up to
+// the end of the segment, returns the first frame that differs or the end of the segment
+std::uint64_t MatchWrites(segment_t &seg, trace_reader_t &scout, std::uint64_t From) {
+	auto &writes = *seg.Writes;
+	writes.SkipTo(From);
+	scout.SkipTo(From);
+	if (writes.GetFrame() != From || scout.GetFrame() != From)
+		return From;
+
+	std::vector<trace_reader_t::event_t> Events, ScoutEvents;
+	for (std::uint64_t f = From; f < seg.GetRenderedEnd(); ++f) {
+		const bool Found = writes.ReadFrame(Events);
+		if (Found != scout.ReadFrame(ScoutEvents) || Events != ScoutEvents)
+			return f;
+		if (!Found)
+			break;
+	}
+	return seg.GetRenderedEnd();
+}
+
+// Appends the frames of a segment that are not yet in the output, up to the given frame
+void AppendFrames(CParallelRenderer::rendered_audio_t &out, const segment_t &seg, std::uint64_t End) {
+	const std::uint64_t Begin = std::clamp<std::uint64_t>(out.FrameEnds.size(), seg.Begin, seg.GetRenderedEnd());
+	End = std::clamp(End, Begin, seg.GetRenderedEnd());
+	const std::size_t First = seg.GetFrameBegin(Begin);
+	const std::size_t Base = out.Samples.size();
+	for (std::uint64_t f = Begin; f < End; ++f)
+		out.FrameEnds.push_back(Base + seg.FrameEnds[f - seg.Begin] - First);
+	out.Samples.insert(out.Samples.end(), seg.Samples.begin() + First, seg.Samples.begin() + seg.GetFrameBegin(End));
+}
+
+} // namespace
+
+CParallelRenderer::CParallelRenderer(const CFamiTrackerModule &modfile, unsigned Track, unsigned SampleRate,
+	CHeadlessPlayer::mixer_settings_t Mixer) :
+	modfile_(modfile), track_(Track), sample_rate_(SampleRate), mixer_(std::move(Mixer))
+{
+}
+
+CParallelRenderer::~CParallelRenderer() {
+}
+
+void CParallelRenderer::SetWarmup(unsigned Warmup, unsigned Overlap) {
+	warmup_ = Warmup;
+	overlap_ = std::max(Overlap, 1u);
+}
+
+CParallelRenderer::rendered_audio_t CParallelRenderer::Render(std::uint64_t Ticks, unsigned Segments) {
+	seams_ = rejected_ = 0;
+	rendered_ = 0;
+
+	auto pTimeline = CTempoTimeline::Get(modfile_, *modfile_.MakeSongView(track_, false));
+	const auto &timeline = *pTimeline;
+	auto Begins = SplitSong(timeline, Ticks, std::max(Segments, 1u), warmup_ + overlap_);
+
+	// players are created here as the VRC7 emulator initializes shared tables
+	auto MakePlayer = [&] {
+		return std::make_unique<CHeadlessPlayer>(modfile_, sample_rate_, mixer_);
+	};
+
+	std::vector<segment_t> segs(Begins.size());
+	for (std::size_t i = 0; i < segs.size(); ++i) {
+		auto &seg = segs[i];
+		seg.pPlayer = MakePlayer();
+		seg.Begin = Begins[i];
+		seg.End = i + 1 < segs.size() ? Begins[i + 1] + overlap_ : Ticks;
+		seg.SeamEnd = i ? seg.Begin + overlap_ : 0;
+		seg.Exact = !i;
+		seg.Checkpoint = i ? FindCheckpoint(timeline, seg.Begin - std::min<std::uint64_t>(seg.Begin, warmup_)) : 0;
+		seg.Writes.emplace(seg.Trace, seg.Checkpoint);
+	}
+
+	auto pScout = MakePlayer();
+	CRegisterTrace ScoutTrace;
+	std::vector<std::future<void>> tasks;
+	tasks.push_back(std::async(std::launch::async, [&] {
+		RunScout(*pScout, ScoutTrace, track_, segs, Ticks, cancel_);
+	}));
+	for (auto &seg : segs)
+		tasks.push_back(std::async(std::launch::async, [&] {
+			RenderSegment(seg, track_, rendered_, cancel_);
+		}));
+	for (auto &task : tasks)
+		task.get();
+	pScout.reset();
+
+	// the previous segment is always identical to a serial render
+	rendered_audio_t out;
+	trace_reader_t ScoutWrites {ScoutTrace, 0};
+	std::list<segment_t> fallbacks;
+	segment_t *prev = &segs.front();
+	for (std::size_t i = 1; i < segs.size(); ++i) {
+		auto &next = segs[i];
+		if (prev->Halted && prev->GetRenderedEnd() <= next.Begin)
+			break;
+		++seams_;
+		const std::uint64_t SeamEnd = next.Begin + overlap_;
+		if (auto Writes = ScoutWrites; MatchSeam(*prev, next, SeamEnd) && MatchWrites(next, Writes, SeamEnd) == next.GetRenderedEnd()) {
+			ScoutWrites = Writes;
+			AppendFrames(out, *prev, SeamEnd);
+			prev->pPlayer.reset();
+			prev->Samples.clear();
+			prev = &next;
+			continue;
+		}
+
+		++rejected_;
+		const std::uint64_t From = prev->GetRenderedEnd();
+		PlaySegment(*prev, next.End, rendered_, cancel_);
+		if (!prev->Exact)
+			if (std::uint64_t Diverged = MatchWrites(*prev, ScoutWrites, From); Diverged < prev->GetRenderedEnd()) {
+				AppendFrames(out, *prev, Diverged);
+				prev->pPlayer.reset();
+				auto &seg = fallbacks.emplace_back();
+				seg.pPlayer = MakePlayer();
+				seg.Begin = Diverged;
+				seg.End = next.End;
+				seg.Exact = true;
+				seg.pPlayer->StartPlayer(track_);
+				seg.Halted = !seg.pPlayer->SeekTick(seg.Begin);
+				PlaySegment(seg, seg.End, rendered_, cancel_);
+				prev = &seg;
+			}
+		next.pPlayer.reset();
+	}
+	AppendFrames(out, *prev, Ticks);
+
+	return out;
+}
+
+void CParallelRenderer::Cancel() {
+	cancel_ = true;
+}
+
+std::uint64_t CParallelRenderer::GetRenderedTicks() const {
+	return rendered_;
+}
+
+unsigned CParallelRenderer::GetSeamCount() const {
+	return seams_;
+}
+
+unsigned CParallelRenderer::GetRejectedSeamCount() const {
+	return rejected_;
+}
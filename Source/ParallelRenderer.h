@@ -0,0 +1,95 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+#pragma once
+
+#include "HeadlessPlayer.h"
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+class CFamiTrackerModule;
+
+// // // Renders one song on several threads. The song is split into segments that start at
+// frame boundaries, each played by its own CHeadlessPlayer. A scout player fast-forwards
+// through the song without audio (see CHeadlessPlayer::SkipTick), saving a checkpoint at the
+// start of a frame some frames before each segment. The player of a segment starts at that
+// checkpoint with the chips restored from it and the sound driver restored from the song's
+// CSongState checkpoints, renders silently up to its segment so that running notes, the VRC7
+// and the mixer catch up, and renders its segment followed by a few frames that overlap the
+// next segment. A seam is accepted only if the next segment reproduces the whole overlap
+// exactly, if its APU state at the end of the overlap, including every chip's registers,
+// counters and sequencers (see CAPU::SaveState), is identical to that of the previous segment,
+// and if its register writes up to the end of the segment are those of the scout, which plays
+// the song from the beginning; the sound driver never reads from the chips, so the scout
+// writes the same registers as a full render. Otherwise the player of the previous segment
+// continues through the next one, and if its own writes then differ from the scout's, a new
+// player renders the rest from the beginning of the song, so the audio is always that of a
+// serial render.
+class CParallelRenderer {
+public:
+	static constexpr unsigned DEFAULT_WARMUP_TICKS = 600;
+	static constexpr unsigned DEFAULT_OVERLAP_TICKS = 60;
+
+	struct rendered_audio_t {
+		std::vector<int16_t> Samples;
+		std::vector<std::size_t> FrameEnds;		// end of each frame in Samples
+	};
+
+	CParallelRenderer(const CFamiTrackerModule &modfile, unsigned Track, unsigned SampleRate = CHeadlessPlayer::DEFAULT_SAMPLE_RATE,
+		CHeadlessPlayer::mixer_settings_t Mixer = { });
+	~CParallelRenderer();
+
+	// Sets the number of frames played silently before each segment, and the number of
+	// frames by which consecutive segments overlap
+	void SetWarmup(unsigned Warmup, unsigned Overlap);
+
+	// Renders the given number of frames from the start of the song, or until the song halts,
+	// splitting it into at most the given number of segments
+	rendered_audio_t Render(std::uint64_t Ticks, unsigned Segments);
+
+	// Stops the current and any later render, which return incomplete audio; may be called
+	// from any thread
+	void Cancel();
+	// Number of frames rendered so far, including the overlaps and the frames rendered again
+	// after a rejected seam; may be called from any thread
+	std::uint64_t GetRenderedTicks() const;
+
+	// Number of seams between the segments of the last render, and how many of them were
+	// rejected
+	unsigned GetSeamCount() const;
+	unsigned GetRejectedSeamCount() const;
+
+private:
+	const CFamiTrackerModule &modfile_;
+	unsigned track_;
+	unsigned sample_rate_;
+	CHeadlessPlayer::mixer_settings_t mixer_;
+	unsigned warmup_ = DEFAULT_WARMUP_TICKS;
+	unsigned overlap_ = DEFAULT_OVERLAP_TICKS;
+	unsigned seams_ = 0;
+	unsigned rejected_ = 0;
+	std::atomic<bool> cancel_ = false;
+	std::atomic<std::uint64_t> rendered_ = 0;
+};
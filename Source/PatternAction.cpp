@@ -302,6 +302,16 @@ void CPActionEditNote::Redo(CMainFrame &MainFrm)
 
 
 
+void CPActionEditNote::UpdateViews(CMainFrame &MainFrm) const		// // //
+{
+	// Only one cell has changed
+	const CCursorPos &Cursor = m_pUndoState->Cursor;
+	GET_PATTERN_EDITOR()->InvalidateCell(Cursor.Ypos.Frame, Cursor.Ypos.Row, Cursor.Xpos.Track);
+	MainFrm.GetActiveDocument()->UpdateAllViews(NULL, UPDATE_CELL);
+}
+
+
+
 CPActionReplaceNote::CPActionReplaceNote(const stChanNote &Note, int Frame, int Row, int Channel) :
 	m_NewNote(Note), m_iFrame(Frame), m_iRow(Row), m_iChannel(Channel)
 {
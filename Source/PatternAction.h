@@ -127,6 +127,7 @@ private:
 	bool SaveState(const CMainFrame &MainFrm) override;
 	void Undo(CMainFrame &MainFrm) override;
 	void Redo(CMainFrame &MainFrm) override;
+	void UpdateViews(CMainFrame &MainFrm) const override;		// // //
 
 	stChanNote m_NewNote, m_OldNote;
 };
@@ -22,14 +22,24 @@
 
 #include "PatternData.h"
 #include <type_traits>
+#include <atomic>
 
 namespace {
 
 const auto BLANK = stChanNote { };
 
+std::atomic<std::uint64_t> g_iPatternVersion {0u};		// // //
+
 } // namespace
 
 CPatternData::CPatternData(const CPatternData &other) : data_(std::make_unique<elem_t>(*other.data_)) {
+	Touch();
+}
+
+CPatternData::CPatternData(CPatternData &&other) noexcept :
+	data_(std::move(other.data_)), version_(other.version_)
+{
+	other.Touch();
 }
 
 CPatternData &CPatternData::operator=(const CPatternData &other) {
@@ -40,12 +50,23 @@ CPatternData &CPatternData::operator=(const CPatternData &other) {
 		}
 		else
 			data_.reset();
+		Touch();
+	}
+	return *this;
+}
+
+CPatternData &CPatternData::operator=(CPatternData &&other) noexcept {
+	if (this != &other) {
+		data_ = std::move(other.data_);
+		version_ = other.version_;
+		other.Touch();
 	}
 	return *this;
 }
 
 stChanNote &CPatternData::GetNoteOn(unsigned row) {
 	Allocate();
+	Touch();
 	return (*data_)[row];
 }
 
@@ -55,6 +76,7 @@ const stChanNote &CPatternData::GetNoteOn(unsigned row) const {
 
 void CPatternData::SetNoteOn(unsigned row, const stChanNote &note) {
 	Allocate();
+	Touch();
 	(*data_)[row] = note;
 }
 
@@ -107,6 +129,14 @@ bool CPatternData::IsEmpty() const {
 	return true;
 }
 
+std::uint64_t CPatternData::GetVersion() const noexcept {
+	return version_;
+}
+
+void CPatternData::Touch() noexcept {
+	version_ = ++g_iPatternVersion;
+}
+
 void CPatternData::Allocate() {
 	if (!data_)
 		data_ = std::make_unique<elem_t>();
@@ -25,6 +25,7 @@
 
 #include <memory>
 #include <array>
+#include <cstdint>
 #include "PatternNote.h"
 
 class stChanNote;
@@ -37,9 +38,9 @@ class CPatternData {
 public:
 	CPatternData() = default;
 	CPatternData(const CPatternData &other);
-	CPatternData(CPatternData &&other) noexcept = default;
+	CPatternData(CPatternData &&other) noexcept;
 	CPatternData &operator=(const CPatternData &other);
-	CPatternData &operator=(CPatternData &&other) noexcept = default;
+	CPatternData &operator=(CPatternData &&other) noexcept;
 	~CPatternData() noexcept = default;
 
 	stChanNote &GetNoteOn(unsigned row);
@@ -54,6 +55,10 @@ public:
 	unsigned GetNoteCount(int maxrows = max_size) const;
 	bool IsEmpty() const;
 
+	// // // changes whenever the pattern may have been modified; unique across all patterns,
+	// except that patterns which were never written to all return 0
+	std::uint64_t GetVersion() const noexcept;
+
 	// void (*F)(stChanNote &note p [, unsigned row])
 	template <typename F>
 	void VisitRows(F f) {
@@ -69,6 +74,7 @@ public:
 	template <typename F>
 	void VisitRows(unsigned rows, F f) {
 		if (data_) {
+			Touch();
 			for (unsigned row = 0; row < rows; ++row)
 				if constexpr (std::is_invocable_v<F, stChanNote &>)
 					f((*data_)[row]);
@@ -90,8 +96,10 @@ public:
 
 private:
 	void Allocate();
+	void Touch() noexcept;		// // //
 
 private:
 	using elem_t = std::array<stChanNote, max_size>;
 	std::unique_ptr<elem_t> data_;
+	std::uint64_t version_ = 0;		// // //
 };
@@ -193,6 +193,7 @@ CPatternEditor::CPatternEditor() :
 	m_iLastFrame(0),
 	m_iLastFirstChannel(0),
 	m_iLastPlayRow(0),
+	m_iLastPlayFrame(0),		// // //
 	m_iPlayRow(0),
 	m_iPlayFrame(0),
 	m_iPatternWidth(0),
@@ -269,6 +270,7 @@ void CPatternEditor::ApplyColorScheme()
 	CalcLayout();
 
 	// Create pattern font
+	m_GlyphCache.Clear();		// // //
 	if (m_fontPattern.m_hObject != NULL)
 		m_fontPattern.DeleteObject();
 	m_fontPattern.CreateFontW(-m_iPatternFontSize, 0, 0, 0, FW_DONTCARE, FALSE, FALSE, FALSE, ANSI_CHARSET,
@@ -365,6 +367,20 @@ void CPatternEditor::InvalidateHeader()
 	m_bHeaderInvalidated = true;
 }
 
+void CPatternEditor::InvalidateRow(int Frame, int Row)		// // //
+{
+	// A single row has changed, e.g. the play cursor moved
+	m_DirtyCells.push_back({Frame, Row, -1, 0u});
+}
+
+void CPatternEditor::InvalidateCell(int Frame, int Row, int Channel)		// // //
+{
+	// A single note has changed, this also repaints the same pattern in preview frames
+	int f = Frame % GetFrameCount();
+	if (f < 0) f += GetFrameCount();
+	m_DirtyCells.push_back({f, Row, Channel, m_pView->GetSongView()->GetFramePattern(Channel, f)});
+}
+
 void CPatternEditor::UpdatePatternLength()
 {
 	m_iPatternLength = GetCurrentPatternLength(GetFrame());
@@ -423,10 +439,11 @@ void CPatternEditor::DrawScreen(CDC &DC, CFamiTrackerView *pView)
 		bQuickRedraw = false;
 	}
 
-	if (m_iLastPlayRow != m_iPlayRow) {
-		if (FTEnv.GetSoundGenerator()->IsPlaying() && !m_bFollowMode) {
-			bDrawPattern = true;		// // //
-			bQuickRedraw = false;
+	if (m_iLastPlayRow != m_iPlayRow || m_iLastPlayFrame != m_iPlayFrame) {		// // //
+		// Only the rows under the old and new play cursor need to be repainted
+		if (!(FTEnv.GetSoundGenerator()->IsPlaying() && m_bFollowMode)) {
+			InvalidateRow(m_iLastPlayFrame, m_iLastPlayRow);
+			InvalidateRow(m_iPlayFrame, m_iPlayRow);
 		}
 	}
 
@@ -436,6 +453,13 @@ void CPatternEditor::DrawScreen(CDC &DC, CFamiTrackerView *pView)
 		bQuickRedraw = false;
 	}
 
+	// // // Individual rows
+	if (!m_DirtyCells.empty()) {
+		bDrawPattern = true;
+		if (bQuickRedraw)
+			ResolveDirtyLines();
+	}
+
 	if (bDrawPattern) {
 
 		// Wrap arounds
@@ -468,6 +492,7 @@ void CPatternEditor::DrawScreen(CDC &DC, CFamiTrackerView *pView)
 	m_iLastFrame = GetFrame();		// // //
 	m_iLastFirstChannel = m_iFirstChannel;
 	m_iLastPlayRow = m_iPlayRow;
+	m_iLastPlayFrame = m_iPlayFrame;		// // //
 
 	//
 	// Draw pattern header, when needed
@@ -486,6 +511,8 @@ void CPatternEditor::DrawScreen(CDC &DC, CFamiTrackerView *pView)
 	m_bBackgroundInvalidated = false;
 	m_bHeaderInvalidated = false;
 	m_bSelectionInvalidated = false;
+	m_DirtyCells.clear();		// // //
+	m_DirtyLines.clear();
 
 	//
 	// Blit to visible surface
@@ -888,19 +915,11 @@ void CPatternEditor::PerformQuickRedraw(CDC &DC)
 
 	ScrollPatternArea(DC, DiffRows);
 
-	// Play cursor
-	if (FTEnv.GetSoundGenerator()->IsPlaying() && !m_bFollowMode) {
-		//PrintRow(DC, m_iPlayRow,
-	}
-	else if (!FTEnv.GetSoundGenerator()->IsPlaying() && m_iLastPlayRow != -1) {
-		if (m_iPlayFrame == GetFrame()) {
-			int Line = RowToLine(m_iLastPlayRow);
-			if (Line >= 0 && Line <= m_iLinesVisible) {
-				// Erase
-				PrintRow(DC, m_iLastPlayRow, Line, GetFrame());
-			}
-		}
-	}
+	// // // Rows invalidated individually, including the play cursor
+	const int FirstRow = m_iCenterRow - m_iLinesVisible / 2;
+	for (int i = 0, n = static_cast<int>(m_DirtyLines.size()); i < n; ++i)
+		if (m_DirtyLines[i].any())
+			PrintRow(DC, FirstRow + i, i, GetFrame(), &m_DirtyLines[i]);
 
 	// Restore
 	DC.SetWindowOrg(0, 0);
@@ -911,14 +930,23 @@ void CPatternEditor::PerformQuickRedraw(CDC &DC)
 	++m_iQuickRedraws;
 }
 
-void CPatternEditor::PrintRow(CDC &DC, int Row, int Line, int Frame) const
+void CPatternEditor::PrintRow(CDC &DC, int Row, int Line, int Frame, const channel_mask_t *pChannels) const
 {
-	const int FrameCount = GetFrameCount();		// // //
+	const int CurrentFrame = Frame;		// // //
+	if (GetPreviewRow(Row, Frame))
+		DrawRow(DC, Row, Line, Frame, Frame != CurrentFrame, pChannels);
+	else
+		ClearRow(DC, Line);
+}
+
+bool CPatternEditor::GetPreviewRow(int &Row, int &Frame) const		// // //
+{
+	// Moves a row outside the pattern of Frame into the frame it is previewed from,
+	// returns false if the row is not displayed at all
 	const int rEnd = (FTEnv.GetSoundGenerator()->IsPlaying() && m_bFollowMode) ? std::max(m_iPlayRow + 1, m_iPatternLength) : m_iPatternLength;
-	if (Row >= 0 && Row < rEnd) {
-		DrawRow(DC, Row, Line, Frame, false);
-	}
-	else if (FTEnv.GetSettings()->General.bFramePreview) {
+	if (Row >= 0 && Row < rEnd)
+		return true;
+	if (FTEnv.GetSettings()->General.bFramePreview) {
 		if (Row >= rEnd) { // first frame
 			Row -= rEnd;
 			++Frame;
@@ -937,10 +965,36 @@ void CPatternEditor::PrintRow(CDC &DC, int Row, int Line, int Frame) const
 			}*/
 			Row += GetCurrentPatternLength(--Frame);
 		}
-		DrawRow(DC, Row, Line, Frame, true);
+		return true;
 	}
-	else {
-		ClearRow(DC, Line);
+	return false;
+}
+
+void CPatternEditor::ResolveDirtyLines()		// // //
+{
+	// Maps the rows passed to InvalidateRow / InvalidateCell to visible lines
+	const CSongView *pSongView = m_pView->GetSongView();
+	const int Frames = GetFrameCount();
+	const int FirstRow = m_iCenterRow - m_iLinesVisible / 2;
+
+	m_DirtyLines.assign(m_iLinesVisible, channel_mask_t { });
+	for (int i = 0; i < m_iLinesVisible; ++i) {
+		int Row = FirstRow + i;
+		int Frame = GetFrame();
+		if (!GetPreviewRow(Row, Frame))
+			continue;
+		int f = Frame % Frames;
+		if (f < 0) f += Frames;
+		for (const auto &Cell : m_DirtyCells) {
+			if (Cell.Row != Row)
+				continue;
+			if (Cell.Channel == -1) {
+				if (Cell.Frame == f)
+					m_DirtyLines[i].set();
+			}
+			else if (pSongView->GetFramePattern(Cell.Channel, f) == Cell.Pattern)
+				m_DirtyLines[i].set(Cell.Channel);
+		}
 	}
 }
 
@@ -1053,7 +1107,7 @@ bool CPatternEditor::IsInRange(const CSelection &sel, int Frame, int Row, int Ch
 }
 
 // Draw a single row
-void CPatternEditor::DrawRow(CDC &DC, int Row, int Line, int Frame, bool bPreview) const
+void CPatternEditor::DrawRow(CDC &DC, int Row, int Line, int Frame, bool bPreview, const channel_mask_t *pChannels) const		// // //
 {
 	// Row is row from pattern to display
 	// Line is (absolute) screen line
@@ -1186,6 +1240,11 @@ void CPatternEditor::DrawRow(CDC &DC, int Row, int Line, int Frame, bool bPrevie
 
 	// Draw channels
 	for (int i = m_iFirstChannel; i < m_iFirstChannel + m_iChannelsVisible; ++i) {
+		if (pChannels && !pChannels->test(i)) {		// // //
+			OffsetX += m_iChannelWidths[i];
+			continue;
+		}
+
 		int f = Frame % GetFrameCount();
 		if (f < 0) f += GetFrameCount();
 
@@ -1673,8 +1732,7 @@ void CPatternEditor::DrawRegisters(CDC &DC) {		// // //
 // Draws a colored character
 void CPatternEditor::DrawChar(CDC &DC, int x, int y, WCHAR c, COLORREF Color) const
 {
-	DC.SetTextColor(Color);
-	DC.TextOutW(x, y, &c, 1);
+	m_GlyphCache.DrawChar(DC, x, y, c, Color);		// // //
 	++m_iCharsDrawn;
 }
 
@@ -3529,9 +3587,9 @@ CStringW CPatternEditor::GetSelectionAsText() const {		// // //
 			auto RowString = CTextExport::ExportCellText(NoteData, pSongView->GetEffectColumnCount(i),
 				IsAPUNoise(pSongView->GetChannelOrder().TranslateChannel(i)));
 			if (i == b.m_iChannel) for (unsigned c = 0; c < value_cast(BegCol); ++c)
-				for (int j = 0; j < COLUMN_CHAR_LEN[c]; ++j) RowString.SetAt(COLUMN_CHAR_POS[c] + j, ' ');
+				for (int j = 0; j < COLUMN_CHAR_LEN[c]; ++j) RowString[COLUMN_CHAR_POS[c] + j] = ' ';		// // //
 			if (i == e.m_iChannel && EndCol < column_t::Effect4)
-				RowString = RowString.Left(COLUMN_CHAR_POS[value_cast(EndCol) + 1] - 1);
+				RowString = RowString.substr(0, COLUMN_CHAR_POS[value_cast(EndCol) + 1] - 1);		// // //
 			AppendFormatW(line, L" : %s", conv::to_wide(RowString).data());
 		}
 		str.Append(line);
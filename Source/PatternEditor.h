@@ -27,10 +27,13 @@
 
 #include "stdafx.h"		// // //
 #include <memory>		// // //
+#include <vector>		// // //
+#include <bitset>		// // //
 #include "Common.h"
 #include "PatternEditorTypes.h"
 #include "SongData.h"		// // //
 #include "APU/Types.h"		// // //
+#include "PatternGlyphCache.h"		// // //
 
 // Row color cache
 struct RowColorInfo_t {
@@ -70,6 +73,8 @@ public:
 	void InvalidateCursor();
 	void InvalidateBackground();
 	void InvalidateHeader();
+	void InvalidateRow(int Frame, int Row);		// // //
+	void InvalidateCell(int Frame, int Row, int Channel);		// // //
 
 	// Drawing
 	void DrawScreen(CDC &DC, CFamiTrackerView *pView);	// Draw pattern area
@@ -221,12 +226,17 @@ private:
 	void DrawUnbufferedArea(CDC &DC);
 	void DrawHeader(CDC &DC);
 
+	// // // Dirty rows, one bit per channel
+	using channel_mask_t = std::bitset<CHANID_COUNT>;
+
 	// Helper draw methods
 	void MovePatternArea(CDC &DC, int FromRow, int ToRow, int NumRows) const;
 	void ScrollPatternArea(CDC &DC, int Rows) const;
 	void ClearRow(CDC &DC, int Line) const;
-	void PrintRow(CDC &DC, int Row, int Line, int Frame) const;
-	void DrawRow(CDC &DC, int Row, int Line, int Frame, bool bPreview) const;
+	void PrintRow(CDC &DC, int Row, int Line, int Frame, const channel_mask_t *pChannels = nullptr) const;		// // //
+	void DrawRow(CDC &DC, int Row, int Line, int Frame, bool bPreview, const channel_mask_t *pChannels = nullptr) const;		// // //
+	bool GetPreviewRow(int &Row, int &Frame) const;		// // //
+	void ResolveDirtyLines();		// // //
 	// // //
 	void DrawCell(CDC &DC, int PosX, cursor_column_t Column, int Channel, bool bInvert,
 		const stChanNote &NoteData, const RowColorInfo_t &ColorInfo) const;		// // //
@@ -333,6 +343,7 @@ private:
 	int		m_iLastFrame;					// Previous frame
 	int		m_iLastFirstChannel;			// Previous first visible channel
 	int		m_iLastPlayRow;					// Previous play row
+	int		m_iLastPlayFrame;				// // // Previous play frame
 
 	// Play cursor
 	int		m_iPlayRow;
@@ -358,6 +369,18 @@ private:
 	int		m_iChannelOffsets[CHANID_COUNT] = { };		// Cached x position of channels
 	cursor_column_t	m_iColumns[CHANID_COUNT]; // // // Cached *index of rightmost column* in each channel
 
+	// // // Rows invalidated without a full redraw
+	struct dirty_cell_t {
+		int Frame;
+		int Row;
+		int Channel;		// -1 for all channels
+		unsigned Pattern;
+	};
+	std::vector<dirty_cell_t> m_DirtyCells;
+	std::vector<channel_mask_t> m_DirtyLines;		// Dirty channels of each visible line
+
+	mutable CPatternGlyphCache m_GlyphCache;		// // //
+
 	// Drawing (TODO remove these)
 	int		m_iDrawCursorRow;
 	int		m_iDrawFrame;
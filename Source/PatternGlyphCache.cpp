@@ -0,0 +1,104 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+#include "PatternGlyphCache.h"
+#include "Color.h"
+
+void CPatternGlyphCache::Clear()
+{
+	m_Slots.clear();
+	m_pBits = nullptr;
+	m_pAtlasDC.reset();
+	m_pAtlasBmp.reset();
+}
+
+void CPatternGlyphCache::DrawChar(CDC &DC, int x, int y, WCHAR c, COLORREF Color)
+{
+	if (!m_pAtlasDC)
+		Create(DC);
+
+	const std::uint64_t Key = (static_cast<std::uint64_t>(Color & 0xFFFFFFu) << 16) | c;
+	int Slot;
+	if (auto it = m_Slots.find(Key); it != m_Slots.end())
+		Slot = it->second;
+	else {
+		if (m_Slots.size() >= MAX_GLYPHS)		// start over rather than evicting individual glyphs
+			m_Slots.clear();
+		Slot = static_cast<int>(m_Slots.size());
+		RenderGlyph(Slot, c, Color);
+		m_Slots.try_emplace(Key, Slot);
+	}
+
+	const BLENDFUNCTION Blend = {AC_SRC_OVER, 0, 0xFF, AC_SRC_ALPHA};
+	DC.AlphaBlend(x - m_iCellWidth / 2, y - m_iAscent, m_iCellWidth, m_iCellHeight,
+		m_pAtlasDC.get(), Slot * m_iCellWidth, 0, m_iCellWidth, m_iCellHeight, Blend);
+}
+
+void CPatternGlyphCache::Create(CDC &DC)
+{
+	TEXTMETRICW tm = { };
+	DC.GetTextMetricsW(&tm);
+	m_iAscent = tm.tmAscent;
+	m_iCellHeight = tm.tmHeight;
+	m_iCellWidth = (tm.tmMaxCharWidth + tm.tmOverhang) * 2;		// centered glyphs may overhang on either side
+
+	BITMAPINFO bmi = { };
+	bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+	bmi.bmiHeader.biWidth = m_iCellWidth * MAX_GLYPHS;
+	bmi.bmiHeader.biHeight = -m_iCellHeight;		// top-down
+	bmi.bmiHeader.biPlanes = 1;
+	bmi.bmiHeader.biBitCount = 32;
+	bmi.bmiHeader.biCompression = BI_RGB;
+
+	void *pBits = nullptr;
+	m_pAtlasBmp = std::make_unique<CBitmap>();
+	m_pAtlasBmp->Attach(::CreateDIBSection(DC.GetSafeHdc(), &bmi, DIB_RGB_COLORS, &pBits, NULL, 0));
+	m_pBits = static_cast<std::uint32_t *>(pBits);
+
+	m_pAtlasDC = std::make_unique<CDC>();
+	m_pAtlasDC->CreateCompatibleDC(&DC);
+	m_pAtlasDC->SelectObject(m_pAtlasBmp.get());
+	m_pAtlasDC->SelectObject(DC.GetCurrentFont());
+	m_pAtlasDC->SetBkMode(TRANSPARENT);
+	m_pAtlasDC->SetTextAlign(TA_CENTER | TA_BASELINE);
+	m_pAtlasDC->SetTextColor(WHITE);
+}
+
+void CPatternGlyphCache::RenderGlyph(int Slot, WCHAR c, COLORREF Color)
+{
+	// Render white on black to obtain the coverage, then tint it
+	const int Left = Slot * m_iCellWidth;
+	m_pAtlasDC->FillSolidRect(Left, 0, m_iCellWidth, m_iCellHeight, BLACK);
+	m_pAtlasDC->TextOutW(Left + m_iCellWidth / 2, m_iAscent, &c, 1);
+	::GdiFlush();
+
+	const int Stride = m_iCellWidth * MAX_GLYPHS;
+	for (int y = 0; y < m_iCellHeight; ++y) {
+		std::uint32_t *pRow = m_pBits + y * Stride + Left;
+		for (int x = 0; x < m_iCellWidth; ++x) {
+			// DIB pixels are 0xAARRGGBB, COLORREF is 0x00BBGGRR
+			const unsigned Px = pRow[x];
+			const unsigned a = (((Px >> 16) & 0xFF) + ((Px >> 8) & 0xFF) + (Px & 0xFF)) / 3;
+			pRow[x] = (a << 24) | ((GetR(Color) * a / 0xFF) << 16) | ((GetG(Color) * a / 0xFF) << 8) | (GetB(Color) * a / 0xFF);
+		}
+	}
+}
@@ -0,0 +1,58 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+#pragma once
+
+#include "stdafx.h"		// // //
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+
+// // // Pre-rendered pattern font glyphs, keyed by character and text color. Each glyph
+// is stored as a premultiplied coverage mask so that it can be alpha-blended over the
+// gradient row backgrounds at the same place CDC::TextOutW would have drawn it.
+class CPatternGlyphCache {
+public:
+	// Discards all glyphs, must be called before the pattern font is destroyed
+	void Clear();
+
+	// Draws a glyph using the font currently selected into DC, the reference point is
+	// interpreted as TA_CENTER | TA_BASELINE
+	void DrawChar(CDC &DC, int x, int y, WCHAR c, COLORREF Color);
+
+private:
+	void Create(CDC &DC);
+	void RenderGlyph(int Slot, WCHAR c, COLORREF Color);
+
+	static constexpr int MAX_GLYPHS = 256;
+
+	std::unique_ptr<CBitmap> m_pAtlasBmp;
+	std::unique_ptr<CDC> m_pAtlasDC;
+	std::uint32_t *m_pBits = nullptr;
+
+	int m_iCellWidth = 0;
+	int m_iCellHeight = 0;
+	int m_iAscent = 0;
+
+	std::unordered_map<std::uint64_t, int> m_Slots;
+};
@@ -0,0 +1,191 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+#include "PatternIndex.h"
+#include "FamiTrackerModule.h"
+#include "ChannelOrder.h"
+#include "SongData.h"
+#include "TrackData.h"
+#include "SearchTerm.h"
+
+
+
+CPatternIndex::slot_t CPatternIndex::MakeSlot(unsigned Song, stChannelID Channel, unsigned Pattern) noexcept {
+	return (static_cast<slot_t>(Song) << 40) | (static_cast<slot_t>(Channel.ToInteger()) << 16) | Pattern;
+}
+
+void CPatternIndex::Update(const CFamiTrackerModule &modfile) {
+	++generation_;
+
+	modfile.VisitSongs([&] (const CSongData &song, unsigned s) {
+		song.VisitTracks([&] (const CTrackData &track, stChannelID ch) {
+			track.VisitPatterns([&] (const CPatternData &pattern, std::size_t p) {
+				if (std::uint64_t Version = pattern.GetVersion()) { // never written to otherwise
+					slot_t Slot = MakeSlot(s, ch, static_cast<unsigned>(p));
+					pattern_t &Entry = patterns_[Slot];
+					Entry.Generation = generation_;
+					if (Entry.Version != Version) {
+						Remove(Slot, Entry);
+						Insert(Slot, Entry, pattern);
+						Entry.Version = Version;
+					}
+				}
+			});
+		});
+	});
+
+	for (auto it = patterns_.begin(); it != patterns_.end(); )
+		if (it->second.Generation != generation_) {
+			Remove(it->first, it->second);
+			it = patterns_.erase(it);
+		}
+		else
+			++it;
+}
+
+void CPatternIndex::Insert(slot_t Slot, pattern_t &Entry, const CPatternData &Pattern) {
+	const auto Add = [&] (field_t Field, unsigned Key, unsigned Row) {
+		auto &rows = postings_[Field][Key][Slot];
+		if (rows.none())
+			Entry.Keys.emplace_back(Field, Key);
+		rows.set(Row);
+	};
+
+	Pattern.VisitRows([&] (const stChanNote &Note, unsigned Row) {
+		if (Note.Note != note_t::none)
+			Add(NOTE, (value_cast(Note.Note) << 8) | Note.Octave, Row);
+		if (Note.Instrument != MAX_INSTRUMENTS)
+			Add(INST, Note.Instrument, Row);
+		if (Note.Vol != MAX_VOLUME)
+			Add(VOL, Note.Vol, Row);
+		for (const auto &cmd : Note.Effects)
+			if (cmd.fx != effect_t::none)
+				Add(EFFECT, value_cast(cmd.fx), Row);
+	});
+}
+
+void CPatternIndex::Remove(slot_t Slot, pattern_t &Entry) {
+	for (auto [Field, Key] : Entry.Keys) {
+		auto it = postings_[Field].find(Key);
+		it->second.erase(Slot);
+		if (it->second.empty())
+			postings_[Field].erase(it);
+	}
+	Entry.Keys.clear();
+}
+
+bool CPatternIndex::IsFieldUsable(const searchTerm &Term, field_t Field) {
+	// blank values are not indexed, so the term must reject them
+	switch (Field) {
+	case NOTE:
+		if (!Term.Definite[WC_NOTE])
+			return false;
+		for (unsigned Octave = 0; Octave <= 0xFFu; ++Octave) {
+			stChanNote Blank;
+			Blank.Octave = static_cast<unsigned char>(Octave);
+			if (Term.IsNoteMatch(Blank, false) || Term.IsNoteMatch(Blank, true))
+				return false;
+		}
+		return true;
+	case INST:
+		return Term.Definite[WC_INST] && !Term.Inst->IsMatch(MAX_INSTRUMENTS);
+	case VOL:
+		return Term.Definite[WC_VOL] && !Term.Vol->IsMatch(MAX_VOLUME);
+	case EFFECT:
+		return Term.Definite[WC_EFF] && !Term.EffNumber[value_cast(effect_t::none)];
+	default:
+		return false;
+	}
+}
+
+bool CPatternIndex::AcceptsKey(const searchTerm &Term, field_t Field, unsigned Key) {
+	switch (Field) {
+	case NOTE: {
+		stChanNote Note;
+		Note.Note = enum_cast<note_t>(static_cast<unsigned char>(Key >> 8));
+		Note.Octave = static_cast<unsigned char>(Key & 0xFFu);
+		return Term.IsNoteMatch(Note, false) || Term.IsNoteMatch(Note, true);
+	}
+	case INST:
+		return Term.Inst->IsMatch(static_cast<unsigned char>(Key));
+	case VOL:
+		return Term.Vol->IsMatch(static_cast<unsigned char>(Key));
+	case EFFECT:
+		return Term.EffNumber[Key];
+	default:
+		return false;
+	}
+}
+
+CPatternIndex::match_t CPatternIndex::Find(const CFamiTrackerModule &modfile, unsigned Track, const searchTerm &Term, int EffColumn, bool Negate) {
+	Update(modfile);
+
+	// a default channel ID does not have the smallest integer value
+	const slot_t SongBegin = MakeSlot(Track, stChannelID::FromInteger(0u), 0);
+	const slot_t SongEnd = MakeSlot(Track + 1, stChannelID::FromInteger(0u), 0);
+
+	// negated searches match blank rows as well
+	std::size_t Best = static_cast<std::size_t>(-1);
+	field_t BestField = FIELD_COUNT;
+	if (!Negate)
+		for (unsigned i = 0; i < FIELD_COUNT; ++i) {
+			const auto Field = static_cast<field_t>(i);
+			if (!IsFieldUsable(Term, Field))
+				continue;
+			std::size_t Count = 0;
+			for (const auto &[Key, slots] : postings_[Field])
+				if (AcceptsKey(Term, Field, Key))
+					for (auto it = slots.lower_bound(SongBegin), end = slots.lower_bound(SongEnd); it != end; ++it)
+						Count += it->second.count();
+			if (Count < Best) {
+				Best = Count;
+				BestField = Field;
+			}
+		}
+	const CSearchQuery Query {Term, EffColumn, Negate};		// // //
+	if (BestField == FIELD_COUNT)
+		return Query.Find(modfile, Track);
+
+	std::map<slot_t, rows_t> Candidates;
+	for (const auto &[Key, slots] : postings_[BestField])
+		if (AcceptsKey(Term, BestField, Key))
+			for (auto it = slots.lower_bound(SongBegin), end = slots.lower_bound(SongEnd); it != end; ++it)
+				Candidates[it->first] |= it->second;
+
+	match_t Matches;
+	const CSongData &song = *modfile.GetSong(Track);
+	for (const auto &[Slot, rows] : Candidates) {
+		const stChannelID ch = stChannelID::FromInteger(static_cast<std::uint32_t>((Slot >> 16) & 0xFFFFFFu));
+		const unsigned p = static_cast<unsigned>(Slot & 0xFFFFu);
+		const CTrackData *pTrack = song.GetTrack(ch);
+		const CPatternData &pattern = pTrack->GetPattern(p);
+		const int EffCount = pTrack->GetEffectColumnCount();
+		rows_t Found;
+		for (unsigned Row = 0; Row < rows.size(); ++Row)
+			if (rows.test(Row) && Query.IsMatch(pattern.GetNoteOn(Row), IsAPUNoise(ch), EffCount))
+				Found.set(Row);
+		if (Found.any())
+			Matches.try_emplace({ch, p}, Found);
+	}
+
+	return Matches;
+}
@@ -0,0 +1,81 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+#pragma once
+
+#include <map>
+#include <array>
+#include <bitset>
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include "FamiTrackerDefines.h"
+#include "APU/Types.h"
+#include "SearchQuery.h"		// // //
+
+class CFamiTrackerModule;
+class CPatternData;
+class searchTerm;
+
+// // // inverted index from pattern cell values to the rows containing them
+
+class CPatternIndex {
+public:
+	using match_t = CSearchQuery::match_t;
+
+	/*!	\brief Brings the index up to date with a module.
+		\details Only patterns whose version changed since the last call are indexed again. */
+	void Update(const CFamiTrackerModule &modfile);
+
+	/*!	\brief Finds the rows that match a search term in the patterns of a song.
+		\details The index is updated first. Candidate rows are taken from the postings of the most
+		selective field of the search term and then compared in full; if no field can narrow down
+		the search, CSearchQuery::Find is used instead. The result covers at least every pattern used by the
+		song's frames.
+		\param Track The song index.
+		\param EffColumn The effect column to search, or MAX_EFFECT_COLUMNS to search all columns.
+		\param Negate Whether the search is negated. */
+	match_t Find(const CFamiTrackerModule &modfile, unsigned Track, const searchTerm &Term, int EffColumn, bool Negate);
+
+private:
+	enum field_t : unsigned char { NOTE, INST, VOL, EFFECT, FIELD_COUNT };
+	using slot_t = std::uint64_t;
+	using rows_t = CSearchQuery::rows_t;
+
+	struct pattern_t {
+		std::uint64_t Version = 0;
+		unsigned Generation = 0;
+		std::vector<std::pair<field_t, unsigned>> Keys;
+	};
+
+	static slot_t MakeSlot(unsigned Song, stChannelID Channel, unsigned Pattern) noexcept;
+	static bool AcceptsKey(const searchTerm &Term, field_t Field, unsigned Key);
+	static bool IsFieldUsable(const searchTerm &Term, field_t Field);
+
+	void Insert(slot_t Slot, pattern_t &Entry, const CPatternData &Pattern);
+	void Remove(slot_t Slot, pattern_t &Entry);
+
+	std::map<slot_t, pattern_t> patterns_;
+	std::array<std::map<unsigned, std::map<slot_t, rows_t>>, FIELD_COUNT> postings_;
+	unsigned generation_ = 0;
+};
@@ -60,7 +60,9 @@ CStringA GetPitchText(int digits, int period, double freq) {
 
 } // namespace
 
-CRegisterDisplay::CRegisterDisplay(CDC &dc, COLORREF bgColor) : dc_(dc), bgColor_(bgColor) {
+CRegisterDisplay::CRegisterDisplay(CDC &dc, COLORREF bgColor) :
+	dc_(dc), bgColor_(bgColor), snapshot_(FTEnv.GetSoundGenerator()->GetRegisterSnapshot())		// // //
+{
 }
 
 void CRegisterDisplay::Draw() {
@@ -186,7 +188,7 @@ void CRegisterDisplay::Draw() {
 		dc_.FillSolidRect(x + 300 - 1, y - 1, 2 * Length + 2, 17, 0x808080);
 		dc_.FillSolidRect(x + 300, y, 2 * Length, 15, 0);
 		for (int i = 0; i < Length; ++i) {
-			auto pState = pSoundGen->GetRegState(sound_chip_t::N163, i);
+			auto pState = GetRegState(sound_chip_t::N163, i);
 			const int Hi = (pState->GetValue() >> 4) & 0x0F;
 			const int Lo = pState->GetValue() & 0x0F;
 			COLORREF Col = BLEND(GREY(192), DECAY_COLOR[pState->GetNewValueTime()],
@@ -195,8 +197,8 @@ void CRegisterDisplay::Draw() {
 			dc_.FillSolidRect(x + 300 + i * 2 + 1, y + 15 - Hi, 1, Hi, Col);
 		}
 		for (int i = 0; i < N163_CHANS; ++i) {
-			auto pPosState = pSoundGen->GetRegState(sound_chip_t::N163, 0x78 - i * 8 + 6);
-			auto pLenState = pSoundGen->GetRegState(sound_chip_t::N163, 0x78 - i * 8 + 4);
+			auto pPosState = GetRegState(sound_chip_t::N163, 0x78 - i * 8 + 6);
+			auto pLenState = GetRegState(sound_chip_t::N163, 0x78 - i * 8 + 4);
 			const int WavePos = pPosState->GetValue();
 			const int WaveLen = 0x100 - (pLenState->GetValue() & 0xFC);
 			const int NewTime = std::min(pPosState->GetNewValueTime(), pLenState->GetNewValueTime());
@@ -232,8 +234,8 @@ void CRegisterDisplay::Draw() {
 	if (pSoundGen->IsExpansionEnabled(sound_chip_t::FDS)) {
 		DrawHeader("FDS registers");		// // //
 
-		int period = (pSoundGen->GetReg(sound_chip_t::FDS, 0x4082) & 0xFF) | ((pSoundGen->GetReg(sound_chip_t::FDS, 0x4083) & 0x0F) << 8);
-		int vol = (pSoundGen->GetReg(sound_chip_t::FDS, 0x4080) & 0x3F);
+		int period = (GetReg(sound_chip_t::FDS, 0x4082) & 0xFF) | ((GetReg(sound_chip_t::FDS, 0x4083) & 0x0F) << 8);
+		int vol = (GetReg(sound_chip_t::FDS, 0x4080) & 0x3F);
 		double freq = pSoundGen->GetChannelFrequency(sound_chip_t::FDS, 0);		// // //
 
 		for (int i = 0; i < 11; ++i) {
@@ -257,7 +259,7 @@ void CRegisterDisplay::Draw() {
 			DrawReg(FormattedA("$x%01X:", i), 3);
 
 			int period = reg[0] | ((reg[1] & 0x01) << 8);
-			int vol = 0x0F - (pSoundGen->GetReg(sound_chip_t::VRC7, i + 0x30) & 0x0F);
+			int vol = 0x0F - (GetReg(sound_chip_t::VRC7, i + 0x30) & 0x0F);
 			double freq = pSoundGen->GetChannelFrequency(sound_chip_t::VRC7, i);		// // //
 
 			DrawText_(180, FormattedA("%s, vol = %02i, patch = $%01X", (LPCSTR)GetPitchText(3, period, freq), vol, reg[2] >> 4));
@@ -274,14 +276,14 @@ void CRegisterDisplay::Draw() {
 			DrawReg(FormattedA("$%02X:", i * 2), 2);
 
 			int period = reg[0] | ((reg[1] & 0x0F) << 8);
-			int vol = pSoundGen->GetReg(sound_chip_t::S5B, 8 + i) & 0x0F;
+			int vol = GetReg(sound_chip_t::S5B, 8 + i) & 0x0F;
 			double freq = pSoundGen->GetChannelFrequency(sound_chip_t::S5B, i);		// // //
 
 			if (i < MAX_CHANNELS_S5B)
 				DrawText_(180, FormattedA("%s, vol = %02i, mode = %c%c%c", (LPCSTR)GetPitchText(3, period, freq), vol,
-					(pSoundGen->GetReg(sound_chip_t::S5B, 7) & (1 << i)) ? L'-' : L'T',
-					(pSoundGen->GetReg(sound_chip_t::S5B, 7) & (8 << i)) ? L'-' : L'N',
-					(pSoundGen->GetReg(sound_chip_t::S5B, 8 + i) & 0x10) ? L'E' : L'-'));
+					(GetReg(sound_chip_t::S5B, 7) & (1 << i)) ? L'-' : L'T',
+					(GetReg(sound_chip_t::S5B, 7) & (8 << i)) ? L'-' : L'N',
+					(GetReg(sound_chip_t::S5B, 8 + i) & 0x10) ? L'E' : L'-'));
 			else
 				DrawText_(180, FormattedA("pitch = $%02X", reg[0] & 0x1F));
 
@@ -338,8 +340,19 @@ void CRegisterDisplay::DrawText_(int xOffs, const CStringA &text) {
 template <typename F>
 void CRegisterDisplay::GetRegs(sound_chip_t Chip, F f, int count) {
 	for (int j = 0; j < count; ++j) {
-		auto pState = FTEnv.GetSoundGenerator()->GetRegState(Chip, f(j));		// // //
+		auto pState = GetRegState(Chip, f(j));		// // //
 		reg[j] = pState->GetValue();
 		update[j] = pState->GetLastUpdatedTime() | (pState->GetNewValueTime() << 4);
 	}
 }
+
+const CRegisterState *CRegisterDisplay::GetRegState(sound_chip_t Chip, unsigned Reg) const {		// // //
+	static const CRegisterState EMPTY;
+	if (const CRegisterState *pState = snapshot_ ? snapshot_->GetRegister(Chip, Reg) : nullptr)
+		return pState;
+	return &EMPTY;
+}
+
+uint8_t CRegisterDisplay::GetReg(sound_chip_t Chip, unsigned Reg) const {		// // //
+	return GetRegState(Chip, Reg)->GetValue();
+}
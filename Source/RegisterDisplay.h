@@ -26,6 +26,10 @@
 #include "stdafx.h"
 #include "APU/Types_fwd.h"
 #include <string_view>
+#include <memory>		// // //
+
+class CRegisterState;		// // //
+class CRegisterSnapshot;		// // //
 
 class CRegisterDisplay {		// // // TODO: move to its own thread
 public:
@@ -38,10 +42,13 @@ private:
 	void DrawText_(int xOffs, const CStringA &text);
 	template <typename F>
 	void GetRegs(sound_chip_t Chip, F f, int Count);
+	const CRegisterState *GetRegState(sound_chip_t Chip, unsigned Reg) const;		// // //
+	uint8_t GetReg(sound_chip_t Chip, unsigned Reg) const;		// // //
 
 private:
 	CDC &dc_;
 	COLORREF bgColor_;
+	std::shared_ptr<const CRegisterSnapshot> snapshot_;		// // // register states of the last completed frame
 
 	static const int LINE_HEIGHT = 13;		// // //
 	int x = 30;
@@ -21,9 +21,10 @@
 */
 
 #include "RegisterState.h"
+#include <algorithm>		// // //
 
 CRegisterLogger::CRegisterLogger() :
-	m_mRegister(),
+	m_pIndex(std::make_shared<register_index_t>()),		// // //
 	m_iPort(0),
 	m_bAutoIncrement(false),
 	m_bBlocked(false)
@@ -32,26 +33,42 @@ CRegisterLogger::CRegisterLogger() :
 
 void CRegisterLogger::Reset()
 {
-	for (auto &r : m_mRegister)
-		r.second.Reset();
+	for (auto &r : m_Registers)		// // //
+		r.Reset();
 }
 
 bool CRegisterLogger::AddRegisterRange(unsigned Low, unsigned High)
 {
+	if (Low > High)		// // //
+		return false;
 	for (unsigned i = Low; i <= High; ++i)
-		if (m_mRegister.find(i) != m_mRegister.end()) // conflict
+		if (m_pIndex->Find(i) != -1) // conflict
 			return false;
 
-	for (unsigned i = Low; i <= High; ++i)
-		m_mRegister[i] = CRegisterState { };
-	m_mWarpValues[++High] = Low;
+	// // // rebuild the table, as snapshots may still refer to the old one
+	auto pIndex = std::make_shared<register_index_t>(*m_pIndex);
+	if (pIndex->Slots.empty())
+		pIndex->Base = Low;
+	else if (Low < pIndex->Base) {
+		pIndex->Slots.insert(pIndex->Slots.begin(), pIndex->Base - Low, -1);
+		pIndex->Base = Low;
+	}
+	if (High - pIndex->Base >= pIndex->Slots.size())
+		pIndex->Slots.resize(High - pIndex->Base + 1, -1);
+
+	for (unsigned i = Low; i <= High; ++i) {
+		pIndex->Slots[i - pIndex->Base] = static_cast<int>(m_Registers.size());
+		m_Registers.emplace_back();
+	}
+	m_pIndex = std::move(pIndex);
+	m_WarpValues.emplace_back(High + 1, Low);
 	return true;
 }
 
 bool CRegisterLogger::SetPort(unsigned Address)
 {
 	m_iPort = Address;
-	return m_mRegister.find(m_iPort) != m_mRegister.end();
+	return m_pIndex->Find(m_iPort) != -1;		// // //
 }
 
 void CRegisterLogger::SetAutoincrement(bool Enable)
@@ -61,28 +78,103 @@ void CRegisterLogger::SetAutoincrement(bool Enable)
 
 bool CRegisterLogger::Write(uint8_t Value)
 {
-	if (m_mRegister.find(m_iPort) == m_mRegister.end())
+	int Index = m_pIndex->Find(m_iPort);		// // //
+	if (Index == -1)
 		return false;
 
-	m_mRegister.at(m_iPort).Update(Value);
-	if (m_bAutoIncrement)
-		if (m_mWarpValues.find(++m_iPort) != m_mWarpValues.end())
-			m_iPort = m_mWarpValues[m_iPort];
+	m_Registers[Index].Update(Value);
+	if (m_bAutoIncrement) {
+		++m_iPort;
+		for (const auto &[From, To] : m_WarpValues)
+			if (m_iPort == From) {
+				m_iPort = To;
+				break;
+			}
+	}
 
 	return true;
 }
 
 CRegisterState *CRegisterLogger::GetRegister(unsigned Address)
 {
-	if (m_mRegister.find(Address) == m_mRegister.end())
-		return nullptr;
-	return &m_mRegister.at(Address);
+	int Index = m_pIndex->Find(Address);		// // //
+	return Index != -1 ? &m_Registers[Index] : nullptr;
 }
 
 void CRegisterLogger::Step()
 {
-	for (auto &r : m_mRegister)
-		r.second.Step();
+	for (auto &r : m_Registers)		// // //
+		r.Step();
+}
+
+std::shared_ptr<const CRegisterLogger::register_index_t> CRegisterLogger::GetIndex() const		// // //
+{
+	return m_pIndex;
+}
+
+const std::vector<CRegisterState> &CRegisterLogger::GetRegisters() const		// // //
+{
+	return m_Registers;
+}
+
+
+
+void CRegisterSnapshot::AddChip(sound_chip_t Chip, const CRegisterLogger &Logger)		// // //
+{
+	m_Chips.push_back({Chip, Logger.GetIndex(), Logger.GetRegisters()});
+}
+
+const CRegisterState *CRegisterSnapshot::GetRegister(sound_chip_t Chip, unsigned Address) const		// // //
+{
+	for (const auto &x : m_Chips)
+		if (x.Chip == Chip) {
+			int Index = x.pIndex->Find(Address);
+			return Index != -1 ? &x.Registers[Index] : nullptr;
+		}
+	return nullptr;
+}
+
+uint8_t CRegisterSnapshot::GetValue(sound_chip_t Chip, unsigned Address) const		// // //
+{
+	const CRegisterState *pState = GetRegister(Chip, Address);
+	return pState ? pState->GetValue() : static_cast<uint8_t>(0);
+}
+
+
+
+void CRegisterHistory::Push(std::shared_ptr<const CRegisterSnapshot> pSnapshot)		// // //
+{
+	{
+		std::lock_guard<std::mutex> lock {m_Lock};
+		m_iHead = (m_iHead + 1) % MAX_FRAMES;
+		m_pSnapshots[m_iHead].swap(pSnapshot);
+		m_iCount = std::min(m_iCount + 1, MAX_FRAMES);
+	}
+	// the discarded snapshot, if any, is released outside the lock
+}
+
+std::shared_ptr<const CRegisterSnapshot> CRegisterHistory::Get(unsigned FramesBack) const		// // //
+{
+	std::lock_guard<std::mutex> lock {m_Lock};
+	if (FramesBack >= m_iCount)
+		return nullptr;
+	return m_pSnapshots[(m_iHead + MAX_FRAMES - FramesBack) % MAX_FRAMES];
+}
+
+std::size_t CRegisterHistory::GetCount() const		// // //
+{
+	std::lock_guard<std::mutex> lock {m_Lock};
+	return m_iCount;
+}
+
+void CRegisterHistory::Clear()		// // //
+{
+	decltype(m_pSnapshots) Old;
+	{
+		std::lock_guard<std::mutex> lock {m_Lock};
+		m_pSnapshots.swap(Old);
+		m_iCount = 0;
+	}
 }
 
 
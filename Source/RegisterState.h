@@ -23,7 +23,12 @@
 
 #pragma once
 
-#include <unordered_map>
+#include <cstdint>		// // //
+#include <array>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "APU/Types_fwd.h"
 
 /*!
 	\brief A class which manages writes to a single APU register.
@@ -113,14 +118,110 @@ public:
 	/*!	\brief Steps one tick and updates the time information of all registers. */
 	void Step();
 
+public:
+	/*!
+		\brief A lookup table from register addresses to indices into the dense register array.
+		\details The table is immutable once built, so that snapshots may share it with the logger.
+	*/
+	struct register_index_t {		// // //
+		/*!	\brief Obtains the array index of a register.
+			\param Address The address value of the register.
+			\return The index, or -1 if the given address does not exist. */
+		int Find(unsigned Address) const {
+			Address -= Base;
+			return Address < Slots.size() ? Slots[Address] : -1;
+		}
+
+		unsigned Base = 0;
+		std::vector<int> Slots;
+	};
+
+	/*!	\brief Obtains the address lookup table of the logger.
+		\return The lookup table, valid for the registers returned by GetRegisters. */
+	std::shared_ptr<const register_index_t> GetIndex() const;		// // //
+
+	/*!	\brief Obtains the states of all registers, in the order their address ranges were added.
+		\return The register state array. */
+	const std::vector<CRegisterState> &GetRegisters() const;		// // //
+
 protected:
-	std::unordered_map<unsigned, CRegisterState> m_mRegister;
-	std::unordered_map<unsigned, unsigned> m_mWarpValues;
+	std::vector<CRegisterState> m_Registers;		// // // dense, replaces the address map
+	std::shared_ptr<const register_index_t> m_pIndex;		// // //
+	std::vector<std::pair<unsigned, unsigned>> m_WarpValues;		// // // (High + 1, Low) of every range
 	unsigned int m_iPort;
 	bool m_bAutoIncrement;
 	bool m_bBlocked;
 };
 
+/*!
+	\brief An immutable copy of the register states of all active sound chips, taken at the end of
+	a frame.
+	\details The register display reads snapshots so that it never touches the live emulator state
+	while the sound thread is writing to it.
+*/
+class CRegisterSnapshot		// // //
+{
+public:
+	/*!	\brief Copies the current register states of a sound chip into the snapshot.
+		\param Chip The sound chip identifier.
+		\param Logger The register logger of the sound chip. */
+	void AddChip(sound_chip_t Chip, const CRegisterLogger &Logger);
+
+	/*!	\brief Obtains a register state object.
+		\param Chip The sound chip identifier.
+		\param Address The address value of the register.
+		\return The register state object, or nullptr if the register is not in the snapshot. */
+	const CRegisterState *GetRegister(sound_chip_t Chip, unsigned Address) const;
+
+	/*!	\brief Obtains a register value.
+		\param Chip The sound chip identifier.
+		\param Address The address value of the register.
+		\return The register value, or 0 if the register is not in the snapshot. */
+	uint8_t GetValue(sound_chip_t Chip, unsigned Address) const;
+
+private:
+	struct chip_registers_t {
+		sound_chip_t Chip;
+		std::shared_ptr<const CRegisterLogger::register_index_t> pIndex;
+		std::vector<CRegisterState> Registers;
+	};
+
+	std::vector<chip_registers_t> m_Chips;
+};
+
+/*!
+	\brief A ring of the most recent register snapshots.
+	\details The sound thread pushes one snapshot per frame; other threads may retrieve any of the
+	stored snapshots, for example to step the register display back in time.
+*/
+class CRegisterHistory		// // //
+{
+public:
+	static const std::size_t MAX_FRAMES = 64;
+
+	/*!	\brief Adds a snapshot as the most recent one, discarding the oldest if the ring is full.
+		\param pSnapshot The new snapshot. */
+	void Push(std::shared_ptr<const CRegisterSnapshot> pSnapshot);
+
+	/*!	\brief Obtains a snapshot.
+		\param FramesBack Number of frames before the most recent snapshot.
+		\return The snapshot, or nullptr if it is not available. */
+	std::shared_ptr<const CRegisterSnapshot> Get(unsigned FramesBack = 0) const;
+
+	/*!	\brief Obtains the number of stored snapshots.
+		\return The snapshot count. */
+	std::size_t GetCount() const;
+
+	/*!	\brief Removes all snapshots. */
+	void Clear();
+
+private:
+	mutable std::mutex m_Lock;
+	std::array<std::shared_ptr<const CRegisterSnapshot>, MAX_FRAMES> m_pSnapshots;
+	std::size_t m_iHead = 0;
+	std::size_t m_iCount = 0;
+};
+
 /*!
 	\brief A class which allows internal changes to the register state without causing external changes
 	due to logging.
@@ -0,0 +1,220 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+#include "SearchQuery.h"
+#include "SearchTerm.h"
+#include "FamiTrackerModule.h"
+#include "FamiTrackerEnv.h"
+#include "SoundChipService.h"
+#include "ChannelOrder.h"
+#include "SongData.h"
+#include "TrackData.h"
+#include <future>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+
+
+
+CSearchQuery::CSearchQuery(const searchTerm &Term, int EffColumn, bool Negate) :
+	eff_column_(EffColumn), negate_(Negate)
+{
+	for (int Noise = 0; Noise < 2; ++Noise) {
+		if (!Term.Definite[WC_NOTE]) {
+			notes_[Noise].set();
+			continue;
+		}
+		stChanNote Note;
+		for (unsigned n = 0; n < 0x100u; ++n)
+			for (unsigned o = 0; o < 0x100u; ++o) {
+				Note.Note = enum_cast<note_t>(static_cast<unsigned char>(n));
+				Note.Octave = static_cast<unsigned char>(o);
+				switch (Term.MatchNote(Note, Noise != 0)) {
+				case searchTerm::note_match_t::match:
+					notes_[Noise].set(MakeKey(static_cast<unsigned char>(n), static_cast<unsigned char>(o)));
+					break;
+				case searchTerm::note_match_t::exclude:
+					excluded_[Noise] = true;
+					break;
+				case searchTerm::note_match_t::mismatch:
+					break;
+				}
+			}
+	}
+
+	for (unsigned i = 0; i < 0x100u; ++i) {
+		const auto x = static_cast<unsigned char>(i);
+		instruments_[i] = !Term.Definite[WC_INST] || Term.Inst->IsMatch(x);
+		volumes_[i] = !Term.Definite[WC_VOL] || Term.Vol->IsMatch(x);
+	}
+
+	for (unsigned fx = 0; fx < 0x100u; ++fx) {
+		const bool FxMatch = !Term.Definite[WC_EFF] ||
+			(fx < std::size(Term.EffNumber) && Term.EffNumber[fx]);
+		if (FxMatch)
+			for (unsigned param = 0; param < 0x100u; ++param)
+				if (!Term.Definite[WC_PARAM] || Term.EffParam->IsMatch(static_cast<unsigned char>(param)))
+					effects_.set(MakeKey(static_cast<unsigned char>(fx), static_cast<unsigned char>(param)));
+	}
+	any_effect_ = effects_.all();
+}
+
+inline unsigned CSearchQuery::MakeKey(unsigned char Hi, unsigned char Lo) noexcept {
+	return (static_cast<unsigned>(Hi) << 8) | Lo;
+}
+
+unsigned CSearchQuery::GetColumnMask(int EffCount) const noexcept {
+	int EffColumn = eff_column_;
+	if (EffColumn > EffCount && EffColumn != MAX_EFFECT_COLUMNS) EffColumn = EffCount;
+	int Limit = MAX_EFFECT_COLUMNS - 1;
+	if (EffCount < Limit) Limit = EffCount;
+	if (EffColumn < Limit) Limit = EffColumn;
+
+	unsigned Mask = 0u;
+	for (int i = EffColumn % MAX_EFFECT_COLUMNS; i <= Limit; ++i)
+		Mask |= 1u << i;
+	return Mask;
+}
+
+inline bool CSearchQuery::IsMaskMatch(const stChanNote &Note, bool Noise, unsigned ColumnMask) const noexcept {
+	// the column mask is never empty
+	bool EffectMatch = any_effect_;
+	if (!EffectMatch)
+		for (std::size_t i = 0; i < MAX_EFFECT_COLUMNS; ++i)
+			EffectMatch |= ((ColumnMask >> i) & 1u) & effects_[MakeKey(value_cast(Note.Effects[i].fx), Note.Effects[i].param)];
+
+	const bool Match = notes_[Noise][MakeKey(value_cast(Note.Note), Note.Octave)] &
+		instruments_[Note.Instrument] & volumes_[Note.Vol] & EffectMatch;
+	return !excluded_[Noise] & (Match != negate_);
+}
+
+bool CSearchQuery::IsMatch(const stChanNote &Note, bool Noise, int EffCount) const noexcept {
+	return IsMaskMatch(Note, Noise, GetColumnMask(EffCount));
+}
+
+CSearchQuery::rows_t CSearchQuery::ScanPattern(const CPatternData &Pattern, unsigned Rows, bool Noise, int EffCount) const {
+	const unsigned ColumnMask = GetColumnMask(EffCount);
+
+	// patterns without note data are not visited
+	rows_t Found;
+	if (IsMaskMatch(stChanNote { }, Noise, ColumnMask))
+		for (unsigned Row = 0; Row < Rows; ++Row)
+			Found.set(Row);
+	Pattern.VisitRows(Rows, [&] (const stChanNote &Note, unsigned Row) {
+		Found[Row] = IsMaskMatch(Note, Noise, ColumnMask);
+	});
+	return Found;
+}
+
+CSearchQuery::match_t CSearchQuery::Find(const CFamiTrackerModule &modfile, unsigned Track) const {
+	const CSongData &song = *modfile.GetSong(Track);
+	const unsigned Frames = song.GetFrameCount();
+	const unsigned Rows = song.GetPatternLength();
+
+	std::vector<std::future<match_t>> tasks;
+	modfile.GetChannelOrder().ForeachChannel([&] (stChannelID ch) {
+		tasks.push_back(std::async(std::launch::async, [&, ch] {
+			match_t Matches;
+			const CTrackData *pTrack = song.GetTrack(ch);
+			if (!pTrack)
+				return Matches;
+			const int EffCount = pTrack->GetEffectColumnCount();
+			std::bitset<MAX_PATTERN> Visited;
+			for (unsigned f = 0; f < Frames; ++f) {
+				const unsigned p = pTrack->GetFramePattern(f);
+				if (Visited.test(p))
+					continue;
+				Visited.set(p);
+				if (rows_t Found = ScanPattern(pTrack->GetPattern(p), Rows, IsAPUNoise(ch), EffCount); Found.any())
+					Matches.try_emplace({ch, p}, Found);
+			}
+			return Matches;
+		}));
+	});
+
+	match_t Matches;
+	for (auto &task : tasks)
+		Matches.merge(task.get());
+	return Matches;
+}
+
+stChanNote CSearchQuery::Replace(const stChanNote &Original, const replaceTerm &Term, bool RemoveOriginal, sound_chip_t Chip, int EffCount) const {
+	stChanNote Target;
+	if (!RemoveOriginal)
+		Target = Original;
+
+	if (Term.Definite[WC_NOTE])
+		Target.Note = Term.Note.Note;
+
+	if (Term.Definite[WC_OCT])
+		Target.Octave = Term.Note.Octave;
+
+	if (Term.Definite[WC_INST])
+		Target.Instrument = Term.Note.Instrument;
+
+	if (Term.Definite[WC_VOL])
+		Target.Vol = Term.Note.Vol;
+
+	if (Term.Definite[WC_EFF] || Term.Definite[WC_PARAM]) {
+		std::vector<int> MatchedColumns;
+		if (eff_column_ < MAX_EFFECT_COLUMNS)
+			MatchedColumns.push_back(eff_column_);
+		else {
+			const int c = std::min(EffCount, static_cast<int>(MAX_EFFECT_COLUMNS) - 1);
+			for (int i = 0; i <= c; ++i)
+				if (effects_[MakeKey(value_cast(Target.Effects[i].fx), Target.Effects[i].param)])
+					MatchedColumns.push_back(i);
+		}
+
+		if (Term.Definite[WC_EFF]) {
+			effect_t fx = FTEnv.GetSoundChipService()->TranslateEffectName(EFF_CHAR[value_cast(Term.Note.Effects[0].fx)], Chip);
+			if (fx != effect_t::none)
+				for (const int &i : MatchedColumns)
+					Target.Effects[i].fx = fx;
+		}
+
+		if (Term.Definite[WC_PARAM])
+			for (const int &i : MatchedColumns)
+				Target.Effects[i].param = Term.Note.Effects[0].param;
+	}
+
+	return Target;
+}
+
+unsigned CSearchQuery::ReplaceAll(CFamiTrackerModule &modfile, unsigned Track, const replaceTerm &Term, bool RemoveOriginal) const {
+	const match_t Matches = Find(modfile, Track);
+	CSongData &song = *modfile.GetSong(Track);
+
+	unsigned Count = 0;
+	for (const auto &[Key, Rows] : Matches) {
+		const auto &[ch, p] = Key;
+		CTrackData *pTrack = song.GetTrack(ch);
+		CPatternData &pattern = pTrack->GetPattern(p);
+		const int EffCount = pTrack->GetEffectColumnCount();
+		for (unsigned Row = 0; Row < Rows.size(); ++Row)
+			if (Rows.test(Row)) {
+				pattern.SetNoteOn(Row, Replace(pattern.GetNoteOn(Row), Term, RemoveOriginal, ch.Chip, EffCount));
+				++Count;
+			}
+	}
+	return Count;
+}
@@ -0,0 +1,110 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+#pragma once
+
+#include <map>
+#include <bitset>
+#include <utility>
+#include "PatternNote.h"
+#include "APU/Types.h"
+
+class CFamiTrackerModule;
+class CPatternData;
+class searchTerm;
+struct replaceTerm;
+
+/*!
+	\brief A search term compiled into lookup tables, for matching large numbers of notes.
+	\details Every field of the search term is turned into a table indexed by the raw field
+	values, so matching a note takes a fixed number of lookups without branching on the search
+	term. Queries do not depend on the find dialog or any other UI state, and may be shared
+	between threads.
+*/
+class CSearchQuery {
+public:
+	// matching rows by channel and pattern index
+	using rows_t = std::bitset<MAX_PATTERN_LENGTH>;
+	using match_t = std::map<std::pair<stChannelID, unsigned>, rows_t>;
+
+	/*!	\brief Compiles a search term.
+		\param Term The search term.
+		\param EffColumn The effect column to search, or MAX_EFFECT_COLUMNS to search all columns.
+		\param Negate Whether the search is negated. */
+	CSearchQuery(const searchTerm &Term, int EffColumn, bool Negate);
+
+	/*!	\brief Checks whether a note matches the query.
+		\details Equivalent to searchTerm::IsMatch with the same arguments.
+		\param Note The note to test.
+		\param Noise Whether the note belongs to a noise channel.
+		\param EffCount The effect column count of the note's track. */
+	bool IsMatch(const stChanNote &Note, bool Noise, int EffCount) const noexcept;
+
+	/*!	\brief Matches the first rows of a pattern.
+		\param Pattern The pattern.
+		\param Rows The number of rows to test.
+		\param Noise Whether the pattern belongs to a noise channel.
+		\param EffCount The effect column count of the pattern's track.
+		\return The matching rows. */
+	rows_t ScanPattern(const CPatternData &Pattern, unsigned Rows, bool Noise, int EffCount) const;
+
+	/*!	\brief Finds all matching rows in the patterns used by a song's frames.
+		\details Each pattern is visited once regardless of how many frames use it, and channels are
+		processed concurrently. Rows up to the song's pattern length are tested.
+		\param Track The song index. */
+	match_t Find(const CFamiTrackerModule &modfile, unsigned Track) const;
+
+	/*!	\brief Computes the result of applying a replacement to a matching note.
+		\param Original The original note.
+		\param Term The replacement term.
+		\param RemoveOriginal Whether fields not present in the replacement term are cleared.
+		\param Chip The sound chip of the note's channel, used to translate effect names.
+		\param EffCount The effect column count of the note's track.
+		\return The replaced note. */
+	stChanNote Replace(const stChanNote &Original, const replaceTerm &Term, bool RemoveOriginal, sound_chip_t Chip, int EffCount) const;
+
+	/*!	\brief Replaces all matching rows in the patterns used by a song's frames.
+		\details Every matching row of a pattern is replaced exactly once, even if the pattern
+		appears in multiple frames.
+		\param Track The song index.
+		\param Term The replacement term.
+		\param RemoveOriginal Whether fields not present in the replacement term are cleared.
+		\return The number of replaced rows. */
+	unsigned ReplaceAll(CFamiTrackerModule &modfile, unsigned Track, const replaceTerm &Term, bool RemoveOriginal) const;
+
+private:
+	static constexpr std::size_t KEY_COUNT = 0x10000u;
+
+	static unsigned MakeKey(unsigned char Hi, unsigned char Lo) noexcept;
+	unsigned GetColumnMask(int EffCount) const noexcept;
+	bool IsMaskMatch(const stChanNote &Note, bool Noise, unsigned ColumnMask) const noexcept;
+
+	std::bitset<KEY_COUNT> notes_[2];		// by note and octave, for non-noise and noise channels
+	bool excluded_[2] = { };
+	std::bitset<0x100u> instruments_;
+	std::bitset<0x100u> volumes_;
+	std::bitset<KEY_COUNT> effects_;		// by effect and parameter
+	bool any_effect_;
+	int eff_column_;
+	bool negate_;
+};
@@ -0,0 +1,440 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+#include "SearchTerm.h"
+#include "NumConv.h"
+#include <cctype>
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+const char NOTE_NAME[7] = {'C', 'D', 'E', 'F', 'G', 'A', 'B'};
+const char NOTE_SIGN[3] = {'b', '-', '#'};
+const note_t NOTE_OFFSET[7] = {note_t::C, note_t::D, note_t::E, note_t::F, note_t::G, note_t::A, note_t::B};
+
+void RaiseIf(bool Check, const std::string &Msg) {
+	if (Check)
+		throw CFindException {Msg};
+}
+
+std::string Quoted(std::string_view str) {
+	return '"' + std::string {str} + '"';
+}
+
+bool IsDecimal(std::string_view str) noexcept {
+	return str.find_first_not_of("0123456789") == std::string_view::npos;
+}
+
+} // namespace
+
+searchTerm::searchTerm() :
+	Note(std::make_unique<NoteRange>()),
+	Oct(std::make_unique<CharRange>()),
+	Inst(std::make_unique<CharRange>(0, MAX_INSTRUMENTS)),
+	Vol(std::make_unique<CharRange>(0, MAX_VOLUME)),
+	EffNumber(),
+	EffParam(std::make_unique<CharRange>()),
+	Definite()
+{
+}
+
+bool searchTerm::IsMatch(const stChanNote &Target, bool Noise, int EffCount, int EffColumn, bool Negate) const
+{
+	if (EffColumn > EffCount && EffColumn != MAX_EFFECT_COLUMNS) EffColumn = EffCount;
+	bool EffectMatch = false;
+
+	if (Definite[WC_NOTE])
+		switch (MatchNote(Target, Noise)) {
+		case note_match_t::exclude: return false;
+		case note_match_t::mismatch: return Negate;
+		case note_match_t::match: break;
+		}
+	if (Definite[WC_INST] && !Inst->IsMatch(Target.Instrument)) return Negate;
+	if (Definite[WC_VOL] && !Vol->IsMatch(Target.Vol)) return Negate;
+	int Limit = MAX_EFFECT_COLUMNS - 1;
+	if (EffCount < Limit) Limit = EffCount;
+	if (EffColumn < Limit) Limit = EffColumn;
+	for (int i = EffColumn % MAX_EFFECT_COLUMNS; i <= Limit; ++i) {
+		if ((!Definite[WC_EFF] || EffNumber[value_cast(Target.Effects[i].fx)])
+		&& (!Definite[WC_PARAM] || EffParam->IsMatch(Target.Effects[i].param)))
+			EffectMatch = true;
+	}
+	if (!EffectMatch) return Negate;
+
+	return !Negate;
+}
+
+bool searchTerm::IsNoteMatch(const stChanNote &Target, bool Noise) const
+{
+	return !Definite[WC_NOTE] || MatchNote(Target, Noise) == note_match_t::match;
+}
+
+searchTerm::note_match_t searchTerm::MatchNote(const stChanNote &Target, bool Noise) const
+{
+	bool Melodic = is_note(Note->Min) && // ||
+				   is_note(Note->Max) &&
+				   Definite[WC_OCT];
+
+	if (NoiseChan) {
+		if (!Noise && Melodic) return note_match_t::exclude;
+		if (!is_note(Note->Min) || !is_note(Note->Max)) {
+			if (!Note->IsMatch(Target.Note)) return note_match_t::mismatch;
+		}
+		else {
+			int NoiseNote = Target.ToMidiNote() % 16;
+			int Low = ft0cc::doc::midi_note(Oct->Min, Note->Min) % 16;
+			int High = ft0cc::doc::midi_note(Oct->Max, Note->Max) % 16;
+			if ((NoiseNote < Low && NoiseNote < High) || (NoiseNote > Low && NoiseNote > High))
+				return note_match_t::mismatch;
+		}
+	}
+	else {
+		if (Noise && Melodic) return note_match_t::exclude;
+		if (Melodic) {
+			if (!is_note(Target.Note))
+				return note_match_t::mismatch;
+			int NoteValue = Target.ToMidiNote();
+			int Low = ft0cc::doc::midi_note(Oct->Min, Note->Min);
+			int High = ft0cc::doc::midi_note(Oct->Max, Note->Max);
+			if ((NoteValue < Low && NoteValue < High) || (NoteValue > Low && NoteValue > High))
+				return note_match_t::mismatch;
+		}
+		else {
+			if (!Note->IsMatch(Target.Note)) return note_match_t::mismatch;
+			if (Definite[WC_OCT] && !Oct->IsMatch(Target.Octave))
+				return note_match_t::mismatch;
+		}
+	}
+
+	return note_match_t::match;
+}
+
+
+
+searchTerm CSearchTermParser::ParseFind(const searchFields &Fields)
+{
+	searchTerm newTerm;
+
+	if (Fields.Note) {
+		bool empty = Fields.Note->empty();
+		ParseNote(newTerm, *Fields.Note, false);
+		ParseNote(newTerm, Fields.Note2.value_or(""), !empty);
+		RaiseIf(((newTerm.Note->Min == note_t::echo && is_note(newTerm.Note->Max)) ||
+			(newTerm.Note->Max == note_t::echo && is_note(newTerm.Note->Min))) &&
+			newTerm.Definite[WC_OCT],
+			"Cannot use both notes and echo buffer in a range search query.");
+	}
+	if (Fields.Inst) {
+		bool empty = Fields.Inst->empty();
+		ParseInst(newTerm, *Fields.Inst, false);
+		ParseInst(newTerm, Fields.Inst2.value_or(""), !empty);
+	}
+	if (Fields.Vol) {
+		bool empty = Fields.Vol->empty();
+		ParseVol(newTerm, *Fields.Vol, false);
+		ParseVol(newTerm, Fields.Vol2.value_or(""), !empty);
+	}
+	if (Fields.Eff)
+		ParseEff(newTerm, *Fields.Eff, false);
+
+	for (int i = 0; i <= 6; ++i) {
+		RaiseIf(i == 6, "Search query is empty.");
+		if (newTerm.Definite[i]) break;
+	}
+
+	return newTerm;
+}
+
+replaceTerm CSearchTermParser::ParseReplace(const searchFields &Fields, bool RemoveOriginal)
+{
+	searchTerm newTerm;
+
+	if (Fields.Note)
+		ParseNote(newTerm, *Fields.Note, false);
+	if (Fields.Inst)
+		ParseInst(newTerm, *Fields.Inst, false);
+	if (Fields.Vol)
+		ParseVol(newTerm, *Fields.Vol, false);
+	if (Fields.Eff)
+		ParseEff(newTerm, *Fields.Eff, false);
+
+	for (int i = 0; i <= 6; ++i) {
+		RaiseIf(i == 6, "Replacement query is empty.");
+		if (newTerm.Definite[i]) break;
+	}
+
+	if ((newTerm.Note->Min == note_t::halt || newTerm.Note->Min == note_t::release) && newTerm.Note->Min == newTerm.Note->Max)
+		newTerm.Oct->Min = newTerm.Oct->Max = 0;
+
+	RaiseIf((newTerm.Definite[WC_NOTE] && !newTerm.Note->IsSingle()) ||
+			(newTerm.Definite[WC_OCT] && !newTerm.Oct->IsSingle()) ||
+			(newTerm.Definite[WC_INST] && !newTerm.Inst->IsSingle()) ||
+			(newTerm.Definite[WC_VOL] && !newTerm.Vol->IsSingle()) ||
+			(newTerm.Definite[WC_PARAM] && !newTerm.EffParam->IsSingle()),
+			"Replacement query cannot contain wildcards.");
+
+	if (RemoveOriginal) {
+		RaiseIf(newTerm.Definite[WC_NOTE] && !newTerm.Definite[WC_OCT],
+				"Replacement query cannot contain a note with an unspecified octave if "
+				"the option \"Remove original data\" is enabled.");
+		RaiseIf(newTerm.Definite[WC_EFF] && !newTerm.Definite[WC_PARAM],
+				"Replacement query cannot contain an effect with an unspecified parameter if "
+				"the option \"Remove original data\" is enabled.");
+	}
+
+	return ToReplace(newTerm);
+}
+
+void CSearchTermParser::ParseNote(searchTerm &Term, std::string_view str, bool Half)
+{
+	if (!Half) Term.Definite[WC_NOTE] = Term.Definite[WC_OCT] = false;
+
+	if (str.empty()) {
+		if (!Half) {
+			Term.Definite[WC_NOTE] = true;
+			Term.Definite[WC_OCT] = true;
+			Term.Note->Set(note_t::none);
+			Term.Oct->Set(0);
+		}
+		return;
+	}
+
+	RaiseIf(Half && (!Term.Note->IsSingle() || !Term.Oct->IsSingle()),
+		"Cannot use wildcards in a range search query.");
+
+	if (str == "-" || str == "---") {
+		RaiseIf(Half, "Cannot use note cut in a range search query.");
+		Term.Definite[WC_NOTE] = true;
+		Term.Definite[WC_OCT] = true;
+		Term.Note->Set(note_t::halt);
+		Term.Oct->Min = 0; Term.Oct->Max = 7;
+		return;
+	}
+
+	if (str == "=" || str == "===") {
+		RaiseIf(Half, "Cannot use note release in a range search query.");
+		Term.Definite[WC_NOTE] = true;
+		Term.Definite[WC_OCT] = true;
+		Term.Note->Set(note_t::release);
+		Term.Oct->Min = 0; Term.Oct->Max = 7;
+		return;
+	}
+
+	if (str == ".") {
+		RaiseIf(Half, "Cannot use wildcards in a range search query.");
+		Term.Definite[WC_NOTE] = true;
+		Term.Note->Min = note_t::C;
+		Term.Note->Max = note_t::echo;
+		return;
+	}
+
+	if (str.front() == '^') {
+		RaiseIf(Half && !Term.Definite[WC_OCT], "Cannot use wildcards in a range search query.");
+		Term.Definite[WC_NOTE] = true;
+		Term.Definite[WC_OCT] = true;
+		Term.Note->Set(note_t::echo);
+		str.remove_prefix(1);
+		if (!str.empty()) {
+			if (str.front() == '-')
+				str.remove_prefix(1);
+			int BufPos = conv::to_int(str).value_or(static_cast<int>(ECHO_BUFFER_LENGTH));
+			RaiseIf(BufPos >= static_cast<int>(ECHO_BUFFER_LENGTH), "Echo buffer access \"^" + std::string {str} +
+				"\" is out of range, maximum is " + conv::from_int(ECHO_BUFFER_LENGTH - 1) + ".");
+			Term.Oct->Set(BufPos, Half);
+		}
+		else {
+			Term.Oct->Min = 0; Term.Oct->Max = ECHO_BUFFER_LENGTH - 1;
+		}
+		return;
+	}
+
+	if (str.substr(1, 2) != "-#") for (int i = 0; i < 7; ++i) {
+		if (std::toupper(static_cast<unsigned char>(str.front())) == NOTE_NAME[i]) {
+			Term.Definite[WC_NOTE] = true;
+			int Note = value_cast(NOTE_OFFSET[i]);
+			int Oct = 0;
+			for (int j = 0; j < 3; ++j) if (str.size() > 1 && str[1] == NOTE_SIGN[j]) {
+				Note += j - 1;
+				str.remove_prefix(1); break;
+			}
+			str.remove_prefix(1);
+			if (!str.empty()) {
+				Term.Definite[WC_OCT] = true;
+				RaiseIf(!IsDecimal(str), "Unknown note octave.");
+				Oct = conv::to_int(str).value_or(-1);
+				RaiseIf(Oct >= OCTAVE_RANGE || Oct < 0,
+					"Note octave " + Quoted(str) + " is out of range, maximum is " + conv::from_int(OCTAVE_RANGE - 1) + ".");
+				Term.Oct->Set(Oct, Half);
+			}
+			else RaiseIf(Half, "Cannot use wildcards in a range search query.");
+			while (Note > value_cast(note_t::B)) { Note -= NOTE_RANGE; if (Term.Definite[WC_OCT]) Term.Oct->Set(++Oct, Half); }
+			while (Note < value_cast(note_t::C)) { Note += NOTE_RANGE; if (Term.Definite[WC_OCT]) Term.Oct->Set(--Oct, Half); }
+			Term.Note->Set(enum_cast<note_t>(Note), Half);
+			RaiseIf(Term.Definite[WC_OCT] && (Oct >= OCTAVE_RANGE || Oct < 0),
+				"Note octave " + Quoted(str) + " is out of range, check if the note contains Cb or B#.");
+			return;
+		}
+	}
+
+	if (str.size() == 3 && str.substr(1) == "-#") {
+		Term.Definite[WC_NOTE] = true;
+		Term.Definite[WC_OCT] = true;
+		if (str.front() == '.') {
+			Term.Note->Min = note_t::C; Term.Note->Max = note_t::Ds;
+			Term.Oct->Min = 0; Term.Oct->Max = 1;
+		}
+		else {
+			int NoteValue = GetHex(str.substr(0, 1));
+			Term.Note->Set(ft0cc::doc::pitch_from_midi(NoteValue), Half);
+			Term.Oct->Set(ft0cc::doc::oct_from_midi(NoteValue), Half);
+		}
+		Term.NoiseChan = true;
+		return;
+	}
+
+	if (IsDecimal(str)) {
+		int NoteValue = conv::to_int(str).value_or(-1);
+		RaiseIf(NoteValue == 0 && str.front() != '0', "Invalid note " + Quoted(str) + ".");
+		RaiseIf(NoteValue >= NOTE_COUNT || NoteValue < 0,
+			"Note value " + Quoted(str) + " is out of range, maximum is " + conv::from_int(NOTE_COUNT - 1) + ".");
+		Term.Definite[WC_NOTE] = true;
+		Term.Definite[WC_OCT] = true;
+		Term.Note->Set(ft0cc::doc::pitch_from_midi(NoteValue), Half);
+		Term.Oct->Set(ft0cc::doc::oct_from_midi(NoteValue), Half);
+		return;
+	}
+
+	RaiseIf(true, "Unknown note query.");
+}
+
+void CSearchTermParser::ParseInst(searchTerm &Term, std::string_view str, bool Half)
+{
+	Term.Definite[WC_INST] = true;
+	if (str.empty()) {
+		if (!Half)
+			Term.Inst->Set(MAX_INSTRUMENTS);
+		return;
+	}
+	RaiseIf(Half && !Term.Inst->IsSingle(), "Cannot use wildcards in a range search query.");
+
+	if (str == ".") {
+		RaiseIf(Half, "Cannot use wildcards in a range search query.");
+		Term.Inst->Min = 0;
+		Term.Inst->Max = MAX_INSTRUMENTS - 1;
+	}
+	else if (str == "&&") {		// // // 050B
+		RaiseIf(Half, "Cannot use && in a range search query.");
+		Term.Inst->Set(HOLD_INSTRUMENT);
+	}
+	else {
+		unsigned char Val = GetHex(str);
+		RaiseIf(Val >= MAX_INSTRUMENTS,
+			"Instrument " + Quoted(str) + " is out of range, maximum is " + conv::from_int_hex(MAX_INSTRUMENTS - 1) + ".");
+		Term.Inst->Set(Val, Half);
+	}
+}
+
+void CSearchTermParser::ParseVol(searchTerm &Term, std::string_view str, bool Half)
+{
+	Term.Definite[WC_VOL] = true;
+	if (str.empty()) {
+		if (!Half)
+			Term.Vol->Set(MAX_VOLUME);
+		return;
+	}
+	RaiseIf(Half && !Term.Vol->IsSingle(), "Cannot use wildcards in a range search query.");
+
+	if (str == ".") {
+		RaiseIf(Half, "Cannot use wildcards in a range search query.");
+		Term.Vol->Min = 0;
+		Term.Vol->Max = MAX_VOLUME - 1;
+	}
+	else {
+		unsigned char Val = GetHex(str);
+		RaiseIf(Val >= MAX_VOLUME,
+			"Channel volume " + Quoted(str) + " is out of range, maximum is " + conv::from_int_hex(MAX_VOLUME - 1) + ".");
+		Term.Vol->Set(Val, Half);
+	}
+}
+
+void CSearchTermParser::ParseEff(searchTerm &Term, std::string_view str, bool Half)
+{
+	RaiseIf(str.size() == 2, "Effect " + Quoted(str.substr(0, 1)) + " is too short.");
+
+	if (str.empty()) {
+		Term.Definite[WC_EFF] = true;
+		Term.Definite[WC_PARAM] = true;
+		Term.EffNumber[value_cast(effect_t::none)] = true;
+		Term.EffParam->Set(0);
+	}
+	else if (str == ".") {
+		Term.Definite[WC_EFF] = true;
+		for (auto fx : enum_values<effect_t>())
+			Term.EffNumber[value_cast(fx)] = true;
+	}
+	else {
+		char Name = str.front();
+		bool found = false;
+		for (auto fx : enum_values<effect_t>()) {
+			if (Name == EFF_CHAR[value_cast(fx)]) {
+				Term.Definite[WC_EFF] = true;
+				Term.EffNumber[value_cast(fx)] = true;
+				found = true;
+			}
+		}
+		RaiseIf(!found, "Unknown effect " + Quoted(str.substr(0, 1)) + " found in search query.");
+	}
+	if (str.size() > 1) {
+		Term.Definite[WC_PARAM] = true;
+		Term.EffParam->Set(GetHex(str.substr(str.size() - 2)));
+	}
+}
+
+unsigned CSearchTermParser::GetHex(std::string_view str)
+{
+	auto val = conv::to_int(str, 16);
+	RaiseIf(!val, "Invalid hexadecimal " + Quoted(str) + ".");
+	return *val;
+}
+
+replaceTerm CSearchTermParser::ToReplace(const searchTerm &x)
+{
+	replaceTerm Term;
+	Term.Note.Note = x.Note->Min;
+	Term.Note.Octave = x.Oct->Min;
+	Term.Note.Instrument = x.Inst->Min;
+	Term.Note.Vol = x.Vol->Min;
+	Term.NoiseChan = x.NoiseChan;
+	if (x.EffNumber[value_cast(effect_t::none)])
+		Term.Note.Effects[0].fx = effect_t::none;
+	else
+		for (auto fx : enum_values<effect_t>())
+			if (x.EffNumber[value_cast(fx)]) {
+				Term.Note.Effects[0].fx = fx;
+				break;
+			}
+	Term.Note.Effects[0].param = x.EffParam->Min;
+	std::copy(std::begin(x.Definite), std::end(x.Definite), std::begin(Term.Definite));
+
+	return Term;
+}
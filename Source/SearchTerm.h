@@ -0,0 +1,172 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+#pragma once
+
+#include <memory>
+#include <limits>
+#include <type_traits>
+#include <string>
+#include <string_view>
+#include <optional>
+#include <stdexcept>
+
+#include "PatternNote.h"
+
+// // // search terms used by find / replace
+
+namespace details {
+
+template <typename T, bool>
+struct underlying_type {
+	using type = T;
+};
+template <typename T>
+struct underlying_type<T, true> {
+	using type = std::underlying_type_t<T>;
+};
+template <typename T>
+using underlying_type_t = typename underlying_type<T, std::is_enum_v<T>>::type;
+
+} // namespace details
+
+template <typename T>
+struct FindRange {
+	constexpr FindRange() noexcept = default;
+	constexpr FindRange(T a, T b) noexcept : Min(a), Max(b) { }
+
+	constexpr void Set(T x, bool Half = false) noexcept {
+		if (!Half)
+			Min = x;
+		Max = x;
+	}
+	constexpr bool IsMatch(T x) const noexcept {
+		return (x >= Min && x <= Max) || (x >= Max && x <= Min);
+	}
+	constexpr bool IsSingle() const noexcept {
+		return Min == Max;
+	}
+
+	T Min = static_cast<T>(std::numeric_limits<details::underlying_type_t<T>>::min());
+	T Max = static_cast<T>(std::numeric_limits<details::underlying_type_t<T>>::max());
+};
+
+using CharRange = FindRange<unsigned char>;
+using NoteRange = FindRange<note_t>;
+
+// indices of searchTerm::Definite
+enum {
+	WC_NOTE = 0,
+	WC_OCT,
+	WC_INST,
+	WC_VOL,
+	WC_EFF,
+	WC_PARAM,
+};
+
+class searchTerm
+{
+public:
+	searchTerm();
+
+	/*!	\brief Checks whether a note matches the search term.
+		\param Target The note to test.
+		\param Noise Whether the note belongs to a noise channel.
+		\param EffCount The effect column count of the note's track.
+		\param EffColumn The effect column to search, or MAX_EFFECT_COLUMNS to search all columns.
+		\param Negate Whether to return the opposite result for notes which can be compared.
+		\return True if the note matches. */
+	bool IsMatch(const stChanNote &Target, bool Noise, int EffCount, int EffColumn, bool Negate) const;
+
+	/*!	\brief Checks whether the note and octave fields of a note match the search term.
+		\details Other fields are ignored, and the result is never negated.
+		\param Target The note to test.
+		\param Noise Whether the note belongs to a noise channel.
+		\return True if the note fields match. */
+	bool IsNoteMatch(const stChanNote &Target, bool Noise) const;
+
+	std::unique_ptr<NoteRange> Note;
+	std::unique_ptr<CharRange> Oct, Inst, Vol;
+	bool EffNumber[enum_count<effect_t>() + 1] = { };
+	std::unique_ptr<CharRange> EffParam;
+	bool Definite[6] = { };
+	bool NoiseChan = false;
+
+private:
+	friend class CSearchQuery;		// // //
+
+	enum class note_match_t { match, mismatch, exclude };
+	note_match_t MatchNote(const stChanNote &Target, bool Noise) const;
+};
+
+struct replaceTerm
+{
+	stChanNote Note;
+	bool Definite[6];
+	bool NoiseChan;
+};
+
+// Exception for search queries
+
+class CFindException : public std::runtime_error
+{
+public:
+	CFindException(const std::string &msg) : std::runtime_error(msg) { }
+};
+
+// // // text of the find / replace query fields, empty for fields that are not enabled
+struct searchFields
+{
+	std::optional<std::string> Note, Note2;
+	std::optional<std::string> Inst, Inst2;
+	std::optional<std::string> Vol, Vol2;
+	std::optional<std::string> Eff;
+};
+
+/*!
+	\brief Parser for the textual find / replace queries, independent of the find dialog.
+	\details All methods throw CFindException if the query is malformed.
+*/
+class CSearchTermParser
+{
+public:
+	/*!	\brief Parses a search query.
+		\details The second field of each pair is the upper bound of a range search; it is ignored
+		if the first field is empty.
+		\param Fields The query text. */
+	static searchTerm ParseFind(const searchFields &Fields);
+
+	/*!	\brief Parses a replacement query. The second fields of the ranges are ignored.
+		\param Fields The query text.
+		\param RemoveOriginal Whether the original data of matching notes is discarded. */
+	static replaceTerm ParseReplace(const searchFields &Fields, bool RemoveOriginal);
+
+	static void ParseNote(searchTerm &Term, std::string_view str, bool Half);
+	static void ParseInst(searchTerm &Term, std::string_view str, bool Half);
+	static void ParseVol(searchTerm &Term, std::string_view str, bool Half);
+	static void ParseEff(searchTerm &Term, std::string_view str, bool Half);
+
+private:
+	static unsigned GetHex(std::string_view str);
+	static replaceTerm ToReplace(const searchTerm &x);
+};
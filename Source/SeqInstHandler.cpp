@@ -36,13 +36,6 @@
 
 CSeqInstHandler::CSeqInstHandler(CChannelHandlerInterface *pInterface, int Vol, int Duty) :
 	CInstHandler(pInterface, Vol),
-	m_SequenceInfo {
-		{sequence_t::Volume, { }},
-		{sequence_t::Arpeggio, { }},
-		{sequence_t::Pitch, { }},
-		{sequence_t::HiPitch, { }},
-		{sequence_t::DutyCycle, { }},
-	},
 	m_iDefaultDuty(Duty)
 {
 }
@@ -54,20 +47,28 @@ void CSeqInstHandler::LoadInstrument(std::shared_ptr<CInstrument> pInst)
 	if (!pSeqInst)
 		return;
 
-	for (auto &[seqType, info] : m_SequenceInfo)
-		if (!pSeqInst->GetSeqEnable(seqType))
-			ClearSequence(seqType);
+	// // // sequences that did not change keep their positions
+	auto pProgram = pSeqInst->GetProgram();
+	for (std::size_t i = 0; i < SEQ_COUNT; ++i) {
+		auto &info = m_SequenceInfo[i];
+		const auto *pSeq = pProgram->Get(enum_cast<sequence_t>(i));
+		if (!pSeq)
+			info = seq_info_t { };
 		else {
-			const auto pSequence = pSeqInst->GetSequence(seqType);
-			if (pSequence != info.m_pSequence || info.m_iSeqState == seq_state_t::Disabled)
-				SetupSequence(seqType, std::move(pSequence));
+			const auto *pOld = m_pProgram ? m_pProgram->Get(enum_cast<sequence_t>(i)) : nullptr;
+			if (!pOld || pOld->Source != pSeq->Source || info.m_iSeqState == seq_state_t::Disabled)
+				info = {seq_state_t::Running, 0};
 		}
+	}
+	m_pProgram = std::move(pProgram);
 }
 
 void CSeqInstHandler::TriggerInstrument()
 {
-	for (auto &x : m_SequenceInfo)
-		x.second.Trigger();
+	if (m_pProgram)		// // //
+		for (std::size_t i = 0; i < SEQ_COUNT; ++i)
+			if (m_pProgram->Get(enum_cast<sequence_t>(i)))
+				m_SequenceInfo[i].Trigger();
 
 	m_iVolume = m_iDefaultVolume;
 	m_iNoteOffset = 0;
@@ -82,36 +83,42 @@ void CSeqInstHandler::TriggerInstrument()
 
 void CSeqInstHandler::ReleaseInstrument()
 {
-	if (!m_pInterface->IsReleasing())
-		for (auto &x : m_SequenceInfo)
-			x.second.Release();
+	if (!m_pInterface->IsReleasing() && m_pProgram)		// // //
+		for (std::size_t i = 0; i < SEQ_COUNT; ++i)
+			if (const auto *pSeq = m_pProgram->Get(enum_cast<sequence_t>(i)))
+				m_SequenceInfo[i].Release(*pSeq);
 }
 
 void CSeqInstHandler::UpdateInstrument()
 {
-	if (!m_pInterface->IsActive())
+	if (!m_pInterface->IsActive() || !m_pProgram)		// // //
 		return;
-	for (auto &[_, info] : m_SequenceInfo) {
-		(void)_;
-		const auto &pSeq = info.m_pSequence;
-		if (!pSeq || pSeq->GetItemCount() == 0)
+
+	// // // pick up edits made in the sequence editor
+	if (!m_pProgram->IsCurrent())
+		m_pProgram = m_pProgram->Recompile();
+
+	for (std::size_t i = 0; i < SEQ_COUNT; ++i) {		// // //
+		auto &info = m_SequenceInfo[i];
+		const auto *pSeq = m_pProgram->Get(enum_cast<sequence_t>(i));
+		if (!pSeq || pSeq->Length == 0)
 			continue;
 		switch (info.m_iSeqState) {
 		case seq_state_t::Running:
 			ProcessSequence(*pSeq, info.m_iSeqPointer);
-			info.Step(m_pInterface->IsReleasing());
+			info.Step(*pSeq, m_pInterface->IsReleasing());
 			break;
 
 		case seq_state_t::End:
-			switch (pSeq->GetSequenceType()) {
+			switch (pSeq->Type) {
 			case sequence_t::Arpeggio:
-				if (pSeq->GetSetting() == SETTING_ARP_FIXED)
+				if (pSeq->Setting == SETTING_ARP_FIXED)
 					m_pInterface->SetPeriod(m_pInterface->TriggerNote(m_pInterface->GetNote()));
 				break;
 			}
 			info.m_iSeqState = seq_state_t::Halt;
 #ifndef FT0CC_EXT_BUILD
-			FTEnv.GetSoundGenerator()->SetSequencePlayPos(pSeq, -1);
+			FTEnv.GetSoundGenerator()->SetSequencePlayPos(pSeq->Source, -1);
 #endif
 			break;
 
@@ -122,12 +129,17 @@ void CSeqInstHandler::UpdateInstrument()
 	}
 }
 
-bool CSeqInstHandler::ProcessSequence(const CSequence &Seq, int Pos)
+const CSeqProgram::seq_code_t *CSeqInstHandler::GetSequence(sequence_t Index) const		// // //
 {
-	int Value = Seq.GetItem(Pos);
-	seq_setting_t Setting = Seq.GetSetting();
+	return m_pProgram ? m_pProgram->Get(Index) : nullptr;
+}
 
-	switch (Seq.GetSequenceType()) {
+bool CSeqInstHandler::ProcessSequence(const CSeqProgram::seq_code_t &Seq, int Pos)		// // //
+{
+	int Value = Seq.Items[Pos];
+	seq_setting_t Setting = Seq.Setting;
+
+	switch (Seq.Type) {
 	// Volume modifier
 	case sequence_t::Volume:
 		m_pInterface->SetVolume(Value);
@@ -186,47 +198,31 @@ bool CSeqInstHandler::ProcessSequence(const CSequence &Seq, int Pos)
 	return false;
 }
 
-void CSeqInstHandler::SetupSequence(sequence_t Index, std::shared_ptr<const CSequence> pSequence)		// // //
-{
-	m_SequenceInfo[Index] = {std::move(pSequence), seq_state_t::Running, 0};
-}
-
-void CSeqInstHandler::ClearSequence(sequence_t Index)
-{
-	m_SequenceInfo[Index] = seq_info_t { };		// // //
-}
-
 void CSeqInstHandler::seq_info_t::Trigger() {
-	if (m_pSequence) {
-		m_iSeqState = seq_state_t::Running;
-		m_iSeqPointer = 0;
-	}
+	m_iSeqState = seq_state_t::Running;
+	m_iSeqPointer = 0;
 }
 
-void CSeqInstHandler::seq_info_t::Release() {
-	if (m_pSequence && (m_iSeqState == seq_state_t::Running || m_iSeqState == seq_state_t::End)) {
-		int ReleasePoint = m_pSequence->GetReleasePoint();
-		if (ReleasePoint != -1) {
-			m_iSeqPointer = ReleasePoint;
+void CSeqInstHandler::seq_info_t::Release(const CSeqProgram::seq_code_t &Seq) {		// // //
+	if (m_iSeqState == seq_state_t::Running || m_iSeqState == seq_state_t::End) {
+		if (Seq.Release != -1) {
+			m_iSeqPointer = Seq.Release;
 			m_iSeqState = seq_state_t::Running;
 		}
 	}
 }
 
-void CSeqInstHandler::seq_info_t::Step(bool isReleasing) {
+void CSeqInstHandler::seq_info_t::Step(const CSeqProgram::seq_code_t &Seq, bool isReleasing) {		// // //
 	++m_iSeqPointer;
-	int Release = m_pSequence->GetReleasePoint();
-	int Items = m_pSequence->GetItemCount();
-	int Loop = m_pSequence->GetLoopPoint();
-	if (m_iSeqPointer == (Release + 1) || m_iSeqPointer >= Items) {
+	if (m_iSeqPointer == Seq.Hold || m_iSeqPointer >= Seq.Length) {
 		// End point reached
-		if (Loop != -1 && !(isReleasing && Release != -1) && Loop < Release) {		// // //
-			m_iSeqPointer = Loop;
+		if (Seq.ReleaseLoop != -1 && !isReleasing) {
+			m_iSeqPointer = Seq.ReleaseLoop;
 		}
-		else if (m_iSeqPointer >= Items) {
+		else if (m_iSeqPointer >= Seq.Length) {
 			// End of sequence
-			if (Loop >= Release && Loop != -1)		// // //
-				m_iSeqPointer = Loop;
+			if (Seq.EndLoop != -1)
+				m_iSeqPointer = Seq.EndLoop;
 			else
 				m_iSeqState = seq_state_t::End;
 		}
@@ -236,6 +232,6 @@ void CSeqInstHandler::seq_info_t::Step(bool isReleasing) {
 		}
 	}
 #ifndef FT0CC_EXT_BUILD
-	FTEnv.GetSoundGenerator()->SetSequencePlayPos(m_pSequence, m_iSeqPointer);
+	FTEnv.GetSoundGenerator()->SetSequencePlayPos(Seq.Source, m_iSeqPointer);
 #endif
 }
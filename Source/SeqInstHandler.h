@@ -24,8 +24,8 @@
 #pragma once
 
 #include "InstHandler.h"
-#include "Sequence.h"
-#include <unordered_map>
+#include "SeqProgram.h"		// // //
+#include <array>
 
 class CSeqInstrument;
 
@@ -60,35 +60,32 @@ public:
 protected:
 	/*!	\brief Processes the value retrieved from a sequence.
 		\return True if the sequence has finished processing.
-		\param Seq Reference to the sequence.
+		\param Seq Reference to the compiled sequence.
 		\param Pos Sequence position. */
-	virtual bool ProcessSequence(const CSequence &Seq, int Pos);
+	virtual bool ProcessSequence(const CSeqProgram::seq_code_t &Seq, int Pos);		// // //
 
-	/*!	\brief Prepares a sequence type for use by CSeqInstHandler::UpdateInstrument.
-		\param Index The sequence type.
-		\param pSequence Pointer to the sequence. */
-	void SetupSequence(sequence_t Index, std::shared_ptr<const CSequence> pSequence);
-
-	/*!	\brief Clears a sequence type from use.
+	/*!	\brief Returns the compiled sequence of a given type used by the current instrument.
+		\return Pointer to the compiled sequence, or nullptr if it is not enabled.
 		\param Index The sequence type. */
-	void ClearSequence(sequence_t Index);
+	const CSeqProgram::seq_code_t *GetSequence(sequence_t Index) const;		// // //
 
 protected:
 	/*! \brief A struct containing runtime state of a given sequence type. */
 	struct seq_info_t {
 		void Trigger();
-		void Release();
-		void Step(bool isReleasing);
+		void Release(const CSeqProgram::seq_code_t &Seq);
+		void Step(const CSeqProgram::seq_code_t &Seq, bool isReleasing);
 
-		/*!	\brief Pointer to the sequence used by the current instrument. */
-		std::shared_ptr<const CSequence> m_pSequence;
 		/*!	\brief State of the current sequence type. */
 		seq_state_t m_iSeqState = seq_state_t::Disabled;
 		/*!	\brief Tick index of the current sequence type. */
 		int m_iSeqPointer = 0;
 	};
-	/*! \brief Sequence states for the default sequence types. */
-	std::unordered_map<sequence_t, seq_info_t> m_SequenceInfo;
+	/*!	\brief The compiled sequences of the current instrument.
+		\details Loading another instrument only exchanges this pointer. */
+	std::shared_ptr<const CSeqProgram> m_pProgram;		// // //
+	/*! \brief Sequence states for the default sequence types, indexed by sequence type. */
+	std::array<seq_info_t, SEQ_COUNT> m_SequenceInfo = { };		// // //
 
 	/*!	\brief The current duty cycle of the instrument.
 		\details The exact interpretation of this member may not be identical across sound channels.
@@ -22,6 +22,7 @@
 
 #include "SeqInstHandlerN163.h"
 #include "ChannelHandlerInterface.h"
+#include <algorithm>		// // //
 
 /*
  * Class CSeqInstHandlerN163
@@ -78,9 +79,8 @@ void CSeqInstHandlerN163::UpdateWave(const CInstrumentN163 &Inst)
 	// raw position and count
 	// int Duty = m_pInterface->GetDutyPeriod();
 	// if (Duty < 0) return;
-	int Index = m_pInterface->GetDutyPeriod();
-	if (Index >= Inst.GetWaveCount())
-		Index = Inst.GetWaveCount() - 1;
+	// // // negative duty sequence values select the first wave
+	int Index = std::clamp(m_pInterface->GetDutyPeriod(), 0, Inst.GetWaveCount() - 1);
 	const unsigned Count = Inst.GetWaveSize() >> 1;
 	for (unsigned i = 0; i < Count; ++i)
 		m_pBufferCurrent[i] = Inst.GetSample(Index, 2 * i) | (Inst.GetSample(Index, 2 * i + 1) << 4);
@@ -24,13 +24,13 @@
 #include "ChannelHandlerInterface.h"
 #include "Sequence.h"
 
-bool CSeqInstHandlerS5B::ProcessSequence(const CSequence &Seq, int Pos)
+bool CSeqInstHandlerS5B::ProcessSequence(const CSeqProgram::seq_code_t &Seq, int Pos)		// // //
 {
-	switch (Seq.GetSequenceType()) {
+	switch (Seq.Type) {
 	case sequence_t::DutyCycle:
 		if (auto pChan = dynamic_cast<CChannelHandlerInterfaceS5B *>(m_pInterface)) {
-			m_pInterface->SetDutyPeriod(Seq.GetItem(Pos) & 0xE0);
-			pChan->SetNoiseFreq(Seq.GetItem(Pos) & 0x1F);
+			m_pInterface->SetDutyPeriod(Seq.Items[Pos] & 0xE0);
+			pChan->SetNoiseFreq(Seq.Items[Pos] & 0x1F);
 			return true;
 		}
 	}
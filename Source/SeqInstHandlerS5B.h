@@ -35,5 +35,5 @@ public:
 	using CSeqInstHandler::CSeqInstHandler;
 
 private:
-	virtual bool ProcessSequence(const CSequence &Seq, int Pos);
+	virtual bool ProcessSequence(const CSeqProgram::seq_code_t &Seq, int Pos);		// // //
 };
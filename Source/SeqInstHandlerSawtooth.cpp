@@ -26,8 +26,8 @@
 void CSeqInstHandlerSawtooth::TriggerInstrument()
 {
 	CSeqInstHandler::TriggerInstrument();
-	const auto &pVolSeq = m_SequenceInfo[sequence_t::Volume].m_pSequence;
-	m_bIgnoreDuty = pVolSeq && pVolSeq->GetSetting() == SETTING_VOL_64_STEPS;
+	const auto *pVolSeq = GetSequence(sequence_t::Volume);		// // //
+	m_bIgnoreDuty = pVolSeq && pVolSeq->Setting == SETTING_VOL_64_STEPS;
 }
 
 bool CSeqInstHandlerSawtooth::IsDutyIgnored() const
@@ -23,6 +23,7 @@
 #include "SeqInstrument.h"
 #include "InstrumentManagerInterface.h"
 #include "Sequence.h"
+#include "SeqProgram.h"		// // //
 
 /*
  * Base class for instruments using sequences
@@ -108,6 +109,17 @@ void CSeqInstrument::SetSequence(sequence_t SeqType, std::shared_ptr<CSequence>
 		m_pInstManager->SetSequence(m_iType, SeqType, it->second.second, std::move(pSeq));
 }
 
+std::shared_ptr<const CSeqProgram> CSeqInstrument::GetProgram() const		// // //
+{
+	// the sound thread and the instrument editor may both compile the program
+	auto pProgram = std::atomic_load(&program_);
+	if (!pProgram || !pProgram->Matches(*this)) {
+		pProgram = CSeqProgram::Compile(*this);
+		std::atomic_store(&program_, pProgram);
+	}
+	return pProgram;
+}
+
 bool CSeqInstrument::CanRelease() const
 {
 	return GetSeqEnable(sequence_t::Volume) && GetSequence(sequence_t::Volume)->GetReleasePoint() != -1;
@@ -28,6 +28,7 @@
 #include <unordered_map>
 
 class CSequence;
+class CSeqProgram;		// // //
 enum class sequence_t : unsigned;
 
 class CSeqInstrument : public CInstrument		// // //
@@ -46,6 +47,10 @@ public:
 	virtual std::shared_ptr<CSequence> GetSequence(sequence_t SeqType) const;		// // //
 	virtual void	SetSequence(sequence_t SeqType, std::shared_ptr<CSequence> pSeq);		// // // register sequence in document
 
+	// // // Returns the compiled sequences of the instrument, the program is compiled again only
+	// if the sequences or their assignment have changed since the last call
+	std::shared_ptr<const CSeqProgram> GetProgram() const;
+
 	// static const int SEQUENCE_TYPES[] = {sequence_t::Volume, sequence_t::Arpeggio, sequence_t::Pitch, sequence_t::HiPitch, sequence_t::DutyCycle};
 	virtual const char *GetSequenceName(int Index) const { return nullptr; }		// // //
 
@@ -55,4 +60,5 @@ protected:
 
 private:
 	std::unordered_map<sequence_t, std::pair<bool, int>> seq_indices_;		// // //
+	mutable std::shared_ptr<const CSeqProgram> program_;		// // //
 };
@@ -0,0 +1,97 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+#include "SeqProgram.h"
+#include "SeqInstrument.h"
+
+/*
+ * Class CSeqProgram
+ */
+
+std::shared_ptr<const CSeqProgram> CSeqProgram::Compile(const CSeqInstrument &Inst)
+{
+	auto pProgram = std::make_shared<CSeqProgram>();
+	foreachSeq([&] (sequence_t i) {
+		if (Inst.GetSeqEnable(i))
+			pProgram->Assign(value_cast(i), Inst.GetSequence(i));
+	});
+	return pProgram;
+}
+
+std::shared_ptr<const CSeqProgram> CSeqProgram::Recompile() const
+{
+	auto pProgram = std::make_shared<CSeqProgram>();
+	for (std::size_t i = 0; i < SEQ_COUNT; ++i)
+		pProgram->Assign(i, sources_[i]);
+	return pProgram;
+}
+
+bool CSeqProgram::IsCurrent() const
+{
+	for (const auto &code : codes_)
+		if (code.Source && code.Source->GetVersion() != code.Version)
+			return false;
+	return true;
+}
+
+bool CSeqProgram::Matches(const CSeqInstrument &Inst) const
+{
+	if (!IsCurrent())
+		return false;
+	bool Same = true;
+	foreachSeq([&] (sequence_t i) {
+		const CSequence *pSeq = Inst.GetSeqEnable(i) ? Inst.GetSequence(i).get() : nullptr;
+		if (pSeq != sources_[value_cast(i)].get())
+			Same = false;
+	});
+	return Same;
+}
+
+const CSeqProgram::seq_code_t *CSeqProgram::Get(sequence_t Index) const
+{
+	const auto &code = codes_[value_cast(Index)];
+	return code.Source ? &code : nullptr;
+}
+
+void CSeqProgram::Assign(std::size_t Index, std::shared_ptr<const CSequence> pSeq)
+{
+	auto &code = codes_[Index];
+	code = seq_code_t { };
+	if (pSeq) {
+		const int Length = pSeq->GetItemCount();
+		const int Loop = pSeq->GetLoopPoint();
+		const int Release = pSeq->GetReleasePoint();
+
+		code.Type = pSeq->GetSequenceType();
+		code.Setting = pSeq->GetSetting();
+		code.Length = Length;
+		code.Release = Release;
+		code.Hold = Release != -1 ? Release + 1 : -1;
+		code.ReleaseLoop = Loop != -1 && Loop < Release ? Loop : -1;
+		code.EndLoop = Loop != -1 && Loop >= Release ? Loop : -1;
+		for (int i = 0; i < MAX_SEQUENCE_ITEMS; ++i)
+			code.Items[i] = pSeq->GetItem(i);
+		code.Source = pSeq.get();
+		code.Version = pSeq->GetVersion();
+	}
+	sources_[Index] = std::move(pSeq);
+}
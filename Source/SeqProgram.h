@@ -0,0 +1,87 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+#pragma once
+
+#include "Sequence.h"
+#include <array>
+#include <memory>
+
+class CSeqInstrument;
+
+/*!
+	\brief A flat copy of the sequences used by a sequence instrument.
+	\details The loop and release points are resolved into the positions that the instrument
+	handler jumps to, so that playing a sequence does not need to look up or inspect the
+	instrument's sequences on every tick. Programs are immutable; a program whose sequences
+	have been modified is replaced with a recompiled one.
+*/
+class CSeqProgram
+{
+public:
+	/*!	\brief The compiled form of one sequence. */
+	struct seq_code_t {
+		/*!	\brief Type of the source sequence. */
+		sequence_t Type = sequence_t::none;
+		/*!	\brief Setting of the source sequence. */
+		seq_setting_t Setting = SETTING_DEFAULT;
+		/*!	\brief Number of items in the sequence. */
+		int Length = 0;
+		/*!	\brief Release point, or -1 if the sequence has none. */
+		int Release = -1;
+		/*!	\brief Position at which the sequence waits for the note to be released, or -1. */
+		int Hold = -1;
+		/*!	\brief Loop point used before the note is released, or -1. */
+		int ReleaseLoop = -1;
+		/*!	\brief Loop point used at the end of the sequence, or -1 if the sequence ends there. */
+		int EndLoop = -1;
+		/*!	\brief Values of the sequence, including unused items past its length. */
+		std::array<int8_t, MAX_SEQUENCE_ITEMS> Items = { };
+		/*!	\brief The source sequence, used to identify it in the sequence editor. */
+		const CSequence *Source = nullptr;
+		/*!	\brief Version of the source sequence at the time of compilation. */
+		unsigned int Version = 0;
+	};
+
+	/*!	\brief Compiles the enabled sequences of an instrument. */
+	static std::shared_ptr<const CSeqProgram> Compile(const CSeqInstrument &Inst);
+
+	/*!	\brief Compiles the program again from the current state of the same sequences. */
+	std::shared_ptr<const CSeqProgram> Recompile() const;
+
+	/*!	\brief Checks whether any of the program's sequences has been modified since compilation. */
+	bool IsCurrent() const;
+
+	/*!	\brief Checks whether the program was compiled from the current sequences of an instrument. */
+	bool Matches(const CSeqInstrument &Inst) const;
+
+	/*!	\brief Returns the compiled sequence of a given type.
+		\return Pointer to the compiled sequence, or nullptr if the sequence is disabled. */
+	const seq_code_t *Get(sequence_t Index) const;
+
+private:
+	void Assign(std::size_t Index, std::shared_ptr<const CSequence> pSeq);
+
+	std::array<seq_code_t, SEQ_COUNT> codes_;
+	std::array<std::shared_ptr<const CSequence>, SEQ_COUNT> sources_;
+};
@@ -23,6 +23,7 @@
 #include "Sequence.h"
 #include <stdexcept>		// // //
 #include <algorithm>		// // //
+#include <atomic>		// // //
 
 bool CSequence::operator==(const CSequence &other)		// // //
 {
@@ -43,6 +44,7 @@ void CSequence::Clear() {
 void CSequence::SetItem(int Index, int8_t Value)		// // //
 {
 	m_cValues[Index] = Value;
+	Modify();		// // //
 }
 
 void CSequence::SetItemCount(unsigned int Count)
@@ -58,6 +60,7 @@ void CSequence::SetItemCount(unsigned int Count)
 		m_iLoopPoint = -1;
 	if (m_iReleasePoint >= m_iItemCount)
 		m_iReleasePoint = -1;
+	Modify();		// // //
 }
 
 void CSequence::SetLoopPoint(unsigned int Point)
@@ -65,6 +68,7 @@ void CSequence::SetLoopPoint(unsigned int Point)
 	m_iLoopPoint = Point;
 	if (m_iLoopPoint >= m_iItemCount)		// // //
 		m_iLoopPoint = -1;
+	Modify();		// // //
 }
 
 void CSequence::SetReleasePoint(unsigned int Point)
@@ -72,15 +76,18 @@ void CSequence::SetReleasePoint(unsigned int Point)
 	m_iReleasePoint = Point;
 	if (m_iReleasePoint >= m_iItemCount)		// // //
 		m_iReleasePoint = -1;
+	Modify();		// // //
 }
 
 void CSequence::SetSetting(seq_setting_t Setting)		// // //
 {
 	m_iSetting = Setting;
+	Modify();		// // //
 }
 
 void CSequence::SetSequenceType(sequence_t SeqType) {		// // //
 	seq_type_ = SeqType;
+	Modify();		// // //
 }
 
 int8_t CSequence::GetItem(int Index) const		// // //
@@ -111,3 +118,12 @@ seq_setting_t CSequence::GetSetting() const		// // //
 sequence_t CSequence::GetSequenceType() const {		// // //
 	return seq_type_;
 }
+
+unsigned int CSequence::GetVersion() const {		// // //
+	return version_;
+}
+
+void CSequence::Modify() {		// // //
+	static std::atomic<unsigned int> counter {0};
+	version_ = ++counter;
+}
@@ -124,6 +124,13 @@ public:
 	void		 SetSetting(seq_setting_t Setting);		// // //
 	void		 SetSequenceType(sequence_t SeqType);		// // //
 
+	// // // Changes whenever the sequence is modified; no two modifications of any sequences
+	// produce the same value, so copying a sequence also changes the version of the target
+	unsigned int GetVersion() const;
+
+private:
+	void		 Modify();		// // //
+
 private:
 	// Sequence data
 	sequence_t seq_type_;		// // //
@@ -132,4 +139,5 @@ private:
 	unsigned int m_iReleasePoint = -1;
 	seq_setting_t m_iSetting = SETTING_DEFAULT;		// // //
 	std::array<int8_t, MAX_SEQUENCE_ITEMS> m_cValues = { };		// // //
+	unsigned int version_ = 0;		// // //
 };
@@ -85,6 +85,8 @@ public:
 		bool	bHexKeypad;
 		bool	bMultiFrameSel;
 		bool	bCheckVersion;		// // //
+		bool	bAutoSave;		// // //
+		bool	bParallelWave;		// // //
 	} General;
 
 	struct {
@@ -275,6 +275,8 @@ void CSettingsService::SetupSettings() {
 	NewSetting(L"General", L"Hexadecimal keypad", false, s.General.bHexKeypad);
 	NewSetting(L"General", L"Multi-frame selection", false, s.General.bMultiFrameSel);
 	NewSetting(L"General", L"Check for new versions", true, s.General.bCheckVersion);
+	NewSetting(L"General", L"Auto save", false, s.General.bAutoSave);		// // //
+	NewSetting(L"General", L"Parallel WAV export", false, s.General.bParallelWave);		// // //
 
 	// // // Version / Compatibility info
 	NewSetting(L"Version", L"Module error level", MODULE_ERROR_DEFAULT, s.Version.iErrorLevel);
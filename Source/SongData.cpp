@@ -25,6 +25,8 @@
 #include "ChannelOrder.h"		// // //
 #include "FamiTrackerEnv.h"		// // //
 #include "SoundChipService.h"		// // //
+#include "SongLengthScanner.h"		// // //
+#include "SongState.h"		// // //
 
 // Defaults when creating new modules
 const unsigned CSongData::DEFAULT_ROW_COUNT	= 64;
@@ -35,7 +37,9 @@ const stHighlight CSongData::DEFAULT_HIGHLIGHT = {4, 16, 0};		// // //
 
 CSongData::CSongData(unsigned int PatternLength) :		// // //
 	m_sTrackName("New song"),
-	m_iPatternLength(PatternLength)
+	m_iPatternLength(PatternLength),
+	length_cache_(std::make_unique<CSongLengthCache>()),
+	state_cache_(std::make_unique<CSongStateCache>())
 {
 	FTEnv.GetSoundChipService()->ForeachTrack([&] (stChannelID track) {		// // //
 		tracks_.try_emplace(track);
@@ -105,7 +109,10 @@ CPatternData &CSongData::GetPattern(stChannelID Channel, unsigned Pattern) {
 }
 
 const CPatternData &CSongData::GetPattern(stChannelID Channel, unsigned Pattern) const {
-	return const_cast<CSongData *>(this)->GetPattern(Channel, Pattern);
+	auto track = GetTrack(Channel);		// // //
+	if (!track)
+		throw std::out_of_range {"Bad stChannelID in CSongData::GetPattern(stChannelID, unsigned)"};
+	return track->GetPattern(Pattern);
 }
 
 CPatternData &CSongData::GetPatternOnFrame(stChannelID Channel, unsigned Frame) {
@@ -116,7 +123,10 @@ CPatternData &CSongData::GetPatternOnFrame(stChannelID Channel, unsigned Frame)
 }
 
 const CPatternData &CSongData::GetPatternOnFrame(stChannelID Channel, unsigned Frame) const {
-	return const_cast<CSongData *>(this)->GetPatternOnFrame(Channel, Frame);
+	auto track = GetTrack(Channel);		// // //
+	if (!track)
+		throw std::out_of_range {"Bad stChannelID in CSongData::GetPattern(stChannelID, unsigned)"};
+	return track->GetPatternOnFrame(Frame);
 }
 
 std::string_view CSongData::GetTitle() const		// // //
@@ -158,37 +168,46 @@ bool CSongData::GetSongGroove() const		// // //
 void CSongData::SetTitle(std::string_view str)		// // //
 {
 	m_sTrackName = str;
+	dirty_ = true;
 }
 
 void CSongData::SetPatternLength(unsigned int Length)
 {
 	m_iPatternLength = Length;
+	dirty_ = true;
 }
 
 void CSongData::SetFrameCount(unsigned int Count)
 {
-	m_iFrameCount = Count;
+	if (m_iFrameCount != Count) {
+		m_iFrameCount = Count;
+		SetDirty();		// // // changes the set of saved patterns
+	}
 }
 
 void CSongData::SetSongSpeed(unsigned int Speed)
 {
 	m_iSongSpeed = Speed;
+	dirty_ = true;
 }
 
 void CSongData::SetSongTempo(unsigned int Tempo)
 {
 	m_iSongTempo = Tempo;
+	dirty_ = true;
 }
 
 void CSongData::SetEffectColumnCount(stChannelID Channel, unsigned Count)
 {
 	if (auto track = GetTrack(Channel))		// // //
 		track->SetEffectColumnCount(Count);
+	dirty_ = true;
 }
 
 void CSongData::SetSongGroove(bool Groove)		// // //
 {
 	m_bUseGroove = Groove;
+	dirty_ = true;
 }
 
 unsigned int CSongData::GetFramePattern(unsigned int Frame, stChannelID Channel) const
@@ -201,6 +220,7 @@ void CSongData::SetFramePattern(unsigned int Frame, stChannelID Channel, unsigne
 {
 	if (auto track = GetTrack(Channel))		// // //
 		track->SetFramePattern(Frame, Pattern);
+	dirty_ = true;
 }
 
 const stHighlight &CSongData::GetRowHighlight() const
@@ -211,6 +231,7 @@ const stHighlight &CSongData::GetRowHighlight() const
 void CSongData::SetRowHighlight(const stHighlight &Hl)		// // //
 {
 	m_vRowHighlight = Hl;
+	dirty_ = true;
 }
 
 stHighlight CSongData::GetHighlightAt(unsigned Frame, unsigned Row) const {		// // //
@@ -270,15 +291,22 @@ void CSongData::InsertRow(stChannelID Chan, unsigned Frame, unsigned Row) {
 
 void CSongData::CopyTrack(stChannelID Chan, const CSongData &From, stChannelID ChanFrom) {
 	if (auto *lhs = GetTrack(Chan))
-		if (auto *rhs = From.GetTrack(ChanFrom))
+		if (auto *rhs = From.GetTrack(ChanFrom)) {
 			*lhs = *rhs;
+			lhs->SetDirty();		// // //
+			dirty_ = true;
+		}
 }
 
 void CSongData::SwapChannels(stChannelID First, stChannelID Second)		// // //
 {
 	if (auto *lhs = GetTrack(First))
-		if (auto *rhs = GetTrack(Second))
+		if (auto *rhs = GetTrack(Second)) {
 			std::swap(*lhs, *rhs);
+			lhs->SetDirty();		// // //
+			rhs->SetDirty();
+			dirty_ = true;
+		}
 }
 
 bool CSongData::AddFrames(unsigned Frame, unsigned Count) {
@@ -372,6 +400,7 @@ bool CSongData::CloneFrame(unsigned Frame) {
 }
 
 CBookmarkCollection &CSongData::GetBookmarks() {
+	dirty_ = true;		// // //
 	return bookmarks_;
 }
 
@@ -380,6 +409,7 @@ const CBookmarkCollection &CSongData::GetBookmarks() const {
 }
 
 void CSongData::SetBookmarks(const CBookmarkCollection &bookmarks) {
+	dirty_ = true;		// // //
 	bookmarks_.ClearBookmarks();
 	for (const auto &bm : bookmarks)
 		bookmarks_.AddBookmark(std::make_unique<CBookmark>(*bm));
@@ -387,4 +417,41 @@ void CSongData::SetBookmarks(const CBookmarkCollection &bookmarks) {
 
 void CSongData::SetBookmarks(CBookmarkCollection &&bookmarks) {
 	bookmarks_ = std::move(bookmarks);
+	dirty_ = true;		// // //
+}
+
+bool CSongData::IsDirty() const {		// // //
+	if (dirty_)
+		return true;
+	for (const auto &x : tracks_)
+		if (x.second.IsDirty())
+			return true;
+	return false;
+}
+
+bool CSongData::IsPatternDirty(stChannelID Channel, unsigned Pattern) const {
+	auto track = GetTrack(Channel);
+	return track && track->IsPatternDirty(Pattern);
+}
+
+void CSongData::SetDirty() {
+	dirty_ = true;
+	VisitTracks([] (CTrackData &track) {
+		track.SetDirty();
+	});
+}
+
+void CSongData::ClearDirty() {
+	dirty_ = false;
+	VisitTracks([] (CTrackData &track) {
+		track.ClearDirty();
+	});
+}
+
+CSongLengthCache &CSongData::GetLengthCache() const {
+	return *length_cache_;
+}
+
+CSongStateCache &CSongData::GetStateCache() const {		// // //
+	return *state_cache_;
 }
@@ -31,6 +31,8 @@
 #include "BookmarkCollection.h"		// // //
 
 class stChanNote;		// // //
+class CSongLengthCache;		// // //
+class CSongStateCache;		// // //
 
 // CSongData holds all notes in the patterns
 class CSongData
@@ -101,6 +103,17 @@ public:
 	void SetBookmarks(const CBookmarkCollection &bookmarks);
 	void SetBookmarks(CBookmarkCollection &&bookmarks);
 
+	// // // dirty tracking for incremental saving
+	bool IsDirty() const;
+	bool IsPatternDirty(stChannelID Channel, unsigned Pattern) const;
+	void SetDirty();
+	void ClearDirty();
+
+	// // // cached length analysis, updated on demand by CSongLengthScanner
+	CSongLengthCache &GetLengthCache() const;
+	// // // cached playback state checkpoints, updated on demand by CSongState
+	CSongStateCache &GetStateCache() const;
+
 	// void (*F)(CTrackData &track [, stChannelID ch])
 	template <typename F>
 	void VisitTracks(F f) {
@@ -186,4 +199,9 @@ private:
 	CBookmarkCollection bookmarks_;		// // //
 
 	std::map<stChannelID, CTrackData> tracks_;		// // //
+
+	bool dirty_ = true;		// // // song properties, frames and bookmarks
+
+	std::unique_ptr<CSongLengthCache> length_cache_;		// // //
+	std::unique_ptr<CSongStateCache> state_cache_;		// // //
 };
@@ -26,52 +26,127 @@
 #include "SongData.h"
 #include "ft0cc/doc/groove.hpp"
 #include "ChannelOrder.h"
-#include <bitset>
+#include "TempoCounter.h"		// // //
 #include <type_traits>
 #include <algorithm>
+#include <future>
+
+
+
+namespace {
+
+bool IsLengthEffect(effect_t fx) noexcept {
+	switch (fx) {
+	case effect_t::SPEED: case effect_t::GROOVE:
+	case effect_t::JUMP: case effect_t::SKIP: case effect_t::HALT:
+		return true;
+	default:
+		return false;
+	}
+}
+
+} // namespace
+
+
+
+const std::vector<CSongLengthCache::event_t> &CSongLengthCache::GetFrameEvents(const CConstSongView &view, unsigned Frame) {
+	if (Frame >= frames_.size())
+		frames_.resize(Frame + 1);
+	auto &entry = frames_[Frame];
+
+	key_.clear();
+	view.ForeachTrack([&] (const CTrackData &track) {
+		key_.emplace_back(track.GetPatternOnFrame(Frame).GetVersion(), track.GetEffectColumnCount());
+	});
+	if (entry.Key == key_)
+		return entry.Events;
+
+	entry.Key = key_;
+	entry.Events.clear();
+	view.ForeachTrack([&] (const CTrackData &track) {
+		const unsigned Columns = track.GetEffectColumnCount();
+		track.GetPatternOnFrame(Frame).VisitRows([&] (const stChanNote &note, unsigned row) {
+			for (unsigned i = 0; i < Columns; ++i)
+				if (IsLengthEffect(note.Effects[i].fx))
+					entry.Events.push_back({row, note.Effects[i]});
+		});
+	});
+	std::stable_sort(entry.Events.begin(), entry.Events.end(), [] (const event_t &lhs, const event_t &rhs) {
+		return lhs.Row < rhs.Row;
+	});
+	return entry.Events;
+}
 
 
 
 class loop_visitor {
 public:
-	explicit loop_visitor(const CConstSongView &view) :
-		song_view_(view.GetChannelOrder().Canonicalize(), view.GetSong(), false) { }
+	// // // effects are visited in the channel order of the view, which the sound driver also uses
+	loop_visitor(const CConstSongView &view, CSongLengthCache &cache) :
+		song_view_(view.GetChannelOrder(), view.GetSong(), false), cache_(cache) { }
 
+	// void (*F)(unsigned rows, unsigned frame, unsigned row), void (*G)(stEffectCommand cmd)
+	// rows without flow or timing effects are passed to F in runs
 	template <typename F, typename G>
 	void Visit(F cb, G fx) {
 		unsigned FrameCount = song_view_.GetSong().GetFrameCount();
 		unsigned Rows = song_view_.GetSong().GetPatternLength();
 
-		std::bitset<MAX_PATTERN_LENGTH> RowVisited[MAX_FRAMES] = { };		// // //
-		while (!RowVisited[f_][r_]) {
-			RowVisited[f_][r_] = true;
+		std::vector<std::vector<std::pair<unsigned, unsigned>>> Visited(FrameCount);		// // // [begin, end) rows
+		while (true) {
+			unsigned Limit = Rows;
+			bool Revisit = false;
+			for (auto [b, e] : Visited[f_]) {
+				if (r_ >= b && r_ < e)
+					Revisit = true;
+				else if (b > r_)
+					Limit = std::min(Limit, b);
+			}
+			if (Revisit)
+				break;
+
+			const auto &Events = cache_.GetFrameEvents(song_view_, f_);
+			auto it = std::lower_bound(Events.begin(), Events.end(), r_, [] (const auto &ev, unsigned row) {
+				return ev.Row < row;
+			});
+
+			if (unsigned Next = it != Events.end() ? std::min(it->Row, Limit) : Limit; Next > r_) {
+				Visited[f_].emplace_back(r_, Next);
+				cb(Next - r_, f_, r_);		// // //
+				r_ = Next;
+				if (r_ >= Rows) {
+					r_ = 0;
+					if (++f_ >= FrameCount)
+						f_ = 0;
+				}
+				continue;
+			}
+
+			Visited[f_].emplace_back(r_, r_ + 1);
 
 			int Bxx = -1;
 			int Dxx = -1;
 			bool Cxx = false;
 
-			song_view_.ForeachTrack([&] (const CTrackData &track /* , stChannelID id */) {
-				const auto &Note = track.GetPatternOnFrame(f_).GetNoteOn(r_);		// // //
-				for (unsigned l = 0, m = track.GetEffectColumnCount(); l < m; ++l) {
-					switch (Note.Effects[l].fx) {
-					case effect_t::JUMP:
-						Bxx = Note.Effects[l].param;
-						break;
-					case effect_t::SKIP:
-						Dxx = Note.Effects[l].param;
-						break;
-					case effect_t::HALT:
-						Cxx = true;
-						break;
-					default:
-						fx(/* id, */ Note.Effects[l]);
-					}
+			for (; it != Events.end() && it->Row == r_; ++it) {
+				switch (it->Command.fx) {
+				case effect_t::JUMP:
+					Bxx = it->Command.param;
+					break;
+				case effect_t::SKIP:
+					Dxx = it->Command.param;
+					break;
+				case effect_t::HALT:
+					Cxx = true;
+					break;
+				default:
+					fx(it->Command);
 				}
-			});
+			}
 
 			if (Cxx && !first_)
 				break;
-			cb();
+			cb(1, f_, r_);		// // //
 			if (Cxx)
 				break;
 
@@ -96,6 +171,7 @@ public:
 
 private:
 	CConstSongView song_view_;
+	CSongLengthCache &cache_;
 	unsigned f_ = 0;
 	unsigned r_ = 0;
 	bool first_ = true;
@@ -103,76 +179,193 @@ private:
 
 
 
+std::shared_ptr<const CTempoTimeline> CTempoTimeline::Get(const CFamiTrackerModule &modfile, const CConstSongView &view) {
+	const auto &song = view.GetSong();
+	CSongLengthCache &cache = song.GetLengthCache();
+	std::lock_guard<std::mutex> lock {cache.mutex_};
+
+	// only the timing and flow effects, the song's initial tempo and the grooves are part of
+	// the key, so that editing anything else keeps the timeline
+	CConstSongView playback {view.GetChannelOrder(), song, false};
+	std::vector<std::uint32_t> key {
+		song.GetFrameCount(), song.GetPatternLength(), song.GetSongSpeed(), song.GetSongTempo(),
+		song.GetSongGroove(), modfile.GetSpeedSplitPoint(),
+	};
+	for (unsigned i = 0; i < MAX_GROOVE; ++i) {
+		if (auto pGroove = modfile.GetGroove(i)) {
+			key.push_back(static_cast<std::uint32_t>(pGroove->size() + 1));
+			key.insert(key.end(), pGroove->begin(), pGroove->end());
+		}
+		else
+			key.push_back(0u);
+	}
+	for (unsigned f = 0, n = song.GetFrameCount(); f < n; ++f) {
+		const auto &Events = cache.GetFrameEvents(playback, f);
+		key.push_back(static_cast<std::uint32_t>(Events.size()));
+		for (const auto &ev : Events)
+			key.push_back(ev.Row << 16 | value_cast(ev.Command.fx) << 8 | ev.Command.param);
+	}
+
+	if (!cache.timeline_ || cache.timeline_->key_ != key) {
+		auto pTimeline = std::make_shared<CTempoTimeline>();
+		pTimeline->Build(modfile, playback, cache);
+		pTimeline->key_ = std::move(key);
+		cache.timeline_ = std::move(pTimeline);
+	}
+	return cache.timeline_;
+}
+
+void CTempoTimeline::Build(const CFamiTrackerModule &modfile, const CConstSongView &view, CSongLengthCache &cache) {
+	// rows are timed by the same tempo counter as the sound driver
+	CTempoCounter counter {modfile};
+	counter.LoadTempo(view.GetSong());
+	std::vector<stEffectCommand> Commands;
+	std::uint64_t Tick = 0;
+
+	const auto fxhandler = [&] (stEffectCommand cmd) {
+		Commands.push_back(cmd);
+	};
+
+	const auto rowhandler = [&] (unsigned Count, unsigned Frame, unsigned Row) {
+		segments_.push_back({static_cast<unsigned>(ticks_.size()), Frame, Row, Count});
+		for (unsigned i = 0; i < Count; ++i) {
+			counter.StepRow();
+			for (auto cmd : Commands)
+				switch (cmd.fx) {
+				case effect_t::SPEED:
+					counter.DoFxx(cmd.param ? cmd.param : 1);
+					break;
+				case effect_t::GROOVE:
+					counter.DoOxx(cmd.param % MAX_GROOVE);
+					break;
+				}
+			Commands.clear();
+
+			ticks_.push_back(Tick);
+			do {
+				counter.Tick();
+				++Tick;
+			} while (!counter.CanStepRow());
+		}
+	};
+
+	loop_visitor visitor(view, cache);
+	visitor.Visit(rowhandler, fxhandler);
+	first_ = static_cast<unsigned>(ticks_.size());
+	rows_ = segments_;
+	Commands.clear();
+	visitor.Visit(rowhandler, fxhandler);
+	ticks_.push_back(Tick);
+
+	std::sort(rows_.begin(), rows_.end(), [] (const segment_t &lhs, const segment_t &rhs) {
+		return std::make_pair(lhs.Frame, lhs.Row) < std::make_pair(rhs.Frame, rhs.Row);
+	});
+}
+
+unsigned CTempoTimeline::GetLoopLength() const {
+	return static_cast<unsigned>(ticks_.size() - 1) - first_;
+}
+
+std::pair<unsigned, unsigned> CTempoTimeline::GetRowCount() const {
+	unsigned Loop = GetLoopLength();
+	return {first_ - Loop, Loop};
+}
+
+std::pair<std::uint64_t, std::uint64_t> CTempoTimeline::GetTickCount() const {
+	return {ticks_[first_ - GetLoopLength()], ticks_.back() - ticks_[first_]};
+}
+
+std::uint64_t CTempoTimeline::GetTick(unsigned Index) const {
+	const unsigned Total = static_cast<unsigned>(ticks_.size() - 1);
+	if (Index <= Total)
+		return ticks_[Index];
+	const unsigned Loop = GetLoopLength();
+	if (!Loop)
+		return ticks_.back();
+	const unsigned Loops = (Index - first_) / Loop;
+	return ticks_[first_ + (Index - first_) % Loop] + Loops * (ticks_.back() - ticks_[first_]);
+}
+
+unsigned CTempoTimeline::GetIndex(std::uint64_t Tick) const {
+	const unsigned Total = static_cast<unsigned>(ticks_.size() - 1);
+	const auto FindTick = [&] (auto b, std::uint64_t t) {
+		return static_cast<unsigned>(std::upper_bound(b, ticks_.end() - 1, t) - ticks_.begin()) - 1;
+	};
+	if (Tick < ticks_.back())
+		return FindTick(ticks_.begin(), Tick);
+	const std::uint64_t LoopTicks = ticks_.back() - ticks_[first_];
+	if (!LoopTicks)
+		return Total;
+	const std::uint64_t Loops = (Tick - ticks_[first_]) / LoopTicks;
+	const std::uint64_t Offset = (Tick - ticks_[first_]) % LoopTicks;
+	return FindTick(ticks_.begin() + first_, ticks_[first_] + Offset) + static_cast<unsigned>(Loops) * GetLoopLength();
+}
+
+CTempoTimeline::position_t CTempoTimeline::GetPosition(unsigned Index) const {
+	if (segments_.empty())
+		return {0, 0};
+	const unsigned Total = static_cast<unsigned>(ticks_.size() - 1);
+	if (Index >= Total) {
+		const unsigned Loop = GetLoopLength();
+		Index = Loop ? first_ + (Index - first_) % Loop : Total - 1;
+	}
+	auto it = std::upper_bound(segments_.begin(), segments_.end(), Index, [] (unsigned i, const segment_t &seg) {
+		return i < seg.Index;
+	});
+	--it;
+	return {it->Frame, it->Row + (Index - it->Index)};
+}
+
+std::optional<unsigned> CTempoTimeline::FindRow(unsigned Frame, unsigned Row) const {
+	auto it = std::upper_bound(rows_.begin(), rows_.end(), std::make_pair(Frame, Row), [] (const auto &pos, const segment_t &seg) {
+		return pos < std::make_pair(seg.Frame, seg.Row);
+	});
+	if (it == rows_.begin())
+		return std::nullopt;
+	--it;
+	if (it->Frame != Frame || Row >= it->Row + it->Count)
+		return std::nullopt;
+	return it->Index + (Row - it->Row);
+}
+
+
+
 CSongLengthScanner::CSongLengthScanner(const CFamiTrackerModule &modfile, const CConstSongView &view) :
 	modfile_(modfile), song_view_(view)
 {
 }
 
 std::pair<unsigned, unsigned> CSongLengthScanner::GetRowCount() {
-	Compute();
-	return {rows1_, rows2_};
+	return GetTimeline().GetRowCount();
 }
 
 std::pair<double, double> CSongLengthScanner::GetSecondsCount() {
-	Compute();
-	return {sec1_, sec2_};
+	auto [Intro, Loop] = GetTickCount();
+	const double Rate = modfile_.GetFrameRate();
+	return {Intro / Rate, Loop / Rate};
 }
 
-void CSongLengthScanner::Compute() {
-	if (std::exchange(scanned_, true))
-		return;
-
-	const auto &song = song_view_.GetSong();
-
-	double Tempo = song.GetSongTempo();
-	if (!Tempo)
-		Tempo = 2.5 * modfile_.GetFrameRate();
-	const bool AllowTempo = song.GetSongTempo() != 0;
-	const int Split = modfile_.GetSpeedSplitPoint();
-	int Speed = song.GetSongSpeed();
-	int GrooveIndex = song.GetSongGroove() ? Speed : -1;
-	int GroovePointer = 0;
+std::pair<std::uint64_t, std::uint64_t> CSongLengthScanner::GetTickCount() {		// // //
+	return GetTimeline().GetTickCount();
+}
 
-	if (GrooveIndex != -1 && !modfile_.HasGroove(Speed)) {
-		GrooveIndex = -1;
-		Speed = DEFAULT_SPEED;
-	}
+std::vector<CSongLengthScanner::song_length_t> CSongLengthScanner::ScanSongs(const CFamiTrackerModule &modfile) {
+	std::vector<std::future<song_length_t>> tasks;
+	for (unsigned i = 0, n = modfile.GetSongCount(); i < n; ++i)
+		tasks.push_back(std::async(std::launch::async, [&modfile, i] {
+			auto pSongView = modfile.MakeSongView(i, false);
+			CSongLengthScanner scanner {modfile, *pSongView};
+			return song_length_t {scanner.GetRowCount(), scanner.GetSecondsCount()};
+		}));
 
-	const auto fxhandler = [&] (stEffectCommand cmd) {
-		switch (cmd.fx) {
-		case effect_t::SPEED:
-			if (AllowTempo && cmd.param >= Split)
-				Tempo = cmd.param;
-			else {
-				GrooveIndex = -1;
-				Speed = cmd.param;
-			}
-			break;
-		case effect_t::GROOVE:
-			if (modfile_.HasGroove(cmd.param)) {
-				GrooveIndex = cmd.param;
-				GroovePointer = 0;
-			}
-			break;
-		}
-	};
+	std::vector<song_length_t> lengths;
+	for (auto &task : tasks)
+		lengths.push_back(task.get());
+	return lengths;
+}
 
-	loop_visitor visitor(song_view_);
-	visitor.Visit([&] {
-		if (auto pGroove = modfile_.GetGroove(GrooveIndex))
-			Speed = pGroove->entry(GroovePointer++);
-		sec1_ += Speed / Tempo;
-		++rows1_;
-	}, fxhandler);
-	visitor.Visit([&] {
-		if (auto pGroove = modfile_.GetGroove(GrooveIndex))
-			Speed = pGroove->entry(GroovePointer++);
-		sec2_ += Speed / Tempo;
-		++rows2_;
-	}, fxhandler);
-
-	rows1_ -= rows2_;
-	sec1_ -= sec2_;
-	sec1_ *= 2.5;
-	sec2_ *= 2.5;
+const CTempoTimeline &CSongLengthScanner::GetTimeline() {		// // //
+	if (!timeline_)
+		timeline_ = CTempoTimeline::Get(modfile_, song_view_);
+	return *timeline_;
 }
@@ -24,25 +24,109 @@
 #pragma once
 
 #include <utility>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <mutex>
+#include <cstdint>
+#include "PatternNote.h"
 
 class CFamiTrackerModule;
 class CConstSongView;
+class CTempoTimeline;
+
+// // // per-frame summary of the effects that affect song length, owned by CSongData
+class CSongLengthCache {
+	friend class CTempoTimeline;		// // //
+
+public:
+	struct event_t {
+		unsigned Row;
+		stEffectCommand Command;
+	};
+
+	// Returns the flow and timing effects of a frame, in the order the player reads them.
+	// Frames are rescanned only if the pattern versions or effect column counts differ
+	// from the last call.
+	const std::vector<event_t> &GetFrameEvents(const CConstSongView &view, unsigned Frame);
+
+private:
+	struct frame_t {
+		std::vector<std::pair<std::uint64_t, unsigned>> Key;
+		std::vector<event_t> Events;
+	};
+
+	std::vector<frame_t> frames_;
+	std::vector<std::pair<std::uint64_t, unsigned>> key_;
+	std::shared_ptr<const CTempoTimeline> timeline_;		// // //
+	std::mutex mutex_;
+};
+
+// // // Tick at which each row of a song starts, in playback order. The timeline covers the
+// first playthrough of the song, followed by one more iteration of its loop; positions past
+// that are extrapolated by repeating the second loop.
+class CTempoTimeline {
+public:
+	struct position_t {
+		unsigned Frame;
+		unsigned Row;
+	};
+
+	// Returns the timeline of a song. The timeline is cached in the song's CSongLengthCache
+	// and rebuilt only if the tempo, groove or flow effects used by the song have changed.
+	static std::shared_ptr<const CTempoTimeline> Get(const CFamiTrackerModule &modfile, const CConstSongView &view);
+
+	// Number of rows / ticks before the loop point, and of one loop
+	std::pair<unsigned, unsigned> GetRowCount() const;
+	std::pair<std::uint64_t, std::uint64_t> GetTickCount() const;
+
+	// Tick at which the row with the given playback index starts
+	std::uint64_t GetTick(unsigned Index) const;
+	// Playback index of the row being played at the given tick
+	unsigned GetIndex(std::uint64_t Tick) const;
+	// Frame and row of the given playback index
+	position_t GetPosition(unsigned Index) const;
+	// Playback index at which a row is first played, if it is reachable
+	std::optional<unsigned> FindRow(unsigned Frame, unsigned Row) const;
+
+private:
+	struct segment_t {
+		unsigned Index;
+		unsigned Frame;
+		unsigned Row;
+		unsigned Count;
+	};
+
+	void Build(const CFamiTrackerModule &modfile, const CConstSongView &view, CSongLengthCache &cache);
+	unsigned GetLoopLength() const;
+
+	std::vector<std::uint64_t> ticks_;		// start tick of each row, plus the end tick
+	std::vector<segment_t> segments_;		// runs of consecutive rows, by playback index
+	std::vector<segment_t> rows_;		// runs of the first playthrough, by frame and row
+	unsigned first_ = 0;		// rows in the first playthrough
+	std::vector<std::uint32_t> key_;		// timing-related song data used to build the timeline
+};
 
 class CSongLengthScanner {
 public:
+	struct song_length_t {
+		std::pair<unsigned, unsigned> Rows;
+		std::pair<double, double> Seconds;
+	};
+
 	CSongLengthScanner(const CFamiTrackerModule &modfile, const CConstSongView &view);
 	std::pair<unsigned, unsigned> GetRowCount();
 	std::pair<double, double> GetSecondsCount();
+	std::pair<std::uint64_t, std::uint64_t> GetTickCount();		// // //
+
+	// // // scans all songs of a module concurrently
+	static std::vector<song_length_t> ScanSongs(const CFamiTrackerModule &modfile);
 
 private:
-	void Compute();
+	const CTempoTimeline &GetTimeline();		// // //
 
 	const CFamiTrackerModule &modfile_;
 	const CConstSongView &song_view_;
 
-	unsigned rows1_ = 0;
-	unsigned rows2_ = 0;
-	double sec1_ = 0.;
-	double sec2_ = 0.;
-	bool scanned_ = false;
+	std::shared_ptr<const CTempoTimeline> timeline_;		// // //
 };
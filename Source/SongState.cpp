@@ -30,6 +30,7 @@
 #include "NumConv.h"
 #include "FamiTrackerEnv.h"
 #include "SoundChipService.h"
+#include "ChannelOrder.h"		// // //
 
 
 
@@ -53,6 +54,15 @@ void UpdateEchoTranspose(const stChanNote &Note, int &Value, unsigned int EffCol
 	}
 }
 
+// // // pattern versions and effect column counts of a frame
+std::vector<std::pair<std::uint64_t, unsigned>> GetFrameKey(const CConstSongView &view, unsigned Frame) {
+	std::vector<std::pair<std::uint64_t, unsigned>> key;
+	view.ForeachTrack([&] (const CTrackData &track) {
+		key.emplace_back(track.GetPatternOnFrame(Frame).GetVersion(), track.GetEffectColumnCount());
+	});
+	return key;
+}
+
 } // namespace
 
 
@@ -148,38 +158,14 @@ std::string stChannelState::GetStateString() const {
 
 void stChannelState::HandleNote(const stChanNote &Note, unsigned EffColumns) {
 	if (Note.Note != note_t::none && Note.Note != note_t::release) {
-		for (int i = 0; i < std::min(BufferPos, (int)std::size(Echo)); ++i) {
-			if (Echo[i] == ECHO_BUFFER_ECHO) {
-				UpdateEchoTranspose(Note, Transpose[i], EffColumns);
-				switch (Note.Note) {
-				case note_t::halt: Echo[i] = ECHO_BUFFER_HALT; break;
-				case note_t::echo: Echo[i] = ECHO_BUFFER_ECHO + Note.Octave; break;
-				default:
-					int NewNote = Note.ToMidiNote() + Transpose[i];
-					NewNote = std::clamp(NewNote, 0, NOTE_COUNT - 1);
-					Echo[i] = NewNote;
-				}
-			}
-			else if (Echo[i] > ECHO_BUFFER_ECHO && Echo[i] < ECHO_BUFFER_ECHO + (int)ECHO_BUFFER_LENGTH)
-				--Echo[i];
+		int Delta = 0;		// // //
+		UpdateEchoTranspose(Note, Delta, EffColumns);
+		switch (Note.Note) {
+		case note_t::halt: PushEcho(ECHO_BUFFER_HALT, Delta); break;
+		case note_t::echo: PushEcho(ECHO_BUFFER_ECHO + Note.Octave, Delta); break;
+		default: PushEcho(Note.ToMidiNote(), Delta);
 		}
-		if (BufferPos >= 0 && BufferPos < (int)ECHO_BUFFER_LENGTH) {
-			int Value;
-			switch (Note.Note) {
-			case note_t::halt: Value = ECHO_BUFFER_HALT; break;
-			case note_t::echo: Value = ECHO_BUFFER_ECHO + Note.Octave; break;
-			default:
-				Value = Note.ToMidiNote();
-				UpdateEchoTranspose(Note, Value, EffColumns);
-				Value = std::clamp(Value, 0, NOTE_COUNT - 1);
-			}
-			Echo[BufferPos] = Value;
-			UpdateEchoTranspose(Note, Transpose[BufferPos], EffColumns);
-		}
-		++BufferPos;
 	}
-	if (BufferPos < 0)
-		BufferPos = 0;
 
 	if (Instrument == MAX_INSTRUMENTS)
 		if (Note.Instrument != MAX_INSTRUMENTS && Note.Instrument != HOLD_INSTRUMENT)		// // // 050B
@@ -217,6 +203,8 @@ void stChannelState::HandleExxCommand2A03(unsigned char param) {
 void stChannelState::HandleSxxCommand(unsigned char xy) {
 	if (!IsAPUTriangle(ChannelID))
 		return;
+	if (NoteCutAny == -1 && xy >= 0x80)		// // //
+		NoteCutAny = xy;
 	if (Effect[value_cast(effect_t::NOTE_CUT)] == -1) {
 		if (xy <= 0x7F) {
 			if (Effect_LengthCounter == -1)
@@ -231,31 +219,153 @@ void stChannelState::HandleSxxCommand(unsigned char xy) {
 	}
 }
 
+void stChannelState::PushEcho(int Value, int Delta) {		// // //
+	const auto Resolve = [Value] (int Transpose) {
+		if (Value == ECHO_BUFFER_HALT || Value >= ECHO_BUFFER_ECHO)
+			return Value;
+		return std::clamp(Value + Transpose, 0, NOTE_COUNT - 1);
+	};
+
+	for (int i = 0; i < std::min(BufferPos, (int)std::size(Echo)); ++i) {
+		if (Echo[i] == ECHO_BUFFER_ECHO) {
+			Transpose[i] += Delta;
+			Echo[i] = Resolve(Transpose[i]);
+		}
+		else if (Echo[i] > ECHO_BUFFER_ECHO && Echo[i] < ECHO_BUFFER_ECHO + (int)ECHO_BUFFER_LENGTH)
+			--Echo[i];
+	}
+	if (BufferPos < (int)ECHO_BUFFER_LENGTH) {
+		Echo[BufferPos] = Resolve(Delta);
+		Transpose[BufferPos] += Delta;
+	}
+	if (BufferPos < (int)EchoNotes.size())
+		EchoNotes[BufferPos] = {Value, Delta};
+	++BufferPos;
+}
+
+bool stChannelState::IsEchoSettled() const {		// // //
+	return BufferPos >= (int)ECHO_BUFFER_LENGTH && std::none_of(Echo.begin(), Echo.end(), [] (int x) {
+		return x >= ECHO_BUFFER_ECHO && x < ECHO_BUFFER_ECHO + (int)ECHO_BUFFER_LENGTH;
+	});
+}
+
+bool stChannelState::CanCombine(const stChannelState &earlier) const {		// // //
+	// the echo buffer can be completed if all earlier notes are known, or if the known ones suffice
+	if (!BufferPos || earlier.BufferPos <= (int)EchoNotes.size() || IsEchoSettled())
+		return true;
+	stChannelState state = *this;
+	for (auto [Value, Delta] : earlier.EchoNotes)
+		state.PushEcho(Value, Delta);
+	return state.IsEchoSettled();
+}
+
+void stChannelState::Combine(const stChannelState &earlier, bool MaskFDS) {		// // //
+	if (Instrument == MAX_INSTRUMENTS)
+		Instrument = earlier.Instrument;
+	if (Volume == MAX_VOLUME)
+		Volume = earlier.Volume;
+
+	if (!BufferPos) {
+		Echo = earlier.Echo;
+		Transpose = earlier.Transpose;
+		EchoNotes = earlier.EchoNotes;
+		BufferPos = earlier.BufferPos;
+	}
+	else {
+		const int Count = std::min(earlier.BufferPos, (int)EchoNotes.size());
+		for (int i = 0; i < Count; ++i)
+			PushEcho(earlier.EchoNotes[i].first, earlier.EchoNotes[i].second);
+		BufferPos += earlier.BufferPos - Count;
+	}
+
+	// slide effects are set together, so they can be taken individually
+	for (std::size_t i = 0; i < Effect.size(); ++i)
+		if (Effect[i] == -1)
+			switch (enum_cast<effect_t>(i)) {
+			case effect_t::VOLUME: case effect_t::NOTE_CUT: case effect_t::FDS_MOD_SPEED_HI:
+				break;
+			default:
+				Effect[i] = earlier.Effect[i];
+			}
+
+	// Exx and Sxx also depend on the length counter
+	int &Vol = Effect[value_cast(effect_t::VOLUME)];
+	int &NoteCut = Effect[value_cast(effect_t::NOTE_CUT)];
+	if (Effect_LengthCounter == -1) {
+		Effect_LengthCounter = earlier.Effect_LengthCounter;
+		Vol = earlier.Effect[value_cast(effect_t::VOLUME)];
+		NoteCut = earlier.Effect[value_cast(effect_t::NOTE_CUT)];
+	}
+	else {
+		if (Vol == -1)
+			Vol = earlier.Effect[value_cast(effect_t::VOLUME)];
+		if (NoteCut == -1 && Effect_LengthCounter != 0xE0)
+			NoteCut = earlier.NoteCutAny;
+	}
+
+	// FDS modulation speed is ignored past a reset
+	if (Effect_AutoFMMult == -1)
+		Effect_AutoFMMult = MaskFDS ? earlier.AutoFMDepth : earlier.Effect_AutoFMMult;
+	if (!MaskFDS && Effect[value_cast(effect_t::FDS_MOD_SPEED_HI)] == -1)
+		Effect[value_cast(effect_t::FDS_MOD_SPEED_HI)] = earlier.Effect[value_cast(effect_t::FDS_MOD_SPEED_HI)];
+
+	if (NoteCutAny == -1)
+		NoteCutAny = earlier.NoteCutAny;
+	if (AutoFMDepth == -1)
+		AutoFMDepth = earlier.AutoFMDepth;
+}
+
 
 
 void CSongState::Retrieve(const CFamiTrackerModule &modfile, unsigned Track, unsigned Frame, unsigned Row) {
-	CConstSongView SongView {modfile.GetChannelOrder().Canonicalize(), *modfile.GetSong(Track), false};
+	CConstSongView SongView {modfile.GetChannelOrder(), *modfile.GetSong(Track), false};		// // // all channels the driver plays
 	const auto &song = SongView.GetSong();
 
+	Reset(SongView);
+	{
+		auto &cache = song.GetStateCache();		// // //
+		std::lock_guard<std::mutex> lock {cache.mutex_};
+		Scan(modfile, SongView, Frame, Row, cache.GetCheckpoints(modfile, SongView, Frame));
+	}
+
+	if (GroovePos == -1 && song.GetSongGroove()) {
+		unsigned Index = song.GetSongSpeed();
+		if (Index < MAX_GROOVE && modfile.HasGroove(Index)) {
+			GroovePos = total_rows_;
+			Speed = Index;
+		}
+	}
+}
+
+void CSongState::Reset(const CConstSongView &view) {		// // //
 	State.clear();
-	SongView.GetChannelOrder().ForeachChannel([&] (stChannelID id) {
+	view.GetChannelOrder().ForeachChannel([&] (stChannelID id) {
 		State.try_emplace(id, stChannelState { });
 	});
+	Tempo = -1;
+	Speed = -1;
+	GroovePos = -1;
+	total_rows_ = 0;
+	tempo_any_ = -1;
+	mask_fds_ = false;
+	halted_ = false;
+}
 
-	int totalRows = 0;
-
-	bool maskFDS = false;
-	bool doHalt = false;
+void CSongState::Scan(const CFamiTrackerModule &modfile, const CConstSongView &view, unsigned Frame, unsigned Row,
+	const std::vector<CSongState> &Checkpoints) {		// // //
+	const auto &song = view.GetSong();
 
 	while (true) {
 		if (Row)
 			--Row;
+		else if (Frame < Checkpoints.size() && TryCombine(Checkpoints[Frame]))
+			return;
 		else if (Frame)
-			Row = SongView.GetFrameLength(--Frame) - 1;
+			Row = view.GetFrameLength(--Frame) - 1;
 		else
 			break;
 
-		SongView.ForeachTrack([&] (const CTrackData &track, stChannelID c) {
+		view.ForeachTrack([&] (const CTrackData &track, stChannelID c) {
 			stChannelState &chState = State.find(c)->second;
 			int EffColumns = track.GetEffectColumnCount();
 			const auto &Note = track.GetPatternOnFrame(Frame).GetNoteOn(Row);		// // //
@@ -274,9 +384,11 @@ void CSongState::Retrieve(const CFamiTrackerModule &modfile, unsigned Track, uns
 				case effect_t::JUMP: case effect_t::SKIP: // no true backward iterator
 					break;
 				case effect_t::HALT:
-					doHalt = true;
+					halted_ = true;
 					break;
 				case effect_t::SPEED:
+					if (tempo_any_ == -1 && cmd.param >= modfile.GetSpeedSplitPoint())		// // //
+						tempo_any_ = cmd.param;
 					if (Speed == -1 && (cmd.param < modfile.GetSpeedSplitPoint() || song.GetSongTempo() == 0)) {
 						Speed = std::max((unsigned char)1u, cmd.param);
 						GroovePos = -2;
@@ -286,7 +398,7 @@ void CSongState::Retrieve(const CFamiTrackerModule &modfile, unsigned Track, uns
 					break;
 				case effect_t::GROOVE:
 					if (GroovePos == -1 && cmd.param < MAX_GROOVE && modfile.HasGroove(cmd.param)) {
-						GroovePos = totalRows + 1;
+						GroovePos = total_rows_ + 1;
 						Speed = cmd.param;
 					}
 					break;
@@ -299,18 +411,20 @@ void CSongState::Retrieve(const CFamiTrackerModule &modfile, unsigned Track, uns
 				case effect_t::FDS_MOD_DEPTH:
 					if (chState.Effect_AutoFMMult == -1 && cmd.param >= 0x80)
 						chState.Effect_AutoFMMult = cmd.param;
+					if (chState.AutoFMDepth == -1 && cmd.param >= 0x80)		// // //
+						chState.AutoFMDepth = cmd.param;
 					break;
 				case effect_t::FDS_MOD_SPEED_HI:
 					if (cmd.param <= 0x0F)
-						maskFDS = true;
-					else if (!maskFDS && chState.Effect[value_cast(cmd.fx)] == -1) {
+						mask_fds_ = true;
+					else if (!mask_fds_ && chState.Effect[value_cast(cmd.fx)] == -1) {
 						chState.Effect[value_cast(cmd.fx)] = cmd.param;
 						if (chState.Effect_AutoFMMult == -1)
 							chState.Effect_AutoFMMult = -2;
 					}
 					break;
 				case effect_t::FDS_MOD_SPEED_LO:
-					maskFDS = true;
+					mask_fds_ = true;
 					break;
 				case effect_t::DUTY_CYCLE:
 					if (c.Chip == sound_chip_t::VRC7)		// // // 050B
@@ -331,17 +445,31 @@ void CSongState::Retrieve(const CFamiTrackerModule &modfile, unsigned Track, uns
 				}
 			}
 		});
-		if (doHalt)
+		if (halted_)
 			break;
-		++totalRows;
+		++total_rows_;
 	}
-	if (GroovePos == -1 && song.GetSongGroove()) {
-		unsigned Index = song.GetSongSpeed();
-		if (Index < MAX_GROOVE && modfile.HasGroove(Index)) {
-			GroovePos = totalRows;
-			Speed = Index;
-		}
+}
+
+bool CSongState::TryCombine(const CSongState &earlier) {		// // //
+	for (const auto &[id, chState] : State)
+		if (!chState.CanCombine(earlier.State.find(id)->second))
+			return false;
+
+	for (auto &[id, chState] : State)
+		chState.Combine(earlier.State.find(id)->second, mask_fds_);
+	if (Tempo == -1)
+		Tempo = Speed == -1 ? earlier.Tempo : earlier.tempo_any_;
+	if (Speed == -1) {
+		Speed = earlier.Speed;
+		GroovePos = earlier.GroovePos >= 0 ? earlier.GroovePos + total_rows_ : earlier.GroovePos;
 	}
+	if (tempo_any_ == -1)
+		tempo_any_ = earlier.tempo_any_;
+	total_rows_ += earlier.total_rows_;
+	mask_fds_ = mask_fds_ || earlier.mask_fds_;
+	halted_ = earlier.halted_;
+	return true;
 }
 
 std::string CSongState::GetChannelStateString(const CFamiTrackerModule &modfile, stChannelID chan) const {
@@ -365,3 +493,45 @@ std::string CSongState::GetChannelStateString(const CFamiTrackerModule &modfile,
 
 	return str;
 }
+
+
+const std::vector<CSongState> &CSongStateCache::GetCheckpoints(const CFamiTrackerModule &modfile, const CConstSongView &view, unsigned Frame) {		// // //
+	const auto &song = view.GetSong();
+
+	// song-wide settings that affect the scan
+	std::vector<std::uint32_t> key {song.GetPatternLength(), modfile.GetSpeedSplitPoint(), song.GetSongTempo() == 0};
+	std::uint32_t grooves = 0;
+	for (unsigned i = 0; i < MAX_GROOVE; ++i)
+		if (modfile.HasGroove(i))
+			grooves |= 1u << i;
+	key.push_back(grooves);
+	view.GetChannelOrder().ForeachChannel([&] (stChannelID id) {
+		key.push_back(id.ToInteger());
+	});
+	if (key_ != key) {
+		key_ = std::move(key);
+		checkpoints_.clear();
+		frame_keys_.clear();
+	}
+
+	Frame = std::min(Frame, song.GetFrameCount());
+	for (unsigned f = 0; f < frame_keys_.size() && f < Frame; ++f)
+		if (frame_keys_[f] != GetFrameKey(view, f)) {
+			frame_keys_.erase(frame_keys_.begin() + f, frame_keys_.end());
+			checkpoints_.erase(checkpoints_.begin() + f + 1, checkpoints_.end());
+			break;
+		}
+
+	if (checkpoints_.empty())
+		checkpoints_.emplace_back().Reset(view);
+	while (checkpoints_.size() <= Frame) {
+		const unsigned f = checkpoints_.size();
+		CSongState state;
+		state.Reset(view);
+		state.Scan(modfile, view, f, 0, checkpoints_);
+		frame_keys_.push_back(GetFrameKey(view, f - 1));
+		checkpoints_.push_back(std::move(state));
+	}
+
+	return checkpoints_;
+}
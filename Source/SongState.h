@@ -30,8 +30,13 @@
 #include <string>
 #include <array>
 #include <map>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+#include <utility>
 
 class CFamiTrackerModule;
+class CConstSongView;
 class stChanNote;
 struct stEffectCommand;
 
@@ -73,11 +78,22 @@ private:
 	void HandleExxCommand2A03(unsigned char param);
 	void HandleSxxCommand(unsigned char param);
 
+	// // // checkpoint support
+	void PushEcho(int Value, int Delta);
+	bool IsEchoSettled() const;
+	bool CanCombine(const stChannelState &earlier) const;
+	void Combine(const stChannelState &earlier, bool MaskFDS);
+
 	int BufferPos = 0;
 	std::array<int, ECHO_BUFFER_LENGTH> Transpose = { };
+	std::array<std::pair<int, int>, ECHO_BUFFER_LENGTH * 2> EchoNotes = { };		// // // value and transpose of the first notes
+	int NoteCutAny = -1;		// // // first Sxx regardless of the length counter
+	int AutoFMDepth = -1;		// // // first Hxx regardless of FDS masking
 };
 
 class CSongState {
+	friend class CSongStateCache;
+
 public:
 	void Retrieve(const CFamiTrackerModule &modfile, unsigned Track, unsigned Frame, unsigned Row);
 	std::string GetChannelStateString(const CFamiTrackerModule &modfile, stChannelID chan) const;
@@ -86,4 +102,32 @@ public:
 	int Tempo = -1;
 	int Speed = -1;
 	int GroovePos = -1; // -1: disable groove
+
+private:
+	void Reset(const CConstSongView &view);
+	void Scan(const CFamiTrackerModule &modfile, const CConstSongView &view, unsigned Frame, unsigned Row,
+		const std::vector<CSongState> &Checkpoints);		// // //
+	bool TryCombine(const CSongState &earlier);		// // //
+
+	int total_rows_ = 0;
+	int tempo_any_ = -1;
+	bool mask_fds_ = false;
+	bool halted_ = false;
+};
+
+// // // scan states at frame boundaries, owned by CSongData
+class CSongStateCache {
+	friend class CSongState;
+
+public:
+	// Returns the states of all rows before each frame up to the given frame. Checkpoints
+	// computed before an edit to an earlier frame are discarded; missing ones are computed
+	// from the previous checkpoint.
+	const std::vector<CSongState> &GetCheckpoints(const CFamiTrackerModule &modfile, const CConstSongView &view, unsigned Frame);
+
+private:
+	std::vector<CSongState> checkpoints_;
+	std::vector<std::vector<std::pair<std::uint64_t, unsigned>>> frame_keys_;
+	std::vector<std::uint32_t> key_;
+	std::mutex mutex_;
 };
@@ -34,6 +34,7 @@
 #include "SongState.h"
 #include "ChannelMap.h"
 #include "Assertion.h"
+#include <algorithm>		// // //
 
 
 
@@ -53,19 +54,40 @@ void CSoundDriver::SetupTracks() {
 
 	auto *pSCS = FTEnv.GetSoundChipService();
 	pSCS->ForeachTrack([&] (stChannelID id) {
-		tracks_.try_emplace(id, nullptr, std::make_unique<CTrackerChannel>());
+		tracks_.push_back({id, nullptr, std::make_unique<CTrackerChannel>()});		// // //
 	});
+	std::sort(tracks_.begin(), tracks_.end(), [] (const track_t &lhs, const track_t &rhs) {
+		return stChannelID_ident_less { }(lhs.ID, rhs.ID);
+	});
+	tracks_.erase(std::unique(tracks_.begin(), tracks_.end(), [] (const track_t &lhs, const track_t &rhs) {
+		return stChannelID_ident_less::compare(lhs.ID, rhs.ID) == 0;
+	}), tracks_.end());
+
 	pSCS->ForeachType([&] (sound_chip_t c) {
 		chips_.push_back(FTEnv.GetSoundChipService()->MakeChipHandler(c, INSTANCE_ID));
 	});
 
 	for (auto &x : chips_) {
 		x->VisitChannelHandlers([&] (CChannelHandler &ch) {
-			tracks_[ch.GetChannelID()].first = &ch;
+			if (auto *track = FindTrack(ch.GetChannelID()))
+				track->Handler = &ch;
 		});
 	}
 }
 
+CSoundDriver::track_t *CSoundDriver::FindTrack(stChannelID chan) {		// // //
+	if (chan.Chip == sound_chip_t::none)
+		return nullptr;
+	auto it = std::lower_bound(tracks_.begin(), tracks_.end(), chan, [] (const track_t &lhs, const stChannelID &rhs) {
+		return stChannelID_ident_less { }(lhs.ID, rhs);
+	});
+	return it != tracks_.end() && stChannelID_ident_less::compare(it->ID, chan) == 0 ? &*it : nullptr;
+}
+
+const CSoundDriver::track_t *CSoundDriver::FindTrack(stChannelID chan) const {		// // //
+	return const_cast<CSoundDriver *>(this)->FindTrack(chan);
+}
+
 void CSoundDriver::AssignModule(const CFamiTrackerModule &modfile) {
 	modfile_ = &modfile;
 }
@@ -89,17 +111,13 @@ void CSoundDriver::ConfigureDocument() {
 }
 
 CChannelHandler *CSoundDriver::GetChannelHandler(stChannelID chan) const {
-	if (chan.Chip != sound_chip_t::none)
-		if (auto it = tracks_.find(chan); it != tracks_.end())
-			return it->second.first;
-	return nullptr;
+	auto *track = FindTrack(chan);		// // //
+	return track ? track->Handler : nullptr;
 }
 
 CTrackerChannel *CSoundDriver::GetTrackerChannel(stChannelID chan) {
-	if (chan.Chip != sound_chip_t::none)
-		if (auto it = tracks_.find(chan); it != tracks_.end())
-			return it->second.second.get();
-	return nullptr;
+	auto *track = FindTrack(chan);		// // //
+	return track ? track->Tracker.get() : nullptr;
 }
 
 const CTrackerChannel *CSoundDriver::GetTrackerChannel(stChannelID chan) const {
@@ -130,6 +148,8 @@ void CSoundDriver::ResetTracks() {
 		ch.ResetChannel();
 		tr.Reset();
 	});
+	for (auto &x : tracks_)		// // //
+		x.Deferred = false;
 }
 
 void CSoundDriver::LoadSoundState(const CSongState &state) {
@@ -220,34 +240,75 @@ void CSoundDriver::UpdateChannels() {
 	for (auto &chip : chips_)
 		chip->RefreshBefore(*apu_);
 
-	ForeachTrack([&] (CChannelHandler &Chan, CTrackerChannel &TrackerChan, stChannelID ID) {		// // //
-		if (!modfile_->GetChannelOrder().HasChannel(ID))
-			return;
+	// // // the channel order may change between ticks
+	const auto &order = modfile_->GetChannelOrder();
+	for (auto &x : tracks_)
+		x.Active = order.HasChannel(x.ID);
+
+	for (auto &x : tracks_) {		// // //
+		if (!x.Handler || !x.Active)
+			continue;
+		// // // a channel left over from the last frame is updated right away
+		if (!x.Deferred && !m_bHaltRequest)
+			if (unsigned Delay = x.Tracker->GetNoteDelay(); Delay > 0) {
+				x.Deferred = true;
+				x.Delay = Delay;
+				continue;
+			}
+		x.Deferred = false;
+		UpdateChannel(x);
+	}
+
+	for (auto &chip : chips_)
+		chip->RefreshAfter(*apu_);
+}
+
+void CSoundDriver::UpdateChannel(track_t &track) {		// // //
+	CChannelHandler &Chan = *track.Handler;
+	CTrackerChannel &TrackerChan = *track.Tracker;
 
-		// Run auto-arpeggio, if enabled
-		if (int Arpeggio = parent_ ? parent_->GetArpNote(ID) : -1; Arpeggio > 0)		// // //
-			Chan.Arpeggiate(Arpeggio);
+	// Run auto-arpeggio, if enabled
+	if (int Arpeggio = parent_ ? parent_->GetArpNote(track.ID) : -1; Arpeggio > 0)		// // //
+		Chan.Arpeggiate(Arpeggio);
 
-		// Check if new note data has been queued for playing
-		if (TrackerChan.NewNoteData())
-			Chan.PlayNote(TrackerChan.GetNote());		// // //
+	// Check if new note data has been queued for playing
+	if (TrackerChan.NewNoteData())
+		Chan.PlayNote(TrackerChan.GetNote());		// // //
 
-		// Pitch wheel
-		Chan.SetPitch(TrackerChan.GetPitch());
+	// Pitch wheel
+	Chan.SetPitch(TrackerChan.GetPitch());
 
-		// Channel updates (instruments, effects etc)
-		m_bHaltRequest ? Chan.ResetChannel() : Chan.ProcessChannel();
-		Chan.RefreshChannel();
-		Chan.FinishTick();		// // //
-	});
+	// Channel updates (instruments, effects etc)
+	m_bHaltRequest ? Chan.ResetChannel() : Chan.ProcessChannel();
+	Chan.RefreshChannel();
+	Chan.FinishTick();		// // //
+}
+
+unsigned CSoundDriver::GetNextNoteDelay() const {		// // //
+	unsigned Next = (unsigned)-1;
+	for (auto &x : tracks_)
+		if (x.Deferred)
+			Next = std::min(Next, x.Delay);
+	return Next;
+}
+
+void CSoundDriver::PlayDelayedNotes(unsigned Cycle) {		// // //
+	for (auto &chip : chips_)
+		chip->RefreshBefore(*apu_);
+
+	for (auto &x : tracks_)
+		if (x.Deferred && x.Delay <= Cycle) {
+			x.Deferred = false;
+			UpdateChannel(x);
+		}
 
 	for (auto &chip : chips_)
 		chip->RefreshAfter(*apu_);
 }
 
-void CSoundDriver::QueueNote(stChannelID chan, const stChanNote &note, note_prio_t priority) {
+void CSoundDriver::QueueNote(stChannelID chan, const stChanNote &note, note_prio_t priority, unsigned Delay) {
 	if (auto *track = GetTrackerChannel(chan))
-		track->SetNote(note, priority);
+		track->SetNote(note, priority, Delay);		// // //
 }
 
 void CSoundDriver::ForceReloadInstrument(stChannelID chan) {
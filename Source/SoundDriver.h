@@ -25,7 +25,6 @@
 
 #include <memory>
 #include <vector>
-#include <map>
 #include <array>
 #include <string>
 #include "APU/Types.h"
@@ -67,9 +66,15 @@ public:
 
 	void Tick();
 
-	void QueueNote(stChannelID chan, const stChanNote &note, note_prio_t priority);
+	// // // Delay is the number of cycles into the next frame at which the channel is updated
+	void QueueNote(stChannelID chan, const stChanNote &note, note_prio_t priority, unsigned Delay = 0);
 	void ForceReloadInstrument(stChannelID chan);
 
+	// // // Channels with a delayed note skip their update on Tick; the caller plays them once
+	// the APU has run for that many cycles into the frame
+	unsigned GetNextNoteDelay() const;
+	void PlayDelayedNotes(unsigned Cycle);
+
 	bool IsPlaying() const;
 	bool ShouldHalt() const;
 
@@ -85,21 +90,30 @@ public:
 	// void (*F)(CChannelHandler &channel, CTrackerChannel &track [, stChannelID id])
 	template <typename F>
 	void ForeachTrack(F f) const {
-		if constexpr (std::is_invocable_v<F, CChannelHandler &, CTrackerChannel &>) {
-			for (auto &x : tracks_)
-				if (auto &[ch, tr] = x.second; ch && tr)
-					f(*ch, *tr);
-		}
-		else if constexpr (std::is_invocable_v<F, CChannelHandler &, CTrackerChannel &, stChannelID>) {
-			for (auto &[id, x] : tracks_)
-				if (auto &[ch, tr] = x; ch && tr)
-					f(*ch, *tr, id);
-		}
-		else
-			static_assert(sizeof(F) == 0, "Unknown function signature");
+		VisitTracks(f, false);
+	}
+
+	// // // Visits only the channels in the module's channel order as of the last tick
+	template <typename F>
+	void ForeachActiveTrack(F f) const {
+		VisitTracks(f, true);
 	}
 
 private:
+	template <typename F>
+	void VisitTracks(F &f, bool ActiveOnly) const {		// // //
+		for (auto &x : tracks_) {
+			if (!x.Handler || (ActiveOnly && !x.Active))
+				continue;
+			if constexpr (std::is_invocable_v<F, CChannelHandler &, CTrackerChannel &>)
+				f(*x.Handler, *x.Tracker);
+			else if constexpr (std::is_invocable_v<F, CChannelHandler &, CTrackerChannel &, stChannelID>)
+				f(*x.Handler, *x.Tracker, x.ID);
+			else
+				static_assert(sizeof(F) == 0, "Unknown function signature");
+		}
+	}
+
 	CChannelHandler *GetChannelHandler(stChannelID chan) const;
 
 	void SetupVibrato();
@@ -134,7 +148,22 @@ private:
 		}
 	};
 
-	std::map<stChannelID, std::pair<CChannelHandler *, std::unique_ptr<CTrackerChannel>>, stChannelID_ident_less> tracks_;
+	struct track_t {		// // //
+		stChannelID ID;
+		CChannelHandler *Handler = nullptr;
+		std::unique_ptr<CTrackerChannel> Tracker;
+		bool Active = false;
+		bool Deferred = false;		// waiting for PlayDelayedNotes
+		unsigned Delay = 0;
+	};
+
+	track_t *FindTrack(stChannelID chan);		// // //
+	const track_t *FindTrack(stChannelID chan) const;		// // //
+	void UpdateChannel(track_t &track);		// // //
+
+	// // // built once by SetupTracks and sorted by channel ID, so that the channels of each
+	// chip are adjacent and are updated back-to-back
+	std::vector<track_t> tracks_;
 	std::vector<std::unique_ptr<CChipHandler>> chips_;		// // //
 	const CFamiTrackerModule *modfile_ = nullptr;		// // //
 	CSoundGenBase *parent_ = nullptr;		// // //
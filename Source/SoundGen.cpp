@@ -51,6 +51,7 @@ CSoundGen depends on CFamiTrackerView for:
 #include "APU/Mixer.h"		// // // CHIP_LEVEL_*
 #include "SoundChipSet.h"		// // //
 #include "ft0cc/doc/dpcm_sample.hpp"		// // //
+#include "DPCMEncoder.h"		// // //
 #include "InstrumentRecorder.h"		// // //
 #include "Settings.h"
 #include "MIDI.h"
@@ -316,11 +317,17 @@ int CSoundGen::GetNamcoChannelCount() const {		// // //
 }
 
 void CSoundGen::PreviewSample(std::shared_ptr<const ft0cc::doc::dpcm_sample> pSample, int Offset, int Pitch)		// // //
+{
+	PreviewSample(std::make_shared<CDPCMStream>(std::move(pSample)), Offset, Pitch);
+}
+
+void CSoundGen::PreviewSample(std::shared_ptr<const CDPCMStream> pStream, int Offset, int Pitch)		// // //
 {
 	if (!m_hThread)
 		return;
 
-	m_pPreviewSample = std::move(pSample);
+	// The stream may still be encoding; playback starts with the bytes converted so far
+	m_pPreviewSample = std::move(pStream);
 	// Preview a DPCM sample. If the name of sample is null,
 	// the sample will be removed after played
 	PostThreadMessageW(WM_USER_PREVIEW_SAMPLE, Offset, Pitch);
@@ -697,6 +704,10 @@ void CSoundGen::HaltPlayer() {
 	m_bPlayingSingleRow = false;		// // //
 	m_pTempoDisplay.reset();		// // //
 
+	TRACE(L"SoundGen: %llu frames, driver %.1f us/frame, emulation %.1f us/frame\n", m_TickTimer.GetTicks(),		// // //
+		m_TickTimer.GetAverage(tick_part_t::driver), m_TickTimer.GetAverage(tick_part_t::emulation));
+	m_TickTimer.Reset();
+
 #ifdef WRITE_VGM		// // //
 	if (m_pVGMWriter) {
 		m_pVGMWriter->SaveVGMFile();
@@ -732,6 +743,11 @@ CRegisterState *CSoundGen::GetRegState(sound_chip_t Chip, unsigned Reg) const		/
 	return m_pAPU->GetRegState(Chip, Reg);
 }
 
+std::shared_ptr<const CRegisterSnapshot> CSoundGen::GetRegisterSnapshot(unsigned FramesBack) const		// // //
+{
+	return m_pAPU->GetRegisterSnapshot(FramesBack);
+}
+
 double CSoundGen::GetChannelFrequency(sound_chip_t Chip, int Channel) const		// // //
 {
 	return m_pAPU->GetFreq(Chip, Channel);
@@ -827,6 +843,7 @@ void CSoundGen::LoadMachineSettings()		// // //
 
 	// Number of cycles between each APU update
 	m_iUpdateCycles = BaseFreq / Rate;
+	m_FramePeriod = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double> {1. / Rate});		// // //
 
 	{
 		CSingleLock l(&m_csAPULock, TRUE);		// // //
@@ -957,10 +974,14 @@ bool CSoundGen::IsBackgroundTask() const
 
 void CSoundGen::PlayPreviewSample(int Offset, int Pitch) {		// // //
 	int Loop = 0;
-	int Length = ((m_pPreviewSample->size() - 1) >> 4) - (Offset << 2);
+	int Length = ((m_pPreviewSample->GetSample()->size() - 1) >> 4) - (Offset << 2);		// // //
 
-	if (auto *p2A03 = dynamic_cast<C2A03 *>(m_pAPU->GetSoundChip(sound_chip_t::APU)))		// // //
-		p2A03->WriteSample(std::move(m_pPreviewSample));		// // //
+	// // // the stream may still be encoding; its progress counter shares ownership of the stream,
+	// so that the chip keeps it alive without knowing about the encoder
+	if (auto *p2A03 = dynamic_cast<C2A03 *>(m_pAPU->GetSoundChip(sound_chip_t::APU)))
+		p2A03->WriteSample(m_pPreviewSample->GetSample(),
+			std::shared_ptr<const std::atomic<std::size_t>> {m_pPreviewSample, &m_pPreviewSample->GetProgress()});
+	m_pPreviewSample.reset();
 
 	m_pAPU->Write(0x4010, Pitch | Loop);
 	m_pAPU->Write(0x4012, Offset);			// load address, start at $C000
@@ -1064,9 +1085,11 @@ BOOL CSoundGen::IdleLoop() {
 		return TRUE;
 
 	++m_iFrameCounter;
+	AdvanceNoteClock();		// // //
 
 	// Access the document object, skip if access wasn't granted to avoid gaps in audio playback
 	m_pDocument->Locked([this] {
+		auto probe = m_TickTimer.Measure(tick_part_t::driver);		// // //
 		m_pSoundDriver->Tick();		// // //
 	}, 0);
 
@@ -1087,7 +1110,11 @@ BOOL CSoundGen::IdleLoop() {
 		}
 
 	// Update APU registers
-	UpdateAPU();
+	{
+		auto probe = m_TickTimer.Measure(tick_part_t::emulation);		// // //
+		UpdateAPU();
+	}
+	m_TickTimer.EndTick();		// // //
 
 	if (IsPlaying())		// // //
 		if (stChannelID Channel = m_pInstRecorder->GetRecordChannel(); Channel.Chip != sound_chip_t::none)		// // //
@@ -1107,24 +1134,41 @@ void CSoundGen::UpdateAPU()
 	m_bInternalWaveChanged = m_bWaveChanged;
 	m_bWaveChanged = false;
 
-	if (CSingleLock l(&m_csAPULock); l.Lock()) {
+	const auto RenderFrame = [&] {		// // //
+		CSingleLock l(&m_csAPULock);
+		if (!l.Lock())
+			return;
+
 		// Update APU channel registers
 		int cycles = m_iUpdateCycles;
 		sound_chip_t LastChip = sound_chip_t::none;		// // // 050B
 
-		m_pSoundDriver->ForeachTrack([&] (CChannelHandler &Chan, CTrackerChannel &, stChannelID ID) {		// // //
-			if (m_pModule->GetChannelOrder().HasChannel(ID)) {
-				int Delay = (ID.Chip == LastChip) ? 150 : 250;
-				if (Delay < cycles) {
-					// Add APU cycles
-					cycles -= Delay;
-					m_pAPU->AddTime(Delay);
-				}
-				LastChip = ID.Chip;
+		// // // channels that were not updated on the last tick take no time
+		m_pSoundDriver->ForeachActiveTrack([&] (CChannelHandler &, CTrackerChannel &, stChannelID ID) {		// // //
+			int Delay = (ID.Chip == LastChip) ? 150 : 250;
+			if (Delay < cycles) {
+				// Add APU cycles
+				cycles -= Delay;
+				m_pAPU->AddTime(Delay);
+				m_pAPU->Process();
 			}
-			m_pAPU->Process();
+			LastChip = ID.Chip;
 		});
 
+		// // // Play notes scheduled within the frame at their cycle
+		for (unsigned Next; (Next = m_pSoundDriver->GetNextNoteDelay()) < static_cast<unsigned>(m_iUpdateCycles); ) {
+			unsigned Elapsed = m_iUpdateCycles - cycles;
+			if (Next > Elapsed) {
+				m_pAPU->AddTime(Next - Elapsed);
+				m_pAPU->Process();
+				cycles -= Next - Elapsed;
+			}
+			m_pSoundDriver->PlayDelayedNotes(Next);
+		}
+		// // // delays queued against a longer frame play at the end of this one
+		if (m_pSoundDriver->GetNextNoteDelay() != static_cast<unsigned>(-1))
+			m_pSoundDriver->PlayDelayedNotes(static_cast<unsigned>(-1));
+
 		// Finish the audio frame
 		m_pAPU->AddTime(cycles);
 		m_pAPU->Process();
@@ -1136,7 +1180,14 @@ void CSoundGen::UpdateAPU()
 		if (m_pVGMWriter)
 			m_pVGMWriter->Tick();		// // //
 #endif
-	}
+	};
+
+	// // // Channels deferred by this frame's driver tick have not been ticked yet; hold the document
+	// for the whole frame instead of trying the lock for each note, so none of them loses the tick
+	if (m_pSoundDriver->GetNextNoteDelay() != static_cast<unsigned>(-1))
+		m_pDocument->Locked(RenderFrame);
+	else
+		RenderFrame();
 
 #ifdef LOGGING
 	if (m_bPlaying)
@@ -1265,13 +1316,38 @@ void CSoundGen::SetNamcoMixing(bool bLinear)		// // //
 
 // Player state functions
 
-void CSoundGen::QueueNote(stChannelID Channel, const stChanNote &NoteData, note_prio_t Priority) const		// // //
+void CSoundGen::QueueNote(stChannelID Channel, const stChanNote &NoteData, note_prio_t Priority,
+	std::chrono::steady_clock::time_point Time) const		// // //
 {
 	// Queue a note for play
-	m_pSoundDriver->QueueNote(Channel, NoteData, Priority);
+	m_pSoundDriver->QueueNote(Channel, NoteData, Priority, GetNoteDelay(Time));		// // //
 	FTEnv.GetMIDI()->WriteNote((uint8_t)m_pModule->GetChannelOrder().GetChannelIndex(Channel), NoteData.Note, NoteData.Octave, NoteData.Vol);
 }
 
+unsigned CSoundGen::GetNoteDelay(std::chrono::steady_clock::time_point Time) const		// // //
+{
+	// Events arriving during one frame are played during the next one at the same offset, which
+	// turns the jitter of waiting for the next tick into a constant latency of one frame
+	if (Time == std::chrono::steady_clock::time_point { } || m_FramePeriod.count() <= 0)
+		return 0u;
+	auto Offset = Time - m_NoteClock.load(std::memory_order_acquire);
+	if (Offset.count() <= 0 || Offset >= m_FramePeriod)
+		return 0u;
+	return static_cast<unsigned>(static_cast<double>(Offset.count()) / m_FramePeriod.count() * m_iUpdateCycles);
+}
+
+void CSoundGen::AdvanceNoteClock()		// // //
+{
+	// Frames are rendered in bursts whenever the audio buffer has room, so the clock advances by
+	// the nominal frame period and only follows the system clock when it drifts too far away
+	const auto Now = std::chrono::steady_clock::now();
+	const auto Ahead = std::chrono::milliseconds {FTEnv.GetSettings()->Sound.iBufferLength};
+	auto Clock = m_NoteClock.load(std::memory_order_relaxed) + m_FramePeriod;
+	if (Clock + m_FramePeriod < Now || Clock > Now + Ahead)
+		Clock = Now;
+	m_NoteClock.store(Clock, std::memory_order_release);
+}
+
 void CSoundGen::ForceReloadInstrument(stChannelID Channel)		// // //
 {
 	m_pSoundDriver->ForceReloadInstrument(Channel);
@@ -1322,8 +1398,8 @@ CInstrumentManager *CSoundGen::GetInstrumentManager() const
 	return m_pModule ? m_pModule->GetInstrumentManager() : nullptr;
 }
 
-void CSoundGen::SetSequencePlayPos(std::shared_ptr<const CSequence> pSequence, int Pos) {		// // //
-	if (pSequence == m_pSequencePlayPos) {
+void CSoundGen::SetSequencePlayPos(const CSequence *pSequence, int Pos) {		// // //
+	if (pSequence == m_pSequencePlayPos.get()) {
 		m_iSequencePlayPos = Pos;
 		m_iSequenceTimeout = 5;
 	}
@@ -33,9 +33,12 @@
 #include <vector>		// // //
 #include <map>		// // //
 #include <memory>		// // //
+#include <chrono>		// // //
+#include <atomic>		// // //
 #include "SoundGenBase.h"		// // //
 #include "APU/Types.h"
 #include "ft0cc/fs.h"		// // //
+#include "TickTimer.h"		// // //
 
 // Custom messages
 enum {
@@ -71,6 +74,7 @@ class CVisualizerWnd;
 class CInstrumentManager;		// // //
 class CInstrumentRecorder;		// // //
 class CRegisterState;		// // //
+class CRegisterSnapshot;		// // //
 class CArpeggiator;		// // //
 class CAudioDriver;		// // //
 class CWaveRenderer;		// // //
@@ -81,6 +85,7 @@ class CPlayerCursor;		// // //
 class CSoundDriver;		// // //
 class CSoundChipSet;		// // //
 class CSimpleFile;		// // //
+class CDPCMStream;		// // //
 
 namespace ft0cc::doc {
 class dpcm_sample;
@@ -168,6 +173,7 @@ public:
 
 	// Sample previewing
 	void		 PreviewSample(std::shared_ptr<const ft0cc::doc::dpcm_sample> pSample, int Offset, int Pitch);		// // //
+	void		 PreviewSample(std::shared_ptr<const CDPCMStream> pStream, int Offset, int Pitch);		// // //
 	void		 CancelPreviewSample();
 	bool		 PreviewDone() const;
 
@@ -179,6 +185,7 @@ public:
 
 	uint8_t		GetReg(sound_chip_t Chip, int Reg) const;
 	CRegisterState *GetRegState(sound_chip_t Chip, unsigned Reg) const;		// // //
+	std::shared_ptr<const CRegisterSnapshot> GetRegisterSnapshot(unsigned FramesBack = 0) const;		// // //
 	double		GetChannelFrequency(sound_chip_t Chip, int Channel) const;		// // //
 	std::string	RecallChannelState(stChannelID Channel) const;		// // //
 
@@ -192,7 +199,10 @@ public:
 	std::pair<unsigned, unsigned> GetPlayerPos() const;		// // // frame / row
 	int			GetPlayerTrack() const;
 	int			GetPlayerTicks() const;
-	void		QueueNote(stChannelID Channel, const stChanNote &NoteData, note_prio_t Priority) const;		// // //
+	// // // Time schedules the note at the same offset into the next frame as the time since the
+	// start of the frame being rendered; it is ignored unless the note comes from a timestamped event
+	void		QueueNote(stChannelID Channel, const stChanNote &NoteData, note_prio_t Priority,
+		std::chrono::steady_clock::time_point Time = { }) const;
 	void		ForceReloadInstrument(stChannelID Channel);		// // //
 	void		MoveToFrame(int Frame);
 	void		SetQueueFrame(unsigned Frame);		// // //
@@ -207,7 +217,7 @@ public:
 	void			SetRecordSetting(const stRecordSetting &Setting);
 
 	// Sequence play position
-	void SetSequencePlayPos(std::shared_ptr<const CSequence> pSequence, int Pos);		// // //
+	void SetSequencePlayPos(const CSequence *pSequence, int Pos);		// // //
 	int GetSequencePlayPos(std::shared_ptr<const CSequence> pSequence);		// // //
 
 	void SetMeterDecayRate(decay_rate_t Type) const;		// // // 050B
@@ -232,6 +242,8 @@ private:
 
 	// Player
 	void		UpdateAPU();
+	void		AdvanceNoteClock();		// // //
+	unsigned	GetNoteDelay(std::chrono::steady_clock::time_point Time) const;		// // //
 	void		ResetBuffer();
 	void		BeginPlayer(std::unique_ptr<CPlayerCursor> Pos);		// // //
 	void		HaltPlayer();
@@ -270,7 +282,7 @@ private:
 	std::unique_ptr<CAudioDriver>	m_pAudioDriver;			// // //
 	std::unique_ptr<CAPU>			m_pAPU;
 
-	std::shared_ptr<const ft0cc::doc::dpcm_sample> m_pPreviewSample;
+	std::shared_ptr<const CDPCMStream> m_pPreviewSample;		// // //
 	CVisualizerWnd					*m_pVisualizerWnd = nullptr;
 
 	bool				m_bRunning;
@@ -295,6 +307,9 @@ private:
 	int					m_iFrameCounter;
 
 	int					m_iUpdateCycles;					// Number of cycles/APU update
+	std::chrono::steady_clock::duration m_FramePeriod { };		// // //
+	std::atomic<std::chrono::steady_clock::time_point> m_NoteClock { };		// // // nominal start of the frame being rendered
+	CTickTimer			m_TickTimer;		// // // driver and emulation time per frame
 
 	int					m_iLastTrack = 0;					// // //
 	int					m_iLastHighlight;					// // //
@@ -22,16 +22,13 @@
 
 #include "TextExporter.h"
 #include "SongData.h"		// // //
-#include "SoundGen.h"		// // //
-#include "FamiTrackerDoc.h"
 #include "FamiTrackerModule.h"		// // //
 #include "ChannelMap.h"		// // //
 #include "version.h"		// // //
 #include "FamiTrackerEnv.h"		// // //
-#include "FamiTrackerViewMessage.h"		// // //
-#include "str_conv/str_conv.hpp"		// // //
 #include "NumConv.h"		// // //
 #include "NoteName.h"		// // //
+#include "MappedFile.h"		// // //
 
 #include "ft0cc/doc/dpcm_sample.hpp"		// // //
 #include "ft0cc/doc/groove.hpp"		// // //
@@ -46,9 +43,18 @@
 #include "InstrumentN163.h"		// // //
 #include "SoundChipSet.h"		// // //
 
-#include <type_traits>		// // //
+#ifndef FT0CC_EXT_BUILD
+#include "SoundGen.h"		// // //
+#include "FamiTrackerDoc.h"
+#include "str_conv/str_conv.hpp"		// // //
+#endif
 
-#define DEBUG_OUT(...) { OutputDebugString(FormattedA(__VA_ARGS__)); }
+#include <type_traits>		// // //
+#include <charconv>		// // //
+#include <optional>		// // //
+#include <cstring>		// // //
+#include <cctype>		// // //
+#include <algorithm>		// // //
 
 // command tokens
 enum
@@ -163,6 +169,165 @@ const char *CT[CT_COUNT] = {
 	"ROW",
 };
 
+
+// // // case-insensitive comparison of ASCII strings
+bool EqualsNoCase(std::string_view lhs, std::string_view rhs) noexcept {
+	if (lhs.size() != rhs.size())
+		return false;
+	for (std::size_t i = 0; i < lhs.size(); ++i)
+		if (std::toupper(static_cast<unsigned char>(lhs[i])) != std::toupper(static_cast<unsigned char>(rhs[i])))
+			return false;
+	return true;
+}
+
+std::string ToUpper(std::string_view sv) {
+	std::string str {sv};
+	for (char &ch : str)
+		ch = static_cast<char>(std::toupper(static_cast<unsigned char>(ch)));
+	return str;
+}
+
+// // // parses a complete token, accepting the same inputs as conv::to_int and conv::to_uint
+template <typename T>
+std::optional<T> ParseNumber(std::string_view sv, int radix) noexcept {
+	if constexpr (std::is_signed_v<T>)
+		if (!sv.empty() && sv.front() == '+') {		// not accepted by std::from_chars
+			sv.remove_prefix(1);
+			if (!sv.empty() && sv.front() == '-')
+				return std::nullopt;
+		}
+
+	T x = 0;
+	const char *end = sv.data() + sv.size();
+	if (auto [ptr, ec] = std::from_chars(sv.data(), end, x, radix); ec != std::errc { } || ptr != end)
+		return std::nullopt;
+	return x;
+}
+
+// // // writes x as "%0*X" would, returns the end of the output
+char *PutHex(char *p, unsigned long long x, unsigned Digits) noexcept {
+	char buf[16];
+	unsigned n = 0;
+	do {
+		buf[n++] = "0123456789ABCDEF"[x & 0xFu];
+		x >>= 4;
+	} while (x);
+	while (n < Digits && n < std::size(buf))
+		buf[n++] = '0';
+	while (n)
+		*p++ = buf[--n];
+	return p;
+}
+
+// // // writes x as "%*d" would, returns the end of the output
+char *PutInt(char *p, long long x, unsigned Width) noexcept {
+	char buf[24];
+	auto len = static_cast<unsigned>(std::to_chars(std::begin(buf), std::end(buf), x).ptr - buf);
+	for (; Width > len; --Width)
+		*p++ = ' ';
+	std::memcpy(p, buf, len);
+	return p + len;
+}
+
+// // // text export buffer, reserved from an estimate of the output size so that the text is
+// written in place instead of through temporary strings
+class CTextBuffer {
+public:
+	explicit CTextBuffer(std::size_t Capacity) {
+		text_.reserve(Capacity);
+	}
+
+	// makes room for at least Size more characters
+	void Reserve(std::size_t Size) {
+		if (text_.capacity() - text_.size() < Size)
+			text_.reserve(std::max(text_.capacity() * 2, text_.size() + Size));
+	}
+
+	// returns a pointer to Size characters at the end of the buffer, which must be followed
+	// by a call to Commit with the end of the characters actually written
+	char *Extend(std::size_t Size) {
+		Reserve(Size);
+		std::size_t Pos = text_.size();
+		text_.resize(Pos + Size);
+		return text_.data() + Pos;
+	}
+
+	void Commit(const char *End) {
+		text_.resize(End - text_.data());
+	}
+
+	void Write(std::string_view str) {
+		text_.append(str);
+	}
+
+	void Write(char ch) {
+		text_.push_back(ch);
+	}
+
+	// "%*d"
+	void WriteInt(int x, unsigned Width = 0) {
+		char buf[48];
+		text_.append(buf, PutInt(buf, x, std::min(Width, 24u)));
+	}
+
+	// " %*d" for each argument, converted to int as printf would
+	template <typename... Ts>
+	void WriteFields(unsigned Width, Ts... xs) {
+		((Write(' '), WriteInt(static_cast<int>(xs), Width)), ...);
+	}
+
+	// "%0*X"
+	void WriteHex(unsigned long long x, unsigned Digits) {
+		char buf[16];
+		text_.append(buf, PutHex(buf, x, Digits));
+	}
+
+	// "%-*s"
+	void WritePadded(std::string_view str, unsigned Width) {
+		text_.append(str);
+		if (str.size() < Width)
+			text_.append(Width - str.size(), ' ');
+	}
+
+	// puts " at beginning and end of string, replace " with ""
+	void WriteQuoted(std::string_view str) {
+		text_.push_back('\"');
+		while (true) {
+			auto n = str.find('\"');
+			text_.append(str.substr(0, n));
+			if (n == std::string_view::npos)
+				break;
+			text_.append("\"\"");
+			str.remove_prefix(n + 1);
+		}
+		text_.push_back('\"');
+	}
+
+	std::string Release() {
+		return std::move(text_);
+	}
+
+private:
+	std::string text_;
+};
+
+// // // everything except the pattern data, which is reserved one pattern at a time
+std::size_t EstimateTextSize(const CFamiTrackerModule &modfile) {
+	const std::size_t Channels = modfile.GetChannelOrder().GetChannelCount();
+	std::size_t Size = 0x10000;		// settings, macros, grooves, instruments
+
+	for (unsigned i = 0; i < MAX_DSAMPLES; ++i)
+		if (auto pSample = modfile.GetDSampleManager()->GetDSample(i))
+			Size += 32 + pSample->name().size() + pSample->size() * 3 + (pSample->size() / 32 + 1) * 8;
+
+	modfile.VisitSongs([&] (const CSongData &song) {
+		Size += 32 + song.GetTitle().size() + Channels * 2;
+		Size += song.GetFrameCount() * (12 + Channels * 3);
+	});
+
+	return Size;
+}
+
 } // namespace
 
 // =============================================================================
@@ -170,7 +335,7 @@ const char *CT[CT_COUNT] = {
 class Tokenizer
 {
 public:
-	explicit Tokenizer(const fs::path &FileName) : text(ReadFromFile(FileName)) { }
+	explicit Tokenizer(std::string_view Text) : text(Text) { }		// // //
 	~Tokenizer() = default;
 
 	void Reset() {
@@ -180,81 +345,93 @@ public:
 	}
 
 	void FinishLine() {
-		if (int newpos = text.Find('\n', pos); newpos >= 0) {		// // //
+		if (auto newpos = text.find('\n', pos); newpos != std::string_view::npos) {		// // //
 			++line;
 			pos = newpos + 1;
 		}
 		else
-			pos = text.GetLength();
+			pos = text.size();
 		last_pos_ = linestart = pos;
 	}
 
 	int GetColumn() const {
-		return 1 + pos - linestart;
+		return 1 + static_cast<int>(pos - linestart);
 	}
 
 	bool Finished() const {
-		return pos >= text.GetLength();
+		return pos >= text.size();
 	}
 
-	CStringA ReadToken() {
+	// // // the returned view refers to the text itself, except for quoted strings containing
+	// escaped quotes, which are unescaped into a buffer overwritten by the next call
+	std::string_view ReadToken() {
 		ConsumeSpace();
-		CStringA t = "";
-
-		bool isQuoted = TrimChar('\"');		// // //
-		while (!Finished())
-			switch (char c = text.GetAt(pos)) {
-			case '\r': case '\n':
-				if (isQuoted)
-					throw MakeError("incomplete quoted string.");
-				goto outer;
-			case '\"':
-				if (!isQuoted)
-					goto outer;
-				++pos;
-				if (!TrimChar('\"'))
-					goto outer;
-				t += c;
-				break;
-			case ' ': case '\t':
-				if (!isQuoted)
-					goto outer;
-				[[fallthrough]];
-			default:
-				t += c;
+
+		if (!TrimChar('\"')) {
+			std::size_t begin = pos;
+			while (!Finished()) {
+				char c = text[pos];
+				if (c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\"')
+					break;
 				++pos;
 			}
-		outer:
+			last_pos_ = pos;
+			return text.substr(begin, pos - begin);
+		}
+
+		std::size_t begin = pos;
+		std::size_t seg = pos;
+		bool escaped = false;
+		for (; !Finished(); ++pos) {
+			char c = text[pos];
+			if (c == '\r' || c == '\n')
+				throw MakeError("incomplete quoted string.");
+			if (c == '\"') {
+				if (pos + 1 >= text.size() || text[pos + 1] != '\"')
+					break;
+				if (!escaped)
+					unescaped_.clear();
+				escaped = true;
+				unescaped_.append(text.substr(seg, pos + 1 - seg));
+				seg = ++pos + 1;
+			}
+		}
+		std::size_t end = pos;
+		TrimChar('\"');
 
-		//DEBUG_OUT("ReadToken(%d,%d): '%s'\n", line, GetColumn(), t);
 		last_pos_ = pos;
-		return t;
+		if (!escaped)
+			return text.substr(begin, end - begin);
+		unescaped_.append(text.substr(seg, end - seg));
+		return unescaped_;
 	}
 
 	int ReadInt(int range_min, int range_max) {
-		if (CStringA t = ReadToken(); !t.IsEmpty()) {
-			if (auto i = conv::to_int(t)) {
+		if (auto t = ReadToken(); !t.empty()) {
+			if (auto i = ParseNumber<int>(t, 10)) {		// // //
 				if (*i >= range_min && *i <= range_max) {
 					last_pos_ = pos;
 					return *i;
 				}
-				throw MakeError("expected integer in range [%d,%d], %d found.", range_min, range_max, *i);
+				throw MakeError("expected integer in range [" + std::to_string(range_min) + "," +
+					std::to_string(range_max) + "], " + std::to_string(*i) + " found.");
 			}
-			throw MakeError("expected integer, '%s' found.", (LPCSTR)t);
+			throw MakeError("expected integer, '" + std::string {t} + "' found.");
 		}
 		throw MakeError("expected integer, no token found.");
 	}
 
 	unsigned ReadHex(unsigned range_min, unsigned range_max) {
-		if (CStringA t = ReadToken(); !t.IsEmpty()) {
-			if (auto i = conv::to_uint(t, 16)) {
+		if (auto t = ReadToken(); !t.empty()) {
+			if (auto i = ParseNumber<unsigned>(t, 16)) {		// // //
 				if (*i >= range_min && *i <= range_max) {
 					last_pos_ = pos;
 					return *i;
 				}
-				throw MakeError("expected hexadecimal in range [%X,%X], %X found.", range_min, range_max, *i);
+				throw MakeError("expected hexadecimal in range [" + conv::from_uint_hex(range_min) + "," +
+					conv::from_uint_hex(range_max) + "], " + conv::from_uint_hex(*i) + " found.");
 			}
-			throw MakeError("expected hexadecimal, '%s' found.", (LPCSTR)t);
+			throw MakeError("expected hexadecimal, '" + std::string {t} + "' found.");
 		}
 		throw MakeError("expected hexadecimal, no token found.");
 	}
@@ -262,11 +439,11 @@ public:
 	// note: finishes line if found
 	void ReadEOL() {
 		ConsumeSpace();
-		if (CStringA s = ReadToken(); !s.IsEmpty())
-			throw MakeError("expected end of line, '%s' found.", (LPCSTR)s);
+		if (auto s = ReadToken(); !s.empty())
+			throw MakeError("expected end of line, '" + std::string {s} + "' found.");
 		if (!Finished()) {
-			if (char eol = text.GetAt(pos); eol != '\r' && eol != '\n')
-				throw MakeError("expected end of line, '%c' found.", eol);
+			if (char eol = text[pos]; eol != '\r' && eol != '\n')
+				throw MakeError("expected end of line, '" + std::string(1, eol) + "' found.");
 			FinishLine();
 		}
 		last_pos_ = pos;
@@ -289,41 +466,38 @@ public:
 		return false;
 	}
 
-	int ImportHex(const CStringA &sToken) {		// // //
-		auto x = conv::to_int(sToken, 16);
+	int ImportHex(std::string_view sToken) {		// // //
+		auto x = ParseNumber<int>(sToken, 16);
 		if (!x)
-			throw MakeError("hexadecimal number expected, '%s' found.", (LPCSTR)sToken);
+			throw MakeError("hexadecimal number expected, '" + std::string {sToken} + "' found.");
 		return *x;
 	}
 
-	template <typename... Args>
-	auto MakeError(LPCSTR fmt, Args&&... args) const {		// // //
-		CStringA str = FormattedA("Line %d column %d: ", line, GetColumn());
-		AppendFormatA(str, fmt, std::forward<Args>(args)...);
-		return std::runtime_error {(LPCSTR)str};
+	std::runtime_error MakeError(const std::string &msg) const {		// // //
+		return std::runtime_error {"Line " + std::to_string(line) + " column " + std::to_string(GetColumn()) + ": " + msg};
 	}
 
 	stChanNote ImportCellText(unsigned fxMax, stChannelID chan) {		// // //
 		stChanNote Cell;		// // //
 
-		CStringA sNote = ReadToken();
+		std::string_view sNote = ReadToken();
 		if (sNote == "...") { Cell.Note = note_t::none; }
 		else if (sNote == "---") { Cell.Note = note_t::halt; }
 		else if (sNote == "===") { Cell.Note = note_t::release; }
 		else {
-			if (sNote.GetLength() != 3)
-				throw MakeError("note column should be 3 characters wide, '%s' found.", (LPCSTR)sNote);
+			if (sNote.size() != 3)
+				throw MakeError("note column should be 3 characters wide, '" + std::string {sNote} + "' found.");
 
 			if (IsAPUNoise(chan)) {		// // // noise
-				int h = ImportHex(sNote.Left(1));		// // //
+				int h = ImportHex(sNote.substr(0, 1));		// // //
 				Cell.Note = ft0cc::doc::pitch_from_midi(h);
 				Cell.Octave = ft0cc::doc::oct_from_midi(h);
 
 				// importer is very tolerant about the second and third characters
 				// in a noise note, they can be anything
 			}
-			else if (sNote.GetAt(0) == '^' && sNote.GetAt(1) == '-') {		// // //
-				unsigned o = sNote.GetAt(2) - '0';
+			else if (sNote[0] == '^' && sNote[1] == '-') {		// // //
+				unsigned o = sNote[2] - '0';
 				if (o >= ECHO_BUFFER_LENGTH)
 					throw MakeError("out-of-bound echo buffer accessed.");
 				Cell.Note = note_t::echo;
@@ -331,7 +505,7 @@ public:
 			}
 			else {
 				int n = 1;
-				switch (sNote.GetAt(0)) {
+				switch (sNote[0]) {
 				case 'c': case 'C': n = value_cast(note_t::C); break;
 				case 'd': case 'D': n = value_cast(note_t::D); break;
 				case 'e': case 'E': n = value_cast(note_t::E); break;
@@ -340,63 +514,59 @@ public:
 				case 'a': case 'A': n = value_cast(note_t::A); break;
 				case 'b': case 'B': n = value_cast(note_t::B); break;
 				default:
-					throw MakeError("unrecognized note '%s'.", (LPCSTR)sNote);
+					throw MakeError("unrecognized note '" + std::string {sNote} + "'.");
 				}
-				switch (sNote.GetAt(1)) {
+				switch (sNote[1]) {
 				case '-': case '.': break;
 				case '#': case '+': ++n; break;
 				case 'b': case 'f': --n; break;
 				default:
-					throw MakeError("unrecognized note '%s'.", (LPCSTR)sNote);
+					throw MakeError("unrecognized note '" + std::string {sNote} + "'.");
 				}
 				while (n < value_cast(note_t::C)) n += NOTE_RANGE;
 				while (n > value_cast(note_t::B)) n -= NOTE_RANGE;
 				Cell.Note = enum_cast<note_t>(n);
 
-				int o = sNote.GetAt(2) - '0';
+				int o = sNote[2] - '0';
 				if (o < 0 || o >= OCTAVE_RANGE) {
-					throw MakeError("unrecognized octave '%s'.", (LPCSTR)sNote);
+					throw MakeError("unrecognized octave '" + std::string {sNote} + "'.");
 				}
 				Cell.Octave = o;
 			}
 		}
 
-		CStringA sInst = ReadToken();
+		std::string_view sInst = ReadToken();
 		if (sInst == "..") { Cell.Instrument = MAX_INSTRUMENTS; }
 		else if (sInst == "&&") { Cell.Instrument = HOLD_INSTRUMENT; }		// // // 050B
 		else {
-			if (sInst.GetLength() != 2)
-				throw MakeError("instrument column should be 2 characters wide, '%s' found.", (LPCSTR)sInst);
+			if (sInst.size() != 2)
+				throw MakeError("instrument column should be 2 characters wide, '" + std::string {sInst} + "' found.");
 			int h = ImportHex(sInst);		// // //
 			if (h >= MAX_INSTRUMENTS)
-				throw MakeError("instrument '%s' is out of bounds.", (LPCSTR)sInst);
+				throw MakeError("instrument '" + std::string {sInst} + "' is out of bounds.");
 			Cell.Instrument = h;
 		}
 
-		Cell.Vol = [&] (const CStringA &str) -> unsigned {
+		Cell.Vol = [&] (std::string_view str) -> unsigned {
 			if (str == ".")
 				return MAX_VOLUME;
-			const LPCSTR VOL_TEXT[] = {
-				"0", "1", "2", "3", "4", "5", "6", "7",
-				"8", "9", "A", "B", "C", "D", "E", "F",
-			};
-			unsigned v = 0;
-			for (; v < std::size(VOL_TEXT); ++v)
-				if (str == VOL_TEXT[v])
+			if (str.size() == 1)		// // //
+				if (unsigned v = conv::from_digit(str[0]); v < 0x10u)
 					return v;
-			throw MakeError("unrecognized volume token '%s'.", (LPCSTR)str);
-		}(ReadToken().MakeUpper());
+			throw MakeError("unrecognized volume token '" + ToUpper(str) + "'.");
+		}(ReadToken());
 
 		for (unsigned int e = 0; e < fxMax; ++e) {		// // //
-			CStringA sEff = ReadToken().MakeUpper();
-			if (sEff.GetLength() != 3)
-				throw MakeError("effect column should be 3 characters wide, '%s' found.", (LPCSTR)sEff);
+			std::string_view sEff = ReadToken();
+			if (sEff.size() != 3)
+				throw MakeError("effect column should be 3 characters wide, '" + ToUpper(sEff) + "' found.");
 
 			if (sEff != "...") {
-				effect_t Eff = FTEnv.GetSoundChipService()->TranslateEffectName(sEff.GetAt(0), chan.Chip);		// // //
+				char ch = static_cast<char>(std::toupper(static_cast<unsigned char>(sEff[0])));
+				effect_t Eff = FTEnv.GetSoundChipService()->TranslateEffectName(ch, chan.Chip);		// // //
 				if (Eff == effect_t::none)
-					throw MakeError("unrecognized effect '%s'.", (LPCSTR)sEff);
-				Cell.Effects[e] = {Eff, static_cast<uint8_t>(ImportHex(sEff.Right(2)))};		// // //
+					throw MakeError("unrecognized effect '" + ToUpper(sEff) + "'.");
+				Cell.Effects[e] = {Eff, static_cast<uint8_t>(ImportHex(sEff.substr(1)))};		// // //
 			}
 		}
 
@@ -407,7 +577,7 @@ public:
 private:
 	bool TrimChar(char ch) {
 		if (!Finished())
-			if (char x = text.GetAt(pos); x == ch) {
+			if (char x = text[pos]; x == ch) {
 				++pos;
 				return true;
 			}
@@ -415,103 +585,88 @@ private:
 	}
 
 	void ConsumeSpace() {
-		while (TrimChar(' ') || TrimChar('\t'))		// // //
+		// // // carriage returns are skipped here instead of being stripped from the text
+		while (TrimChar(' ') || TrimChar('\t') || TrimChar('\r'))		// // //
 			;
 	}
 
-	CStringA ReadFromFile(const fs::path &FileName) {
-		CFileException oFileException;
-		if (CStdioFile f; f.Open(FileName.c_str(), CFile::modeRead | CFile::typeBinary, &oFileException)) {
-			CStringA str;
-			while (f.GetPosition() < f.GetLength()) {
-				char buf[1024] = { };
-				ULONGLONG sz = std::min(f.GetLength() - f.GetPosition(), (ULONGLONG)std::size(buf));
-				f.Read(buf, (UINT)sz);
-				CStringA part(buf, (int)sz);
-				part.Replace("\r", "");
-				str += part;
-			}
-			f.Close();
-			return str;
-		}
-
-		WCHAR szError[256];
-		oFileException.GetErrorMessage(szError, std::size(szError));
-		throw std::runtime_error {"Unable to open file:\n" + conv::to_utf8(szError)};
-	}
-
 public:
 	int line = 1;
 
 private:
-	const CStringA text; // TODO: move outside and use string_view
-	int pos = 0;
-	int linestart = 0;
-	int last_pos_ = 0;		// // //
+	std::string_view text;		// // //
+	std::string unescaped_;		// // //
+	std::size_t pos = 0;
+	std::size_t linestart = 0;
+	std::size_t last_pos_ = 0;		// // //
 };
 
 // =============================================================================
 
-CStringA CTextExport::ExportString(const CStringA &s)
+std::size_t CTextExport::WriteCellText(char *Buf, const stChanNote &stCell, unsigned int nEffects, bool bNoise)		// // //
 {
-	return ExportString(std::string_view {(LPCSTR)s});
-}
+	static_assert(MAX_CELL_TEXT >= 3 + 3 + 2 + 4 * MAX_EFFECT_COLUMNS);
+	char *p = Buf;
 
-CStringA CTextExport::ExportString(std::string_view s)		// // //
-{
-	// puts " at beginning and end of string, replace " with ""
-	CStringA r = "\"";
-	for (char c : s) {
-		if (c == '\"')
-			r += c;
-		r += c;
+	if (bNoise && (is_note(stCell.Note) || stCell.Note == note_t::echo)) {		// // //
+		p = PutHex(p, stCell.ToMidiNote() & 0x0F, 1);
+		*p++ = '-';
+		*p++ = '#';
+	}
+	else if (stCell.Note <= note_t::echo && stCell.Note != note_t::none) {
+		std::string sNote = GetNoteString(stCell);
+		p = std::copy(sNote.begin(), sNote.end(), p);
+	}
+	else
+		p = std::copy_n("...", 3, p);
+
+	if (stCell.Instrument == MAX_INSTRUMENTS)
+		p = std::copy_n(" ..", 3, p);
+	else if (stCell.Instrument == HOLD_INSTRUMENT)		// // // 050B
+		p = std::copy_n(" &&", 3, p);
+	else {
+		*p++ = ' ';
+		p = PutHex(p, stCell.Instrument, 2);
 	}
-	r += "\"";
-	return r;
-}
-
-// =============================================================================
-
-CStringA CTextExport::ExportCellText(const stChanNote &stCell, unsigned int nEffects, bool bNoise)		// // //
-{
-	CStringA s = "...";
-	if (bNoise && (is_note(stCell.Note) || stCell.Note == note_t::echo))		// // //
-		s = FormattedA("%01X-#", stCell.ToMidiNote() & 0x0F);
-	else if (stCell.Note <= note_t::echo)
-		s = GetNoteString(stCell).data();
-
-	s += (stCell.Instrument == MAX_INSTRUMENTS) ? CStringA(" ..") :
-		(stCell.Instrument == HOLD_INSTRUMENT) ? CStringA(" &&") : FormattedA(" %02X", stCell.Instrument);		// // // 050B
 
-	s += (stCell.Vol == 0x10) ? CStringA(" .") : FormattedA(" %01X", stCell.Vol);		// // //
+	*p++ = ' ';
+	if (stCell.Vol == 0x10)
+		*p++ = '.';
+	else
+		p = PutHex(p, stCell.Vol, 1);
 
-	for (unsigned int e=0; e < nEffects; ++e)
+	for (unsigned int e = 0; e < nEffects; ++e) {
+		*p++ = ' ';
 		if (stCell.Effects[e].fx == effect_t::none)
-			s.Append(" ...");
-		else
-			AppendFormatA(s, " %c%02X", EFF_CHAR[value_cast(stCell.Effects[e].fx)], stCell.Effects[e].param);
+			p = std::copy_n("...", 3, p);
+		else {
+			*p++ = EFF_CHAR[value_cast(stCell.Effects[e].fx)];
+			p = PutHex(p, stCell.Effects[e].param, 2);
+		}
+	}
 
-	return s;
+	return p - Buf;
+}
+
+std::string CTextExport::ExportCellText(const stChanNote &stCell, unsigned int nEffects, bool bNoise)		// // //
+{
+	char buf[MAX_CELL_TEXT];
+	return std::string(buf, WriteCellText(buf, stCell, nEffects, bNoise));
 }
 
 // =============================================================================
 
 #define CHECK_SYMBOL(x) do { \
-		if (CStringA symbol_ = t.ReadToken(); symbol_ != x) \
-			throw t.MakeError("expected '%s', '%s' found.", (LPCSTR)x, (LPCSTR)symbol_); \
+		if (auto symbol_ = t.ReadToken(); symbol_ != x) \
+			throw t.MakeError("expected '" + std::string {x} + "', '" + std::string {symbol_} + "' found."); \
 	} while (false)
 
 #define CHECK_COLON() CHECK_SYMBOL(":")
 
-void CTextExport::ImportFile(const fs::path &FileName, CFamiTrackerDoc &Doc) {
-	// begin a new document
-	if (!Doc.OnNewDocument())
-		throw std::runtime_error {"Unable to create new LLtracker document."};
-
+void CTextExport::ImportText(std::string_view Text, CFamiTrackerModule &modfile) {		// // //
 	// parse the file
-	Tokenizer t(FileName);		// // //
+	Tokenizer t(Text);		// // //
 
-	auto &modfile = *Doc.GetModule();		// // //
 	auto &InstManager = *modfile.GetInstrumentManager();
 
 	unsigned int dpcm_index = 0;
@@ -521,30 +676,30 @@ void CTextExport::ImportFile(const fs::path &FileName, CFamiTrackerDoc &Doc) {
 	unsigned int pattern = 0;
 	int N163count = -1;		// // //
 	bool UseGroove[MAX_TRACKS] = {};		// // //
+	std::vector<std::pair<stChannelID, CTrackData *>> Tracks;		// // // channels of the current track
 	while (!t.Finished()) {
 		// read first token on line
 		if (t.IsEOL()) continue; // blank line
-		CStringA command = t.ReadToken().MakeUpper();		// // //
+		std::string_view command = t.ReadToken();		// // //
 
 		int c = 0;
 		for (; c < CT_COUNT; ++c)
-			if (command == CT[c]) break;
+			if (EqualsNoCase(command, CT[c])) break;
 
-		//DEBUG_OUT("Command read: %s\n", command);
 		switch (c) {
 		case CT_COMMENTLINE:
 			t.FinishLine();
 			break;
 		case CT_TITLE:
-			modfile.SetModuleName(LPCSTR(t.ReadToken()));
+			modfile.SetModuleName(t.ReadToken());
 			t.ReadEOL();
 			break;
 		case CT_AUTHOR:
-			modfile.SetModuleArtist(LPCSTR(t.ReadToken()));
+			modfile.SetModuleArtist(t.ReadToken());
 			t.ReadEOL();
 			break;
 		case CT_COPYRIGHT:
-			modfile.SetModuleCopyright(LPCSTR(t.ReadToken()));
+			modfile.SetModuleCopyright(t.ReadToken());
 			t.ReadEOL();
 			break;
 		case CT_COMMENT:
@@ -567,7 +722,12 @@ void CTextExport::ImportFile(const fs::path &FileName, CFamiTrackerDoc &Doc) {
 			break;
 		case CT_EXPANSION: {
 			auto flag = t.ReadInt(0, CSoundChipSet::NSF_MAX_FLAG);		// // //
-			modfile.SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(CSoundChipSet::FromNSFFlag(flag), modfile.GetNamcoChannels()));
+			// // // the 2A03 channels are always exported; the N163 channel count is set by
+			// N163CHANNELS, but the map must have at least one N163 channel
+			auto Chips = CSoundChipSet::FromNSFFlag(flag).WithChip(sound_chip_t::APU);
+			int N163chs = Chips.ContainsChip(sound_chip_t::N163) ? std::max(modfile.GetNamcoChannels(), 1) : 0;
+			modfile.SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(Chips, N163chs));
+			Tracks.clear();		// // //
 			t.ReadEOL();
 			break;
 		}
@@ -598,6 +758,7 @@ void CTextExport::ImportFile(const fs::path &FileName, CFamiTrackerDoc &Doc) {
 			N163count = t.ReadInt(1, MAX_CHANNELS_N163);		// // //
 			t.ReadEOL();
 			modfile.SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(modfile.GetSoundChipSet(), MAX_CHANNELS_N163));
+			Tracks.clear();		// // //
 			break;
 		case CT_MACRO:
 		case CT_MACROVRC6:
@@ -621,7 +782,7 @@ void CTextExport::ImportFile(const fs::path &FileName, CFamiTrackerDoc &Doc) {
 			while (!t.IsEOL()) {
 				int item = t.ReadInt(-128, 127);
 				if (count >= MAX_SEQUENCE_ITEMS)
-					throw t.MakeError("macro overflow, max size: %d.", MAX_SEQUENCE_ITEMS);
+					throw t.MakeError("macro overflow, max size: " + std::to_string(MAX_SEQUENCE_ITEMS) + ".");
 				pSeq->SetItem(count, item);
 				++count;
 			}
@@ -641,7 +802,7 @@ void CTextExport::ImportFile(const fs::path &FileName, CFamiTrackerDoc &Doc) {
 			dpcm_index = t.ReadInt(0, MAX_DSAMPLES - 1);
 			dpcm_size = t.ReadInt(0, ft0cc::doc::dpcm_sample::max_size);
 			dpcm_sample = std::make_shared<ft0cc::doc::dpcm_sample>();		// // //
-			dpcm_sample->rename(LPCSTR(t.ReadToken()));
+			dpcm_sample->rename(t.ReadToken());
 
 			t.ReadEOL();
 		}
@@ -653,7 +814,7 @@ void CTextExport::ImportFile(const fs::path &FileName, CFamiTrackerDoc &Doc) {
 				auto sample = static_cast<ft0cc::doc::dpcm_sample::sample_t>(t.ReadHex(0x00, 0xFF));
 				std::size_t pos = dpcm_sample->size();
 				if (pos >= dpcm_size)
-					throw t.MakeError("DPCM sample %d overflow, increase size used in %s.", dpcm_index, CT[CT_DPCMDEF]);
+					throw t.MakeError("DPCM sample " + std::to_string(dpcm_index) + " overflow, increase size used in " + CT[CT_DPCMDEF] + ".");
 				dpcm_sample->resize(pos + 1);		// // //
 				dpcm_sample->set_sample_at(pos, sample);
 			}
@@ -720,7 +881,7 @@ void CTextExport::ImportFile(const fs::path &FileName, CFamiTrackerDoc &Doc) {
 				pInstN163->SetWavePos(t.ReadInt(0, 256 - 16 * N163count - 1));
 				pInstN163->SetWaveCount(t.ReadInt(1, CInstrumentN163::MAX_WAVE_COUNT));
 			}
-			seqInst->SetName(LPCSTR(t.ReadToken()));
+			seqInst->SetName(t.ReadToken());
 			InstManager.InsertInstrument(inst_index, std::move(pInst));
 			t.ReadEOL();
 		}
@@ -732,7 +893,7 @@ void CTextExport::ImportFile(const fs::path &FileName, CFamiTrackerDoc &Doc) {
 			pInst->SetPatch(t.ReadInt(0, 15));
 			for (int r = 0; r < 8; ++r)
 				pInst->SetCustomReg(r, t.ReadHex(0x00, 0xFF));
-			pInst->SetName(LPCSTR(t.ReadToken()));
+			pInst->SetName(t.ReadToken());
 			InstManager.InsertInstrument(inst_index, std::move(pInst));
 			t.ReadEOL();
 		}
@@ -745,7 +906,7 @@ void CTextExport::ImportFile(const fs::path &FileName, CFamiTrackerDoc &Doc) {
 			pInst->SetModulationSpeed(t.ReadInt(0, 4095));
 			pInst->SetModulationDepth(t.ReadInt(0, 63));
 			pInst->SetModulationDelay(t.ReadInt(0, 255));
-			pInst->SetName(LPCSTR(t.ReadToken()));
+			pInst->SetName(t.ReadToken());
 			InstManager.InsertInstrument(inst_index, std::move(pInst));
 			t.ReadEOL();
 		}
@@ -754,7 +915,7 @@ void CTextExport::ImportFile(const fs::path &FileName, CFamiTrackerDoc &Doc) {
 		{
 			int inst_index = t.ReadInt(0, MAX_INSTRUMENTS - 1);
 			if (InstManager.GetInstrumentType(inst_index) != INST_2A03)
-				throw t.MakeError("instrument %d is not defined as a 2A03 instrument.", inst_index);
+				throw t.MakeError("instrument " + std::to_string(inst_index) + " is not defined as a 2A03 instrument.");
 			auto pInst = std::static_pointer_cast<CInstrument2A03>(InstManager.GetInstrument(inst_index));
 
 			int io = t.ReadInt(0, OCTAVE_RANGE);
@@ -773,7 +934,7 @@ void CTextExport::ImportFile(const fs::path &FileName, CFamiTrackerDoc &Doc) {
 		{
 			int inst_index = t.ReadInt(0, MAX_INSTRUMENTS - 1);
 			if (InstManager.GetInstrumentType(inst_index) != INST_FDS)
-				throw t.MakeError("instrument %d is not defined as an FDS instrument.", inst_index);
+				throw t.MakeError("instrument " + std::to_string(inst_index) + " is not defined as an FDS instrument.");
 			auto pInst = std::static_pointer_cast<CInstrumentFDS>(InstManager.GetInstrument(inst_index));
 			CHECK_COLON();
 			for (int s = 0; s < CInstrumentFDS::WAVE_SIZE; ++s)
@@ -785,7 +946,7 @@ void CTextExport::ImportFile(const fs::path &FileName, CFamiTrackerDoc &Doc) {
 		{
 			int inst_index = t.ReadInt(0, MAX_INSTRUMENTS - 1);
 			if (InstManager.GetInstrumentType(inst_index) != INST_FDS)
-				throw t.MakeError("instrument %d is not defined as an FDS instrument.", inst_index);
+				throw t.MakeError("instrument " + std::to_string(inst_index) + " is not defined as an FDS instrument.");
 			auto pInst = std::static_pointer_cast<CInstrumentFDS>(InstManager.GetInstrument(inst_index));
 			CHECK_COLON();
 			for (int s = 0; s < CInstrumentFDS::MOD_SIZE; ++s)
@@ -797,7 +958,7 @@ void CTextExport::ImportFile(const fs::path &FileName, CFamiTrackerDoc &Doc) {
 		{
 			int inst_index = t.ReadInt(0, MAX_INSTRUMENTS - 1);
 			if (InstManager.GetInstrumentType(inst_index) != INST_FDS)
-				throw t.MakeError("instrument %d is not defined as an FDS instrument.", inst_index);
+				throw t.MakeError("instrument " + std::to_string(inst_index) + " is not defined as an FDS instrument.");
 			auto pInst = std::static_pointer_cast<CInstrumentFDS>(InstManager.GetInstrument(inst_index));
 
 			auto SeqType = (sequence_t)t.ReadInt(0, CInstrumentFDS::SEQUENCE_COUNT - 1);		// // //
@@ -813,7 +974,7 @@ void CTextExport::ImportFile(const fs::path &FileName, CFamiTrackerDoc &Doc) {
 			while (!t.IsEOL()) {
 				int item = t.ReadInt(-128, 127);
 				if (count >= MAX_SEQUENCE_ITEMS)
-					throw t.MakeError("macro overflow, max size: %d.", MAX_SEQUENCE_ITEMS);
+					throw t.MakeError("macro overflow, max size: " + std::to_string(MAX_SEQUENCE_ITEMS) + ".");
 				pSeq->SetItem(count, item);
 				++count;
 			}
@@ -826,7 +987,7 @@ void CTextExport::ImportFile(const fs::path &FileName, CFamiTrackerDoc &Doc) {
 		{
 			int inst_index = t.ReadInt(0, MAX_INSTRUMENTS - 1);
 			if (InstManager.GetInstrumentType(inst_index) != INST_N163)
-				throw t.MakeError("instrument %d is not defined as an N163 instrument.", inst_index);
+				throw t.MakeError("instrument " + std::to_string(inst_index) + " is not defined as an N163 instrument.");
 			auto pInst = std::static_pointer_cast<CInstrumentN163>(InstManager.GetInstrument(inst_index));
 
 			int iw = t.ReadInt(0, CInstrumentN163::MAX_WAVE_COUNT - 1);
@@ -846,10 +1007,11 @@ void CTextExport::ImportFile(const fs::path &FileName, CFamiTrackerDoc &Doc) {
 			pSong->SetSongGroove(UseGroove[track]);		// // //
 			pSong->SetSongSpeed(t.ReadInt(0, MAX_TEMPO));
 			pSong->SetSongTempo(t.ReadInt(0, MAX_TEMPO));
-			pSong->SetTitle((LPCSTR)t.ReadToken());		// // //
+			pSong->SetTitle(t.ReadToken());		// // //
 
 			t.ReadEOL();
 			++track;
+			Tracks.clear();		// // //
 		}
 		break;
 		case CT_COLUMNS:
@@ -884,18 +1046,24 @@ void CTextExport::ImportFile(const fs::path &FileName, CFamiTrackerDoc &Doc) {
 			if (track == 0)
 				throw t.MakeError("no TRACK defined, cannot add ROW data.");
 
+			if (Tracks.empty()) {		// // //
+				CSongData *pSong = modfile.GetSong(track - 1);
+				modfile.GetChannelOrder().ForeachChannel([&] (stChannelID c) {
+					Tracks.emplace_back(c, pSong->GetTrack(c));
+				});
+			}
+
 			int row = t.ReadHex(0, MAX_PATTERN_LENGTH - 1);
-			modfile.GetChannelOrder().ForeachChannel([&] (stChannelID c) {
+			for (auto [c, pTrack] : Tracks) {		// // //
 				CHECK_COLON();
-				auto *pTrack = modfile.GetSong(track - 1)->GetTrack(c);		// // //
 				pTrack->GetPattern(pattern).SetNoteOn(row, t.ImportCellText(pTrack->GetEffectColumnCount(), c));
-			});
+			}
 			t.ReadEOL();
 		}
 		break;
 		case CT_COUNT:
 		default:
-			throw t.MakeError("Unrecognized command: '%s'.", (LPCSTR)command);
+			throw t.MakeError("Unrecognized command: '" + std::string {command} + "'.");
 		}
 	}
 
@@ -906,31 +1074,15 @@ void CTextExport::ImportFile(const fs::path &FileName, CFamiTrackerDoc &Doc) {
 	}
 	if (N163count != -1)		// // //
 		modfile.SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(modfile.GetSoundChipSet(), N163count));
-
-	FTEnv.GetSoundGenerator()->AssignModule(modfile);		// / //
-	FTEnv.GetSoundGenerator()->ModuleChipChanged();		// // //
 }
 
 // =============================================================================
 
-CStringA CTextExport::ExportRows(const fs::path &FileName, const CFamiTrackerModule &modfile) {		// // //
-	CStdioFile f;
-	CFileException oFileException;
-	if (!f.Open(FileName.c_str(), CFile::modeCreate | CFile::modeWrite | CFile::typeText, &oFileException))
-	{
-		WCHAR szError[256];
-		oFileException.GetErrorMessage(szError, std::size(szError));
-
-		return FormattedA("Unable to open file:\n%s", conv::to_utf8(szError).data());
-	}
-
-	const auto WriteString = [&] (const CStringA &str) { // TODO: don't use CStdioFile
-		f.Write(str.GetString(), str.GetLength());
-	};
+std::string CTextExport::ExportRowsText(const CFamiTrackerModule &modfile) {		// // //
+	CTextBuffer buf {EstimateTextSize(modfile)};
 
-	WriteString("ID,SONG,CHIP,SUBINDEX,PATTERN,ROW,NOTE,OCTAVE,INST,VOLUME,FX1,FX1PARAM,FX2,FX2PARAM,FX3,FX3PARAM,FX4,FX4PARAM\n");
+	buf.Write("ID,SONG,CHIP,SUBINDEX,PATTERN,ROW,NOTE,OCTAVE,INST,VOLUME,FX1,FX1PARAM,FX2,FX2PARAM,FX3,FX3PARAM,FX4,FX4PARAM\n");
 
-	const LPCSTR FMT = "%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d\n";
 	int id = 0;
 
 	modfile.VisitSongs([&] (const CSongData &song, unsigned t) {
@@ -938,49 +1090,60 @@ CStringA CTextExport::ExportRows(const fs::path &FileName, const CFamiTrackerMod
 		song.VisitPatterns([&] (const CPatternData &pat, stChannelID c, unsigned p) {
 			if (song.IsPatternInUse(c, p))
 				pat.VisitRows(rows, [&] (const stChanNote &stCell, unsigned r) {
-					if (stCell != stChanNote { })
-						WriteString(FormattedA(FMT, id++, t, value_cast(c.Chip), c.Subindex, p, r,
-							stCell.Note, stCell.Octave, stCell.Instrument, stCell.Vol,
-							stCell.Effects[0].fx, stCell.Effects[0].param,
-							stCell.Effects[1].fx, stCell.Effects[1].param,
-							stCell.Effects[2].fx, stCell.Effects[2].param,
-							stCell.Effects[3].fx, stCell.Effects[3].param));
+					if (stCell != stChanNote { }) {
+						const int Fields[] = {
+							id++, static_cast<int>(t), value_cast(c.Chip), c.Subindex, static_cast<int>(p), static_cast<int>(r),
+							value_cast(stCell.Note), stCell.Octave, stCell.Instrument, stCell.Vol,
+							value_cast(stCell.Effects[0].fx), stCell.Effects[0].param,
+							value_cast(stCell.Effects[1].fx), stCell.Effects[1].param,
+							value_cast(stCell.Effects[2].fx), stCell.Effects[2].param,
+							value_cast(stCell.Effects[3].fx), stCell.Effects[3].param,
+						};
+						char *ptr = buf.Extend(std::size(Fields) * 12);
+						for (int x : Fields) {
+							ptr = PutInt(ptr, x, 0);
+							*ptr++ = ',';
+						}
+						ptr[-1] = '\n';
+						buf.Commit(ptr);
+					}
 				});
 		});
 	});
 
-	return "";
+	return buf.Release();
 }
 
-CStringA CTextExport::ExportFile(const fs::path &FileName, CFamiTrackerDoc &Doc) {		// // //
-	CStdioFile f;
-	CFileException oFileException;
-	if (!f.Open(FileName.c_str(), CFile::modeCreate | CFile::modeWrite | CFile::typeText, &oFileException)) {
-		WCHAR szError[256];
-		oFileException.GetErrorMessage(szError, std::size(szError));
-
-		return FormattedA("Unable to open file:\n%s", conv::to_utf8(szError).data());
-	}
-
-	auto &modfile = *Doc.GetModule();		// // //
-
-	const auto WriteString = [&] (const CStringA &str) { // TODO: don't use CStdioFile
-		f.Write(str.GetString(), str.GetLength());
-	};
-
-	WriteString(FormattedA("# 0CC-LLTracker text export %s\n\n", Get0CCFTVersionString()));		// // //
-
-	WriteString("# Module information\n");
-	WriteString(FormattedA("%-15s %s\n", CT[CT_TITLE],     (LPCSTR)ExportString(modfile.GetModuleName())));
-	WriteString(FormattedA("%-15s %s\n", CT[CT_AUTHOR],    (LPCSTR)ExportString(modfile.GetModuleArtist())));
-	WriteString(FormattedA("%-15s %s\n", CT[CT_COPYRIGHT], (LPCSTR)ExportString(modfile.GetModuleCopyright())));
-	WriteString("\n");
-
-	WriteString("# Module comment\n");
+std::string CTextExport::ExportText(CFamiTrackerModule &modfile) {		// // //
+	CTextBuffer buf {EstimateTextSize(modfile)};
+
+	buf.Write("# 0CC-LLTracker text export ");		// // //
+	buf.Write(Get0CCFTVersionString());
+	buf.Write("\n\n");
+
+	buf.Write("# Module information\n");
+	buf.WritePadded(CT[CT_TITLE], 15);
+	buf.Write(' ');
+	buf.WriteQuoted(modfile.GetModuleName());
+	buf.Write('\n');
+	buf.WritePadded(CT[CT_AUTHOR], 15);
+	buf.Write(' ');
+	buf.WriteQuoted(modfile.GetModuleArtist());
+	buf.Write('\n');
+	buf.WritePadded(CT[CT_COPYRIGHT], 15);
+	buf.Write(' ');
+	buf.WriteQuoted(modfile.GetModuleCopyright());
+	buf.Write('\n');
+	buf.Write('\n');
+
+	buf.Write("# Module comment\n");
 	std::string_view sComment = modfile.GetComment();		// // //
 	while (true) {
 		auto n = sComment.find_first_of("\r\n");
-		WriteString(FormattedA("%s %s\n", CT[CT_COMMENT], (LPCSTR)ExportString(sComment.substr(0, n))));
+		buf.Write(CT[CT_COMMENT]);
+		buf.Write(' ');
+		buf.WriteQuoted(sComment.substr(0, n));
+		buf.Write('\n');
 		if (n == std::string_view::npos)
 			break;
 		sComment.remove_prefix(n);
@@ -989,30 +1152,37 @@ CStringA CTextExport::ExportFile(const fs::path &FileName, CFamiTrackerDoc &Doc)
 		if (!sComment.empty() && sComment.front() == '\n')
 			sComment.remove_prefix(1);
 	}
-	WriteString("\n");
-
-	WriteString("# Global settings\n");
-	WriteString(FormattedA("%-15s %d\n", CT[CT_MACHINE],   modfile.GetMachine()));
-	WriteString(FormattedA("%-15s %d\n", CT[CT_FRAMERATE], modfile.GetEngineSpeed()));
-	WriteString(FormattedA("%-15s %d\n", CT[CT_EXPANSION], modfile.GetSoundChipSet().GetNSFFlag()));		// // //
-	WriteString(FormattedA("%-15s %d\n", CT[CT_VIBRATO],   modfile.GetVibratoStyle()));
-	WriteString(FormattedA("%-15s %d\n", CT[CT_SPLIT],     modfile.GetSpeedSplitPoint()));
-//	WriteString(FormattedA("%-15s %d %d\n", CT[CT_PLAYBACKRATE]));
-	if (modfile.GetTuningSemitone() || modfile.GetTuningCent())		// // // 050B
-		WriteString(FormattedA("%-15s %d %d\n", CT[CT_TUNING], modfile.GetTuningSemitone(), modfile.GetTuningCent()));
-	WriteString("\n");
+	buf.Write('\n');
+
+	const auto WriteSetting = [&] (int ct, int x) {
+		buf.WritePadded(CT[ct], 15);
+		buf.WriteFields(0, x);
+		buf.Write('\n');
+	};
+
+	buf.Write("# Global settings\n");
+	WriteSetting(CT_MACHINE,   value_cast(modfile.GetMachine()));
+	WriteSetting(CT_FRAMERATE, modfile.GetEngineSpeed());
+	WriteSetting(CT_EXPANSION, modfile.GetSoundChipSet().GetNSFFlag());		// // //
+	WriteSetting(CT_VIBRATO,   value_cast(modfile.GetVibratoStyle()));
+	WriteSetting(CT_SPLIT,     modfile.GetSpeedSplitPoint());
+	if (modfile.GetTuningSemitone() || modfile.GetTuningCent()) {		// // // 050B
+		buf.WritePadded(CT[CT_TUNING], 15);
+		buf.WriteFields(0, modfile.GetTuningSemitone(), modfile.GetTuningCent());
+		buf.Write('\n');
+	}
+	buf.Write('\n');
 
 	int N163count = -1;		// // //
 	if (modfile.HasExpansionChip(sound_chip_t::N163)) {
 		N163count = modfile.GetNamcoChannels();
 		modfile.SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(modfile.GetSoundChipSet(), MAX_CHANNELS_N163));
-		WriteString(FormattedA("# Namco 163 global settings\n"
-			"%-15s %d\n"
-			"\n",
-			CT[CT_N163CHANNELS], N163count));
+		buf.Write("# Namco 163 global settings\n");
+		WriteSetting(CT_N163CHANNELS, N163count);
+		buf.Write('\n');
 	}
 
-	WriteString("# Macros\n");
+	buf.Write("# Macros\n");
 	const auto &InstManager = *modfile.GetInstrumentManager();
 	const inst_type_t CHIP_MACRO[4] = { INST_2A03, INST_VRC6, INST_N163, INST_S5B };
 	for (int c=0; c<4; ++c) {
@@ -1020,81 +1190,86 @@ CStringA CTextExport::ExportFile(const fs::path &FileName, CFamiTrackerDoc &Doc)
 			for (int seq = 0; seq < MAX_SEQUENCES; ++seq) {
 				const auto pSequence = InstManager.GetSequence(CHIP_MACRO[c], st, seq);
 				if (pSequence && pSequence->GetItemCount() > 0) {
-					WriteString(FormattedA("%-9s %3d %3d %3d %3d %3d :",
-						CT[CT_MACRO + c],
-						st,
-						seq,
-						pSequence->GetLoopPoint(),
-						pSequence->GetReleasePoint(),
-						pSequence->GetSetting()));
+					buf.WritePadded(CT[CT_MACRO + c], 9);
+					buf.WriteFields(3, value_cast(st), seq, pSequence->GetLoopPoint(), pSequence->GetReleasePoint(), value_cast(pSequence->GetSetting()));
+					buf.Write(" :");
 					for (unsigned int i = 0; i < pSequence->GetItemCount(); ++i)
-						WriteString(FormattedA(" %d", pSequence->GetItem(i)));
-					WriteString("\n");
+						buf.WriteFields(0, pSequence->GetItem(i));
+					buf.Write('\n');
 				}
 			}
 		}
 	}
-	WriteString("\n");
+	buf.Write('\n');
 
-	WriteString("# DPCM samples\n");
+	buf.Write("# DPCM samples\n");
 	for (int smp=0; smp < MAX_DSAMPLES; ++smp)
 	{
 		if (auto pSample = modfile.GetDSampleManager()->GetDSample(smp)) {		// // //
 			const unsigned int size = pSample->size();
-			WriteString(FormattedA("%s %3d %5d %s\n",
-				CT[CT_DPCMDEF],
-				smp,
-				size,
-				(LPCSTR)ExportString(pSample->name())));
+			buf.Write(CT[CT_DPCMDEF]);
+			buf.WriteFields(3, smp);
+			buf.WriteFields(5, size);
+			buf.Write(' ');
+			buf.WriteQuoted(pSample->name());
+			buf.Write('\n');
 
 			for (unsigned int i=0; i < size; i += 32)
 			{
-				WriteString(FormattedA("%s :", CT[CT_DPCM]));
-				for (unsigned int j=0; j<32 && (i+j)<size; ++j)
-					WriteString(FormattedA(" %02X", pSample->sample_at(i + j)));
-				WriteString("\n");
+				buf.Write(CT[CT_DPCM]);
+				buf.Write(" :");
+				for (unsigned int j=0; j<32 && (i+j)<size; ++j) {
+					buf.Write(' ');
+					buf.WriteHex(pSample->sample_at(i + j), 2);
+				}
+				buf.Write('\n');
 			}
 		}
 	}
-	WriteString("\n");
+	buf.Write('\n');
 
-	WriteString("# Detune settings\n");		// // //
+	buf.Write("# Detune settings\n");		// // //
 	for (int i = 0; i < 6; ++i) for (int j = 0; j < NOTE_COUNT; ++j) {
 		int Offset = modfile.GetDetuneOffset(i, j);
 		if (Offset != 0) {
-			WriteString(FormattedA("%s %3d %3d %3d %5d\n", CT[CT_DETUNE], i, j / NOTE_RANGE, j % NOTE_RANGE, Offset));
+			buf.Write(CT[CT_DETUNE]);
+			buf.WriteFields(3, i, j / NOTE_RANGE, j % NOTE_RANGE);
+			buf.WriteFields(5, Offset);
+			buf.Write('\n');
 		}
 	}
-	WriteString("\n");
+	buf.Write('\n');
 
-	WriteString("# Grooves\n");		// // //
+	buf.Write("# Grooves\n");		// // //
 	for (int i = 0; i < MAX_GROOVE; ++i) {
 		if (const auto pGroove = modfile.GetGroove(i)) {
-			WriteString(FormattedA("%s %3d %3d :", CT[CT_GROOVE], i, pGroove->size()));
+			buf.Write(CT[CT_GROOVE]);
+			buf.WriteFields(3, i, pGroove->size());
+			buf.Write(" :");
 			for (uint8_t entry : *pGroove)
-				WriteString(FormattedA(" %d", entry));
-			WriteString("\n");
+				buf.WriteFields(0, entry);
+			buf.Write('\n');
 		}
 	}
-	WriteString("\n");
+	buf.Write('\n');
 
-	WriteString("# Tracks using default groove\n");		// // //
+	buf.Write("# Tracks using default groove\n");		// // //
 	bool UsedGroove = false;
 	modfile.VisitSongs([&] (const CSongData &song) {
 		if (song.GetSongGroove())
 			UsedGroove = true;
 	});
 	if (UsedGroove) {
-		CStringA s = FormattedA("%s :", CT[CT_USEGROOVE]);
+		buf.Write(CT[CT_USEGROOVE]);
+		buf.Write(" :");
 		modfile.VisitSongs([&] (const CSongData &song, unsigned index) {
 			if (song.GetSongGroove())
-				AppendFormatA(s, " %d", index + 1);
+				buf.WriteFields(0, index + 1);
 		});
-		WriteString(s);
-		WriteString("\n\n");
+		buf.Write("\n\n");
 	}
 
-	WriteString("# Instruments\n");
+	buf.Write("# Instruments\n");
 	for (unsigned int i=0; i<MAX_INSTRUMENTS; ++i) {
 		auto pInst = InstManager.GetInstrument(i);
 		if (!pInst) continue;
@@ -1110,14 +1285,16 @@ CStringA CTextExport::ExportFile(const fs::path &FileName, CFamiTrackerDoc &Doc)
 		case INST_NONE: default:
 			continue;
 		}
-		WriteString(FormattedA("%-8s %3d   ", CTstr, i));
+		buf.WritePadded(CTstr, 8);
+		buf.WriteFields(3, i);
+		buf.Write("   ");
 
 		if (auto seqInst = std::dynamic_pointer_cast<CSeqInstrument>(pInst)) {
 			if (seqInst->GetType() != INST_FDS) {
-				CStringA s;
-				for (auto j : enum_values<sequence_t>())
-					AppendFormatA(s, "%3d ", seqInst->GetSeqEnable(j) ? seqInst->GetSeqIndex(j) : -1);
-				WriteString(s);
+				for (auto j : enum_values<sequence_t>()) {
+					buf.WriteInt(seqInst->GetSeqEnable(j) ? seqInst->GetSeqIndex(j) : -1, 3);
+					buf.Write(' ');
+				}
 			}
 		}
 
@@ -1126,35 +1303,34 @@ CStringA CTextExport::ExportFile(const fs::path &FileName, CFamiTrackerDoc &Doc)
 		case INST_N163:
 			{
 				auto pDI = std::static_pointer_cast<CInstrumentN163>(pInst);
-				WriteString(FormattedA("%3d %3d %3d ",
-					pDI->GetWaveSize(),
-					pDI->GetWavePos(),
-					pDI->GetWaveCount()));
+				buf.WriteInt(pDI->GetWaveSize(), 3);
+				buf.WriteFields(3, pDI->GetWavePos(), pDI->GetWaveCount());
+				buf.Write(' ');
 			}
 			break;
 		case INST_VRC7:
 			{
 				auto pDI = std::static_pointer_cast<CInstrumentVRC7>(pInst);
-				CStringA patch = FormattedA("%3d ", pDI->GetPatch());
-				for (int j = 0; j < 8; ++j)
-					AppendFormatA(patch, "%02X ", pDI->GetCustomReg(j));
-				WriteString(patch);
+				buf.WriteInt(pDI->GetPatch(), 3);
+				buf.Write(' ');
+				for (int j = 0; j < 8; ++j) {
+					buf.WriteHex(pDI->GetCustomReg(j), 2);
+					buf.Write(' ');
+				}
 			}
 			break;
 		case INST_FDS:
 			{
 				auto pDI = std::static_pointer_cast<CInstrumentFDS>(pInst);
-				WriteString(FormattedA("%3d %3d %3d %3d ",
-					pDI->GetModulationEnable(),
-					pDI->GetModulationSpeed(),
-					pDI->GetModulationDepth(),
-					pDI->GetModulationDelay()));
+				buf.WriteInt(pDI->GetModulationEnable(), 3);
+				buf.WriteFields(3, pDI->GetModulationSpeed(), pDI->GetModulationDepth(), pDI->GetModulationDelay());
+				buf.Write(' ');
 			}
 			break;
 		}
 
-		WriteString((LPCSTR)ExportString(pInst->GetName()));
-		WriteString("\n");
+		buf.WriteQuoted(pInst->GetName());
+		buf.Write('\n');
 
 		switch (pInst->GetType())
 		{
@@ -1164,15 +1340,13 @@ CStringA CTextExport::ExportFile(const fs::path &FileName, CFamiTrackerDoc &Doc)
 				for (int n = 0; n < NOTE_COUNT; ++n) {
 					if (unsigned smp = pDI->GetSampleIndex(n); smp != CInstrument2A03::NO_DPCM) {
 						int d = pDI->GetSampleDeltaValue(n);
-						WriteString(FormattedA("%s %3d %3d %3d   %3u %3d %3d %5d %3d\n",
-							CT[CT_KEYDPCM],
-							i,
-							ft0cc::doc::oct_from_midi(n), value_cast(ft0cc::doc::pitch_from_midi(n)) - 1,
-							smp,
-							pDI->GetSamplePitch(n) & 0x0F,
-							pDI->GetSampleLoop(n) ? 1 : 0,
-							pDI->GetSampleLoopOffset(n),
-							(d >= 0 && d <= 127) ? d : -1));
+						buf.Write(CT[CT_KEYDPCM]);
+						buf.WriteFields(3, i, ft0cc::doc::oct_from_midi(n), value_cast(ft0cc::doc::pitch_from_midi(n)) - 1);
+						buf.Write("  ");
+						buf.WriteFields(3, smp, pDI->GetSamplePitch(n) & 0x0F, pDI->GetSampleLoop(n) ? 1 : 0);
+						buf.WriteFields(5, pDI->GetSampleLoopOffset(n));
+						buf.WriteFields(3, (d >= 0 && d <= 127) ? d : -1);
+						buf.Write('\n');
 					}
 				}
 			}
@@ -1182,107 +1356,180 @@ CStringA CTextExport::ExportFile(const fs::path &FileName, CFamiTrackerDoc &Doc)
 				auto pDI = std::static_pointer_cast<CInstrumentN163>(pInst);
 				for (int w=0; w < pDI->GetWaveCount(); ++w)
 				{
-					WriteString(FormattedA("%s %3d %3d :", CT[CT_N163WAVE], i, w));
-
+					buf.Write(CT[CT_N163WAVE]);
+					buf.WriteFields(3, i, w);
+					buf.Write(" :");
 					for (int smp : pDI->GetSamples(w))		// // //
-						WriteString(FormattedA(" %d", smp));
-					WriteString("\n");
+						buf.WriteFields(0, smp);
+					buf.Write('\n');
 				}
 			}
 			break;
 		case INST_FDS:
 			{
 				auto pDI = std::static_pointer_cast<CInstrumentFDS>(pInst);
-				WriteString(FormattedA("%-8s %3d :", CT[CT_FDSWAVE], i));
+				buf.WritePadded(CT[CT_FDSWAVE], 8);
+				buf.WriteFields(3, i);
+				buf.Write(" :");
 				for (unsigned char smp : pDI->GetSamples())		// // //
-					WriteString(FormattedA(" %2d", smp));
-				WriteString("\n");
+					buf.WriteFields(2, smp);
+				buf.Write('\n');
 
-				WriteString(FormattedA("%-8s %3d :", CT[CT_FDSMOD], i));
-				for (unsigned char m : pDI->GetModTable()) {		// // //
-					WriteString(FormattedA(" %2d", m));
-				}
-				WriteString("\n");
+				buf.WritePadded(CT[CT_FDSMOD], 8);
+				buf.WriteFields(3, i);
+				buf.Write(" :");
+				for (unsigned char m : pDI->GetModTable())		// // //
+					buf.WriteFields(2, m);
+				buf.Write('\n');
 
 				for (auto seq : enum_values<sequence_t>()) {
 					const auto pSequence = pDI->GetSequence(seq);		// // //
 					if (!pSequence || pSequence->GetItemCount() < 1)
 						continue;
 
-					WriteString(FormattedA("%-8s %3d %3d %3d %3d %3d :",
-						CT[CT_FDSMACRO],
-						i,
-						seq,
-						pSequence->GetLoopPoint(),
-						pSequence->GetReleasePoint(),
-						pSequence->GetSetting()));
+					buf.WritePadded(CT[CT_FDSMACRO], 8);
+					buf.WriteFields(3, i, value_cast(seq), pSequence->GetLoopPoint(), pSequence->GetReleasePoint(), value_cast(pSequence->GetSetting()));
+					buf.Write(" :");
 					for (unsigned int j=0; j < pSequence->GetItemCount(); ++j)
-						WriteString(FormattedA(" %d", pSequence->GetItem(j)));
-					WriteString("\n");
+						buf.WriteFields(0, pSequence->GetItem(j));
+					buf.Write('\n');
 				}
 			}
 			break;
 		}
 	}
-	WriteString("\n");
+	buf.Write('\n');
 
-	WriteString("# Tracks\n\n");
+	buf.Write("# Tracks\n\n");
 
 	const CChannelOrder &order = modfile.GetChannelOrder();		// // //
 
 	modfile.VisitSongs([&] (const CSongData &song) {
-		WriteString(FormattedA("%s %3d %3d %3d %s\n",
-			CT[CT_TRACK],
-			song.GetPatternLength(),
-			song.GetSongSpeed(),
-			song.GetSongTempo(),
-			(LPCSTR)ExportString(song.GetTitle())));
-
-		WriteString(FormattedA("%s :", CT[CT_COLUMNS]));
+		buf.Write(CT[CT_TRACK]);
+		buf.WriteFields(3, song.GetPatternLength(), song.GetSongSpeed(), song.GetSongTempo());
+		buf.Write(' ');
+		buf.WriteQuoted(song.GetTitle());
+		buf.Write('\n');
+
+		struct column_t {		// // //
+			stChannelID ID;
+			unsigned Effects;
+			bool Noise;
+		};
+		std::vector<column_t> Columns;
+		std::size_t RowWidth = 8;
 		order.ForeachChannel([&] (stChannelID c) {
-			WriteString(FormattedA(" %d", song.GetEffectColumnCount(c)));
+			Columns.push_back({c, song.GetEffectColumnCount(c), IsAPUNoise(c)});
+			RowWidth += 3 + MAX_CELL_TEXT;
 		});
-		WriteString("\n\n");
+
+		buf.Write(CT[CT_COLUMNS]);
+		buf.Write(" :");
+		for (const auto &col : Columns)
+			buf.WriteFields(0, col.Effects);
+		buf.Write("\n\n");
 
 		for (unsigned int o=0; o < song.GetFrameCount(); ++o) {
-			WriteString(FormattedA("%s %02X :", CT[CT_ORDER], o));
-			order.ForeachChannel([&] (stChannelID c) {
-				WriteString(FormattedA(" %02X", song.GetFramePattern(o, c)));
-			});
-			WriteString("\n");
+			buf.Write(CT[CT_ORDER]);
+			buf.Write(' ');
+			buf.WriteHex(o, 2);
+			buf.Write(" :");
+			for (const auto &col : Columns) {
+				buf.Write(' ');
+				buf.WriteHex(song.GetFramePattern(o, col.ID), 2);
+			}
+			buf.Write('\n');
 		}
-		WriteString("\n");
+		buf.Write('\n');
 
+		const unsigned Rows = song.GetPatternLength();
 		for (int p=0; p < MAX_PATTERN; ++p)
 		{
 			// detect and skip empty patterns
 			bool bUsed = false;
-			order.ForeachChannel([&] (stChannelID c) {
-				if (!bUsed && !song.GetPattern(c, p).IsEmpty())
+			for (const auto &col : Columns)
+				if (!song.GetPattern(col.ID, p).IsEmpty()) {
 					bUsed = true;
-			});
+					break;
+				}
 			if (!bUsed)
 				continue;
 
-			WriteString(FormattedA("%s %02X\n", CT[CT_PATTERN], p));
-
-			for (unsigned int r=0; r < song.GetPatternLength(); ++r) {
-				WriteString(FormattedA("%s %02X", CT[CT_ROW], r));
-				order.ForeachChannel([&] (stChannelID c) {
-					WriteString(" : ");
-					WriteString(ExportCellText(song.GetPattern(c, p).GetNoteOn(r), song.GetEffectColumnCount(c), IsAPUNoise(c)));		// // //
-				});
-				WriteString("\n");
+			buf.Write(CT[CT_PATTERN]);
+			buf.Write(' ');
+			buf.WriteHex(p, 2);
+			buf.Write('\n');
+
+			// // // each row is written directly into the buffer
+			buf.Reserve(Rows * RowWidth + 1);
+			for (unsigned int r=0; r < Rows; ++r) {
+				char *ptr = buf.Extend(RowWidth);
+				ptr = std::copy_n(CT[CT_ROW], 3, ptr);
+				*ptr++ = ' ';
+				ptr = PutHex(ptr, r, 2);
+				for (const auto &col : Columns) {
+					ptr = std::copy_n(" : ", 3, ptr);
+					ptr += WriteCellText(ptr, song.GetPattern(col.ID, p).GetNoteOn(r), col.Effects, col.Noise);		// // //
+				}
+				*ptr++ = '\n';
+				buf.Commit(ptr);
 			}
-			WriteString("\n");
+			buf.Write('\n');
 		}
 	});
 
 	if (N163count != -1)		// // //
 		modfile.SetChannelMap(FTEnv.GetSoundChipService()->MakeChannelMap(modfile.GetSoundChipSet(), N163count));
-	WriteString("# End of export\n");
-	FTEnv.GetSoundGenerator()->ModuleChipChanged();		// // //
+	buf.Write("# End of export\n");
+	return buf.Release();
+}
+
+// =============================================================================
+
+#ifndef FT0CC_EXT_BUILD
+
+namespace {
+
+// // // the text is written in a single call; text mode converts line endings
+std::string WriteTextFile(const fs::path &FileName, std::string_view Text) {
+	CStdioFile f;
+	CFileException oFileException;
+	if (!f.Open(FileName.c_str(), CFile::modeCreate | CFile::modeWrite | CFile::typeText, &oFileException)) {
+		WCHAR szError[256];
+		oFileException.GetErrorMessage(szError, std::size(szError));
+
+		return "Unable to open file:\n" + conv::to_utf8(szError);
+	}
+
+	f.Write(Text.data(), static_cast<UINT>(Text.size()));
 	return "";
 }
 
+} // namespace
+
+void CTextExport::ImportFile(const fs::path &FileName, CFamiTrackerDoc &Doc) {
+	// begin a new document
+	if (!Doc.OnNewDocument())
+		throw std::runtime_error {"Unable to create new LLtracker document."};
+
+	CMappedFile File {FileName};		// // //
+	auto &modfile = *Doc.GetModule();		// // //
+	ImportText(File.GetText(), modfile);
+
+	FTEnv.GetSoundGenerator()->AssignModule(modfile);		// / //
+	FTEnv.GetSoundGenerator()->ModuleChipChanged();		// // //
+}
+
+std::string CTextExport::ExportRows(const fs::path &FileName, const CFamiTrackerModule &modfile) {		// // //
+	return WriteTextFile(FileName, ExportRowsText(modfile));
+}
+
+std::string CTextExport::ExportFile(const fs::path &FileName, CFamiTrackerDoc &Doc) {		// // //
+	std::string Error = WriteTextFile(FileName, ExportText(*Doc.GetModule()));
+	FTEnv.GetSoundGenerator()->ModuleChipChanged();		// // //
+	return Error;
+}
+
+#endif
+
 // end of file
@@ -21,10 +21,12 @@
 */
 
 
+
 #pragma once
 
-#include "stdafx.h"		// // //
+#include <string>		// // //
 #include <string_view>		// // //
+#include <cstddef>		// // //
 #include "ft0cc/fs.h"		// // //
 
 class CFamiTrackerDoc; // forward declaration
@@ -32,15 +34,25 @@ class CFamiTrackerModule;		// // //
 class stChanNote;		// // //
 
 struct CTextExport {
-	static CStringA ExportCellText(const stChanNote &stCell, unsigned int nEffects, bool bNoise);		// // //
+	// // // maximum length of the text of a single cell, without the column separator
+	static constexpr std::size_t MAX_CELL_TEXT = 24;
+
+	// // // writes the text of a cell into a buffer of at least MAX_CELL_TEXT characters,
+	// returns the number of characters written
+	static std::size_t WriteCellText(char *Buf, const stChanNote &stCell, unsigned int nEffects, bool bNoise);
+	static std::string ExportCellText(const stChanNote &stCell, unsigned int nEffects, bool bNoise);		// // //
 
+	// // // conversion between modules and text, without touching the file system or the
+	// document; the importer expects a newly created module and throws std::runtime_error
+	static void ImportText(std::string_view Text, CFamiTrackerModule &modfile);
+	static std::string ExportText(CFamiTrackerModule &modfile);
+	static std::string ExportRowsText(const CFamiTrackerModule &modfile);
+
+#ifndef FT0CC_EXT_BUILD
 	void ImportFile(const fs::path &FileName, CFamiTrackerDoc &Doc);		// // //
 
 	// returns an empty string on success, otherwise returns a descriptive error
-	CStringA ExportFile(const fs::path &FileName, CFamiTrackerDoc &Doc);		// // //
-	CStringA ExportRows(const fs::path &FileName, const CFamiTrackerModule &modfile);		// // //
-
-private:		// // //
-	static CStringA ExportString(const CStringA &s);
-	static CStringA ExportString(std::string_view s);
+	std::string ExportFile(const fs::path &FileName, CFamiTrackerDoc &Doc);		// // //
+	std::string ExportRows(const fs::path &FileName, const CFamiTrackerModule &modfile);		// // //
+#endif
 };
@@ -0,0 +1,85 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+// // // Accumulates the time spent in each part of a sound driver tick, so that the cost of
+// the driver itself can be told apart from the cost of the emulated sound chips
+
+enum class tick_part_t : unsigned {
+	driver,		// CSoundDriver::Tick
+	emulation,	// running the APU for one frame
+};
+
+class CTickTimer {
+	using clock = std::chrono::steady_clock;
+
+public:
+	static constexpr std::size_t PARTS = 2;
+
+	class CScope {
+	public:
+		CScope(CTickTimer &timer, tick_part_t part) : timer_(timer), part_(part), start_(clock::now()) { }
+		~CScope() { timer_.total_[static_cast<unsigned>(part_)] += clock::now() - start_; }
+		CScope(const CScope &) = delete;
+		CScope &operator=(const CScope &) = delete;
+
+	private:
+		CTickTimer &timer_;
+		tick_part_t part_;
+		clock::time_point start_;
+	};
+
+	// Measures until the returned object goes out of scope
+	CScope Measure(tick_part_t part) {
+		return {*this, part};
+	}
+
+	void EndTick() {
+		++ticks_;
+	}
+
+	void Reset() {
+		total_ = { };
+		ticks_ = 0;
+	}
+
+	std::uint64_t GetTicks() const {
+		return ticks_;
+	}
+
+	// Average time per tick in microseconds
+	double GetAverage(tick_part_t part) const {
+		if (!ticks_)
+			return 0.;
+		return std::chrono::duration<double, std::micro>(total_[static_cast<unsigned>(part)]).count() / ticks_;
+	}
+
+private:
+	std::array<clock::duration, PARTS> total_ = { };
+	std::uint64_t ticks_ = 0;
+};
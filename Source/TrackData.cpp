@@ -23,6 +23,7 @@
 #include "TrackData.h"
 
 CPatternData &CTrackData::GetPattern(unsigned Pattern) {
+	m_bDirtyPatterns.set(Pattern);
 	return m_pPatternData.at(Pattern);
 }
 
@@ -31,7 +32,7 @@ const CPatternData &CTrackData::GetPattern(unsigned Pattern) const {
 }
 
 CPatternData &CTrackData::GetPatternOnFrame(unsigned Frame) {
-	return m_pPatternData.at(GetFramePattern(Frame));
+	return GetPattern(GetFramePattern(Frame));
 }
 
 const CPatternData &CTrackData::GetPatternOnFrame(unsigned Frame) const {
@@ -43,8 +44,10 @@ unsigned int CTrackData::GetFramePattern(unsigned Frame) const {
 }
 
 void CTrackData::SetFramePattern(unsigned Frame, unsigned Pattern) {
-	if (Frame < m_iFrameList.size())
+	if (Frame < m_iFrameList.size() && m_iFrameList[Frame] != Pattern) {
 		m_iFrameList[Frame] = Pattern;
+		m_bDirtyFrames = true;
+	}
 }
 
 unsigned CTrackData::GetEffectColumnCount() const {
@@ -52,5 +55,27 @@ unsigned CTrackData::GetEffectColumnCount() const {
 }
 
 void CTrackData::SetEffectColumnCount(unsigned Count) {
-	m_iEffectColumns = Count;
+	if (m_iEffectColumns != Count) {
+		m_iEffectColumns = Count;
+		m_bDirtyFrames = true;
+	}
+}
+
+bool CTrackData::IsPatternDirty(unsigned Pattern) const {
+	// frame list changes may add or remove non-empty patterns from the saved set;
+	// patterns that have become empty are always marked
+	return m_bDirtyPatterns.test(Pattern) || (m_bDirtyFrames && !GetPattern(Pattern).IsEmpty());
+}
+
+bool CTrackData::IsDirty() const {
+	return m_bDirtyFrames || m_bDirtyPatterns.any();
+}
+
+void CTrackData::SetDirty() {
+	m_bDirtyFrames = true;
+}
+
+void CTrackData::ClearDirty() {
+	m_bDirtyPatterns.reset();
+	m_bDirtyFrames = false;
 }
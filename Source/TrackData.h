@@ -24,6 +24,7 @@
 #pragma once
 
 #include <array>
+#include <bitset>
 #include "PatternData.h"
 
 class CTrackData {
@@ -40,9 +41,17 @@ public:
 	unsigned GetEffectColumnCount() const;
 	void SetEffectColumnCount(unsigned Count);
 
+	// // // dirty tracking for incremental saving
+	// a pattern is dirty if its saved form may have changed since the last call to ClearDirty
+	bool IsPatternDirty(unsigned Pattern) const;
+	bool IsDirty() const;
+	void SetDirty();
+	void ClearDirty();
+
 	// void (*F)(CPatternData &pattern [, std::size_t p_index])
 	template <typename F>
 	void VisitPatterns(F f) {
+		SetDirty();
 		if constexpr (std::is_invocable_v<F, CPatternData &, std::size_t>) {
 			std::size_t p_index = 0;
 			for (auto &pattern : m_pPatternData)
@@ -76,4 +85,6 @@ private:
 	std::array<CPatternData, MAX_PATTERN> m_pPatternData = { };
 	std::array<unsigned int, MAX_FRAMES> m_iFrameList = { };
 	unsigned char m_iEffectColumns = 1;		// // //
+	std::bitset<MAX_PATTERN> m_bDirtyPatterns;		// // //
+	bool m_bDirtyFrames = true;
 };
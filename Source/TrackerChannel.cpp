@@ -30,7 +30,7 @@
  *
  */
 
-void CTrackerChannel::SetNote(const stChanNote &Note, note_prio_t Priority)		// // //
+void CTrackerChannel::SetNote(const stChanNote &Note, note_prio_t Priority, unsigned Delay)		// // //
 {
 	std::lock_guard<std::mutex> lock {m_csNoteLock};
 
@@ -38,6 +38,7 @@ void CTrackerChannel::SetNote(const stChanNote &Note, note_prio_t Priority)		//
 		m_Note = Note;
 		m_bNewNote = true;
 		m_iNotePriority = Priority;
+		m_iNoteDelay = Delay;		// // //
 	}
 }
 
@@ -49,6 +50,7 @@ stChanNote CTrackerChannel::GetNote()
 	m_Note = stChanNote { };
 	m_bNewNote = false;
 	m_iNotePriority = NOTE_PRIO_0;
+	m_iNoteDelay = 0;		// // //
 
 	return Note;
 }
@@ -58,6 +60,13 @@ bool CTrackerChannel::NewNoteData() const
 	return m_bNewNote;
 }
 
+unsigned CTrackerChannel::GetNoteDelay() const		// // //
+{
+	std::lock_guard<std::mutex> lock {m_csNoteLock};
+
+	return m_bNewNote ? m_iNoteDelay : 0u;
+}
+
 void CTrackerChannel::Reset()
 {
 	std::lock_guard<std::mutex> lock {m_csNoteLock};
@@ -67,6 +76,7 @@ void CTrackerChannel::Reset()
 	m_iPitch = 0;		// // //
 	m_iVolumeMeter = 0;
 	m_iNotePriority = NOTE_PRIO_0;
+	m_iNoteDelay = 0;		// // //
 }
 
 void CTrackerChannel::SetVolumeMeter(int Value)
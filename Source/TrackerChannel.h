@@ -44,8 +44,9 @@ class CTrackerChannel
 {
 public:
 	stChanNote GetNote();
-	void SetNote(const stChanNote &Note, note_prio_t Priority);		// // //
+	void SetNote(const stChanNote &Note, note_prio_t Priority, unsigned Delay = 0);		// // //
 	bool NewNoteData() const;
+	unsigned GetNoteDelay() const;		// // //
 	void Reset();
 
 	void SetVolumeMeter(int Value);
@@ -57,6 +58,7 @@ public:
 private:
 	stChanNote m_Note;
 	note_prio_t m_iNotePriority = NOTE_PRIO_0;
+	unsigned m_iNoteDelay = 0;		// // // cycles into the next frame at which the note starts
 
 	int m_iVolumeMeter = 0;
 	int m_iPitch = 0;
@@ -22,6 +22,7 @@
 
 #include "VisualizerScope.h"
 #include <cmath>
+#include <algorithm>		// // //
 #include "Graphics.h"
 #include "Color.h"		// // //
 
@@ -45,6 +46,11 @@ void CVisualizerScope::Create(int Width, int Height)
 
 	m_pWindowBuf = std::make_unique<short[]>(Width);		// // //
 	m_iWindowBufPtr = 0;
+
+	// // // Background shade of each line
+	m_pBackground = std::make_unique<COLORREF[]>(Height);
+	for (int y = 0; y < Height; ++y)
+		m_pBackground[y] = GREY((unsigned char)(std::sinf((float(y) * 3.14f) / float(Height)) * 40.0f));
 }
 
 void CVisualizerScope::SetSampleRate(int SampleRate)
@@ -53,11 +59,8 @@ void CVisualizerScope::SetSampleRate(int SampleRate)
 
 void CVisualizerScope::ClearBackground()
 {
-	for (int y = 0; y < m_iHeight; ++y) {
-		COLORREF col = GREY((unsigned char)(std::sinf((float(y) * 3.14f) / float(m_iHeight)) * 40.0f));		// // //
-		for (int x = 0; x < m_iWidth; ++x)
-			m_pBlitBuffer[y * m_iWidth + x] = col;
-	}
+	for (int y = 0; y < m_iHeight; ++y)
+		std::fill_n(&m_pBlitBuffer[y * m_iWidth], m_iWidth, m_pBackground[y]);		// // //
 }
 
 void CVisualizerScope::RenderBuffer()
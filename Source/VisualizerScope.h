@@ -44,6 +44,7 @@ private:
 private:
 	int	 m_iWindowBufPtr;
 	std::unique_ptr<short[]> m_pWindowBuf;		// // //
+	std::unique_ptr<COLORREF[]> m_pBackground;		// // //
 	bool m_bBlur;
 
 #ifdef _DEBUG
@@ -21,6 +21,8 @@
 */
 
 #include "VisualizerSpectrum.h"
+#include <algorithm>		// // //
+#include <cmath>		// // //
 #include "Graphics.h"
 #include "Color.h"		// // //
 
@@ -39,6 +41,19 @@ void CVisualizerSpectrum::Create(int Width, int Height)
 	CVisualizerBase::Create(Width, Height);
 
 	std::fill(m_pBlitBuffer.get(), m_pBlitBuffer.get() + Width * Height, BG_COLOR);		// // //
+
+	// // // Precompute the colors of each bar height, the last column of wide bars is dimmed
+	m_pColorRamp = std::make_unique<COLORREF[]>((Height + 1) * Height * 2);
+	for (int Lit = 0; Lit <= Height; ++Lit)
+		for (int y = 0; y < Height; ++y) {
+			COLORREF Color = BLEND(MakeRGB(255, 96, 96), WHITE, y / (Lit + 1.f));
+			if (y == 0)
+				Color = DIM(Color, .9);
+			if (m_iBarSize > 1 && (y & 1))
+				Color = DIM(Color, .4);
+			m_pColorRamp[(Lit * Height + y) * 2] = Color;
+			m_pColorRamp[(Lit * Height + y) * 2 + 1] = m_iBarSize > 1 ? DIM(Color, .5) : Color;
+		}
 }
 
 void CVisualizerSpectrum::SetSampleRate(int SampleRate)
@@ -56,7 +71,6 @@ void CVisualizerSpectrum::SetSampleData(array_view<int16_t> Samples)		// // //
 	CVisualizerBase::SetSampleData(Samples);
 
 	fft_buffer_.CopyIn(Samples.begin(), Samples.size());
-	fft_buffer_.Transform();
 }
 
 void CVisualizerSpectrum::Draw()
@@ -70,6 +84,8 @@ void CVisualizerSpectrum::Draw()
 
 	int LastStep = 0;
 
+	fft_buffer_.Transform();		// // // once per frame instead of once per sample batch
+
 	for (int i = 0; i < m_iWidth / m_iBarSize; ++i) {		// // //
 		int iStep = int(Pos + 0.5f);
 
@@ -99,17 +115,17 @@ void CVisualizerSpectrum::Draw()
 
 		level = m_fFftPoint[iStep];
 
+		// // // Number of lit pixels, the colors come from the precomputed ramp of that height
+		const int Lit = std::min(static_cast<int>(std::ceil(level)), m_iHeight);
+		const COLORREF *pRamp = &m_pColorRamp[Lit * m_iHeight * 2];
 		for (int y = 0; y < m_iHeight; ++y) {
-			COLORREF Color = BLEND(MakeRGB(255, 96, 96), WHITE, y / (level + 1));
-			if (y == 0)
-				Color = DIM(Color, .9);
-			if (m_iBarSize > 1 && (y & 1))		// // //
-				Color = DIM(Color, .4);
-			for (int x = 0; x < m_iBarSize; ++x) {		// // //
-				if (m_iBarSize > 1 && x == m_iBarSize - 1)
-					Color = DIM(Color, .5);
-				m_pBlitBuffer[(m_iHeight - 1 - y) * m_iWidth + i * m_iBarSize + x + OFFSET] = y < level ? Color : BG_COLOR;
+			COLORREF *pPixel = &m_pBlitBuffer[(m_iHeight - 1 - y) * m_iWidth + i * m_iBarSize + OFFSET];
+			if (y < Lit) {
+				std::fill_n(pPixel, m_iBarSize - 1, pRamp[y * 2]);
+				pPixel[m_iBarSize - 1] = pRamp[y * 2 + 1];
 			}
+			else
+				std::fill_n(pPixel, m_iBarSize, BG_COLOR);
 		}
 
 		LastStep = iStep;
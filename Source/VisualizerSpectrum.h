@@ -49,4 +49,5 @@ private:
 	int m_iFillPos;
 	std::array<short, FFT_POINTS> m_pSampleBuffer = { };
 	std::array<float, FFT_POINTS> m_fFftPoint = { };
+	std::unique_ptr<COLORREF[]> m_pColorRamp;		// // // [height][y][column is last]
 };
@@ -42,10 +42,18 @@ UINT CVisualizerWnd::ThreadProcFunc(LPVOID pParam)
 
 // CSampleWindow
 
+namespace {
+
+// // // Samples buffered between the audio thread and the visualizer thread, about 1.5 s at 44.1 kHz
+const std::size_t SAMPLE_RING_SIZE = 1 << 16;
+
+} // namespace
+
 IMPLEMENT_DYNAMIC(CVisualizerWnd, CWnd)
 
 CVisualizerWnd::CVisualizerWnd() :
 	m_iCurrentState(0),
+	m_SampleRing(SAMPLE_RING_SIZE),		// // //
 	m_bThreadRunning(false),
 	m_hNewSamples(NULL),
 	m_bNoAudio(false)
@@ -71,12 +79,6 @@ void CVisualizerWnd::LockedState(F f) const {		// // //
 	f();
 }
 
-template <typename F>
-void CVisualizerWnd::LockedBuffer(F f) const {		// // //
-	CSingleLock l(&m_csBufferSelect, TRUE);
-	f();
-}
-
 BEGIN_MESSAGE_MAP(CVisualizerWnd, CWnd)
 	ON_WM_ERASEBKGND()
 	ON_WM_LBUTTONDOWN()
@@ -110,17 +112,11 @@ void CVisualizerWnd::SetSampleRate(int SampleRate)
 
 void CVisualizerWnd::FlushSamples(array_view<int16_t> Samples)		// // //
 {
+	// Called from the audio thread, this must never wait on the visualizer thread
 	if (!m_bThreadRunning)
 		return;
 
-	LockedBuffer([&] {
-		if (Samples.size() != m_pBuffer1.size()) {
-			m_pBuffer1 = std::vector<int16_t>(Samples.size());		// // //
-			m_pBuffer2 = std::vector<int16_t>(Samples.size());
-		}
-		Samples.copy(m_pBuffer1.data(), Samples.size());
-	});
-
+	m_SampleRing.push(Samples);		// // // samples that do not fit are dropped
 	SetEvent(m_hNewSamples);
 }
 
@@ -140,15 +136,14 @@ UINT CVisualizerWnd::ThreadProc()
 	while (m_bThreadRunning && ::WaitForSingleObject(m_hNewSamples, INFINITE) == WAIT_OBJECT_0) {
 		m_bNoAudio = false;
 
-		// Switch buffers
-		LockedBuffer([&] {
-			m_pBuffer1.swap(m_pBuffer2);
-		});
+		// // // Take everything the audio thread has written so far
+		m_pSampleBuffer.resize(m_SampleRing.size());
+		m_pSampleBuffer.resize(m_SampleRing.pop(m_pSampleBuffer.data(), m_pSampleBuffer.size()));
 
 		// Draw
 		LockedState([&] {
 			if (CDC *pDC = GetDC()) {
-				m_pStates[m_iCurrentState]->SetSampleData(m_pBuffer2);
+				m_pStates[m_iCurrentState]->SetSampleData(m_pSampleBuffer);
 				m_pStates[m_iCurrentState]->Draw();
 				m_pStates[m_iCurrentState]->Display(pDC, false);
 				ReleaseDC(pDC);
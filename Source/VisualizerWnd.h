@@ -29,6 +29,7 @@
 #include <memory>		// // //
 #include <vector>		// // //
 #include "array_view.h"		// // //
+#include "spsc_ring.h"		// // //
 
 class CVisualizerBase;		// // //
 
@@ -55,14 +56,12 @@ private:
 	UINT ThreadProc();
 	template <typename F>
 	void LockedState(F f) const;
-	template <typename F>
-	void LockedBuffer(F f) const;
 
 	std::vector<std::unique_ptr<CVisualizerBase>> m_pStates;		// // //
 	unsigned int m_iCurrentState;
 
-	std::vector<int16_t> m_pBuffer1;		// // //
-	std::vector<int16_t> m_pBuffer2;
+	spsc_ring<int16_t> m_SampleRing;		// // // filled by the audio thread
+	std::vector<int16_t> m_pSampleBuffer;		// // // owned by the worker thread
 
 	HANDLE m_hNewSamples;
 
@@ -72,7 +71,6 @@ private:
 	CWinThread *m_pWorkerThread = nullptr;
 	bool m_bThreadRunning;
 
-	mutable CCriticalSection m_csBufferSelect;
 	mutable CCriticalSection m_csBuffer;
 
 public:
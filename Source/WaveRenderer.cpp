@@ -22,6 +22,9 @@
 
 #include "WaveRenderer.h"
 #include "NumConv.h"
+#include "ParallelRenderer.h"		// // //
+#include <thread>		// // //
+#include <algorithm>		// // //
 
 CWaveRenderer::~CWaveRenderer() {
 	CloseOutputStream();
@@ -81,6 +84,14 @@ void CWaveRenderer::FinishRender() {
 	m_bRequestRenderStop = true;
 }
 
+bool CWaveRenderer::RendersAudio() const {		// // //
+	return false;
+}
+
+COutputWaveStream *CWaveRenderer::GetOutputStream() const {		// // //
+	return m_pWaveStream.get();
+}
+
 
 
 CWaveRendererTick::CWaveRendererTick(unsigned Ticks, double Rate) :
@@ -127,3 +138,67 @@ std::string CWaveRendererRow::GetProgressString() const {
 int CWaveRendererRow::GetProgressPercent() const {
 	return Finished() ? 100 : m_iRenderRow * 100 / m_iRowsToRender;
 }
+
+
+
+// // // CWaveRendererParallel
+
+CWaveRendererParallel::CWaveRendererParallel(const CFamiTrackerModule &modfile, unsigned Track, unsigned Ticks, double Rate,
+	unsigned SampleRate, CHeadlessPlayer::mixer_settings_t Mixer) :
+	CWaveRenderer(),
+	m_pRenderer(std::make_unique<CParallelRenderer>(modfile, Track, SampleRate, std::move(Mixer))),
+	m_iTicksToRender(Ticks),
+	m_fFrameRate(Rate)
+{
+	SetRenderTrack(Track);
+}
+
+CWaveRendererParallel::~CWaveRendererParallel() {
+	CancelRender();
+}
+
+void CWaveRendererParallel::CloseOutputStream() {
+	CancelRender();
+	CWaveRenderer::CloseOutputStream();
+}
+
+void CWaveRendererParallel::Start() {
+	CWaveRenderer::Start();
+	m_Render = std::async(std::launch::async, [this] {
+		auto Audio = m_pRenderer->Render(m_iTicksToRender, std::max(std::thread::hardware_concurrency(), 1u));
+		if (auto *pStream = GetOutputStream())
+			pStream->WriteSamples(array_view<std::int16_t> {Audio.Samples});
+	});
+}
+
+bool CWaveRendererParallel::ShouldStartPlayer() {
+	return false;
+}
+
+bool CWaveRendererParallel::ShouldStopRender() {
+	return m_Render.valid() && m_Render.wait_for(std::chrono::seconds::zero()) == std::future_status::ready;
+}
+
+bool CWaveRendererParallel::RendersAudio() const {
+	return true;
+}
+
+std::string CWaveRendererParallel::GetProgressString() const {
+	auto Ticks = std::min<std::uint64_t>(m_pRenderer->GetRenderedTicks(), m_iTicksToRender);
+	return "Time: " + conv::time_from_uint(static_cast<unsigned>(Ticks / m_fFrameRate)) +
+		" / " + conv::time_from_uint(static_cast<unsigned>(m_iTicksToRender / m_fFrameRate)) +
+		" (" + conv::from_int(GetProgressPercent()) + "% done)";
+}
+
+int CWaveRendererParallel::GetProgressPercent() const {
+	// frames rendered again after a rejected seam are counted as well
+	return Finished() ? 100 : static_cast<int>(std::min<std::uint64_t>(m_pRenderer->GetRenderedTicks(), m_iTicksToRender) * 100 / m_iTicksToRender);
+}
+
+// stops the render if the export is aborted before it finishes
+void CWaveRendererParallel::CancelRender() {
+	if (m_Render.valid()) {
+		m_pRenderer->Cancel();
+		m_Render.wait();
+	}
+}
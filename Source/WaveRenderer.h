@@ -26,29 +26,33 @@
 #include <memory>
 #include <cstdint>
 #include <string>
+#include <future>		// // //
 #include "array_view.h"
 #include "WaveStream.h"
+#include "HeadlessPlayer.h"		// // //
+
+class CParallelRenderer;		// // //
 
 class CWaveRenderer {
 public:
 	virtual ~CWaveRenderer();
 
 	void SetOutputStream(std::unique_ptr<COutputWaveStream> pWave);
-	void CloseOutputStream();
+	virtual void CloseOutputStream();		// // //
 
 	template <typename T>
 	void FlushBuffer(array_view<T> Buf) const {
-		if (m_pWaveStream)
+		if (m_pWaveStream && !RendersAudio())		// // //
 			m_pWaveStream->WriteSamples(Buf);
 	}
 
-	void Start();
+	virtual void Start();		// // //
 	virtual void Tick() { }
 	virtual void StepRow() { }
 
-	bool ShouldStartPlayer();
+	virtual bool ShouldStartPlayer();		// // //
 	bool ShouldStopPlayer() const;		// // //
-	bool ShouldStopRender();
+	virtual bool ShouldStopRender();		// // //
 
 	bool Started() const;
 	bool Finished() const;
@@ -60,6 +64,9 @@ public:
 
 protected:
 	void FinishRender();
+	// // // Renderers that produce the audio themselves ignore that of the sound generator
+	virtual bool RendersAudio() const;
+	COutputWaveStream *GetOutputStream() const;		// // //
 
 private:
 	std::unique_ptr<COutputWaveStream> m_pWaveStream;
@@ -102,3 +109,29 @@ private:
 	unsigned m_iRowsToRender;
 	unsigned m_iRenderRow = 0;
 };
+
+// // // Renders the song on all processor cores with CParallelRenderer instead of the sound
+// generator, whose player is never started
+class CWaveRendererParallel : public CWaveRenderer {
+public:
+	CWaveRendererParallel(const CFamiTrackerModule &modfile, unsigned Track, unsigned Ticks, double Rate,
+		unsigned SampleRate, CHeadlessPlayer::mixer_settings_t Mixer);
+	~CWaveRendererParallel();
+
+	void CloseOutputStream() override;
+	void Start() override;
+	bool ShouldStartPlayer() override;
+	bool ShouldStopRender() override;
+
+private:
+	bool RendersAudio() const override;
+	std::string GetProgressString() const override;
+	int GetProgressPercent() const override;
+	void CancelRender();
+
+private:
+	std::unique_ptr<CParallelRenderer> m_pRenderer;
+	std::future<void> m_Render;
+	unsigned m_iTicksToRender;
+	double m_fFrameRate;
+};
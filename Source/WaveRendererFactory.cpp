@@ -42,3 +42,23 @@ std::unique_ptr<CWaveRenderer> CWaveRendererFactory::Make(const CFamiTrackerModu
 	}
 	return nullptr;
 }
+
+std::unique_ptr<CWaveRenderer> CWaveRendererFactory::MakeParallel(const CFamiTrackerModule &modfile, unsigned track, render_type_t renderType, unsigned param,
+	unsigned SampleRate, const CHeadlessPlayer::mixer_settings_t &Mixer) {		// // //
+	std::uint64_t ticks = 0;
+	switch (renderType) {
+	case render_type_t::Loops: {
+		auto pSongView = modfile.MakeSongView(track, false);
+		CSongLengthScanner scanner {modfile, *pSongView};
+		auto [FirstLoop, SecondLoop] = scanner.GetTickCount();
+		ticks = FirstLoop + SecondLoop * param;
+		break;
+	}
+	case render_type_t::Seconds:
+		ticks = param * modfile.GetFrameRate();
+		break;
+	}
+	if (!ticks)
+		return nullptr;
+	return std::make_unique<CWaveRendererParallel>(modfile, track, static_cast<unsigned>(ticks), modfile.GetFrameRate(), SampleRate, Mixer);
+}
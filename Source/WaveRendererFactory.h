@@ -24,6 +24,7 @@
 #pragma once
 
 #include <memory>
+#include "HeadlessPlayer.h"		// // //
 
 class CFamiTrackerModule;
 class CWaveRenderer;
@@ -35,4 +36,7 @@ enum class render_type_t : unsigned char {
 
 struct CWaveRendererFactory {
 	static std::unique_ptr<CWaveRenderer> Make(const CFamiTrackerModule &modfile, unsigned track, render_type_t renderType, unsigned param);
+	// // // renders the same length on all processor cores, see CWaveRendererParallel
+	static std::unique_ptr<CWaveRenderer> MakeParallel(const CFamiTrackerModule &modfile, unsigned track, render_type_t renderType, unsigned param,
+		unsigned SampleRate, const CHeadlessPlayer::mixer_settings_t &Mixer);
 };
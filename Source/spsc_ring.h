@@ -0,0 +1,106 @@
+/*
+** FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2005-2014  Jonathan Liss
+**
+** 0CC-FamiTracker is (C) 2014-2018 HertzDevil
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+** Library General Public License for more details.  To obtain a
+** copy of the GNU Library General Public License, write to the Free
+** Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+** Any permitted reproduction of these routines, in whole or in part,
+** must bear this legend.
+*/
+
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <type_traits>
+#include "array_view.h"
+
+// // // Wait-free single-producer single-consumer ring buffer. Neither end ever blocks;
+// push drops whatever does not fit, which makes it safe to feed from the audio thread.
+template <typename T>
+class spsc_ring {
+	static_assert(std::is_trivially_copyable_v<T>, "spsc_ring elements must be trivially copyable");
+
+public:
+	using value_type = T;
+	using size_type = std::size_t;
+
+	// capacity is rounded up to a power of two
+	explicit spsc_ring(size_type capacity) {
+		size_type sz = 1;
+		while (sz < capacity)
+			sz <<= 1;
+		buf_ = std::make_unique<T[]>(sz);
+		mask_ = sz - 1;
+	}
+
+	size_type capacity() const noexcept {
+		return mask_ + 1;
+	}
+
+	// number of elements available to the consumer
+	size_type size() const noexcept {
+		return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+	}
+
+	bool empty() const noexcept {
+		return size() == 0;
+	}
+
+	// producer side, returns the number of elements actually written
+	size_type push(array_view<T> items) noexcept {
+		const size_type head = head_.load(std::memory_order_relaxed);
+		const size_type tail = tail_.load(std::memory_order_acquire);
+		const size_type count = std::min(items.size(), capacity() - (head - tail));
+		const size_type first = std::min(count, capacity() - (head & mask_));
+		std::copy_n(items.begin(), first, buf_.get() + (head & mask_));
+		std::copy_n(items.begin() + first, count - first, buf_.get());
+		head_.store(head + count, std::memory_order_release);
+		return count;
+	}
+
+	bool push(const T &x) noexcept {
+		return push(array_view<T> {&x, 1}) == 1;
+	}
+
+	// consumer side, returns the number of elements actually read
+	size_type pop(T *out, size_type count) noexcept {
+		const size_type tail = tail_.load(std::memory_order_relaxed);
+		const size_type head = head_.load(std::memory_order_acquire);
+		count = std::min(count, head - tail);
+		const size_type first = std::min(count, capacity() - (tail & mask_));
+		std::copy_n(buf_.get() + (tail & mask_), first, out);
+		std::copy_n(buf_.get(), count - first, out + first);
+		tail_.store(tail + count, std::memory_order_release);
+		return count;
+	}
+
+	bool pop(T &x) noexcept {
+		return pop(&x, 1) == 1;
+	}
+
+	// consumer side, discards everything pushed so far
+	void clear() noexcept {
+		tail_.store(head_.load(std::memory_order_acquire), std::memory_order_release);
+	}
+
+private:
+	std::unique_ptr<T[]> buf_;
+	size_type mask_ = 0;
+	alignas(64) std::atomic<size_type> head_ {0};		// written by the producer only
+	alignas(64) std::atomic<size_type> tail_ {0};		// written by the consumer only
+};
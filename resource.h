@@ -600,6 +600,7 @@
 #define IDC_COMBO_IMPORT_GROOVE         1465
 #define IDC_BUTTON_IMPORT_ALL           1466
 #define IDC_BUTTON_IMPORT_NONE          1467
+#define IDC_PCM_TRELLIS                 1468
 #define ID_TRACKER_PLAY                 32771
 #define ID_TRACKER_PLAYPATTERN          32775
 #define ID_TRACKER_STOP                 32776
@@ -762,7 +763,7 @@
 #ifndef APSTUDIO_READONLY_SYMBOLS
 #define _APS_NEXT_RESOURCE_VALUE        359
 #define _APS_NEXT_COMMAND_VALUE         33202
-#define _APS_NEXT_CONTROL_VALUE         1467
+#define _APS_NEXT_CONTROL_VALUE         1469
 #define _APS_NEXT_SYMED_VALUE           179
 #endif
 #endif